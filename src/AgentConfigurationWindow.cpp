@@ -195,6 +195,10 @@ void AgentConfigurationWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool AgentConfigurationWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void AgentConfigurationWindow::loadConfiguration () {
 	int result;
 
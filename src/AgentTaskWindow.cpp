@@ -115,6 +115,10 @@ void AgentTaskWindow::syncRecordStore () {
 	}
 }
 
+bool AgentTaskWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void AgentTaskWindow::refreshLayout () {
 	float x, y, y0, x2, y2;
 
@@ -0,0 +1,183 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Config.h"
+#include <stdlib.h>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "App.h"
+#include "Widget.h"
+#include "AnimationTimeline.h"
+
+AnimationTimeline *AnimationTimeline::instance = NULL;
+
+AnimationTimeline::AnimationTimeline ()
+: stepCount (0)
+, tweenListMutex (NULL)
+, isUpdating (false)
+{
+	tweenListMutex = SDL_CreateMutex ();
+	SDL_AtomicSet (&activeCount, 0);
+	SDL_AtomicSet (&drawActiveCount, 0);
+}
+
+AnimationTimeline::~AnimationTimeline () {
+	tweenList.clear ();
+	if (tweenListMutex) {
+		SDL_DestroyMutex (tweenListMutex);
+		tweenListMutex = NULL;
+	}
+}
+
+void AnimationTimeline::addTween (void *target, AnimationTimeline::StepFunction stepFunction, Widget *ownerWidget) {
+	std::vector<AnimationTimeline::Tween>::iterator i, end;
+	AnimationTimeline::Tween tween;
+	bool found;
+
+	if ((! target) || (! stepFunction)) {
+		return;
+	}
+	found = false;
+	SDL_LockMutex (tweenListMutex);
+	i = tweenList.begin ();
+	end = tweenList.end ();
+	while (i != end) {
+		if (i->target == target) {
+			i->stepFunction = stepFunction;
+			i->ownerWidget = ownerWidget;
+			found = true;
+			break;
+		}
+		++i;
+	}
+	if (! found) {
+		tween.target = target;
+		tween.stepFunction = stepFunction;
+		tween.ownerWidget = ownerWidget;
+		tweenList.push_back (tween);
+		SDL_AtomicSet (&activeCount, (int) tweenList.size ());
+	}
+	// Count the tween as drawing until the next update determines whether its owner is visible
+	SDL_AtomicAdd (&drawActiveCount, 1);
+	SDL_UnlockMutex (tweenListMutex);
+}
+
+void AnimationTimeline::removeTween (void *target) {
+	std::vector<AnimationTimeline::Tween>::iterator i, end;
+
+	if (! target) {
+		return;
+	}
+	SDL_LockMutex (tweenListMutex);
+	i = tweenList.begin ();
+	end = tweenList.end ();
+	while (i != end) {
+		if (i->target == target) {
+			if (isUpdating) {
+				// update is iterating the list on this thread; clear the entry and let update remove it
+				i->target = NULL;
+			}
+			else {
+				tweenList.erase (i);
+				SDL_AtomicSet (&activeCount, (int) tweenList.size ());
+			}
+			break;
+		}
+		++i;
+	}
+	SDL_UnlockMutex (tweenListMutex);
+}
+
+bool AnimationTimeline::isActive () {
+	return (SDL_AtomicGet (&drawActiveCount) > 0);
+}
+
+int AnimationTimeline::getActiveCount () {
+	return (SDL_AtomicGet (&activeCount));
+}
+
+void AnimationTimeline::update (int msElapsed) {
+	std::vector<AnimationTimeline::Tween>::iterator i;
+	AnimationTimeline::Tween *tween;
+	int index, drawcount;
+	bool isactive, shouldsetdirty;
+
+	if (SDL_AtomicGet (&activeCount) <= 0) {
+		return;
+	}
+	shouldsetdirty = false;
+	drawcount = 0;
+	SDL_LockMutex (tweenListMutex);
+	isUpdating = true;
+	// Step functions may start other tweens, so iterate by index to allow tweenList to grow during the loop
+	index = 0;
+	while (index < (int) tweenList.size ()) {
+		tween = &(tweenList[index]);
+		if (tween->target) {
+			isactive = tween->stepFunction (tween->target, msElapsed);
+			tween = &(tweenList[index]);
+			if (tween->target) {
+				if (tween->ownerWidget) {
+					// Widgets that are hidden or not yet positioned on screen don't need damage
+					if (tween->ownerWidget->isVisible && tween->ownerWidget->hasScreenPosition && (! tween->ownerWidget->isOffscreen)) {
+						tween->ownerWidget->addDrawDamage ();
+						++drawcount;
+					}
+				}
+				else {
+					shouldsetdirty = true;
+					++drawcount;
+				}
+				if (! isactive) {
+					tween->target = NULL;
+				}
+			}
+		}
+		++index;
+	}
+	isUpdating = false;
+
+	i = tweenList.begin ();
+	while (i != tweenList.end ()) {
+		if (! i->target) {
+			i = tweenList.erase (i);
+		}
+		else {
+			++i;
+		}
+	}
+	SDL_AtomicSet (&activeCount, (int) tweenList.size ());
+	SDL_AtomicSet (&drawActiveCount, drawcount);
+	++stepCount;
+	SDL_UnlockMutex (tweenListMutex);
+
+	if (shouldsetdirty) {
+		App::instance->setDrawDirty ();
+	}
+}
@@ -0,0 +1,86 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+// Object that steps active animations from a single timeline, so that idle objects cost nothing per update
+
+#ifndef ANIMATION_TIMELINE_H
+#define ANIMATION_TIMELINE_H
+
+#include <vector>
+#include "SDL2/SDL.h"
+
+class Widget;
+
+class AnimationTimeline {
+public:
+	AnimationTimeline ();
+	~AnimationTimeline ();
+
+	static AnimationTimeline *instance;
+
+	// Callback that advances a tween's target object by an elapsed millisecond time period, returning a boolean value indicating if the tween remains active
+	typedef bool (*StepFunction) (void *target, int msElapsed);
+
+	// Read-only data members
+	int64_t stepCount;
+
+	// Add a tween that invokes stepFunction with target on each update until the function returns false. If ownerWidget is provided, the timeline adds draw damage to that widget after each step while it's visible; otherwise, each step marks the window as dirty. If target already has an active tween, replace its step function and owner.
+	void addTween (void *target, AnimationTimeline::StepFunction stepFunction, Widget *ownerWidget = NULL);
+
+	// Remove any active tween associated with target. Callers must invoke this method before target is deallocated.
+	void removeTween (void *target);
+
+	// Return a boolean value indicating if any tween changed visible content on its most recent step. Tweens whose owner widget is hidden or offscreen are excluded, since they produce no draw damage and shouldn't keep the draw loop awake.
+	bool isActive ();
+
+	// Return the number of active tweens
+	int getActiveCount ();
+
+	// Step all active tweens as appropriate for an elapsed millisecond time period and discard any that have completed
+	void update (int msElapsed);
+
+private:
+	struct Tween {
+		void *target;
+		AnimationTimeline::StepFunction stepFunction;
+		Widget *ownerWidget;
+		Tween ():
+			target (NULL),
+			stepFunction (NULL),
+			ownerWidget (NULL) { }
+	};
+
+	std::vector<AnimationTimeline::Tween> tweenList;
+	SDL_mutex *tweenListMutex;
+	SDL_atomic_t activeCount;
+	SDL_atomic_t drawActiveCount;
+	bool isUpdating;
+};
+
+#endif
@@ -49,6 +49,7 @@
 #include "StdString.h"
 #include "Log.h"
 #include "TaskGroup.h"
+#include "TaskGraph.h"
 #include "LuaScript.h"
 #include "OsUtil.h"
 #include "MathUtil.h"
@@ -62,6 +63,8 @@
 #include "Input.h"
 #include "Resource.h"
 #include "Network.h"
+#include "Profiler.h"
+#include "AnimationTimeline.h"
 #include "Panel.h"
 #include "ConsoleWindow.h"
 #include "Toolbar.h"
@@ -72,6 +75,10 @@
 #include "App.h"
 
 const int App::DefaultMinFrameDelay = 20;
+const int App::DefaultMaxIdleFrameDelay = 0;
+const int App::UnfocusedMinFrameDelay = 50;
+const int App::HiddenMinFrameDelay = 250;
+const int App::MaxDrawDamageRects = 8;
 const int App::WindowWidths[] = { 768, 1024, 1280, 1600, 1920 };
 const int App::WindowHeights[] = { 432, 576, 720, 900, 1080 };
 const int App::WindowSizeCount = 5;
@@ -107,6 +114,8 @@ void App::createInstance (bool shouldSkipInit) {
 	RecordStore::instance = &(App::instance->recordStore);
 	CommandHistory::instance = &(App::instance->commandHistory);
 	CommandListener::instance = &(App::instance->commandListener);
+	Profiler::instance = &(App::instance->profiler);
+	AnimationTimeline::instance = &(App::instance->animationTimeline);
 
 	if (! shouldSkipInit) {
 		App::instance->init ();
@@ -128,6 +137,8 @@ void App::freeInstance () {
 		RecordStore::instance = NULL;
 		CommandHistory::instance = NULL;
 		CommandListener::instance = NULL;
+		Profiler::instance = NULL;
+		AnimationTimeline::instance = NULL;
 		IMG_Quit ();
 		SDL_Quit ();
 	}
@@ -143,6 +154,7 @@ App::App ()
 , shouldSyncRecordStore (false)
 , isMainToolbarClockEnabled (false)
 , isNetworkActive (false)
+, updateWidget (NULL)
 , isShuttingDown (false)
 , isShutdown (false)
 , startTime (0)
@@ -150,6 +162,11 @@ App::App ()
 , window (NULL)
 , render (NULL)
 , isTextureRenderEnabled (false)
+, isPartialDrawEnabled (false)
+, isDrawBatchEnabled (false)
+, isTextureCacheEnabled (false)
+, isSpriteAtlasEnabled (false)
+, isStartupTraceEnabled (false)
 , rootPanel (NULL)
 , displayDdpi (0.0f)
 , displayHdpi (0.0f)
@@ -157,16 +174,24 @@ App::App ()
 , windowWidth (0)
 , windowHeight (0)
 , minDrawFrameDelay (0)
+, drawFramePeriod (0)
+, isVsyncEnabled (false)
 , minUpdateFrameDelay (0)
+, isDrawOnDemandEnabled (true)
+, maxIdleFrameDelay (0)
 , fontScale (1.0f)
 , imageScale (0)
 , drawCount (0)
+, skipDrawCount (0)
 , updateCount (0)
 , isPrefsWriteDisabled (false)
 , updateThread (NULL)
 , uniqueIdMutex (NULL)
 , nextUniqueId (1)
 , prefsMapMutex (NULL)
+, drawBatchTexture (NULL)
+, isDrawBatchEmpty (true)
+, isClipRectSuspended (false)
 , roundedCornerSprite (NULL)
 , renderTaskMutex (NULL)
 , isSuspendingUpdate (false)
@@ -182,6 +207,24 @@ App::App ()
 , nextBackgroundTextureWidth (0)
 , nextBackgroundTextureHeight (0)
 , backgroundCrossFadeAlpha (0.0f)
+, isDrawDirty (true)
+, isDrawWaiting (false)
+, isRenderTaskPending (false)
+, drawWakeEventType ((Uint32) -1)
+, drawDirtyMutex (NULL)
+, lastWindowEventCount (0)
+, isDrawFullDamage (true)
+, shouldDrawFull (true)
+, isDrawDamageClipActive (false)
+, backTexture (NULL)
+, backTextureWidth (0)
+, backTextureHeight (0)
+, renderTarget (NULL)
+, updateThreadId (0)
+, isDrawFrameDelayDefault (false)
+, frameThrottleDelay (0)
+, startupTraceJson (NULL)
+, recordStoreVersion (-1)
 {
 	uniqueIdMutex = SDL_CreateMutex ();
 	prefsMapMutex = SDL_CreateMutex ();
@@ -190,9 +233,14 @@ App::App ()
 	updateCond = SDL_CreateCond ();
 	consoleWindowMutex = SDL_CreateMutex ();
 	backgroundMutex = SDL_CreateMutex ();
+	drawDirtyMutex = SDL_CreateMutex ();
 }
 
 App::~App () {
+	if (startupTraceJson) {
+		delete (startupTraceJson);
+		startupTraceJson = NULL;
+	}
 	if (rootPanel) {
 		rootPanel->release ();
 		rootPanel = NULL;
@@ -233,6 +281,10 @@ App::~App () {
 		SDL_DestroyMutex (backgroundMutex);
 		backgroundMutex = NULL;
 	}
+	if (drawDirtyMutex) {
+		SDL_DestroyMutex (drawDirtyMutex);
+		drawDirtyMutex = NULL;
+	}
 }
 
 void App::init () {
@@ -294,6 +346,12 @@ void App::init () {
 	}
 	else {
 		prefsPath.assign (OsUtil::getAppendPath (path, StdString::createSprintf ("%s.conf", APPLICATION_PACKAGE_NAME)));
+		if (OsUtil::getEnvValue ("RESOURCE_WARMUP", true)) {
+			resource.setWarmupManifest (OsUtil::getAppendPath (path, StdString::createSprintf ("%s-warmup.conf", APPLICATION_PACKAGE_NAME)), OsUtil::getEnvValue ("RESOURCE_WARMUP_PERIOD", Resource::DefaultWarmupRecordPeriod / 1000) * 1000);
+		}
+		if (OsUtil::getEnvValue ("RECORD_SNAPSHOT", true)) {
+			recordStore.setSnapshotFile (OsUtil::getAppendPath (path, StdString::createSprintf ("%s-records.dat", APPLICATION_PACKAGE_NAME)), OsUtil::getEnvValue ("RECORD_SNAPSHOT_PERIOD", RecordStore::DefaultSnapshotWritePeriod / 1000) * 1000);
+		}
 		if (! log.isFileWriteEnabled) {
 			log.openLogFile (OsUtil::getAppendPath (path, StdString::createSprintf ("%s.log", APPLICATION_PACKAGE_NAME)));
 		}
@@ -301,7 +359,16 @@ void App::init () {
 
 	isConsole = OsUtil::getEnvValue ("CONSOLE", false);
 	minDrawFrameDelay = OsUtil::getEnvValue ("MIN_DRAW_FRAME_DELAY", 0);
+	isVsyncEnabled = OsUtil::getEnvValue ("VSYNC", false);
 	minUpdateFrameDelay = OsUtil::getEnvValue ("MIN_UPDATE_FRAME_DELAY", 0);
+	isDrawOnDemandEnabled = OsUtil::getEnvValue ("DRAW_ON_DEMAND", true);
+	isPartialDrawEnabled = OsUtil::getEnvValue ("PARTIAL_DRAW", true);
+	isDrawBatchEnabled = OsUtil::getEnvValue ("DRAW_BATCH", true);
+	isTextureCacheEnabled = OsUtil::getEnvValue ("TEXTURE_CACHE", true);
+	isSpriteAtlasEnabled = OsUtil::getEnvValue ("SPRITE_ATLAS", true);
+	isStartupTraceEnabled = OsUtil::getEnvValue ("STARTUP_TRACE", false);
+	recordStore.setRecordBudget (OsUtil::getEnvValue ("RECORD_STORE_BUDGET", RecordStore::DefaultRecordBudget));
+	maxIdleFrameDelay = OsUtil::getEnvValue ("MAX_IDLE_FRAME_DELAY", 0);
 	windowWidth = OsUtil::getEnvValue ("WINDOW_WIDTH", 0);
 	windowHeight = OsUtil::getEnvValue ("WINDOW_HEIGHT", 0);
 }
@@ -322,82 +389,206 @@ int App::getImageScale (int w, int h) {
 }
 
 int App::run () {
+	TaskGraph startupgraph;
 	int result;
 
 	startTime = OsUtil::getTime ();
 	if (minDrawFrameDelay <= 0) {
 		minDrawFrameDelay = App::DefaultMinFrameDelay;
+		isDrawFrameDelayDefault = true;
 	}
 	if (minUpdateFrameDelay <= 0) {
 		minUpdateFrameDelay = App::DefaultMinFrameDelay;
 	}
+	if (maxIdleFrameDelay <= 0) {
+		maxIdleFrameDelay = App::DefaultMaxIdleFrameDelay;
+	}
+	if ((maxIdleFrameDelay > 0) && (maxIdleFrameDelay < minDrawFrameDelay)) {
+		maxIdleFrameDelay = minDrawFrameDelay;
+	}
 	prng.seed ((uint32_t) (OsUtil::getTime () & 0xFFFFFFFF));
-	prefsMap.clear ();
-	if (prefsPath.empty ()) {
-		isPrefsWriteDisabled = true;
+
+	addStartupTasks (&startupgraph);
+	result = startupgraph.run ();
+	startupgraph.logTimings ("Startup");
+	if (result != OsUtil::Success) {
+		return (result);
+	}
+	Log::info ("Application startup complete; duration=%llims", (long long) startupgraph.getDuration ());
+	if (isStartupTraceEnabled) {
+		startupTraceJson = startupgraph.createTimingJson ();
+		if (isConsole) {
+			writeStartupTrace (0);
+		}
+	}
+
+	if (isConsole) {
+		result = runConsole ();
 	}
 	else {
-		result = prefsMap.read (prefsPath, true);
+		result = runWindow ();
+	}
+
+	writePrefs ();
+	return (result);
+}
+
+void App::addStartupTasks (TaskGraph *graph) {
+	StringList deps;
+
+	graph->addTask ("readPrefs", App::readPrefsTask, this);
+	graph->addTask ("openResources", App::openResourcesTask, this);
+	graph->addTask ("loadText", App::loadTextTask, this, StringList ("openResources"));
+	graph->addTask ("startNetwork", App::startNetworkTask, this, StringList ("readPrefs"));
+	graph->addTask ("startAgentControl", App::startAgentControlTask, this, StringList ("startNetwork"));
+	graph->addTask ("readCommandHistory", App::readCommandHistoryTask, this, StringList ("readPrefs"));
+	graph->addTask ("readRecordSnapshot", App::readRecordSnapshotTask, this);
+	if (! isConsole) {
+		// Window and texture operations must execute on the main thread, but can overlap with worker tasks that don't touch the renderer
+		graph->addTask ("initWindow", App::initWindowTask, this, StringList ("readPrefs"), true);
+
+		// Image decoding requires IMG_Init from initWindow
+		deps.clear ();
+		deps.push_back (StdString ("initWindow"));
+		deps.push_back (StdString ("openResources"));
+		graph->addTask ("prefetchResources", App::prefetchResourcesTask, this, deps);
+
+		deps.clear ();
+		deps.push_back (StdString ("initWindow"));
+		deps.push_back (StdString ("prefetchResources"));
+		graph->addTask ("loadUiResources", App::loadUiResourcesTask, this, deps, true);
+
+		deps.clear ();
+		deps.push_back (StdString ("loadUiResources"));
+		deps.push_back (StdString ("loadText"));
+		deps.push_back (StdString ("startAgentControl"));
+		deps.push_back (StdString ("readCommandHistory"));
+		graph->addTask ("createUi", App::createUiTask, this, deps, true);
+	}
+}
+
+int App::readPrefsTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	app->prefsMap.clear ();
+	if (app->prefsPath.empty ()) {
+		app->isPrefsWriteDisabled = true;
+	}
+	else {
+		result = app->prefsMap.read (app->prefsPath, true);
 		if (result != OsUtil::Success) {
-			Log::debug ("Failed to read preferences file; prefsPath=\"%s\" err=%i", prefsPath.c_str (), result);
-			prefsMap.clear ();
+			Log::debug ("Failed to read preferences file; prefsPath=\"%s\" err=%i", app->prefsPath.c_str (), result);
+			app->prefsMap.clear ();
 		}
 	}
-	isHttpsEnabled = prefsMap.find (App::HttpsKey, true);
+	app->isHttpsEnabled = app->prefsMap.find (App::HttpsKey, true);
+	return (OsUtil::Success);
+}
 
-	result = resource.open ();
+int App::openResourcesTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	result = app->resource.open ();
 	if (result != OsUtil::Success) {
 		Log::err ("Failed to open application resources; err=%i", result);
-		return (result);
 	}
-	result = uiText.load (OsUtil::getEnvLanguage (UiText::DefaultLanguage));
+	return (result);
+}
+
+int App::loadTextTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	result = app->uiText.load (OsUtil::getEnvLanguage (UiText::DefaultLanguage));
 	if (result != OsUtil::Success) {
 		Log::err ("Failed to load text resources; err=%i", result);
-		return (result);
 	}
-	network.maxRequestThreads = prefsMap.find (App::NetworkThreadsKey, Network::DefaultMaxRequestThreads);
-	network.httpUserAgent.sprintf ("Membrane Control/%s_%s", BUILD_ID, PLATFORM_ID);
-	network.datagramCallback = Network::DatagramCallbackContext (App::datagramReceived, NULL);
-	network.enableDatagramSocket = true;
-	result = network.start ();
+	return (result);
+}
+
+int App::startNetworkTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	app->network.maxRequestThreads = app->prefsMap.find (App::NetworkThreadsKey, Network::DefaultMaxRequestThreads);
+	app->network.httpUserAgent.sprintf ("Membrane Control/%s_%s", BUILD_ID, PLATFORM_ID);
+	app->network.datagramCallback = Network::DatagramCallbackContext (App::datagramReceived, NULL);
+	app->network.enableDatagramSocket = true;
+	result = app->network.start ();
 	if (result != OsUtil::Success) {
 		Log::err ("Failed to acquire application network resources; err=%i", result);
-		return (result);
 	}
+	return (result);
+}
 
-	agentControl.urlHostname = network.getPrimaryInterfaceAddress ();
-	if (agentControl.urlHostname.empty ()) {
+int App::startAgentControlTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	app->agentControl.urlHostname = app->network.getPrimaryInterfaceAddress ();
+	if (app->agentControl.urlHostname.empty ()) {
 		Log::warning ("Failed to determine local hostname, network services may not be available");
 	}
-	result = agentControl.start ();
+	result = app->agentControl.start ();
 	if (result != OsUtil::Success) {
 		Log::err ("Failed to start agent control processes; err=%i", result);
-		return (result);
 	}
+	return (result);
+}
 
-	commandHistory.readPrefs ();
+int App::readCommandHistoryTask (void *appPtr) {
+	App *app;
 
-	if (isConsole) {
-		result = runConsole ();
+	app = (App *) appPtr;
+	app->commandHistory.readPrefs ();
+	return (OsUtil::Success);
+}
+
+int App::readRecordSnapshotTask (void *appPtr) {
+	App *app;
+	int result;
+
+	app = (App *) appPtr;
+	result = app->recordStore.readSnapshotFile ();
+	if (result != OsUtil::Success) {
+		// A missing or unreadable snapshot file only means that record state is not restored until agents respond
+		Log::debug ("Failed to read record snapshot file; err=%i", result);
 	}
 	else {
-		result = runWindow ();
+		app->shouldSyncRecordStore = true;
 	}
+	return (OsUtil::Success);
+}
 
-	writePrefs ();
-	return (result);
+int App::prefetchResourcesTask (void *appPtr) {
+	((App *) appPtr)->resource.prefetchWarmupManifest ();
+	return (OsUtil::Success);
 }
 
-int App::runWindow () {
-	SDL_version version1, version2;
+int App::initWindowTask (void *appPtr) {
+	return (((App *) appPtr)->initWindow ());
+}
+
+int App::loadUiResourcesTask (void *appPtr) {
+	return (((App *) appPtr)->loadUiResources ());
+}
+
+int App::createUiTask (void *appPtr) {
+	return (((App *) appPtr)->createUi ());
+}
+
+int App::initWindow () {
 	SDL_RendererInfo renderinfo;
-	StdString text;
-	int result, delay, i;
-	int64_t endtime, elapsed, t1, t2;
-	Uint32 windowflags;
-	double fps;
-	Ui *ui;
+	SDL_DisplayMode displaymode;
 	SDL_Rect rect;
+	int result, i;
 
 	if (SDL_Init (SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
 		Log::err ("Failed to start SDL: %s", SDL_GetError ());
@@ -413,6 +604,13 @@ int App::runWindow () {
 		Log::err ("Failed to acquire application input devices; err=%i", result);
 		return (result);
 	}
+	if (isDrawOnDemandEnabled) {
+		drawWakeEventType = SDL_RegisterEvents (1);
+		if (drawWakeEventType == ((Uint32) -1)) {
+			Log::warning ("Failed to register draw wake event, idle frames will not be skipped");
+			isDrawOnDemandEnabled = false;
+		}
+	}
 
 	result = SDL_GetDisplayDPI (0, &displayDdpi, &displayHdpi, &displayVdpi);
 	if (result != 0) {
@@ -451,6 +649,26 @@ int App::runWindow () {
 		Log::err ("Failed to create application window: %s", SDL_GetError ());
 		return (OsUtil::SdlOperationFailedError);
 	}
+	if (isVsyncEnabled) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		if (SDL_RenderSetVSync (render, 1) != 0) {
+			Log::warning ("Failed to enable vsync: %s", SDL_GetError ());
+			isVsyncEnabled = false;
+		}
+#else
+		Log::warning ("Failed to enable vsync: not supported by SDL version");
+		isVsyncEnabled = false;
+#endif
+	}
+
+	// Pace draw frames to the display's refresh rate unless a frame delay was configured explicitly
+	drawFramePeriod = minDrawFrameDelay * 1000;
+	if (isDrawFrameDelayDefault) {
+		if ((SDL_GetWindowDisplayMode (window, &displaymode) == 0) && (displaymode.refresh_rate > 0)) {
+			drawFramePeriod = 1000000 / displaymode.refresh_rate;
+			minDrawFrameDelay = drawFramePeriod / 1000;
+		}
+	}
 	result = SDL_GetRendererInfo (render, &renderinfo);
 	if (result != 0) {
 		Log::err ("Failed to create application renderer: %s", SDL_GetError ());
@@ -459,6 +677,10 @@ int App::runWindow () {
 	if ((renderinfo.flags & (SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE)) == (SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE)) {
 		isTextureRenderEnabled = true;
 	}
+	if (! isTextureRenderEnabled) {
+		isPartialDrawEnabled = false;
+		isTextureCacheEnabled = false;
+	}
 	if (isTextureRenderEnabled) {
 		isInterfaceAnimationEnabled = prefsMap.find (App::ShowInterfaceAnimationsKey, true);
 	}
@@ -478,6 +700,12 @@ int App::runWindow () {
 	}
 
 	SDL_SetWindowTitle (window, APPLICATION_NAME);
+	return (OsUtil::Success);
+}
+
+int App::loadUiResources () {
+	int result;
+
 	uiConfig.resetScale ();
 	result = uiConfig.load (fontScale);
 	if (result != OsUtil::Success) {
@@ -485,10 +713,45 @@ int App::runWindow () {
 		return (result);
 	}
 	populateRoundedCornerSprite ();
+	return (OsUtil::Success);
+}
+
+int App::createUi () {
 	populateWidgets ();
+	uiStack.setUi (new MainUi ());
+	return (OsUtil::Success);
+}
+
+void App::writeStartupTrace (int64_t firstFrameTime) {
+	if (! startupTraceJson) {
+		return;
+	}
+	startupTraceJson->set ("buildId", BUILD_ID);
+	startupTraceJson->set ("isConsole", isConsole);
+	if (firstFrameTime > 0) {
+		startupTraceJson->set ("firstFrame", (int64_t) (firstFrameTime - startTime));
+	}
+	Log::info ("Startup trace: %s", startupTraceJson->toString ().c_str ());
+	delete (startupTraceJson);
+	startupTraceJson = NULL;
+}
+
+int App::runWindow () {
+	SDL_version version1, version2;
+	SDL_RendererInfo renderinfo;
+	StdString text;
+	int result, delay, i, frameperiod;
+	int64_t endtime, elapsed;
+	Uint64 perffrequency, nextframetime, now, sectiontime;
+	Uint32 windowflags;
+	double fps;
+	bool isdirty, shoulddraw, shouldwait, ishidden;
 
-	ui = new MainUi ();
-	uiStack.setUi (ui);
+	result = SDL_GetRendererInfo (render, &renderinfo);
+	if (result != 0) {
+		Log::err ("Failed to create application renderer: %s", SDL_GetError ());
+		return (OsUtil::SdlOperationFailedError);
+	}
 
 	updateThread = SDL_CreateThread (App::runUpdateThread, "runUpdateThread", (void *) this);
 
@@ -496,7 +759,7 @@ int App::runWindow () {
 	windowflags = SDL_GetWindowFlags (window);
 	SDL_VERSION (&version1);
 	SDL_GetVersion (&version2);
-	Log::debug ("* sdlBuildVersion=%i.%i.%i sdlLinkVersion=%i.%i.%i windowFlags=0x%x renderName=%s renderFlags=0x%x isTextureRenderEnabled=%s diagonalDpi=%.2f horizontalDpi=%.2f verticalDpi=%.2f imageScale=%i minDrawFrameDelay=%i minUpdateFrameDelay=%i", version1.major, version1.minor, version1.patch, version2.major, version2.minor, version2.patch, (unsigned int) windowflags, renderinfo.name, (unsigned int) renderinfo.flags, BOOL_STRING (isTextureRenderEnabled), displayDdpi, displayHdpi, displayVdpi, imageScale, minDrawFrameDelay, minUpdateFrameDelay);
+	Log::debug ("* sdlBuildVersion=%i.%i.%i sdlLinkVersion=%i.%i.%i windowFlags=0x%x renderName=%s renderFlags=0x%x isTextureRenderEnabled=%s isPartialDrawEnabled=%s isDrawBatchEnabled=%s isTextureCacheEnabled=%s isSpriteAtlasEnabled=%s isStartupTraceEnabled=%s diagonalDpi=%.2f horizontalDpi=%.2f verticalDpi=%.2f imageScale=%i minDrawFrameDelay=%i drawFramePeriod=%ius isVsyncEnabled=%s minUpdateFrameDelay=%i isDrawOnDemandEnabled=%s maxIdleFrameDelay=%i", version1.major, version1.minor, version1.patch, version2.major, version2.minor, version2.patch, (unsigned int) windowflags, renderinfo.name, (unsigned int) renderinfo.flags, BOOL_STRING (isTextureRenderEnabled), BOOL_STRING (isPartialDrawEnabled), BOOL_STRING (isDrawBatchEnabled), BOOL_STRING (isTextureCacheEnabled), BOOL_STRING (isSpriteAtlasEnabled), BOOL_STRING (isStartupTraceEnabled), displayDdpi, displayHdpi, displayVdpi, imageScale, minDrawFrameDelay, drawFramePeriod, BOOL_STRING (isVsyncEnabled), minUpdateFrameDelay, BOOL_STRING (isDrawOnDemandEnabled), maxIdleFrameDelay);
 
 	text.assign ("");
 	if (windowflags & SDL_WINDOW_FULLSCREEN) {
@@ -583,19 +846,36 @@ int App::runWindow () {
 	Log::debug3 ("* Render flags:%s", text.c_str ());
 	text.assign ("");
 
+	perffrequency = SDL_GetPerformanceFrequency ();
+	nextframetime = SDL_GetPerformanceCounter ();
 	while (true) {
 		if (isShutdown) {
 			break;
 		}
 
-		t1 = OsUtil::getTime ();
+		sectiontime = profiler.beginSection ();
 		input.pollEvents ();
+		profiler.endSection (Profiler::PollEventsSection, sectiontime);
+
+		// Throttle the frame rate while the window is hidden, minimized, or not focused
+		windowflags = SDL_GetWindowFlags (window);
+		ishidden = (windowflags & (SDL_WINDOW_HIDDEN | SDL_WINDOW_MINIMIZED)) ? true : false;
+		if (ishidden) {
+			frameThrottleDelay = App::HiddenMinFrameDelay;
+		}
+		else if (! (windowflags & SDL_WINDOW_INPUT_FOCUS)) {
+			frameThrottleDelay = App::UnfocusedMinFrameDelay;
+		}
+		else {
+			frameThrottleDelay = 0;
+		}
 		if (! FLOAT_EQUALS (fontScale, nextFontScale)) {
 			if (uiConfig.reloadFonts (nextFontScale) != OsUtil::Success) {
 				nextFontScale = fontScale;
 			}
 			else {
 				shouldRefreshUi = true;
+				setDrawDirty ();
 				fontScale = nextFontScale;
 				for (i = 0; i < App::FontScaleCount; ++i) {
 					if (FLOAT_EQUALS (fontScale, App::FontScales[i])) {
@@ -608,20 +888,92 @@ int App::runWindow () {
 			}
 		}
 
+		SDL_LockMutex (drawDirtyMutex);
+		isRenderTaskPending = false;
+		SDL_UnlockMutex (drawDirtyMutex);
+		sectiontime = profiler.beginSection ();
 		executeRenderTasks ();
-		draw ();
+		profiler.endSection (Profiler::RenderTasksSection, sectiontime);
+		SDL_LockMutex (drawDirtyMutex);
+		isdirty = isDrawDirty;
+		shouldDrawFull = isDrawFullDamage;
+		drawRectList.swap (drawDamageList);
+		isDrawDirty = false;
+		isDrawFullDamage = false;
+		drawDamageList.clear ();
+		SDL_UnlockMutex (drawDirtyMutex);
+
+		shoulddraw = isDrawOnDemandEnabled ? isdirty : true;
+		if (ishidden) {
+			shoulddraw = false;
+		}
+		if (shoulddraw) {
+			sectiontime = profiler.beginSection ();
+			draw ();
+			profiler.endSection (Profiler::DrawSection, sectiontime);
+			if (startupTraceJson) {
+				writeStartupTrace (OsUtil::getTime ());
+			}
+			profiler.endCounterFrame (Profiler::RenderCallCounter);
+			profiler.endCounterFrame (Profiler::TextureUploadCounter);
+			profiler.endCounterFrame (Profiler::WidgetDrawCounter);
+		}
+		else {
+			++skipDrawCount;
+		}
+		drawRectList.clear ();
 		if ((windowWidth != nextWindowWidth) || (windowHeight != nextWindowHeight)) {
 			resizeWindow ();
 		}
 		uiStack.executeStackCommands ();
+		sectiontime = profiler.beginSection ();
 		resource.compact ();
+		profiler.endSection (Profiler::ResourceCompactSection, sectiontime);
 
-		t2 = OsUtil::getTime ();
-		delay = (int) (minDrawFrameDelay - (t2 - t1));
-		if (delay < 1) {
-			delay = 1;
+		if (isVsyncEnabled && shoulddraw && (frameThrottleDelay <= 0)) {
+			// SDL_RenderPresent has already blocked until the display's vertical blank
+			nextframetime = SDL_GetPerformanceCounter ();
+		}
+		else {
+			// Schedule frames against absolute deadlines, so that sleep granularity doesn't accumulate into frame time drift
+			frameperiod = drawFramePeriod;
+			if (frameperiod < (frameThrottleDelay * 1000)) {
+				frameperiod = frameThrottleDelay * 1000;
+			}
+			nextframetime += ((Uint64) frameperiod) * perffrequency / 1000000;
+			now = SDL_GetPerformanceCounter ();
+			if (nextframetime <= now) {
+				// The frame overran its deadline; restart the schedule from the current time rather than rushing to catch up
+				nextframetime = now;
+			}
+			else {
+				delay = (int) ((nextframetime - now) * 1000 / perffrequency);
+				if (delay > 0) {
+					SDL_Delay ((Uint32) delay);
+				}
+			}
+		}
+
+		if (isDrawOnDemandEnabled && (! shoulddraw)) {
+			// Nothing changed during this frame; block until an input event or a draw wakeup arrives. A nonzero idle frame delay bounds the wait, and its timeout only runs the loop again, drawing only if something became dirty.
+			SDL_LockMutex (drawDirtyMutex);
+			// An active animation adds damage on every update, so skip the wait rather than sleeping until the next damage wakes the draw loop
+			shouldwait = (! isDrawDirty) && (! isRenderTaskPending) && (! animationTimeline.isActive ());
+			isDrawWaiting = shouldwait;
+			SDL_UnlockMutex (drawDirtyMutex);
+			if (shouldwait) {
+				if (maxIdleFrameDelay > 0) {
+					SDL_WaitEventTimeout (NULL, maxIdleFrameDelay);
+				}
+				else {
+					SDL_WaitEvent (NULL);
+				}
+				SDL_LockMutex (drawDirtyMutex);
+				isDrawWaiting = false;
+				SDL_UnlockMutex (drawDirtyMutex);
+				nextframetime = SDL_GetPerformanceCounter ();
+			}
 		}
-		SDL_Delay (delay);
 	}
 	SDL_WaitThread (updateThread, &result);
 
@@ -636,6 +988,16 @@ int App::runWindow () {
 		nextBackgroundTexturePath.assign ("");
 	}
 
+	if (backTexture) {
+		if (renderTarget == backTexture) {
+			SDL_SetRenderTarget (render, NULL);
+			renderTarget = NULL;
+		}
+		backTexture = NULL;
+		resource.unloadTexture (backTexturePath);
+		backTexturePath.assign ("");
+	}
+
 	uiStack.clear ();
 	if (rootPanel) {
 		rootPanel->release ();
@@ -660,7 +1022,7 @@ int App::runWindow () {
 	if (elapsed > 1000) {
 		fps /= ((double) elapsed) / 1000.0f;
 	}
-	Log::info ("Application ended; updateCount=%lli drawCount=%lli runtime=%.3fs FPS=%f pid=%i", (long long) updateCount, (long long) drawCount, ((double) elapsed) / 1000.0f, fps, OsUtil::getProcessId ());
+	Log::info ("Application ended; updateCount=%lli drawCount=%lli skipDrawCount=%lli runtime=%.3fs FPS=%f pid=%i", (long long) updateCount, (long long) drawCount, (long long) skipDrawCount, ((double) elapsed) / 1000.0f, fps, OsUtil::getProcessId ());
 
 	return (OsUtil::Success);
 }
@@ -861,8 +1223,143 @@ SDL_Texture *App::getRoundedCornerTexture (int radius, int *textureWidth, int *t
 	return (roundedCornerSprite->getTexture ((radius - 1), textureWidth, textureHeight));
 }
 
+void App::addDrawBatchQuad (SDL_Texture *texture, const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	SDL_Vertex vertex;
+	SDL_Rect drawrect;
+	float u0, v0, u1, v1;
+	int index;
+
+	if ((! isDrawBatchEmpty) && (texture != drawBatchTexture)) {
+		flushDrawBatch ();
+	}
+
+	// Geometry drawn to the back texture is clipped here, since the batch renders with the clip rectangle disabled and may outlive the clip rectangle that was active when the quad was added
+	drawrect = rect;
+	u0 = 0.0f;
+	v0 = 0.0f;
+	u1 = 1.0f;
+	v1 = 1.0f;
+	if ((renderTarget == backTexture) && (! clipRectStack.empty ()) && (! isClipRectSuspended)) {
+		if (! SDL_IntersectRect (&rect, &clipRect, &drawrect)) {
+			return;
+		}
+		u0 = ((float) (drawrect.x - rect.x)) / (float) rect.w;
+		v0 = ((float) (drawrect.y - rect.y)) / (float) rect.h;
+		u1 = ((float) (drawrect.x + drawrect.w - rect.x)) / (float) rect.w;
+		v1 = ((float) (drawrect.y + drawrect.h - rect.y)) / (float) rect.h;
+	}
+
+	index = (int) drawBatchVertices.size ();
+	vertex.color.r = r;
+	vertex.color.g = g;
+	vertex.color.b = b;
+	vertex.color.a = a;
+
+	vertex.position.x = (float) drawrect.x;
+	vertex.position.y = (float) drawrect.y;
+	vertex.tex_coord.x = u0;
+	vertex.tex_coord.y = v0;
+	drawBatchVertices.push_back (vertex);
+
+	vertex.position.x = (float) (drawrect.x + drawrect.w);
+	vertex.tex_coord.x = u1;
+	drawBatchVertices.push_back (vertex);
+
+	vertex.position.y = (float) (drawrect.y + drawrect.h);
+	vertex.tex_coord.y = v1;
+	drawBatchVertices.push_back (vertex);
+
+	vertex.position.x = (float) drawrect.x;
+	vertex.tex_coord.x = u0;
+	drawBatchVertices.push_back (vertex);
+
+	drawBatchIndices.push_back (index);
+	drawBatchIndices.push_back (index + 1);
+	drawBatchIndices.push_back (index + 2);
+	drawBatchIndices.push_back (index);
+	drawBatchIndices.push_back (index + 2);
+	drawBatchIndices.push_back (index + 3);
+	drawBatchTexture = texture;
+	isDrawBatchEmpty = false;
+}
+
+void App::addDrawBatchRect (const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	if ((rect.w <= 0) || (rect.h <= 0)) {
+		return;
+	}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (isDrawBatchEnabled) {
+		addDrawBatchQuad (NULL, rect, r, g, b, a);
+		return;
+	}
+#endif
+	if (a < 255) {
+		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_BLEND);
+	}
+	SDL_SetRenderDrawColor (render, r, g, b, a);
+	SDL_RenderFillRect (render, &rect);
+	if (a < 255) {
+		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_NONE);
+	}
+	SDL_SetRenderDrawColor (render, 0, 0, 0, 0);
+}
+
+void App::addDrawBatchTexture (SDL_Texture *texture, const SDL_Rect &destRect, Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+	if ((! texture) || (destRect.w <= 0) || (destRect.h <= 0)) {
+		return;
+	}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (isDrawBatchEnabled) {
+		addDrawBatchQuad (texture, destRect, r, g, b, a);
+		return;
+	}
+#endif
+	SDL_SetTextureColorMod (texture, r, g, b);
+	SDL_SetTextureAlphaMod (texture, a);
+	SDL_SetTextureBlendMode (texture, SDL_BLENDMODE_BLEND);
+	SDL_RenderCopy (render, texture, NULL, &destRect);
+	Profiler::instance->addCount (Profiler::RenderCallCounter);
+	SDL_SetTextureAlphaMod (texture, 255);
+}
+
+void App::flushDrawBatch () {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	bool isclipped;
+
+	if (isDrawBatchEmpty) {
+		return;
+	}
+	isclipped = (renderTarget == backTexture) && (! clipRectStack.empty ()) && (! isClipRectSuspended);
+	if (isclipped) {
+		SDL_RenderSetClipRect (render, NULL);
+	}
+	if (drawBatchTexture) {
+		// Vertex colors carry the modulation for textured geometry, replacing any color mod left on the texture
+		SDL_SetTextureColorMod (drawBatchTexture, 255, 255, 255);
+		SDL_SetTextureAlphaMod (drawBatchTexture, 255);
+		SDL_SetTextureBlendMode (drawBatchTexture, SDL_BLENDMODE_BLEND);
+	}
+	else {
+		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_BLEND);
+	}
+	SDL_RenderGeometry (render, drawBatchTexture, &(drawBatchVertices.front ()), (int) drawBatchVertices.size (), &(drawBatchIndices.front ()), (int) drawBatchIndices.size ());
+	Profiler::instance->addCount (Profiler::RenderCallCounter);
+	if (! drawBatchTexture) {
+		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_NONE);
+	}
+	if (isclipped) {
+		SDL_RenderSetClipRect (render, &clipRect);
+	}
+	drawBatchVertices.clear ();
+	drawBatchIndices.clear ();
+	drawBatchTexture = NULL;
+	isDrawBatchEmpty = true;
+#endif
+}
+
 void App::shutdown () {
 	Ui *ui;
+	int result;
 
 	if (isConsole) {
 		isShutdown = true;
@@ -879,6 +1376,10 @@ void App::shutdown () {
 		ui->showShutdownWindow ();
 		ui->release ();
 	}
+	result = recordStore.writeSnapshotFile ();
+	if (result != OsUtil::Success) {
+		Log::debug ("Failed to write record snapshot file; err=%i", result);
+	}
 	agentControl.stop ();
 	taskGroup.stop ();
 	network.stop ();
@@ -906,6 +1407,9 @@ void App::executeRenderTasks () {
 	renderTaskList.swap (renderTaskAddList);
 	SDL_UnlockMutex (renderTaskMutex);
 
+	if (renderTaskList.empty ()) {
+		return;
+	}
 	i = renderTaskList.begin ();
 	end = renderTaskList.end ();
 	while (i != end) {
@@ -916,11 +1420,53 @@ void App::executeRenderTasks () {
 }
 
 void App::draw () {
+	std::vector<SDL_Rect>::iterator i, end;
+
+	if (isPartialDrawEnabled && (! resetBackTexture ())) {
+		Log::warning ("Failed to create window backbuffer texture, partial draw disabled");
+		isPartialDrawEnabled = false;
+	}
+	if (! isPartialDrawEnabled) {
+		SDL_RenderClear (render);
+		drawWindow ();
+		SDL_RenderPresent (render);
+		++drawCount;
+		return;
+	}
+
+	setRenderTarget (backTexture);
+	if (shouldDrawFull) {
+		SDL_RenderClear (render);
+		drawWindow ();
+	}
+	else {
+		i = drawRectList.begin ();
+		end = drawRectList.end ();
+		while (i != end) {
+			drawDamageClipRect = *i;
+			isDrawDamageClipActive = true;
+			pushClipRect (&drawDamageClipRect, true);
+			SDL_SetRenderDrawColor (render, 0, 0, 0, 0);
+			SDL_RenderFillRect (render, &drawDamageClipRect);
+			drawWindow ();
+			popClipRect ();
+			isDrawDamageClipActive = false;
+			++i;
+		}
+	}
+
+	SDL_SetRenderTarget (render, NULL);
+	renderTarget = NULL;
+	SDL_RenderCopy (render, backTexture, NULL, NULL);
+	Profiler::instance->addCount (Profiler::RenderCallCounter);
+	SDL_RenderPresent (render);
+	++drawCount;
+}
+
+void App::drawWindow () {
 	Ui *ui;
 	SDL_Rect rect;
 
-	SDL_RenderClear (render);
-
 	SDL_LockMutex (backgroundMutex);
 	if (! nextBackgroundTexturePath.empty ()) {
 		if (! nextBackgroundTexture) {
@@ -945,6 +1491,7 @@ void App::draw () {
 		rect.h = backgroundTextureHeight;
 		SDL_SetTextureBlendMode (backgroundTexture, SDL_BLENDMODE_NONE);
 		SDL_RenderCopy (render, backgroundTexture, NULL, &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 
 		rect.x = 0;
 		rect.y = 0;
@@ -953,6 +1500,7 @@ void App::draw () {
 		SDL_SetTextureBlendMode (nextBackgroundTexture, SDL_BLENDMODE_BLEND);
 		SDL_SetTextureAlphaMod (nextBackgroundTexture, (Uint8) (backgroundCrossFadeAlpha * 255.0f));
 		SDL_RenderCopy (render, nextBackgroundTexture, NULL, &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 	}
 	else if (nextBackgroundTexture) {
 		rect.x = 0;
@@ -961,6 +1509,7 @@ void App::draw () {
 		rect.h = nextBackgroundTextureHeight;
 		SDL_SetTextureBlendMode (nextBackgroundTexture, SDL_BLENDMODE_NONE);
 		SDL_RenderCopy (render, nextBackgroundTexture, NULL, &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 	}
 	else if (backgroundTexture) {
 		rect.x = 0;
@@ -969,6 +1518,7 @@ void App::draw () {
 		rect.h = backgroundTextureHeight;
 		SDL_SetTextureBlendMode (backgroundTexture, SDL_BLENDMODE_NONE);
 		SDL_RenderCopy (render, backgroundTexture, NULL, &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 	}
 	SDL_UnlockMutex (backgroundMutex);
 
@@ -978,17 +1528,45 @@ void App::draw () {
 		rootPanel->draw ();
 		ui->release ();
 	}
-	SDL_RenderPresent (render);
-	++drawCount;
+	flushDrawBatch ();
+}
+
+bool App::resetBackTexture () {
+	if (backTexture && (backTextureWidth == windowWidth) && (backTextureHeight == windowHeight)) {
+		return (true);
+	}
+	if (backTexture) {
+		if (renderTarget == backTexture) {
+			SDL_SetRenderTarget (render, NULL);
+			renderTarget = NULL;
+		}
+		backTexture = NULL;
+		resource.unloadTexture (backTexturePath);
+		backTexturePath.assign ("");
+	}
+
+	backTexturePath.sprintf ("*_App::backTexture_%llx", (long long int) getUniqueId ());
+	backTexture = resource.createTexture (backTexturePath, windowWidth, windowHeight);
+	if (! backTexture) {
+		backTexturePath.assign ("");
+		return (false);
+	}
+	backTextureWidth = windowWidth;
+	backTextureHeight = windowHeight;
+	SDL_SetTextureBlendMode (backTexture, SDL_BLENDMODE_NONE);
+	shouldDrawFull = true;
+	return (true);
 }
 
 int App::runUpdateThread (void *appPtr) {
 	App *app;
 	StdString line;
 	int64_t t1, t2, last;
+	Uint64 sectiontime;
 	int delay;
 
 	app = (App *) appPtr;
+	app->updateThreadId = SDL_ThreadID ();
 
 	line = OsUtil::getEnvValue ("RUN_SCRIPT", "");
 	if (! line.empty ()) {
@@ -1003,11 +1581,18 @@ int App::runUpdateThread (void *appPtr) {
 		}
 
 		t1 = OsUtil::getTime ();
+		sectiontime = app->profiler.beginSection ();
 		app->update ((int) (t1 - last));
+		app->profiler.endSection (Profiler::UpdateSection, sectiontime);
+		app->profiler.endCounterFrame (Profiler::WidgetUpdateCounter);
 		t2 = OsUtil::getTime ();
 		last = t1;
 
-		delay = (int) (app->minUpdateFrameDelay - (t2 - t1));
+		delay = app->minUpdateFrameDelay;
+		if (delay < app->frameThrottleDelay) {
+			delay = app->frameThrottleDelay;
+		}
+		delay -= (int) (t2 - t1);
 		if (delay < 1) {
 			delay = 1;
 		}
@@ -1019,10 +1604,14 @@ int App::runUpdateThread (void *appPtr) {
 
 void App::update (int msElapsed) {
 	Ui *ui;
+	RecordStore::ChangeSet changes;
+	Uint64 sectiontime;
 
 	agentControl.update (msElapsed);
 	taskGroup.update (msElapsed);
+	sectiontime = profiler.beginSection ();
 	uiStack.update (msElapsed);
+	profiler.endSection (Profiler::UiStackUpdateSection, sectiontime);
 	if (shouldRefreshUi) {
 		uiStack.refresh ();
 		rootPanel->refresh ();
@@ -1031,17 +1620,27 @@ void App::update (int msElapsed) {
 	ui = uiStack.getActiveUi ();
 
 	if (shouldSyncRecordStore) {
-		recordStore.lock ();
-		rootPanel->syncRecordStore ();
+		sectiontime = profiler.beginSection ();
+		recordStore.lock (true);
+		recordStore.getChanges (recordStoreVersion, &changes);
+		recordStoreVersion = changes.version;
+		if (changes.isFullSync) {
+			rootPanel->syncRecordStore ();
+		}
+		else if (! changes.recordIds.empty ()) {
+			rootPanel->syncRecordStoreChanges (changes);
+		}
 		if (ui) {
 			ui->syncRecordStore ();
 		}
 		recordStore.unlock ();
+		profiler.endSection (Profiler::SyncRecordStoreSection, sectiontime);
 		shouldSyncRecordStore = false;
 	}
 
 	SDL_LockMutex (backgroundMutex);
 	if (nextBackgroundTexture) {
+		setDrawDirty ();
 		if (uiConfig.backgroundCrossFadeDuration <= 0) {
 			backgroundCrossFadeAlpha = 1.0f;
 		}
@@ -1067,13 +1666,20 @@ void App::update (int msElapsed) {
 	SDL_UnlockMutex (backgroundMutex);
 
 	rootPanel->processInput ();
+	// Input that changes widget state adds damage through those widgets, but window events such as exposure can invalidate the entire window
+	if (input.windowEventCount != lastWindowEventCount) {
+		lastWindowEventCount = input.windowEventCount;
+		setDrawDirty ();
+	}
 	if (ui) {
 		ui->update (msElapsed);
 		ui->release ();
 	}
+	animationTimeline.update (msElapsed);
 	rootPanel->update (msElapsed, 0.0f, 0.0f);
 
 	writePrefs ();
+	recordStore.updateSnapshotFile ();
 	++updateCount;
 
 	SDL_LockMutex (updateMutex);
@@ -1115,6 +1721,10 @@ bool App::keyEvent (void *ptr, SDL_Keycode keycode, bool isShiftDown, bool isCon
 				App::instance->uiStack.toggleConsoleWindow ();
 				return (true);
 			}
+			case SDLK_p: {
+				App::instance->uiStack.toggleProfilerWindow ();
+				return (true);
+			}
 		}
 	}
 
@@ -1152,6 +1762,10 @@ void App::unsuspendUpdate () {
 void App::pushClipRect (const SDL_Rect *rect, bool disableIntersection) {
 	int x, y, w, h, diff;
 
+	// Batched geometry for the back texture is already clipped, so only other render targets need the batch submitted under the previous clip rectangle
+	if (renderTarget != backTexture) {
+		flushDrawBatch ();
+	}
 	x = rect->x;
 	y = rect->y;
 	w = rect->w;
@@ -1188,6 +1802,12 @@ void App::pushClipRect (const SDL_Rect *rect, bool disableIntersection) {
 	clipRect.y = y;
 	clipRect.w = w;
 	clipRect.h = h;
+	if (isDrawDamageClipActive) {
+		if (! SDL_IntersectRect (&clipRect, &drawDamageClipRect, &clipRect)) {
+			clipRect.w = 0;
+			clipRect.h = 0;
+		}
+	}
 	SDL_RenderSetClipRect (render, &clipRect);
 	clipRectStack.push (clipRect);
 }
@@ -1197,6 +1817,9 @@ void App::popClipRect () {
 		return;
 	}
 
+	if (renderTarget != backTexture) {
+		flushDrawBatch ();
+	}
 	clipRectStack.pop ();
 	if (clipRectStack.empty ()) {
 		clipRect.x = 0;
@@ -1212,15 +1835,20 @@ void App::popClipRect () {
 }
 
 void App::suspendClipRect () {
+	flushDrawBatch ();
+	isClipRectSuspended = true;
 	SDL_RenderSetClipRect (render, NULL);
 }
 
 void App::unsuspendClipRect () {
+	flushDrawBatch ();
+	isClipRectSuspended = false;
 	SDL_RenderSetClipRect (render, &clipRect);
 }
 
 void App::addRenderTask (RenderTaskFunction fn, void *fnData) {
 	App::RenderTaskContext ctx;
+	bool shouldwake;
 
 	if (! fn) {
 		return;
@@ -1230,6 +1858,165 @@ void App::addRenderTask (RenderTaskFunction fn, void *fnData) {
 	SDL_LockMutex (renderTaskMutex);
 	renderTaskAddList.push_back (ctx);
 	SDL_UnlockMutex (renderTaskMutex);
+
+	// Render tasks add damage for any widget they change, so the draw loop only needs to wake and execute them
+	SDL_LockMutex (drawDirtyMutex);
+	isRenderTaskPending = true;
+	shouldwake = isDrawWaiting;
+	SDL_UnlockMutex (drawDirtyMutex);
+	if (shouldwake) {
+		wakeDraw ();
+	}
+}
+
+void App::setDrawDirty () {
+	bool shouldwake;
+
+	shouldwake = false;
+	SDL_LockMutex (drawDirtyMutex);
+	if (! isDrawFullDamage) {
+		isDrawFullDamage = true;
+		drawDamageList.clear ();
+		if (! isDrawDirty) {
+			isDrawDirty = true;
+			shouldwake = isDrawWaiting;
+		}
+	}
+	SDL_UnlockMutex (drawDirtyMutex);
+
+	if (shouldwake) {
+		wakeDraw ();
+	}
+}
+
+void App::addDrawDamage (const Widget::Rectangle &rect) {
+	std::vector<SDL_Rect>::iterator i, end;
+	SDL_Rect damagerect;
+	int x1, y1, x2, y2;
+	bool shouldwake, found;
+
+	x1 = ((int) floorf (rect.x)) - 1;
+	y1 = ((int) floorf (rect.y)) - 1;
+	x2 = ((int) ceilf (rect.x + rect.w)) + 1;
+	y2 = ((int) ceilf (rect.y + rect.h)) + 1;
+	if (x1 < 0) {
+		x1 = 0;
+	}
+	if (y1 < 0) {
+		y1 = 0;
+	}
+	if (x2 > windowWidth) {
+		x2 = windowWidth;
+	}
+	if (y2 > windowHeight) {
+		y2 = windowHeight;
+	}
+	if ((x2 <= x1) || (y2 <= y1)) {
+		return;
+	}
+
+	shouldwake = false;
+	SDL_LockMutex (drawDirtyMutex);
+	if (! isDrawFullDamage) {
+		// Merge the new rectangle with any damage rectangles it overlaps
+		while (true) {
+			found = false;
+			i = drawDamageList.begin ();
+			end = drawDamageList.end ();
+			while (i != end) {
+				if ((x1 <= (i->x + i->w)) && (i->x <= x2) && (y1 <= (i->y + i->h)) && (i->y <= y2)) {
+					found = true;
+					if (i->x < x1) {
+						x1 = i->x;
+					}
+					if (i->y < y1) {
+						y1 = i->y;
+					}
+					if ((i->x + i->w) > x2) {
+						x2 = i->x + i->w;
+					}
+					if ((i->y + i->h) > y2) {
+						y2 = i->y + i->h;
+					}
+					drawDamageList.erase (i);
+					break;
+				}
+				++i;
+			}
+			if (! found) {
+				break;
+			}
+		}
+
+		if (((int) drawDamageList.size ()) >= App::MaxDrawDamageRects) {
+			i = drawDamageList.begin ();
+			end = drawDamageList.end ();
+			while (i != end) {
+				if (i->x < x1) {
+					x1 = i->x;
+				}
+				if (i->y < y1) {
+					y1 = i->y;
+				}
+				if ((i->x + i->w) > x2) {
+					x2 = i->x + i->w;
+				}
+				if ((i->y + i->h) > y2) {
+					y2 = i->y + i->h;
+				}
+				++i;
+			}
+			drawDamageList.clear ();
+		}
+
+		damagerect.x = x1;
+		damagerect.y = y1;
+		damagerect.w = x2 - x1;
+		damagerect.h = y2 - y1;
+		drawDamageList.push_back (damagerect);
+		if (! isDrawDirty) {
+			isDrawDirty = true;
+			shouldwake = isDrawWaiting;
+		}
+	}
+	SDL_UnlockMutex (drawDirtyMutex);
+
+	if (shouldwake) {
+		wakeDraw ();
+	}
+}
+
+void App::addDrawDamage () {
+	if (updateWidget && (SDL_ThreadID () == updateThreadId)) {
+		updateWidget->addDrawDamage ();
+		return;
+	}
+	setDrawDirty ();
+}
+
+void App::wakeDraw () {
+	SDL_Event event;
+
+	SDL_zero (event);
+	event.type = drawWakeEventType;
+	SDL_PushEvent (&event);
+}
+
+void App::setRenderTarget (SDL_Texture *texture) {
+	if (! texture) {
+		texture = backTexture;
+	}
+	if (texture == renderTarget) {
+		return;
+	}
+	flushDrawBatch ();
+	SDL_SetRenderTarget (render, texture);
+	renderTarget = texture;
+
+	// Changing the render target resets the clip rectangle, which must be restored for the default target
+	if ((texture == backTexture) && (! clipRectStack.empty ())) {
+		SDL_RenderSetClipRect (render, &clipRect);
+	}
 }
 
 void App::setConsoleWindow (ConsoleWindow *window) {
@@ -1315,6 +2102,7 @@ void App::resizeWindow () {
 	uiStack.resize ();
 	rootPanel->resetInputState ();
 	shouldRefreshUi = true;
+	setDrawDirty ();
 	unsuspendUpdate ();
 
 	SDL_LockMutex (prefsMapMutex);
@@ -1354,6 +2142,7 @@ void App::setNextBackgroundTexturePath (const StdString &path) {
 		nextBackgroundTexturePath.assign (filepath);
 	}
 	SDL_UnlockMutex (backgroundMutex);
+	setDrawDirty ();
 }
 
 void App::setNextBackgroundTexturePath (const char *path) {
@@ -39,11 +39,14 @@
 #include "Log.h"
 #include "Input.h"
 #include "TaskGroup.h"
+#include "TaskGraph.h"
 #include "Resource.h"
 #include "Network.h"
 #include "Json.h"
 #include "HashMap.h"
 #include "Prng.h"
+#include "Profiler.h"
+#include "AnimationTimeline.h"
 #include "UiStack.h"
 #include "UiText.h"
 #include "UiConfiguration.h"
@@ -70,6 +73,10 @@ public:
 	static void freeInstance ();
 
 	static const int DefaultMinFrameDelay;
+	static const int DefaultMaxIdleFrameDelay;
+	static const int UnfocusedMinFrameDelay;
+	static const int HiddenMinFrameDelay;
+	static const int MaxDrawDamageRects;
 	static const int WindowWidths[];
 	static const int WindowHeights[];
 	static const int WindowSizeCount;
@@ -91,6 +98,8 @@ public:
 	// Read-write data members
 	Log log;
 	Prng prng;
+	Profiler profiler;
+	AnimationTimeline animationTimeline;
 	Input input;
 	TaskGroup taskGroup;
 	UiStack uiStack;
@@ -113,6 +122,7 @@ public:
 	bool shouldSyncRecordStore;
 	bool isMainToolbarClockEnabled;
 	bool isNetworkActive;
+	Widget *updateWidget; // The widget currently executing its update method on the update thread, or NULL if no widget update is in progress
 
 	// Read-only data members
 	bool isShuttingDown;
@@ -122,6 +132,11 @@ public:
 	SDL_Window *window;
 	SDL_Renderer *render; // The renderer must be accessed only from the application's main thread
 	bool isTextureRenderEnabled;
+	bool isPartialDrawEnabled;
+	bool isDrawBatchEnabled;
+	bool isTextureCacheEnabled;
+	bool isSpriteAtlasEnabled;
+	bool isStartupTraceEnabled;
 	Panel *rootPanel;
 	float displayDdpi;
 	float displayHdpi;
@@ -129,10 +144,15 @@ public:
 	int windowWidth;
 	int windowHeight;
 	int minDrawFrameDelay; // milliseconds
+	int drawFramePeriod; // microseconds
+	bool isVsyncEnabled;
 	int minUpdateFrameDelay; // milliseconds
+	bool isDrawOnDemandEnabled;
+	int maxIdleFrameDelay; // milliseconds, or zero to wait indefinitely for input or a draw wakeup while idle
 	float fontScale;
 	int imageScale;
 	int64_t drawCount;
+	int64_t skipDrawCount;
 	int64_t updateCount;
 	SDL_Rect clipRect;
 	bool isPrefsWriteDisabled;
@@ -158,6 +178,18 @@ public:
 	// Unsuspend the application's update thread after a previous call to suspendUpdate
 	void unsuspendUpdate ();
 
+	// Indicate that application state has changed in a way that requires the entire window to be redrawn, waking the render loop if it's idle
+	void setDrawDirty ();
+
+	// Add the provided screen rectangle to the set of window areas that must be redrawn, waking the render loop if it's idle
+	void addDrawDamage (const Widget::Rectangle &rect);
+
+	// Add draw damage covering the widget executing an update on the update thread, or the entire window if no such widget is known
+	void addDrawDamage ();
+
+	// Set the renderer's target texture. A NULL texture selects the default target, which is the window backbuffer texture if partial draw is enabled.
+	void setRenderTarget (SDL_Texture *texture);
+
 	// Push the provided rectangle onto the clip stack and apply it to the application's renderer. Apply the new clip rectangle as an intersection of any existing clip rectangle unless disableIntersection is true.
 	void pushClipRect (const SDL_Rect *rect, bool disableIntersection = false);
 
@@ -177,6 +209,15 @@ public:
 	// Return a texture containing a rounded corner of the specified radius, or NULL if no such texture is available. If a texture is found and width and height pointers are provided, those values are filled in with texture attributes.
 	SDL_Texture *getRoundedCornerTexture (int radius, int *textureWidth = NULL, int *textureHeight = NULL);
 
+	// Add a filled rectangle to the draw batch, to be rendered on the next call to flushDrawBatch. This method must be invoked only from the application's main thread.
+	void addDrawBatchRect (const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+	// Add a quad covering destRect and textured with the full area of the provided texture, modulated by the specified color, to the draw batch. This method must be invoked only from the application's main thread.
+	void addDrawBatchTexture (SDL_Texture *texture, const SDL_Rect &destRect, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
+	// Render all geometry held in the draw batch with a single render call. The batch is flushed automatically when a quad with a different texture is added or the render target changes, and widgets that render directly must flush it before drawing.
+	void flushDrawBatch ();
+
 	typedef void (*RenderTaskFunction) (void *fnData);
 	struct RenderTaskContext {
 		RenderTaskFunction fn;
@@ -249,6 +290,21 @@ private:
 	// Read environment settings and configure the app
 	void init ();
 
+	// Add the application's startup steps to the provided task graph
+	void addStartupTasks (TaskGraph *graph);
+
+	// Create the application window and renderer. Returns a Result value.
+	int initWindow ();
+
+	// Load fonts and sprites, and create the application's top-level widgets. Returns a Result value.
+	int loadUiResources ();
+
+	// Create the application's top-level widgets and main UI. Returns a Result value.
+	int createUi ();
+
+	// Write the startup trace record to the log, including the time elapsed until the first window frame if firstFrameTime is greater than zero
+	void writeStartupTrace (int64_t firstFrameTime);
+
 	// Run the application in window mode
 	int runWindow ();
 
@@ -264,6 +320,15 @@ private:
 	// Execute draw operations to update the application window
 	void draw ();
 
+	// Draw the window background and all widgets, as clipped by any active clip rectangle
+	void drawWindow ();
+
+	// Push an event that wakes the render loop from an idle wait
+	void wakeDraw ();
+
+	// Create backTexture if it's not already present at the current window size. Returns a boolean value indicating if the texture is available.
+	bool resetBackTexture ();
+
 	// Execute all operations in renderTaskList
 	void executeRenderTasks ();
 
@@ -277,10 +342,26 @@ private:
 	// Return the image scale index associated with the specified window size, or a negative value if no such scale is known
 	int getImageScale (int w, int h);
 
+	// Append a quad to the draw batch, flushing it first if it holds geometry for a different texture. The quad is clipped to the active clip rectangle so that clip changes need not flush the batch.
+	void addDrawBatchQuad (SDL_Texture *texture, const SDL_Rect &rect, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+
 	// Run the application's state update thread
 	static int runUpdateThread (void *appPtr);
 	static int runConsoleUpdateThread (void *appPtr);
 
+	// Task functions for use with TaskGraph
+	static int readPrefsTask (void *appPtr);
+	static int openResourcesTask (void *appPtr);
+	static int loadTextTask (void *appPtr);
+	static int startNetworkTask (void *appPtr);
+	static int startAgentControlTask (void *appPtr);
+	static int readCommandHistoryTask (void *appPtr);
+	static int readRecordSnapshotTask (void *appPtr);
+	static int prefetchResourcesTask (void *appPtr);
+	static int initWindowTask (void *appPtr);
+	static int loadUiResourcesTask (void *appPtr);
+	static int createUiTask (void *appPtr);
+
 	// Callback function for use with Network
 	static void datagramReceived (void *callbackData, const char *messageData, int messageLength, const char *sourceAddress, int sourcePort);
 
@@ -294,6 +375,11 @@ private:
 	SDL_mutex *prefsMapMutex;
 	std::vector<SDL_Keycode> keyPressList;
 	std::stack<SDL_Rect> clipRectStack;
+	SDL_Texture *drawBatchTexture;
+	std::vector<SDL_Vertex> drawBatchVertices;
+	std::vector<int> drawBatchIndices;
+	bool isDrawBatchEmpty;
+	bool isClipRectSuspended;
 	Sprite *roundedCornerSprite;
 	SDL_mutex *renderTaskMutex;
 	std::vector<App::RenderTaskContext> renderTaskList;
@@ -312,6 +398,27 @@ private:
 	StdString nextBackgroundTexturePath;
 	int nextBackgroundTextureWidth, nextBackgroundTextureHeight;
 	float backgroundCrossFadeAlpha;
+	bool isDrawDirty;
+	bool isDrawWaiting;
+	bool isRenderTaskPending;
+	Uint32 drawWakeEventType;
+	SDL_mutex *drawDirtyMutex;
+	int lastWindowEventCount;
+	bool isDrawFullDamage;
+	std::vector<SDL_Rect> drawDamageList;
+	bool shouldDrawFull;
+	std::vector<SDL_Rect> drawRectList;
+	SDL_Rect drawDamageClipRect;
+	bool isDrawDamageClipActive;
+	SDL_Texture *backTexture;
+	StdString backTexturePath;
+	int backTextureWidth, backTextureHeight;
+	SDL_Texture *renderTarget;
+	SDL_threadID updateThreadId;
+	bool isDrawFrameDelayDefault;
+	int frameThrottleDelay; // milliseconds
+	Json *startupTraceJson;
+	int64_t recordStoreVersion;
 };
 
 #endif
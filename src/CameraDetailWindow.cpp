@@ -131,6 +131,10 @@ void CameraDetailWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool CameraDetailWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void CameraDetailWindow::refreshLayout () {
 	float x, y, x0, y2;
 
@@ -54,6 +54,9 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	void syncRecordStore ();
 
+	// Return a boolean value indicating if the widget must execute syncRecordStore to reflect the provided set of record changes
+	bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
 	// Return a boolean value indicating if the provided Widget is a member of this class
 	static bool isWidgetType (Widget *widget);
 
@@ -34,6 +34,7 @@
 #include <list>
 #include "SDL2/SDL.h"
 #include "App.h"
+#include "Profiler.h"
 #include "StdString.h"
 #include "OsUtil.h"
 #include "Widget.h"
@@ -317,6 +318,7 @@ void CameraTimelineWindow::createBarTexture (void *windowPtr) {
 		oldsprite->unload ();
 		delete (oldsprite);
 	}
+	window->addDrawDamage ();
 	window->release ();
 }
 
@@ -331,7 +333,9 @@ void CameraTimelineWindow::doDraw (SDL_Texture *targetTexture, float originX, fl
 		rect.y = y0;
 		rect.w = (int) barWidth;
 		rect.h = (int) barHeight;
-		SDL_RenderCopy (App::instance->render, barSprite->getTexture (0), NULL, &rect);
+		App::instance->flushDrawBatch ();
+		SDL_RenderCopy (App::instance->render, barSprite->getTexture (0), barSprite->getSourceRect (0), &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 	}
 	Panel::doDraw (targetTexture, originX, originY);
 }
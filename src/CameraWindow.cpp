@@ -451,6 +451,10 @@ void CameraWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool CameraWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void CameraWindow::setSelected (bool selected, bool shouldSkipStateChangeCallback) {
 	if (selected == isSelected) {
 		return;
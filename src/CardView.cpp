@@ -32,13 +32,15 @@
 #include <math.h>
 #include <list>
 #include <map>
+#include <vector>
+#include <algorithm>
 #include "SDL2/SDL.h"
 #include "App.h"
 #include "StdString.h"
+#include "StringList.h"
 #include "Input.h"
 #include "Ui.h"
 #include "Widget.h"
-#include "HashMap.h"
 #include "Panel.h"
 #include "Label.h"
 #include "UiConfiguration.h"
@@ -48,6 +50,9 @@
 
 const float CardView::SmallItemScale = 0.83f;
 const int CardView::AnimateScaleDuration = 80; // ms
+const float CardView::VirtualItemLoadScale = 1.0f;
+const float CardView::VirtualItemUnloadScale = 2.0f;
+const int CardView::VirtualItemPoolSize = 128;
 
 CardView::CardView (float viewWidth, float viewHeight)
 : ScrollView ()
@@ -55,8 +60,18 @@ CardView::CardView (float viewWidth, float viewHeight)
 , cardAreaBottomPadding (0.0f)
 , itemMarginSize (0.0f)
 , itemMutex (NULL)
-, isSorted (false)
+, itemSortIndex (CardView::compareItemSortKeys)
+, isSorted (true)
+, isLayoutValid (false)
 , scrollBar (NULL)
+, virtualItemCount (0)
+, virtualViewOriginY (0.0f)
+, virtualViewHeight (0.0f)
+, shouldRefreshVirtualLayout (false)
+, virtualLayoutLineY (0.0f)
+, shouldStartRowAnimation (false)
+, virtualItemMaxHeight (0.0f)
+, isVirtualItemIndexValid (false)
 {
 	itemMarginSize = UiConfiguration::instance->marginSize;
 	itemMutex = SDL_CreateMutex ();
@@ -86,6 +101,9 @@ CardView::~CardView () {
 		++i;
 	}
 	itemList.clear ();
+	virtualItemIndex.clear ();
+	realizedItemList.clear ();
+	releaseFreePanels ();
 	if (itemMutex) {
 		SDL_UnlockMutex (itemMutex);
 	}
@@ -156,6 +174,9 @@ void CardView::setRowReverseSorted (int row, bool enable) {
 		return;
 	}
 	pos->second.isReverseSorted = enable;
+	SDL_LockMutex (itemMutex);
+	isSorted = false;
+	SDL_UnlockMutex (itemMutex);
 	refreshLayout ();
 }
 
@@ -170,6 +191,7 @@ void CardView::setRowSelectionAnimated (int row, bool enable) {
 		return;
 	}
 	pos->second.isSelectionAnimated = enable;
+	shouldStartRowAnimation = true;
 	refreshLayout ();
 }
 
@@ -217,13 +239,21 @@ void CardView::setRowDetail (int row, int detailType) {
 	if (pos->second.maxItemWidth < 1.0f) {
 		pos->second.maxItemWidth = 1.0f;
 	}
+	pos->second.virtualItemWidth = -1.0f;
+	pos->second.virtualItemHeight = -1.0f;
 
 	SDL_LockMutex (itemMutex);
 	i = itemList.begin ();
 	end = itemList.end ();
 	while (i != end) {
 		if (i->row == row) {
-			i->panel->setLayout (pos->second.layout, pos->second.maxItemWidth);
+			if (i->panel) {
+				i->panel->setLayout (pos->second.layout, pos->second.maxItemWidth);
+			}
+			if (i->isVirtual) {
+				i->itemWidth = -1.0f;
+				i->itemHeight = -1.0f;
+			}
 		}
 		++i;
 	}
@@ -243,32 +273,47 @@ void CardView::doUpdate (int msElapsed) {
 
 	ScrollView::doUpdate (msElapsed);
 
+	// Row animations only need to start after an item panel appears or changes rows, so the item list is visited only when one of those events has occurred
 	refresh = false;
-	i = rowMap.begin ();
-	iend = rowMap.end ();
-	while (i != iend) {
-		if (i->second.isSelectionAnimated) {
-			SDL_LockMutex (itemMutex);
-			j = itemList.begin ();
-			jend = itemList.end ();
-			while (j != jend) {
-				if (j->row == i->first) {
-					if (! j->isAnimationStarted) {
-						j->panel->animateScale (0.99f, CardView::SmallItemScale, CardView::AnimateScaleDuration);
-						j->isAnimationStarted = true;
-						refresh = true;
+	if (shouldStartRowAnimation) {
+		shouldStartRowAnimation = false;
+		i = rowMap.begin ();
+		iend = rowMap.end ();
+		while (i != iend) {
+			if (i->second.isSelectionAnimated) {
+				SDL_LockMutex (itemMutex);
+				j = itemList.begin ();
+				jend = itemList.end ();
+				while (j != jend) {
+					if ((j->row == i->first) && j->panel) {
+						if (! j->isAnimationStarted) {
+							j->panel->animateScale (0.99f, CardView::SmallItemScale, CardView::AnimateScaleDuration);
+							j->isAnimationStarted = true;
+							if (! j->isVirtual) {
+								refresh = true;
+							}
+						}
 					}
+					++j;
 				}
-				++j;
+				SDL_UnlockMutex (itemMutex);
 			}
-			SDL_UnlockMutex (itemMutex);
+			++i;
 		}
-		++i;
 	}
 
 	if (refresh) {
 		refreshLayout ();
 	}
+	else if (virtualItemCount > 0) {
+		if (shouldRefreshVirtualLayout) {
+			shouldRefreshVirtualLayout = false;
+			refreshVirtualLayout ();
+		}
+		else if ((! FLOAT_EQUALS (viewOriginY, virtualViewOriginY)) || (! FLOAT_EQUALS (height, virtualViewHeight))) {
+			resetVirtualItems ();
+		}
+	}
 }
 
 bool CardView::doProcessMouseState (const Widget::MouseState &mouseState) {
@@ -290,7 +335,7 @@ bool CardView::doProcessMouseState (const Widget::MouseState &mouseState) {
 	if (! highlightedItemId.empty ()) {
 		SDL_LockMutex (itemMutex);
 		item = findItemPosition (highlightedItemId);
-		if (item == itemList.end ()) {
+		if ((item == itemList.end ()) || (! item->panel)) {
 			highlightedItemId.assign ("");
 		}
 		else {
@@ -327,7 +372,7 @@ bool CardView::doProcessMouseState (const Widget::MouseState &mouseState) {
 				j = itemList.begin ();
 				jend = itemList.end ();
 				while (j != jend) {
-					if ((j->row == i->first) && j->panel->isVisible) {
+					if ((j->row == i->first) && j->panel && j->panel->isVisible) {
 						highlight = false;
 						if (mouseState.isEntered && highlightedItemId.empty ()) {
 							x1 = j->panel->screenX;
@@ -394,10 +439,13 @@ void CardView::resetRowSelection (int row) {
 	while (i != end) {
 		if (i->row == row) {
 			i->isAnimationStarted = false;
-			i->panel->setTextureRender (false);
+			if (i->panel) {
+				i->panel->setTextureRender (false);
+			}
 		}
 		++i;
 	}
+	shouldStartRowAnimation = true;
 	SDL_UnlockMutex (itemMutex);
 }
 
@@ -415,7 +463,7 @@ bool CardView::contains (const StdString &itemId) {
 	bool result;
 
 	SDL_LockMutex (itemMutex);
-	result = itemIdMap.exists (itemId);
+	result = (itemIdMap.count (itemId) > 0);
 	SDL_UnlockMutex (itemMutex);
 
 	return (result);
@@ -444,7 +492,10 @@ Widget *CardView::addItem (Panel *itemPanel, const char *itemId, int row, bool s
 Widget *CardView::addItem (Panel *itemPanel, const StdString &itemId, int row, bool shouldSkipRefreshLayout) {
 	CardView::Item item;
 	std::map<int, CardView::Row>::iterator rowpos;
+	std::list<CardView::Item>::iterator pos;
 	StdString id;
+	float y;
+	bool layout;
 
 	if (itemId.empty ()) {
 		id.assign (getAvailableItemId ());
@@ -462,38 +513,140 @@ Widget *CardView::addItem (Panel *itemPanel, const StdString &itemId, int row, b
 	item.panel = itemPanel;
 	item.panel->retain ();
 	item.row = row;
+	item.sortKey.assign (itemPanel->sortKey);
 	rowpos = getRow (row);
 	item.panel->setLayout (rowpos->second.layout, rowpos->second.maxItemWidth);
 
+	layout = false;
+	y = 0.0f;
 	SDL_LockMutex (itemMutex);
-	itemList.push_back (item);
-	isSorted = false;
+	pos = insertItem (item);
+	shouldStartRowAnimation = true;
+	if (shouldSkipRefreshLayout) {
+		isLayoutValid = false;
+	}
+	else if (isSorted && isLayoutValid) {
+		if (pos != itemList.begin ()) {
+			--pos;
+		}
+		y = layoutItems (pos);
+		layout = true;
+	}
 	SDL_UnlockMutex (itemMutex);
 
-	if (! shouldSkipRefreshLayout) {
+	if (layout) {
+		resetScrollBounds (y);
+	}
+	else if (! shouldSkipRefreshLayout) {
 		refreshLayout ();
 	}
 	return (itemPanel);
 }
 
-void CardView::removeItem (const StdString &itemId, bool shouldSkipRefreshLayout) {
+void CardView::addItems (const std::list<Panel *> &itemPanels, const StringList &itemIds, int row) {
+	std::list<Panel *>::const_iterator i, end;
+	StringList::const_iterator j, jend;
+
+	i = itemPanels.begin ();
+	end = itemPanels.end ();
+	j = itemIds.begin ();
+	jend = itemIds.end ();
+	while (i != end) {
+		if (j != jend) {
+			addItem (*i, *j, row, true);
+			++j;
+		}
+		else {
+			addItem (*i, StdString (""), row, true);
+		}
+		++i;
+	}
+	refreshLayout ();
+}
+
+void CardView::addVirtualItem (const StdString &itemId, int row, const StdString &sortKey, const CardView::ItemPanelContext &panelContext, bool shouldSkipRefreshLayout) {
+	CardView::Item item;
 	std::list<CardView::Item>::iterator pos;
-	bool found;
+	float y;
+	bool layout;
+
+	if (itemId.empty ()) {
+		item.id.assign (getAvailableItemId ());
+	}
+	else {
+		item.id.assign (itemId);
+	}
+	if (row < 0) {
+		row = 0;
+	}
+
+	item.row = row;
+	item.isVirtual = true;
+	item.panelContext = panelContext;
+	item.sortKey.assign (sortKey);
+	getRow (row);
+
+	layout = false;
+	y = 0.0f;
+	SDL_LockMutex (itemMutex);
+	pos = insertItem (item);
+	++virtualItemCount;
+	if (shouldSkipRefreshLayout) {
+		isLayoutValid = false;
+	}
+	else if (isSorted && isLayoutValid) {
+		if (pos != itemList.begin ()) {
+			--pos;
+		}
+		y = layoutItems (pos);
+		layout = true;
+	}
+	SDL_UnlockMutex (itemMutex);
+
+	if (layout) {
+		resetScrollBounds (y);
+	}
+	else if (! shouldSkipRefreshLayout) {
+		refreshLayout ();
+	}
+}
+
+void CardView::removeItem (const StdString &itemId, bool shouldSkipRefreshLayout) {
+	std::list<CardView::Item>::iterator pos, start;
+	float y;
+	bool found, layout, isfirst;
 
 	found = false;
+	layout = false;
+	y = 0.0f;
 	SDL_LockMutex (itemMutex);
 	pos = findItemPosition (itemId);
 	if (pos != itemList.end ()) {
 		found = true;
-		pos->panel->isDestroyed = true;
-		pos->panel->release ();
-		isSorted = false;
-		itemList.erase (pos);
-		resetItemIdMap ();
+		isfirst = (pos == itemList.begin ());
+		start = pos;
+		if (! isfirst) {
+			--start;
+		}
+		eraseItem (pos);
+		if (isfirst) {
+			start = itemList.begin ();
+		}
+
+		if (shouldSkipRefreshLayout) {
+			isLayoutValid = false;
+		}
+		else if (isSorted && isLayoutValid) {
+			y = layoutItems (start);
+			layout = true;
+		}
 	}
 	SDL_UnlockMutex (itemMutex);
 
-	if (found && (! shouldSkipRefreshLayout)) {
+	if (layout) {
+		resetScrollBounds (y);
+	}
+	else if (found && (! shouldSkipRefreshLayout)) {
 		refreshLayout ();
 	}
 }
@@ -503,29 +656,18 @@ void CardView::removeItem (const char *itemId, bool shouldSkipRefreshLayout) {
 }
 
 void CardView::removeRowItems (int row) {
-	std::list<CardView::Item>::iterator i, end;
-	bool found;
+	std::list<CardView::Item>::iterator i, end, pos;
 
 	SDL_LockMutex (itemMutex);
-	while (true) {
-		found = false;
-		i = itemList.begin ();
-		end = itemList.end ();
-		while (i != end) {
-			if (i->row == row) {
-				i->panel->isDestroyed = true;
-				i->panel->release ();
-				itemList.erase (i);
-				found = true;
-				break;
-			}
-			++i;
-		}
-		if (! found) {
-			break;
+	i = itemList.begin ();
+	end = itemList.end ();
+	while (i != end) {
+		pos = i;
+		++i;
+		if (pos->row == row) {
+			eraseItem (pos);
 		}
 	}
-	isSorted = false;
 	SDL_UnlockMutex (itemMutex);
 
 	refreshLayout ();
@@ -540,8 +682,16 @@ void CardView::setItemRow (const StdString &itemId, int targetRow, bool shouldSk
 	pos = findItemPosition (itemId);
 	if ((pos != itemList.end ()) && (pos->row != targetRow)) {
 		pos->row = targetRow;
-		pos->panel->setLayout (rowpos->second.layout, rowpos->second.maxItemWidth);
+		if (pos->panel) {
+			pos->panel->setLayout (rowpos->second.layout, rowpos->second.maxItemWidth);
+		}
+		if (pos->isVirtual) {
+			pos->itemWidth = -1.0f;
+			pos->itemHeight = -1.0f;
+		}
 		isSorted = false;
+		isVirtualItemIndexValid = false;
+		shouldStartRowAnimation = true;
 	}
 	SDL_UnlockMutex (itemMutex);
 
@@ -557,12 +707,20 @@ void CardView::removeAllItems () {
 	i = itemList.begin ();
 	end = itemList.end ();
 	while (i != end) {
-		i->panel->isDestroyed = true;
-		i->panel->release ();
+		if (i->panel) {
+			i->panel->isDestroyed = true;
+			i->panel->release ();
+		}
 		++i;
 	}
 	itemList.clear ();
 	itemIdMap.clear ();
+	itemSortIndex.clear ();
+	virtualItemIndex.clear ();
+	realizedItemList.clear ();
+	releaseFreePanels ();
+	isVirtualItemIndexValid = false;
+	virtualItemCount = 0;
 	isSorted = true;
 	SDL_UnlockMutex (itemMutex);
 
@@ -576,7 +734,9 @@ void CardView::processItems (Widget::EventCallback fn, void *fnData, bool should
 	i = itemList.begin ();
 	end = itemList.end ();
 	while (i != end) {
-		fn (fnData, i->panel);
+		if (i->panel) {
+			fn (fnData, i->panel);
+		}
 		++i;
 	}
 	SDL_UnlockMutex (itemMutex);
@@ -593,7 +753,7 @@ void CardView::processRowItems (int row, Widget::EventCallback fn, void *fnData,
 	i = itemList.begin ();
 	end = itemList.end ();
 	while (i != end) {
-		if (i->row == row) {
+		if ((i->row == row) && i->panel) {
 			fn (fnData, i->panel);
 		}
 		++i;
@@ -623,7 +783,7 @@ void CardView::scrollToItem (const StdString &itemId) {
 	SDL_LockMutex (itemMutex);
 	pos = findItemPosition (itemId);
 	if (pos != itemList.end ()) {
-		setViewOrigin (0.0f, pos->panel->position.y - (height / 2.0f) + (pos->panel->height / 2.0f));
+		setViewOrigin (0.0f, pos->positionY - (height / 2.0f) + ((pos->panel ? pos->panel->height : pos->itemHeight) / 2.0f));
 		scrollBar->setPosition (viewOriginY, true);
 		scrollBar->position.assignY (viewOriginY + UiConfiguration::instance->paddingSize);
 	}
@@ -631,29 +791,124 @@ void CardView::scrollToItem (const StdString &itemId) {
 }
 
 void CardView::refreshLayout () {
+	std::list<CardView::Item>::iterator i, end;
+	float y;
+
+	SDL_LockMutex (itemMutex);
+	if (isSorted) {
+		i = itemList.begin ();
+		end = itemList.end ();
+		while (i != end) {
+			if (i->panel && (! i->isVirtual) && (! i->sortKey.equals (i->panel->sortKey))) {
+				isSorted = false;
+				break;
+			}
+			++i;
+		}
+	}
+	if (! isSorted) {
+		doSort ();
+	}
+	y = layoutItems (itemList.begin ());
+	isLayoutValid = true;
+	shouldRefreshVirtualLayout = false;
+	SDL_UnlockMutex (itemMutex);
+
+	resetScrollBounds (y);
+}
+
+void CardView::refreshVirtualLayout () {
+	std::list<CardView::Item>::iterator pos;
+	float y;
+	bool layout;
+
+	layout = false;
+	y = 0.0f;
+	SDL_LockMutex (itemMutex);
+	pos = findItemPosition (virtualLayoutItemId);
+	if (isSorted && isLayoutValid && (pos != itemList.end ())) {
+		if (pos != itemList.begin ()) {
+			--pos;
+		}
+		y = layoutItems (pos);
+		layout = true;
+	}
+	SDL_UnlockMutex (itemMutex);
+
+	if (layout) {
+		resetScrollBounds (y);
+	}
+	else {
+		refreshLayout ();
+	}
+}
+
+float CardView::layoutItems (std::list<CardView::Item>::iterator startPosition) {
 	std::list<CardView::Item>::iterator i, end;
 	std::map<int, CardView::Row>::iterator rowpos;
 	Panel *itempanel, *headerpanel;
-	float x, y, dx, dy, x0, itemw, itemh, rowh, rowmargin;
+	float x, y, dx, dy, x0, itemw, itemh, basew, baseh, rowh, rowmargin;
 	int row;
 
-	row = -1;
+	isVirtualItemIndexValid = false;
 	x0 = UiConfiguration::instance->paddingSize;
-	y = UiConfiguration::instance->paddingSize;
-	x = x0;
-	rowmargin = itemMarginSize;
-	rowh = 0.0f;
-
-	SDL_LockMutex (itemMutex);
-	if (! isSorted) {
-		doSort ();
+	if ((startPosition == itemList.begin ()) || (startPosition == itemList.end ())) {
+		startPosition = itemList.begin ();
+		row = -1;
+		y = UiConfiguration::instance->paddingSize;
+		x = x0;
+		rowmargin = itemMarginSize;
+		rowh = 0.0f;
 	}
-	i = itemList.begin ();
+	else {
+		row = startPosition->layoutRow;
+		x = startPosition->layoutX;
+		y = startPosition->layoutY;
+		rowh = startPosition->layoutRowHeight;
+		rowmargin = startPosition->layoutRowMargin;
+	}
+
+	i = startPosition;
 	end = itemList.end ();
 	while (i != end) {
+		i->layoutRow = row;
+		i->layoutX = x;
+		i->layoutY = y;
+		i->layoutRowHeight = rowh;
+		i->layoutRowMargin = rowmargin;
+
 		itempanel = i->panel;
-		itemw = itempanel->width;
-		itemh = itempanel->height;
+		if ((! itempanel) && i->isVirtual && (i->itemWidth < 0.0f)) {
+			// Create the item's panel to measure its size, if no other item in the row has provided an estimate
+			rowpos = getRow (i->row);
+			if (rowpos->second.virtualItemWidth < 0.0f) {
+				createItemPanel (i);
+				itempanel = i->panel;
+			}
+		}
+		if (itempanel) {
+			itemw = itempanel->width;
+			itemh = itempanel->height;
+			if (i->isVirtual) {
+				i->itemWidth = itemw;
+				i->itemHeight = itemh;
+			}
+		}
+		else if (i->itemWidth >= 0.0f) {
+			itemw = i->itemWidth;
+			itemh = i->itemHeight;
+		}
+		else {
+			rowpos = getRow (i->row);
+			itemw = rowpos->second.virtualItemWidth;
+			itemh = rowpos->second.virtualItemHeight;
+			if (itemw < 0.0f) {
+				itemw = 0.0f;
+				itemh = 0.0f;
+			}
+		}
+		basew = itemw;
+		baseh = itemh;
 		dx = 0.0f;
 		dy = 0.0f;
 
@@ -686,8 +941,8 @@ void CardView::refreshLayout () {
 			if (rowpos->second.isSelectionAnimated) {
 				itemw *= CardView::SmallItemScale;
 				itemh *= CardView::SmallItemScale;
-				dx = (itempanel->width - itemw) / -4.0f;
-				dy = (itempanel->height - itemh) / -4.0f;
+				dx = (basew - itemw) / -4.0f;
+				dy = (baseh - itemh) / -4.0f;
 			}
 		}
 
@@ -700,15 +955,26 @@ void CardView::refreshLayout () {
 			rowh = itemh;
 		}
 
-		itempanel->position.assign (x + dx, y + dy);
+		i->layoutLineY = y;
+		i->positionX = x + dx;
+		i->positionY = y + dy;
+		if (itempanel) {
+			itempanel->position.assign (i->positionX, i->positionY);
+		}
 		x += itemw + rowmargin;
 
 		++i;
 	}
-	SDL_UnlockMutex (itemMutex);
 
 	y += rowh;
 	y += cardAreaBottomPadding;
+	return (y);
+}
+
+void CardView::resetScrollBounds (float contentHeight) {
+	float y;
+
+	y = contentHeight;
 	scrollBar->setScrollBounds (height, y);
 	y -= height;
 	if (y < 0.0f) {
@@ -729,13 +995,219 @@ void CardView::refreshLayout () {
 		scrollBar->position.assign (width - UiConfiguration::instance->paddingSize - scrollBar->width, viewOriginY + UiConfiguration::instance->paddingSize);
 		scrollBar->isVisible = true;
 	}
+
+	if (virtualItemCount > 0) {
+		resetVirtualItems ();
+	}
+}
+
+void CardView::resetVirtualItems () {
+	std::list<std::list<CardView::Item>::iterator>::iterator i, end, pos;
+	std::vector<std::list<CardView::Item>::iterator>::iterator j, jend;
+	std::list<CardView::Item>::iterator item;
+	float loady1, loady2, unloady1, unloady2, h;
+
+	loady1 = viewOriginY - (height * CardView::VirtualItemLoadScale);
+	loady2 = viewOriginY + height + (height * CardView::VirtualItemLoadScale);
+	unloady1 = viewOriginY - (height * CardView::VirtualItemUnloadScale);
+	unloady2 = viewOriginY + height + (height * CardView::VirtualItemUnloadScale);
+
+	SDL_LockMutex (itemMutex);
+	i = realizedItemList.begin ();
+	end = realizedItemList.end ();
+	while (i != end) {
+		pos = i;
+		++i;
+		item = *pos;
+		if (((item->positionY + item->panel->height) < unloady1) || (item->positionY > unloady2)) {
+			poolItemPanel (item);
+		}
+	}
+
+	// Items are laid out in lines of non-decreasing position, so the first line that could reach the load range is found by binary search
+	if (! isVirtualItemIndexValid) {
+		resetVirtualItemIndex ();
+	}
+	j = std::lower_bound (virtualItemIndex.begin (), virtualItemIndex.end (), loady1 - virtualItemMaxHeight, CardView::compareItemLayoutLineY);
+	jend = virtualItemIndex.end ();
+	while (j != jend) {
+		item = *j;
+		++j;
+		if (item->layoutLineY > loady2) {
+			break;
+		}
+		if (item->panel) {
+			continue;
+		}
+		h = item->itemHeight;
+		if (h < 0.0f) {
+			h = 0.0f;
+		}
+		if (((item->positionY + h) >= loady1) && (item->positionY <= loady2)) {
+			createItemPanel (item);
+		}
+	}
+	SDL_UnlockMutex (itemMutex);
+
+	virtualViewOriginY = viewOriginY;
+	virtualViewHeight = height;
+}
+
+void CardView::resetVirtualItemIndex () {
+	std::list<CardView::Item>::iterator i, end;
+	float h;
+
+	virtualItemIndex.clear ();
+	virtualItemMaxHeight = 0.0f;
+	i = itemList.begin ();
+	end = itemList.end ();
+	while (i != end) {
+		if (i->isVirtual) {
+			virtualItemIndex.push_back (i);
+			h = i->panel ? i->panel->height : i->itemHeight;
+			if (h > virtualItemMaxHeight) {
+				virtualItemMaxHeight = h;
+			}
+		}
+		++i;
+	}
+	isVirtualItemIndexValid = true;
+}
+
+bool CardView::compareItemLayoutLineY (const std::list<CardView::Item>::iterator &item, float positionY) {
+	return (item->layoutLineY < positionY);
+}
+
+bool CardView::createItemPanel (std::list<CardView::Item>::iterator item) {
+	std::map<int, CardView::Row>::iterator rowpos;
+	Panel *panel;
+	float w, h;
+
+	if (item->panel) {
+		return (true);
+	}
+	rowpos = getRow (item->row);
+	if (item->panelContext.resetFn && (! rowpos->second.freePanelList.empty ())) {
+		panel = rowpos->second.freePanelList.back ();
+		rowpos->second.freePanelList.pop_back ();
+		if (! item->panelContext.resetFn (item->panelContext.fnData, panel, item->id)) {
+			rowpos->second.freePanelList.push_back (panel);
+			return (false);
+		}
+	}
+	else {
+		if (! item->panelContext.fn) {
+			return (false);
+		}
+		panel = item->panelContext.fn (item->panelContext.fnData, item->id);
+		if (! panel) {
+			return (false);
+		}
+		panel->retain ();
+	}
+
+	addWidget (panel);
+	panel->sortKey.assign (item->sortKey);
+	panel->setLayout (rowpos->second.layout, rowpos->second.maxItemWidth);
+	panel->position.assign (item->positionX, item->positionY);
+	item->panel = panel;
+	item->isHighlighted = false;
+	item->isAnimationStarted = false;
+	realizedItemList.push_back (item);
+	shouldStartRowAnimation = true;
+
+	w = item->itemWidth;
+	h = item->itemHeight;
+	if (w < 0.0f) {
+		w = rowpos->second.virtualItemWidth;
+		h = rowpos->second.virtualItemHeight;
+	}
+	if ((! FLOAT_EQUALS (panel->width, w)) || (! FLOAT_EQUALS (panel->height, h))) {
+		if ((! shouldRefreshVirtualLayout) || (item->layoutLineY < virtualLayoutLineY)) {
+			virtualLayoutItemId.assign (item->id);
+			virtualLayoutLineY = item->layoutLineY;
+		}
+		shouldRefreshVirtualLayout = true;
+	}
+	item->itemWidth = panel->width;
+	item->itemHeight = panel->height;
+	rowpos->second.virtualItemWidth = panel->width;
+	rowpos->second.virtualItemHeight = panel->height;
+	if (panel->height > virtualItemMaxHeight) {
+		virtualItemMaxHeight = panel->height;
+	}
+	return (true);
+}
+
+void CardView::poolItemPanel (std::list<CardView::Item>::iterator item) {
+	std::map<int, CardView::Row>::iterator rowpos;
+	std::list<std::list<CardView::Item>::iterator>::iterator pos;
+
+	if (! item->panel) {
+		return;
+	}
+	if (item->isHighlighted) {
+		item->isHighlighted = false;
+		highlightedItemId.assign ("");
+	}
+	pos = std::find (realizedItemList.begin (), realizedItemList.end (), item);
+	if (pos != realizedItemList.end ()) {
+		realizedItemList.erase (pos);
+	}
+	item->itemWidth = item->panel->width;
+	item->itemHeight = item->panel->height;
+	removeWidget (item->panel);
+	rowpos = getRow (item->row);
+	if (item->panelContext.resetFn && ((int) rowpos->second.freePanelList.size () < CardView::VirtualItemPoolSize)) {
+		rowpos->second.freePanelList.push_back (item->panel);
+	}
+	else {
+		item->panel->isDestroyed = true;
+		item->panel->release ();
+	}
+	item->panel = NULL;
+}
+
+void CardView::releaseItemPanels (std::list<CardView::Item>::iterator item) {
+	std::list<std::list<CardView::Item>::iterator>::iterator pos;
+
+	if (item->panel) {
+		item->panel->isDestroyed = true;
+		item->panel->release ();
+		item->panel = NULL;
+		if (item->isVirtual) {
+			pos = std::find (realizedItemList.begin (), realizedItemList.end (), item);
+			if (pos != realizedItemList.end ()) {
+				realizedItemList.erase (pos);
+			}
+		}
+	}
+}
+
+void CardView::releaseFreePanels () {
+	std::map<int, CardView::Row>::iterator i, end;
+	std::list<Panel *>::iterator j, jend;
+
+	i = rowMap.begin ();
+	end = rowMap.end ();
+	while (i != end) {
+		j = i->second.freePanelList.begin ();
+		jend = i->second.freePanelList.end ();
+		while (j != jend) {
+			(*j)->isDestroyed = true;
+			(*j)->release ();
+			++j;
+		}
+		i->second.freePanelList.clear ();
+		++i;
+	}
 }
 
 void CardView::doSort () {
 	std::map<int, CardView::Row>::iterator ri, rend;
-	std::list<CardView::Item> outlist, rowlist;
+	std::list<CardView::Item> outlist;
 	std::list<CardView::Item>::iterator i, iend;
-	int row, nextrow;
+	CardView::ItemSortIndex::iterator j, jend;
 
 	ri = rowMap.begin ();
 	rend = rowMap.end ();
@@ -744,53 +1216,30 @@ void CardView::doSort () {
 		++ri;
 	}
 
-	row = -1;
+	itemSortIndex.clear ();
+	itemIdMap.clear ();
+	isVirtualItemIndexValid = false;
 	i = itemList.begin ();
 	iend = itemList.end ();
 	while (i != iend) {
-		if ((row < 0) || (i->row < row)) {
-			row = i->row;
-		}
 		ri = getRow (i->row);
 		++(ri->second.itemCount);
+		if (i->panel && (! i->isVirtual)) {
+			i->sortKey.assign (i->panel->sortKey);
+		}
+		itemSortIndex.insert (std::pair<CardView::ItemSortKey, std::list<CardView::Item>::iterator> (getItemSortKey (*i), i));
+		itemIdMap[i->id] = i;
 		++i;
 	}
 
-	while (true) {
-		rowlist.clear ();
-		nextrow = -1;
-		i = itemList.begin ();
-		iend = itemList.end ();
-		while (i != iend) {
-			if (i->row == row) {
-				rowlist.push_back (*i);
-			}
-			else if (i->row > row) {
-				if ((nextrow < 0) || (i->row < nextrow)) {
-					nextrow = i->row;
-				}
-			}
-			++i;
-		}
-
-		ri = getRow (row);
-		rowlist.sort (ri->second.isReverseSorted ? CardView::compareItemsDescending : CardView::compareItemsAscending);
-
-		i = rowlist.begin ();
-		iend = rowlist.end ();
-		while (i != iend) {
-			outlist.push_back (*i);
-			++i;
-		}
-
-		if (nextrow < 0) {
-			break;
-		}
-		row = nextrow;
+	// Splicing moves list elements without copying them, leaving the iterators held by itemSortIndex and itemIdMap valid
+	j = itemSortIndex.begin ();
+	jend = itemSortIndex.end ();
+	while (j != jend) {
+		outlist.splice (outlist.end (), itemList, j->second);
+		++j;
 	}
-
 	itemList.swap (outlist);
-	resetItemIdMap ();
 
 	ri = rowMap.begin ();
 	rend = rowMap.end ();
@@ -808,43 +1257,107 @@ void CardView::doSort () {
 	isSorted = true;
 }
 
-void CardView::resetItemIdMap () {
-	std::list<CardView::Item>::iterator i, end;
-	int index;
+CardView::ItemSortKey CardView::getItemSortKey (const CardView::Item &item) {
+	CardView::ItemSortKey key;
+	std::map<int, CardView::Row>::iterator rowpos;
 
-	itemIdMap.clear ();
-	index = 0;
-	i = itemList.begin ();
-	end = itemList.end ();
-	while (i != end) {
-		itemIdMap.insert (i->id, index);
-		++index;
-		++i;
+	rowpos = getRow (item.row);
+	key.row = item.row;
+	key.isReverseSorted = rowpos->second.isReverseSorted;
+	key.sortKey.assign (item.sortKey);
+	return (key);
+}
+
+std::list<CardView::Item>::iterator CardView::insertItem (const CardView::Item &item) {
+	std::list<CardView::Item>::iterator pos;
+	std::map<int, CardView::Row>::iterator rowpos;
+	CardView::ItemSortIndex::iterator indexpos;
+	CardView::ItemSortKey key;
+
+	isVirtualItemIndexValid = false;
+	if (! isSorted) {
+		pos = itemList.insert (itemList.end (), item);
+		itemIdMap[item.id] = pos;
+		return (pos);
+	}
+
+	key = getItemSortKey (item);
+	indexpos = itemSortIndex.upper_bound (key);
+	if (indexpos == itemSortIndex.end ()) {
+		pos = itemList.insert (itemList.end (), item);
+	}
+	else {
+		pos = itemList.insert (indexpos->second, item);
 	}
+	itemSortIndex.insert (indexpos, std::pair<CardView::ItemSortKey, std::list<CardView::Item>::iterator> (key, pos));
+	itemIdMap[item.id] = pos;
+
+	rowpos = getRow (item.row);
+	++(rowpos->second.itemCount);
+	if (rowpos->second.headerPanel) {
+		rowpos->second.headerPanel->isVisible = true;
+	}
+	return (pos);
 }
 
-bool CardView::compareItemsAscending (const CardView::Item &a, const CardView::Item &b) {
-	return (a.panel->sortKey.compare (b.panel->sortKey) <= 0);
+void CardView::eraseItem (std::list<CardView::Item>::iterator pos) {
+	std::map<StdString, std::list<CardView::Item>::iterator>::iterator idpos;
+	std::map<int, CardView::Row>::iterator rowpos;
+	std::pair<CardView::ItemSortIndex::iterator, CardView::ItemSortIndex::iterator> range;
+	CardView::ItemSortIndex::iterator j;
+
+	releaseItemPanels (pos);
+	isVirtualItemIndexValid = false;
+	if (pos->isVirtual) {
+		--virtualItemCount;
+	}
+	if (pos->isHighlighted) {
+		highlightedItemId.assign ("");
+	}
+
+	if (isSorted) {
+		range = itemSortIndex.equal_range (getItemSortKey (*pos));
+		j = range.first;
+		while (j != range.second) {
+			if (j->second == pos) {
+				itemSortIndex.erase (j);
+				break;
+			}
+			++j;
+		}
+
+		rowpos = getRow (pos->row);
+		--(rowpos->second.itemCount);
+		if ((rowpos->second.itemCount <= 0) && rowpos->second.headerPanel) {
+			rowpos->second.headerPanel->isVisible = false;
+		}
+	}
+
+	idpos = itemIdMap.find (pos->id);
+	if ((idpos != itemIdMap.end ()) && (idpos->second == pos)) {
+		itemIdMap.erase (idpos);
+	}
+	itemList.erase (pos);
 }
 
-bool CardView::compareItemsDescending (const CardView::Item &a, const CardView::Item &b) {
-	return (a.panel->sortKey.compare (b.panel->sortKey) > 0);
+bool CardView::compareItemSortKeys (const CardView::ItemSortKey &a, const CardView::ItemSortKey &b) {
+	if (a.row != b.row) {
+		return (a.row < b.row);
+	}
+	if (a.isReverseSorted) {
+		return (a.sortKey.compare (b.sortKey) > 0);
+	}
+	return (a.sortKey.compare (b.sortKey) < 0);
 }
 
 std::list<CardView::Item>::iterator CardView::findItemPosition (const StdString &itemId) {
-	std::list<CardView::Item>::iterator pos;
-	int index;
+	std::map<StdString, std::list<CardView::Item>::iterator>::iterator pos;
 
-	index = itemIdMap.find (itemId, -1);
-	if ((index < 0) || (index >= (int) itemList.size ())) {
+	pos = itemIdMap.find (itemId);
+	if (pos == itemIdMap.end ()) {
 		return (itemList.end ());
 	}
-	pos = itemList.begin ();
-	while (index > 0) {
-		++pos;
-		--index;
-	}
-	return (pos);
+	return (pos->second);
 }
 
 std::map<int, CardView::Row>::iterator CardView::getRow (int rowNumber) {
@@ -878,6 +1391,24 @@ Widget *CardView::getItem (const char *itemId) {
 	return (getItem (StdString (itemId)));
 }
 
+Widget *CardView::realizeItem (const StdString &itemId) {
+	std::list<CardView::Item>::iterator pos;
+	Widget *result;
+
+	result = NULL;
+	SDL_LockMutex (itemMutex);
+	pos = findItemPosition (itemId);
+	if (pos != itemList.end ()) {
+		if ((! pos->panel) && pos->isVirtual) {
+			createItemPanel (pos);
+		}
+		result = pos->panel;
+	}
+	SDL_UnlockMutex (itemMutex);
+
+	return (result);
+}
+
 int CardView::getItemCount () {
 	int result;
 
@@ -898,6 +1429,22 @@ int CardView::getRowItemCount (int row) {
 	return (rowpos->second.itemCount);
 }
 
+void CardView::getRowItemIds (int row, StringList *destList) {
+	std::list<CardView::Item>::iterator i, end;
+
+	destList->clear ();
+	SDL_LockMutex (itemMutex);
+	i = itemList.begin ();
+	end = itemList.end ();
+	while (i != end) {
+		if (i->row == row) {
+			destList->push_back (i->id);
+		}
+		++i;
+	}
+	SDL_UnlockMutex (itemMutex);
+}
+
 Widget *CardView::findItem (CardView::MatchFunction fn, void *fnData) {
 	std::list<CardView::Item>::iterator i, end;
 	Widget *result;
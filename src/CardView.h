@@ -34,9 +34,10 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include "SDL2/SDL.h"
 #include "StdString.h"
-#include "HashMap.h"
+#include "StringList.h"
 #include "Label.h"
 #include "Panel.h"
 #include "ScrollBar.h"
@@ -55,8 +56,27 @@ public:
 	~CardView ();
 
 	typedef bool (*MatchFunction) (void *data, Widget *widget);
+	typedef Panel *(*ItemPanelFunction) (void *data, const StdString &itemId);
+	typedef bool (*ItemPanelResetFunction) (void *data, Panel *itemPanel, const StdString &itemId);
+	struct ItemPanelContext {
+		CardView::ItemPanelFunction fn;
+		CardView::ItemPanelResetFunction resetFn;
+		void *fnData;
+		ItemPanelContext ():
+			fn (NULL),
+			resetFn (NULL),
+			fnData (NULL) { }
+		ItemPanelContext (CardView::ItemPanelFunction fn, void *fnData, CardView::ItemPanelResetFunction resetFn = NULL):
+			fn (fn),
+			resetFn (resetFn),
+			fnData (fnData) { }
+	};
+
 	static const float SmallItemScale;
 	static const int AnimateScaleDuration;
+	static const float VirtualItemLoadScale;
+	static const float VirtualItemUnloadScale;
+	static const int VirtualItemPoolSize;
 
 	// Read-only data members
 	float cardAreaWidth;
@@ -107,17 +127,29 @@ public:
 	Widget *addItem (Panel *itemPanel, const StdString &itemId = StdString (""), int row = 0, bool shouldSkipRefreshLayout = false);
 	Widget *addItem (Panel *itemPanel, const char *itemId, int row = 0, bool shouldSkipRefreshLayout = false);
 
-	// Return a pointer to the item widget with the specified ID, or NULL if the item wasn't found
+	// Add a set of items to the view, assigning each the specified row, and invoke refreshLayout once after all items have been added. itemIds must be empty, causing the CardView to generate IDs of its own, or hold one ID for each member of itemPanels.
+	void addItems (const std::list<Panel *> &itemPanels, const StringList &itemIds = StringList (), int row = 0);
+
+	// Add a virtual item to the view. A virtual item holds no widget while positioned away from the visible area; the view provides the item's Panel as it scrolls into range, and detaches that Panel after it scrolls out of range again. If panelContext holds a reset function, each row keeps up to VirtualItemPoolSize detached Panels in a free list and hands them to other items of the row as they scroll into range, invoking the reset function to rebind a Panel to its new item ID; the panelContext create function is invoked only while the row's free list is empty. Virtual items sharing a row must use the same panelContext functions. After adding the item, invoke refreshLayout unless shouldSkipRefreshLayout is true.
+	void addVirtualItem (const StdString &itemId, int row, const StdString &sortKey, const CardView::ItemPanelContext &panelContext, bool shouldSkipRefreshLayout = false);
+
+	// Return a pointer to the item widget with the specified ID, or NULL if the item wasn't found or is a virtual item with no widget currently present
 	Widget *getItem (const StdString &itemId);
 	Widget *getItem (const char *itemId);
 
+	// Return a pointer to the item widget with the specified ID, creating the widget if the item is a virtual item with no widget currently present, or NULL if the item wasn't found
+	Widget *realizeItem (const StdString &itemId);
+
 	// Return the number of items in the view
 	int getItemCount ();
 
 	// Return the number of items in the specified row
 	int getRowItemCount (int row);
 
-	// Return a pointer to the first item widget reported matching by the provided function, or NULL if the item wasn't found
+	// Clear the provided list and fill it with the IDs of all items in the specified row, including virtual items with no widget currently present
+	void getRowItemIds (int row, StringList *destList);
+
+	// Return a pointer to the first item widget reported matching by the provided function, or NULL if the item wasn't found. Virtual items with no widget currently present are not checked.
 	Widget *findItem (CardView::MatchFunction fn, void *fnData);
 
 	// Remove the specified item from the view and destroy its underlying widget. After removing the item, invoke refreshLayout unless shouldSkipRefreshLayout is true.
@@ -133,10 +165,10 @@ public:
 	// Remove all items from the view and destroy their underlying widgets
 	void removeAllItems ();
 
-	// Process all items in the view by executing the provided function, optionally resetting widget positions afterward
+	// Process all items in the view by executing the provided function, optionally resetting widget positions afterward. Virtual items with no widget currently present are skipped.
 	void processItems (Widget::EventCallback fn, void *fnData, bool shouldRefreshLayout = false);
 
-	// Process all items in the specified row of the view by executing the provided function, optionally resetting widget positions afterward
+	// Process all items in the specified row of the view by executing the provided function, optionally resetting widget positions afterward. Virtual items with no widget currently present are skipped.
 	void processRowItems (int row, Widget::EventCallback fn, void *fnData, bool shouldRefreshLayout = false);
 
 	// Change the view's vertical scroll position to display the specified row, adding an optional position delta
@@ -168,13 +200,49 @@ private:
 		int row;
 		bool isHighlighted;
 		bool isAnimationStarted;
+		bool isVirtual;
+		CardView::ItemPanelContext panelContext;
+		StdString sortKey;
+		float positionX;
+		float positionY;
+		float itemWidth;
+		float itemHeight;
+		int layoutRow;
+		float layoutX;
+		float layoutY;
+		float layoutRowHeight;
+		float layoutRowMargin;
+		float layoutLineY;
 		Item ():
 			panel (NULL),
 			row (-1),
 			isHighlighted (false),
-			isAnimationStarted (false) { }
+			isAnimationStarted (false),
+			isVirtual (false),
+			positionX (0.0f),
+			positionY (0.0f),
+			itemWidth (-1.0f),
+			itemHeight (-1.0f),
+			layoutRow (-1),
+			layoutX (0.0f),
+			layoutY (0.0f),
+			layoutRowHeight (0.0f),
+			layoutRowMargin (0.0f),
+			layoutLineY (0.0f) { }
+	};
+
+	struct ItemSortKey {
+		int row;
+		bool isReverseSorted;
+		StdString sortKey;
+		ItemSortKey ():
+			row (-1),
+			isReverseSorted (false) { }
 	};
 
+	typedef bool (*ItemSortKeyCompareFunction) (const CardView::ItemSortKey &a, const CardView::ItemSortKey &b);
+	typedef std::multimap<CardView::ItemSortKey, std::list<CardView::Item>::iterator, CardView::ItemSortKeyCompareFunction> ItemSortIndex;
+
 	struct Row {
 		Panel *headerPanel;
 		float itemMarginSize;
@@ -184,6 +252,9 @@ private:
 		int layout;
 		float positionY;
 		float maxItemWidth;
+		float virtualItemWidth;
+		float virtualItemHeight;
+		std::list<Panel *> freePanelList; // Detached Panels of virtual items, available for reuse by any virtual item in the row
 		Row ():
 			headerPanel (NULL),
 			itemMarginSize (-1.0f),
@@ -192,14 +263,28 @@ private:
 			itemCount (0),
 			layout (Panel::NoLayout),
 			positionY (0.0f),
-			maxItemWidth (0.0f) { }
+			maxItemWidth (0.0f),
+			virtualItemWidth (-1.0f),
+			virtualItemHeight (-1.0f) { }
 	};
 
 	// Sort the item list and populate secondary data structures. This method must be invoked only while holding a lock on itemMutex.
 	void doSort ();
 
-	// Reset the contents of itemIdMap to match item state. This method must be invoked only while holding a lock on itemMutex.
-	void resetItemIdMap ();
+	// Return the key that orders the provided item within itemSortIndex
+	CardView::ItemSortKey getItemSortKey (const CardView::Item &item);
+
+	// Add a copy of the provided item to the item list, placing it at its sorted position if the list is already sorted, and return an iterator positioned at the new item. This method must be invoked only while holding a lock on itemMutex.
+	std::list<CardView::Item>::iterator insertItem (const CardView::Item &item);
+
+	// Remove the item at the specified position from the item list and destroy its underlying widget. This method must be invoked only while holding a lock on itemMutex.
+	void eraseItem (std::list<CardView::Item>::iterator pos);
+
+	// Assign positions to items from startPosition to the end of the item list and return the resulting content height. startPosition must be the beginning of the list or an item positioned by a previous layout pass. This method must be invoked only while holding a lock on itemMutex.
+	float layoutItems (std::list<CardView::Item>::iterator startPosition);
+
+	// Reset scroll bounds as appropriate for the specified content height
+	void resetScrollBounds (float contentHeight);
 
 	// Return an iterator positioned at the specified item in the item list, or the end of the item list if the item wasn't found. This method must be invoked only while holding a lock on itemMutex.
 	std::list<CardView::Item>::iterator findItemPosition (const StdString &itemId);
@@ -207,19 +292,59 @@ private:
 	// Return an iterator positioned at the specified item in the row map, creating the item if it doesn't already exist
 	std::map<int, CardView::Row>::iterator getRow (int rowNumber);
 
-	static bool compareItemsAscending (const CardView::Item &a, const CardView::Item &b);
-	static bool compareItemsDescending (const CardView::Item &a, const CardView::Item &b);
+	// Create the Panel for a virtual item and return a boolean value indicating if the Panel was created. This method must be invoked only while holding a lock on itemMutex.
+	bool createItemPanel (std::list<CardView::Item>::iterator item);
+
+	// Detach the Panel held by a virtual item and add it to its row's free list, destroying the Panel instead if the item can't rebind Panels or the free list is full. This method must be invoked only while holding a lock on itemMutex.
+	void poolItemPanel (std::list<CardView::Item>::iterator item);
+
+	// Destroy any Panel held by the provided item and remove the item from realizedItemList. This method must be invoked only while holding a lock on itemMutex.
+	void releaseItemPanels (std::list<CardView::Item>::iterator item);
+
+	// Destroy all Panels held in row free lists. This method must be invoked only while holding a lock on itemMutex.
+	void releaseFreePanels ();
+
+	// Create or detach Panels for virtual items as appropriate for the current view position
+	void resetVirtualItems ();
+
+	// Rebuild virtualItemIndex from the item list. This method must be invoked only while holding a lock on itemMutex.
+	void resetVirtualItemIndex ();
+
+	// Reset layout positions from the first virtual item whose Panel size differed from its estimate, or the whole item list if that item can't be found
+	void refreshVirtualLayout ();
+
+	static bool compareItemSortKeys (const CardView::ItemSortKey &a, const CardView::ItemSortKey &b);
+	static bool compareItemLayoutLineY (const std::list<CardView::Item>::iterator &item, float positionY);
 
 	SDL_mutex *itemMutex;
 	std::list<CardView::Item> itemList;
 
-	// A map of item ID strings to numbers indicating the item's position in itemList
-	HashMap itemIdMap;
+	// A map of item ID strings to the item's position in itemList
+	std::map<StdString, std::list<CardView::Item>::iterator> itemIdMap;
+
+	// An index of itemList positions ordered by item sort key, valid while isSorted is true
+	CardView::ItemSortIndex itemSortIndex;
 
 	StdString highlightedItemId;
 	std::map<int, CardView::Row> rowMap;
 	bool isSorted;
+	bool isLayoutValid;
 	ScrollBar *scrollBar;
+	int virtualItemCount;
+	float virtualViewOriginY;
+	float virtualViewHeight;
+	bool shouldRefreshVirtualLayout;
+	StdString virtualLayoutItemId;
+	float virtualLayoutLineY;
+	bool shouldStartRowAnimation;
+
+	// Virtual items in item list order, used to find the items near the view position without visiting the whole list. Valid while isVirtualItemIndexValid is true.
+	std::vector<std::list<CardView::Item>::iterator> virtualItemIndex;
+	float virtualItemMaxHeight;
+	bool isVirtualItemIndexValid;
+
+	// Virtual items currently holding an attached Panel
+	std::list<std::list<CardView::Item>::iterator> realizedItemList;
 };
 
 #endif
@@ -30,7 +30,9 @@
 #include "Config.h"
 #include <stdlib.h>
 #include <math.h>
+#include "App.h"
 #include "StdString.h"
+#include "AnimationTimeline.h"
 #include "Color.h"
 
 Color::Color (float r, float g, float b, float a)
@@ -40,6 +42,8 @@ Color::Color (float r, float g, float b, float a)
 , a (a)
 , isTranslating (false)
 , isAnimating (false)
+, animationOwner (NULL)
+, isScheduled (false)
 , translateDuration (0)
 , animateDuration (0)
 , animateRepeatDelay (0)
@@ -65,8 +69,92 @@ Color::Color (float r, float g, float b, float a)
 	normalize ();
 }
 
+Color::Color (const Color &other)
+: animationOwner (NULL)
+, isScheduled (false)
+{
+	copyState (other);
+}
+
 Color::~Color () {
+	if (isScheduled && AnimationTimeline::instance) {
+		AnimationTimeline::instance->removeTween (this);
+	}
+}
+
+Color &Color::operator= (const Color &other) {
+	if (this != &other) {
+		copyState (other);
+	}
+	return (*this);
+}
+
+void Color::copyState (const Color &other) {
+	uint8_t lastr, lastg, lastb, lasta;
+
+	lastr = rByte;
+	lastg = gByte;
+	lastb = bByte;
+	lasta = aByte;
+	r = other.r;
+	g = other.g;
+	b = other.b;
+	a = other.a;
+	isTranslating = other.isTranslating;
+	isAnimating = other.isAnimating;
+	translateDuration = other.translateDuration;
+	animateDuration = other.animateDuration;
+	animateRepeatDelay = other.animateRepeatDelay;
+	animateStage = other.animateStage;
+	animateClock = other.animateClock;
+	targetR = other.targetR;
+	targetG = other.targetG;
+	targetB = other.targetB;
+	targetA = other.targetA;
+	deltaR = other.deltaR;
+	deltaG = other.deltaG;
+	deltaB = other.deltaB;
+	deltaA = other.deltaA;
+	animateColor1R = other.animateColor1R;
+	animateColor1G = other.animateColor1G;
+	animateColor1B = other.animateColor1B;
+	animateColor1A = other.animateColor1A;
+	animateColor2R = other.animateColor2R;
+	animateColor2G = other.animateColor2G;
+	animateColor2B = other.animateColor2B;
+	animateColor2A = other.animateColor2A;
+	normalize ();
+	addOwnerDrawDamage (lastr, lastg, lastb, lasta);
+	if (isTranslating || isAnimating) {
+		schedule ();
+	}
+}
+
+void Color::setAnimationOwner (Widget *widget) {
+	animationOwner = widget;
+	if (isScheduled) {
+		AnimationTimeline::instance->addTween (this, Color::stepTween, animationOwner);
+	}
+}
+
+void Color::schedule () {
+	if (isScheduled || (! AnimationTimeline::instance)) {
+		return;
+	}
+	isScheduled = true;
+	AnimationTimeline::instance->addTween (this, Color::stepTween, animationOwner);
+}
+
+bool Color::stepTween (void *colorPtr, int msElapsed) {
+	Color *color;
 
+	color = (Color *) colorPtr;
+	color->update (msElapsed);
+	if (color->isTranslating || color->isAnimating) {
+		return (true);
+	}
+	color->isScheduled = false;
+	return (false);
 }
 
 void Color::normalize () {
@@ -110,20 +198,33 @@ Color Color::copy (float aValue) {
 }
 
 void Color::assign (float rValue, float gValue, float bValue) {
-	r = rValue;
-	g = gValue;
-	b = bValue;
-	isTranslating = false;
-	normalize ();
+	assign (rValue, gValue, bValue, a);
 }
 
 void Color::assign (float rValue, float gValue, float bValue, float aValue) {
+	uint8_t lastr, lastg, lastb, lasta;
+
+	lastr = rByte;
+	lastg = gByte;
+	lastb = bByte;
+	lasta = aByte;
 	r = rValue;
 	g = gValue;
 	b = bValue;
 	a = aValue;
 	isTranslating = false;
 	normalize ();
+	addOwnerDrawDamage (lastr, lastg, lastb, lasta);
+}
+
+void Color::addOwnerDrawDamage (uint8_t lastRByte, uint8_t lastGByte, uint8_t lastBByte, uint8_t lastAByte) {
+	// Owner widgets without a screen position are drawn with their initial colors
+	if ((! animationOwner) || (! animationOwner->isVisible) || (! animationOwner->hasScreenPosition)) {
+		return;
+	}
+	if ((rByte != lastRByte) || (gByte != lastGByte) || (bByte != lastBByte) || (aByte != lastAByte)) {
+		animationOwner->addDrawDamage ();
+	}
 }
 
 void Color::assign (const Color &sourceColor) {
@@ -307,6 +408,7 @@ void Color::translate (float translateTargetR, float translateTargetG, float tra
 	}
 
 	isTranslating = true;
+	schedule ();
 	translateDuration = durationMs;
 	targetR = translateTargetR;
 	targetG = translateTargetG;
@@ -365,6 +467,7 @@ void Color::translate (float translateTargetR, float translateTargetG, float tra
 	}
 
 	isTranslating = true;
+	schedule ();
 	translateDuration = durationMs;
 	targetR = translateTargetR;
 	targetG = translateTargetG;
@@ -406,6 +509,7 @@ void Color::animate (const Color &color1, const Color &color2, int durationMs, i
 	animateStage = 0;
 	animateClock = 0;
 	isAnimating = true;
+	schedule ();
 }
 
 bool Color::equals (const Color &other) const {
@@ -34,11 +34,16 @@
 
 #include "StdString.h"
 
+class Widget;
+
 class Color {
 public:
 	Color (float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 1.0f);
+	Color (const Color &other);
 	~Color ();
 
+	Color &operator= (const Color &other);
+
 	// Read-only data members
 	float r, g, b, a;
 	uint8_t rByte, gByte, bByte, aByte;
@@ -69,7 +74,10 @@ public:
 	void blend (float r, float g, float b, float alpha);
 	void blend (const Color &sourceColor, float alpha);
 
-	// Execute operations to update object state as appropriate for an elapsed millisecond time period
+	// Set the widget that should receive draw damage while the color is translating or animating. If no owner widget is set, translation steps mark the entire window as dirty.
+	void setAnimationOwner (Widget *widget);
+
+	// Execute operations to update object state as appropriate for an elapsed millisecond time period. Translations and animations are stepped by AnimationTimeline, so callers don't need to invoke this method.
 	void update (int msElapsed);
 
 	// Begin an operation to change the color's value over time
@@ -85,6 +93,20 @@ private:
 	// Clip the r, g, and b data members to valid ranges, and reset dependent data members
 	void normalize ();
 
+	// Copy the color's values and translation state from another color
+	void copyState (const Color &other);
+
+	// Add the color to the animation timeline if it isn't already scheduled
+	void schedule ();
+
+	// Add draw damage to the owner widget if it's visible on screen and the color's byte values differ from the provided ones
+	void addOwnerDrawDamage (uint8_t lastRByte, uint8_t lastGByte, uint8_t lastBByte, uint8_t lastAByte);
+
+	// Step the color provided in colorPtr, as an AnimationTimeline::StepFunction
+	static bool stepTween (void *colorPtr, int msElapsed);
+
+	Widget *animationOwner;
+	bool isScheduled;
 	int translateDuration;
 	int animateDuration;
 	int animateRepeatDelay;
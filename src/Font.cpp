@@ -81,6 +81,10 @@ void Font::clearGlyphMap () {
 }
 
 OsUtil::Result Font::load (Buffer *fontData, int pointSize) {
+	return (load (fontData->data, fontData->length, pointSize));
+}
+
+OsUtil::Result Font::load (const uint8_t *fontData, int fontDataLength, int pointSize) {
 	Font::Glyph glyph;
 	FT_GlyphSlot slot;
 	SDL_Surface *surface;
@@ -90,7 +94,7 @@ OsUtil::Result Font::load (Buffer *fontData, int pointSize) {
 	Uint32 *pixels, *dest, color, rmask, gmask, bmask, amask;
 	std::map<char, Font::Glyph>::iterator i, end;
 
-	result = FT_New_Memory_Face (freetype, (FT_Byte *) fontData->data, fontData->length, 0, &face);
+	result = FT_New_Memory_Face (freetype, (const FT_Byte *) fontData, fontDataLength, 0, &face);
 	if (result != 0) {
 		Log::err ("Failed to load font; name=\"%s\" err=\"FT_New_Memory_Face: %i\"", name.c_str (), result);
 		return (OsUtil::FreetypeOperationFailedError);
@@ -68,6 +68,9 @@ public:
 	// Load a font using the specified data buffer and point size. Returns a Result value.
 	OsUtil::Result load (Buffer *fontData, int pointSize);
 
+	// Load a font using the specified data and point size. The font reads its face directly from fontData, which must remain valid until the font is freed. Returns a Result value.
+	OsUtil::Result load (const uint8_t *fontData, int fontDataLength, int pointSize);
+
 	// Return a pointer to a Font::Glyph struct for the specified character, or NULL if no such glyph was found
 	Font::Glyph *getGlyph (char glyphCharacter);
 
@@ -34,6 +34,7 @@
 #include <math.h>
 #include "SDL2/SDL.h"
 #include "App.h"
+#include "Profiler.h"
 #include "StdString.h"
 #include "Sprite.h"
 #include "SpriteHandle.h"
@@ -52,6 +53,7 @@ Image::Image (Sprite *sprite, int spriteFrame, bool shouldDestroySprite)
 , isMouseHighlightScaled (false)
 , mouseHighlightScale (1.0f)
 {
+	drawColor.setAnimationOwner (this);
 	spriteHandle.frame = spriteFrame;
 	maxSpriteWidth = (float) sprite->maxWidth;
 	maxSpriteHeight = (float) sprite->maxHeight;
@@ -88,6 +90,7 @@ void Image::setFrame (int frame) {
 	}
 	spriteHandle.frame = frame;
 	resetSize ();
+	addDrawDamage ();
 }
 
 void Image::setMouseHighlightScale (bool enable, float highlightScale) {
@@ -157,10 +160,7 @@ void Image::doUpdate (int msElapsed) {
 	if (translateAlphaValue.isTranslating) {
 		translateAlphaValue.update (msElapsed);
 		drawAlpha = translateAlphaValue.x;
-	}
-
-	if (isDrawColorEnabled) {
-		drawColor.update (msElapsed);
+		addDrawDamage ();
 	}
 }
 
@@ -180,11 +180,13 @@ void Image::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 	rect.w = (int) width;
 	rect.h = (int) height;
 
+	App::instance->flushDrawBatch ();
 	SDL_SetTextureAlphaMod (texture, (Uint8) (drawAlpha * 255.0f));
 	if (isDrawColorEnabled) {
 		SDL_SetTextureColorMod (texture, drawColor.rByte, drawColor.gByte, drawColor.bByte);
 	}
-	SDL_RenderCopy (App::instance->render, texture, NULL, &rect);
+	SDL_RenderCopy (App::instance->render, texture, spriteHandle.getSourceRect (), &rect);
+	Profiler::instance->addCount (Profiler::RenderCallCounter);
 	if (isDrawColorEnabled) {
 		SDL_SetTextureColorMod (texture, 255, 255, 255);
 	}
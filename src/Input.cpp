@@ -53,6 +53,8 @@ Input::Input ()
 , mouseWheelDownCount (0)
 , mouseWheelUpCount (0)
 , windowCloseCount (0)
+, windowEventCount (0)
+, eventCount (0)
 , isKeyPressListPopulated (false)
 , isKeyRepeating (false)
 , keyRepeatCode (SDLK_UNKNOWN)
@@ -160,6 +162,7 @@ void Input::pollEvents () {
 	while (SDL_PollEvent (&event)) {
 		switch (event.type) {
 			case SDL_KEYDOWN: {
+				++eventCount;
 				i = keyDownMap.find (event.key.keysym.sym);
 				if (i == keyDownMap.end ()) {
 					break;
@@ -178,6 +181,7 @@ void Input::pollEvents () {
 				break;
 			}
 			case SDL_KEYUP: {
+				++eventCount;
 				i = keyDownMap.find (event.key.keysym.sym);
 				if (i == keyDownMap.end ()) {
 					break;
@@ -190,6 +194,7 @@ void Input::pollEvents () {
 				break;
 			}
 			case SDL_MOUSEBUTTONDOWN: {
+				++eventCount;
 				if (event.button.button == SDL_BUTTON_LEFT) {
 					isMouseLeftButtonDown = true;
 					++mouseLeftDownCount;
@@ -201,6 +206,7 @@ void Input::pollEvents () {
 				break;
 			}
 			case SDL_MOUSEBUTTONUP: {
+				++eventCount;
 				if (event.button.button == SDL_BUTTON_LEFT) {
 					isMouseLeftButtonDown = false;
 					++mouseLeftUpCount;
@@ -211,7 +217,12 @@ void Input::pollEvents () {
 				}
 				break;
 			}
+			case SDL_MOUSEMOTION: {
+				++eventCount;
+				break;
+			}
 			case SDL_MOUSEWHEEL: {
+				++eventCount;
 				if (event.wheel.direction == SDL_MOUSEWHEEL_NORMAL) {
 					if (event.wheel.y < 0) {
 						++mouseWheelDownCount;
@@ -231,6 +242,8 @@ void Input::pollEvents () {
 				break;
 			}
 			case SDL_WINDOWEVENT: {
+				++eventCount;
+				++windowEventCount;
 				if (event.window.event == SDL_WINDOWEVENT_CLOSE) {
 					++windowCloseCount;
 				}
@@ -252,6 +265,7 @@ void Input::pollEvents () {
 		if (isKeyRepeating) {
 			if ((keyRepeatStartTime <= 0) || ((now - keyRepeatStartTime) >= keyRepeatDelay)) {
 				keyRepeatStartTime = now;
+				++eventCount;
 				SDL_LockMutex (keyPressListMutex);
 				keyPressList.push_back (keyRepeatCode);
 				isKeyPressListPopulated = true;
@@ -55,6 +55,8 @@ public:
 	int mouseLeftUpCount, mouseRightUpCount;
 	int mouseWheelDownCount, mouseWheelUpCount;
 	int windowCloseCount;
+	int windowEventCount;
+	int64_t eventCount;
 
 	// Initialize input functionality and acquire resources as needed. Returns a Result value.
 	OsUtil::Result start ();
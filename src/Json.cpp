@@ -33,7 +33,6 @@
 #include <string.h>
 #include <stdarg.h>
 #include <math.h>
-#include <map>
 #include <vector>
 #include <list>
 #include "json-parser.h"
@@ -42,10 +41,15 @@
 #include "StdString.h"
 #include "Json.h"
 
+const size_t Json::MinArenaBlockSize = 4096;
+const size_t Json::MaxArenaBlockSize = 1048576;
+const size_t Json::ArenaAlignment = 16;
+
 Json::Json ()
 : json (NULL)
 , shouldFreeJson (false)
 , isJsonBuilder (false)
+, arena (NULL)
 {
 
 }
@@ -64,16 +68,15 @@ bool Json::isAssigned () {
 
 void Json::unassign () {
 	if (json) {
-		if (shouldFreeJson) {
-			if (isJsonBuilder) {
-				json_builder_free (json);
-			}
-			else {
-				json_value_free (json);
-			}
+		if (shouldFreeJson && (! arena)) {
+			json_builder_free (json);
 		}
 		json = NULL;
 	}
+	if (arena) {
+		Json::freeArena (arena);
+		arena = NULL;
+	}
 	shouldFreeJson = false;
 	isJsonBuilder = false;
 }
@@ -103,27 +106,25 @@ void Json::jsonObjectPush (const json_char *name, json_value *value) {
 	json_object_push (json, name, value);
 }
 
-bool Json::exists (const StdString &key) const {
-	int i, len;
+json_value *Json::findValue (const char *key, int keyLength) const {
 	json_object_entry *entry;
 
 	if (! json) {
-		return (false);
+		return (NULL);
 	}
-
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			return (true);
-		}
+	entry = json_object_find (json, key, (unsigned int) keyLength);
+	if (! entry) {
+		return (NULL);
 	}
+	return (entry->value);
+}
 
-	return (false);
+bool Json::exists (const StdString &key) const {
+	return (findValue (key.c_str (), key.length ()) ? true : false);
 }
 
 bool Json::exists (const char *key) const {
-	return (exists (StdString (key)));
+	return (findValue (key, strlen (key)) ? true : false);
 }
 
 void Json::getKeys (std::vector<StdString> *destVector, bool shouldClear) {
@@ -158,147 +159,134 @@ void Json::getKeys (StringList *destList, bool shouldClear) {
 	}
 }
 
-bool Json::isNull (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
+bool Json::isValueType (json_value *value, json_type type) {
+	if (! value) {
 		return (false);
 	}
+	return ((value->type == type) ? true : false);
+}
 
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			return ((entry->value->type == json_null) ? true : false);
-		}
+bool Json::isValueNumber (json_value *value) {
+	if (! value) {
+		return (false);
 	}
+	return (((value->type == json_integer) || (value->type == json_double)) ? true : false);
+}
 
-	return (false);
+bool Json::isNull (const StdString &key) const {
+	return (Json::isValueType (findValue (key.c_str (), key.length ()), json_null));
 }
 
 bool Json::isNull (const char *key) const {
-	return (isNull (StdString (key)));
+	return (Json::isValueType (findValue (key, strlen (key)), json_null));
 }
 
 bool Json::isNumber (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (false);
-	}
-
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_integer: {
-					return (true);
-				}
-				case json_double: {
-					return (true);
-				}
-				default: {
-					return (false);
-				}
-			}
-			break;
-		}
-	}
-
-	return (false);
+	return (Json::isValueNumber (findValue (key.c_str (), key.length ())));
 }
 
 bool Json::isNumber (const char *key) const {
-	return (isNumber (StdString (key)));
+	return (Json::isValueNumber (findValue (key, strlen (key))));
 }
 
 bool Json::isBoolean (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (false);
-	}
-
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			return ((entry->value->type == json_boolean) ? true : false);
-		}
-	}
-
-	return (false);
+	return (Json::isValueType (findValue (key.c_str (), key.length ()), json_boolean));
 }
 
 bool Json::isBoolean (const char *key) const {
-	return (isBoolean (StdString (key)));
+	return (Json::isValueType (findValue (key, strlen (key)), json_boolean));
 }
 
 bool Json::isString (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (false);
-	}
-
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			return ((entry->value->type == json_string) ? true : false);
-		}
-	}
-
-	return (false);
+	return (Json::isValueType (findValue (key.c_str (), key.length ()), json_string));
 }
 
 bool Json::isString (const char *key) const {
-	return (isString (StdString (key)));
+	return (Json::isValueType (findValue (key, strlen (key)), json_string));
 }
 
 bool Json::isArray (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
+	return (Json::isValueType (findValue (key.c_str (), key.length ()), json_array));
+}
 
-	if (! json) {
-		return (false);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			if (entry->value->type == json_array) {
-				return (true);
+bool Json::isArray (const char *key) const {
+	return (Json::isValueType (findValue (key, strlen (key)), json_array));
+}
+
+void *Json::arenaAlloc (size_t size, int zero, void *arenaPtr) {
+	Json::ArenaBlock **arenaptr, *block;
+	size_t headersize, blocksize;
+	uint8_t *ptr;
+
+	arenaptr = (Json::ArenaBlock **) arenaPtr;
+	headersize = (sizeof (Json::ArenaBlock) + Json::ArenaAlignment - 1) & ~(Json::ArenaAlignment - 1);
+	size = (size + Json::ArenaAlignment - 1) & ~(Json::ArenaAlignment - 1);
+	block = *arenaptr;
+	if ((! block) || ((block->size - block->used) < size)) {
+		blocksize = Json::MinArenaBlockSize;
+		if (block) {
+			blocksize = block->size * 2;
+			if (blocksize > Json::MaxArenaBlockSize) {
+				blocksize = Json::MaxArenaBlockSize;
 			}
-			break;
 		}
+		if (blocksize < size) {
+			blocksize = size;
+		}
+		block = (Json::ArenaBlock *) malloc (headersize + blocksize);
+		if (! block) {
+			return (NULL);
+		}
+		block->next = *arenaptr;
+		block->size = blocksize;
+		block->used = 0;
+		*arenaptr = block;
 	}
-	return (false);
+
+	ptr = ((uint8_t *) block) + headersize + block->used;
+	block->used += size;
+	if (zero) {
+		memset (ptr, 0, size);
+	}
+	return (ptr);
 }
 
-bool Json::isArray (const char *key) const {
-	return (isArray (StdString (key)));
+void Json::arenaFree (void *, void *) {
+	// Arena memory is released by freeArena
+}
+
+void Json::freeArena (Json::ArenaBlock *arena) {
+	Json::ArenaBlock *next;
+
+	while (arena) {
+		next = arena->next;
+		free (arena);
+		arena = next;
+	}
 }
 
 bool Json::parse (const char *data, const int dataLength) {
 	json_settings settings;
 	json_value *value;
+	Json::ArenaBlock *parsearena;
 	char buf[json_error_max];
 
+	// Allocate all parsed values from a private arena, replacing many small allocations and frees with a few block allocations and a single release
+	parsearena = NULL;
 	memset (&settings, 0, sizeof (settings));
 	settings.value_extra = json_builder_extra;
+	settings.mem_alloc = Json::arenaAlloc;
+	settings.mem_free = Json::arenaFree;
+	settings.user_data = &parsearena;
 	value = json_parse_ex (&settings, data, dataLength, buf);
 	if (! value) {
+		Json::freeArena (parsearena);
 		return (false);
 	}
 
 	unassign ();
 	json = value;
+	arena = parsearena;
 	shouldFreeJson = true;
 	isJsonBuilder = false;
 	return (true);
@@ -316,7 +304,9 @@ void Json::assign (Json *otherJson) {
 
 	if (otherJson->json) {
 		setJsonValue (otherJson->json, otherJson->isJsonBuilder);
+		arena = otherJson->arena;
 		otherJson->json = NULL;
+		otherJson->arena = NULL;
 		shouldFreeJson = true;
 	}
 	else {
@@ -334,6 +324,19 @@ void Json::copyValue (Json *sourceJson) {
 	shouldFreeJson = true;
 }
 
+json_value *Json::takeJsonValue () {
+	json_value *value;
+
+	value = json;
+	if (value && arena) {
+		// Arena blocks are released as a unit when this object is deleted, so the receiving value needs its own copy
+		value = copyJsonValue (json);
+		unassign ();
+	}
+	json = NULL;
+	return (value);
+}
+
 Json *Json::copy () {
 	Json *j;
 
@@ -342,6 +345,28 @@ Json *Json::copy () {
 	return (j);
 }
 
+Json *Json::copy (const StringList &omitKeys) {
+	Json *j;
+	json_object_entry *entry;
+	StdString name;
+	int i, len;
+
+	j = new Json ();
+	j->setEmpty ();
+	if ((! json) || (json->type != json_object)) {
+		return (j);
+	}
+	len = json->u.object.length;
+	for (i = 0; i < len; ++i) {
+		entry = &(json->u.object.values[i]);
+		name.assign (entry->name, entry->name_length);
+		if (! omitKeys.contains (name)) {
+			j->jsonObjectPush (name.c_str (), copyJsonValue (entry->value));
+		}
+	}
+	return (j);
+}
+
 json_value *Json::copyJsonValue (json_value *sourceValue) {
 	json_value *value;
 	json_object_entry *entry;
@@ -404,8 +429,7 @@ bool Json::deepEquals (Json *other) {
 }
 
 bool Json::deepEqualsValue (json_value *thisValue, json_value *otherValue) {
-	std::map<StdString, int> keymap;
-	std::map<StdString, int>::iterator pos;
+	json_object_entry *entry;
 	int i, len;
 	bool result;
 
@@ -457,19 +481,14 @@ bool Json::deepEqualsValue (json_value *thisValue, json_value *otherValue) {
 				break;
 			}
 
-			keymap.clear ();
-			for (i = 0; i < len; ++i) {
-				keymap.insert (std::pair<StdString, int> (StdString (thisValue->u.object.values[i].name, thisValue->u.object.values[i].name_length), i));
-			}
-
 			result = true;
 			for (i = 0; i < len; ++i) {
-				pos = keymap.find (StdString (otherValue->u.object.values[i].name, otherValue->u.object.values[i].name_length));
-				if (pos == keymap.end ()) {
+				entry = json_object_find (thisValue, otherValue->u.object.values[i].name, otherValue->u.object.values[i].name_length);
+				if (! entry) {
 					result = false;
 					break;
 				}
-				if (! deepEqualsValue (thisValue->u.object.values[pos->second].value, otherValue->u.object.values[i].value)) {
+				if (! deepEqualsValue (entry->value, otherValue->u.object.values[i].value)) {
 					result = false;
 					break;
 				}
@@ -484,563 +503,267 @@ bool Json::deepEqualsValue (json_value *thisValue, json_value *otherValue) {
 	return (result);
 }
 
-int Json::getNumber (const StdString &key, int defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
+int Json::getValueNumber (json_value *value, int defaultValue) {
+	if (! value) {
 		return (defaultValue);
 	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_integer: {
-					return (entry->value->u.integer);
-				}
-				case json_double: {
-					return ((int) entry->value->u.dbl);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
+	switch (value->type) {
+		case json_integer: {
+			return (value->u.integer);
+		}
+		case json_double: {
+			return ((int) value->u.dbl);
+		}
+		default: {
+			return (defaultValue);
 		}
 	}
-	return (defaultValue);
 }
 
-int Json::getNumber (const char *key, int defaultValue) const {
-	return (getNumber (StdString (key), defaultValue));
+int64_t Json::getValueNumber (json_value *value, int64_t defaultValue) {
+	if (! value) {
+		return (defaultValue);
+	}
+	switch (value->type) {
+		case json_integer: {
+			return ((int64_t) value->u.integer);
+		}
+		case json_double: {
+			return ((int64_t) value->u.dbl);
+		}
+		default: {
+			return (defaultValue);
+		}
+	}
 }
 
-int64_t Json::getNumber (const StdString &key, int64_t defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
+double Json::getValueNumber (json_value *value, double defaultValue) {
+	if (! value) {
 		return (defaultValue);
 	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_integer: {
-					return ((int64_t) entry->value->u.integer);
-				}
-				case json_double: {
-					return ((int64_t) entry->value->u.dbl);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
+	switch (value->type) {
+		case json_integer: {
+			return ((double) value->u.integer);
+		}
+		case json_double: {
+			return (value->u.dbl);
+		}
+		default: {
+			return (defaultValue);
 		}
 	}
-	return (defaultValue);
 }
 
-int64_t Json::getNumber (const char *key, int64_t defaultValue) const {
-	return (getNumber (StdString (key), defaultValue));
+float Json::getValueNumber (json_value *value, float defaultValue) {
+	if (! value) {
+		return (defaultValue);
+	}
+	switch (value->type) {
+		case json_integer: {
+			return ((float) value->u.integer);
+		}
+		case json_double: {
+			return ((float) value->u.dbl);
+		}
+		default: {
+			return (defaultValue);
+		}
+	}
 }
 
-double Json::getNumber (const StdString &key, double defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
+bool Json::getValueBoolean (json_value *value, bool defaultValue) {
+	if ((! value) || (value->type != json_boolean)) {
+		return (defaultValue);
+	}
+	return (value->u.boolean);
+}
 
-	if (! json) {
+StdString Json::getValueString (json_value *value, const StdString &defaultValue) {
+	if ((! value) || (value->type != json_string)) {
 		return (defaultValue);
 	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_integer: {
-					return ((double) entry->value->u.integer);
-				}
-				case json_double: {
-					return (entry->value->u.dbl);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
+	return (StdString (value->u.string.ptr, value->u.string.length));
+}
+
+StdString Json::getValueString (json_value *value, const char *defaultValue) {
+	if ((! value) || (value->type != json_string)) {
+		return (StdString (defaultValue));
+	}
+	return (StdString (value->u.string.ptr, value->u.string.length));
+}
+
+json_value *Json::getArrayItem (json_value *value, int index) {
+	if ((! value) || (value->type != json_array) || (index < 0) || (index >= (int) value->u.array.length)) {
+		return (NULL);
 	}
-	return (defaultValue);
+	return (value->u.array.values[index]);
+}
+
+int Json::getNumber (const StdString &key, int defaultValue) const {
+	return (Json::getValueNumber (findValue (key.c_str (), key.length ()), defaultValue));
+}
+
+int Json::getNumber (const char *key, int defaultValue) const {
+	return (Json::getValueNumber (findValue (key, strlen (key)), defaultValue));
+}
+
+int64_t Json::getNumber (const StdString &key, int64_t defaultValue) const {
+	return (Json::getValueNumber (findValue (key.c_str (), key.length ()), defaultValue));
+}
+
+int64_t Json::getNumber (const char *key, int64_t defaultValue) const {
+	return (Json::getValueNumber (findValue (key, strlen (key)), defaultValue));
+}
+
+double Json::getNumber (const StdString &key, double defaultValue) const {
+	return (Json::getValueNumber (findValue (key.c_str (), key.length ()), defaultValue));
 }
 
 double Json::getNumber (const char *key, double defaultValue) const {
-	return (getNumber (StdString (key), defaultValue));
+	return (Json::getValueNumber (findValue (key, strlen (key)), defaultValue));
 }
 
 float Json::getNumber (const StdString &key, float defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_integer: {
-					return ((float) entry->value->u.integer);
-				}
-				case json_double: {
-					return ((float) entry->value->u.dbl);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueNumber (findValue (key.c_str (), key.length ()), defaultValue));
 }
 
 float Json::getNumber (const char *key, float defaultValue) const {
-	return (getNumber (StdString (key), defaultValue));
+	return (Json::getValueNumber (findValue (key, strlen (key)), defaultValue));
 }
 
 bool Json::getBoolean (const StdString &key, bool defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_boolean: {
-					return (entry->value->u.boolean);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueBoolean (findValue (key.c_str (), key.length ()), defaultValue));
 }
 
 bool Json::getBoolean (const char *key, bool defaultValue) const {
-	return (getBoolean (StdString (key), defaultValue));
+	return (Json::getValueBoolean (findValue (key, strlen (key)), defaultValue));
 }
 
 StdString Json::getString (const StdString &key, const StdString &defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-
-	if (! json) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_string: {
-					return (StdString (entry->value->u.string.ptr, entry->value->u.string.length));
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueString (findValue (key.c_str (), key.length ()), defaultValue));
 }
 
 StdString Json::getString (const char *key, const StdString &defaultValue) const {
-	return (getString (StdString (key), defaultValue));
+	return (Json::getValueString (findValue (key, strlen (key)), defaultValue));
 }
 
 StdString Json::getString (const StdString &key, const char *defaultValue) const {
-	return (getString (key, StdString (defaultValue)));
+	return (Json::getValueString (findValue (key.c_str (), key.length ()), defaultValue));
 }
 
 StdString Json::getString (const char *key, const char *defaultValue) const {
-	return (getString (StdString (key), StdString (defaultValue)));
+	return (Json::getValueString (findValue (key, strlen (key)), defaultValue));
 }
 
-bool Json::getStringList (const StdString &key, StringList *destList) const {
+bool Json::getValueStringList (json_value *value, StringList *destList) {
 	int i, len;
 
 	destList->clear ();
-	if (! isArray (key)) {
+	if ((! value) || (value->type != json_array)) {
 		return (false);
 	}
-
-	len = getArrayLength (key);
-	if (len <= 0) {
-		return (true);
-	}
-
+	len = value->u.array.length;
 	for (i = 0; i < len; ++i) {
-		destList->push_back (getArrayString (key, i, StdString ("")));
+		destList->push_back (Json::getValueString (value->u.array.values[i], ""));
 	}
 	return (true);
 }
 
-bool Json::getStringList (const char *key, StringList *destList) const {
-	return (getStringList (StdString (key), destList));
+bool Json::getStringList (const StdString &key, StringList *destList) const {
+	return (Json::getValueStringList (findValue (key.c_str (), key.length ()), destList));
 }
 
-bool Json::getObject (const StdString &key, Json *destJson) {
-	int i, len;
-	json_object_entry *entry;
+bool Json::getStringList (const char *key, StringList *destList) const {
+	return (Json::getValueStringList (findValue (key, strlen (key)), destList));
+}
 
-	if (! json) {
+bool Json::getValueObject (json_value *value, Json *destJson) {
+	if ((! value) || (value->type != json_object)) {
 		return (false);
 	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_object: {
-					if (destJson) {
-						destJson->setJsonValue (entry->value, isJsonBuilder);
-					}
-					return (true);
-				}
-				default: {
-					return (false);
-				}
-			}
-			break;
-		}
+	if (destJson) {
+		destJson->setJsonValue (value, isJsonBuilder);
 	}
-	return (false);
+	return (true);
 }
 
-bool Json::getObject (const char *key, Json *destJson) {
-	return (getObject (StdString (key), destJson));
+bool Json::getObject (const StdString &key, Json *destJson) {
+	return (getValueObject (findValue (key.c_str (), key.length ()), destJson));
 }
 
-int Json::getArrayLength (const StdString &key) const {
-	int i, len;
-	json_object_entry *entry;
+bool Json::getObject (const char *key, Json *destJson) {
+	return (getValueObject (findValue (key, strlen (key)), destJson));
+}
 
-	if (! json) {
+int Json::getValueArrayLength (json_value *value) {
+	if ((! value) || (value->type != json_array)) {
 		return (0);
 	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					return (entry->value->u.array.length);
-				}
-				default: {
-					return (0);
-				}
-			}
-			break;
-		}
-	}
-	return (0);
+	return (value->u.array.length);
+}
+
+int Json::getArrayLength (const StdString &key) const {
+	return (Json::getValueArrayLength (findValue (key.c_str (), key.length ())));
 }
 
 int Json::getArrayLength (const char *key) const {
-	return (getArrayLength (StdString (key)));
+	return (Json::getValueArrayLength (findValue (key, strlen (key))));
 }
 
 int Json::getArrayNumber (const StdString &key, int index, int defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_integer) {
-						return (item->u.integer);
-					}
-					else if (item->type == json_double) {
-						return ((int) item->u.dbl);
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 int Json::getArrayNumber (const char *key, int index, int defaultValue) const {
-	return (getArrayNumber (StdString (key), index, defaultValue));
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 int64_t Json::getArrayNumber (const StdString &key, int index, int64_t defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_integer) {
-						return ((int64_t) item->u.integer);
-					}
-					else if (item->type == json_double) {
-						return ((int64_t) item->u.dbl);
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 int64_t Json::getArrayNumber (const char *key, int index, int64_t defaultValue) const {
-	return (getArrayNumber (StdString (key), index, defaultValue));
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 double Json::getArrayNumber (const StdString &key, int index, double defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_integer) {
-						return ((double) item->u.integer);
-					}
-					else if (item->type == json_double) {
-						return (item->u.dbl);
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 double Json::getArrayNumber (const char *key, int index, double defaultValue) const {
-	return (getArrayNumber (StdString (key), index, defaultValue));
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 float Json::getArrayNumber (const StdString &key, int index, float defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_integer) {
-						return ((float) item->u.integer);
-					}
-					else if (item->type == json_double) {
-						return ((float) item->u.dbl);
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 float Json::getArrayNumber (const char *key, int index, float defaultValue) const {
-	return (getArrayNumber (StdString (key), index, defaultValue));
+	return (Json::getValueNumber (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 StdString Json::getArrayString (const StdString &key, int index, const StdString &defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_string) {
-						return (StdString (item->u.string.ptr, item->u.string.length));
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueString (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 StdString Json::getArrayString (const char *key, int index, const StdString &defaultValue) const {
-	return (getArrayString (StdString (key), index, defaultValue));
+	return (Json::getValueString (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 bool Json::getArrayBoolean (const StdString &key, int index, bool defaultValue) const {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (defaultValue);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (defaultValue);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type == json_boolean) {
-						return (item->u.boolean);
-					}
-
-					return (defaultValue);
-				}
-				default: {
-					return (defaultValue);
-				}
-			}
-			break;
-		}
-	}
-	return (defaultValue);
+	return (Json::getValueBoolean (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), defaultValue));
 }
 
 bool Json::getArrayBoolean (const char *key, int index, bool defaultValue) const {
-	return (getArrayBoolean (StdString (key), index, defaultValue));
+	return (Json::getValueBoolean (Json::getArrayItem (findValue (key, strlen (key)), index), defaultValue));
 }
 
 bool Json::getArrayObject (const StdString &key, int index, Json *destJson) {
-	int i, len;
-	json_object_entry *entry;
-	json_value *item;
-
-	if ((! json) || (index < 0)) {
-		return (false);
-	}
-	len = json->u.object.length;
-	for (i = 0; i < len; ++i) {
-		entry = &(json->u.object.values[i]);
-		if (key.equals (0, key.length (), entry->name, 0, entry->name_length)) {
-			switch (entry->value->type) {
-				case json_array: {
-					if (index >= (int) entry->value->u.array.length) {
-						return (false);
-					}
-					item = entry->value->u.array.values[index];
-					if (item->type != json_object) {
-						return (false);
-					}
-
-					if (destJson) {
-						destJson->setJsonValue (item, isJsonBuilder);
-					}
-					return (true);
-				}
-				default: {
-					return (false);
-				}
-			}
-			break;
-		}
-	}
-	return (false);
+	return (getValueObject (Json::getArrayItem (findValue (key.c_str (), key.length ()), index), destJson));
 }
 
 bool Json::getArrayObject (const char *key, int index, Json *destJson) {
-	return (getArrayObject (StdString (key), index, destJson));
+	return (getValueObject (Json::getArrayItem (findValue (key, strlen (key)), index), destJson));
 }
 
 Json *Json::set (const StdString &key, const char *value) {
@@ -1108,8 +831,7 @@ Json *Json::set (const char *key, const bool value) {
 
 Json *Json::set (const StdString &key, Json *value) {
 	if (value->json) {
-		jsonObjectPush (key.c_str (), value->json);
-		value->json = NULL;
+		jsonObjectPush (key.c_str (), value->takeJsonValue ());
 	}
 	else {
 		jsonObjectPush (key.c_str (), json_object_new (0));
@@ -1249,8 +971,7 @@ Json *Json::set (const StdString &key, std::vector<Json *> *value) {
 		if (! item->json) {
 			item->setEmpty ();
 		}
-		json_array_push (a, item->json);
-		item->json = NULL;
+		json_array_push (a, item->takeJsonValue ());
 		delete (item);
 		++i;
 	}
@@ -1276,8 +997,7 @@ Json *Json::set (const StdString &key, std::list<Json *> *value) {
 		if (! item->json) {
 			item->setEmpty ();
 		}
-		json_array_push (a, item->json);
-		item->json = NULL;
+		json_array_push (a, item->takeJsonValue ());
 		delete (item);
 		++i;
 	}
@@ -1303,8 +1023,7 @@ Json *Json::set (const StdString &key, JsonList *value) {
 		if (! item->json) {
 			item->setEmpty ();
 		}
-		json_array_push (a, item->json);
-		item->json = NULL;
+		json_array_push (a, item->takeJsonValue ());
 		++i;
 	}
 	jsonObjectPush (key.c_str (), a);
@@ -75,6 +75,9 @@ public:
 	// Return a newly created Json object with contents copied from this object
 	Json *copy ();
 
+	// Return a newly created Json object with contents copied from this object, omitting any fields whose names appear in omitKeys
+	Json *copy (const StringList &omitKeys);
+
 	// Return a boolean value indicating if the object's content matches that of another
 	bool deepEquals (Json *other);
 
@@ -205,6 +208,20 @@ public:
 	Json *setNull (const char *key);
 
 private:
+	// A block of memory holding values allocated by json-parser, followed by its data area
+	struct ArenaBlock {
+		Json::ArenaBlock *next;
+		size_t size;
+		size_t used;
+	};
+
+	// The size of the first arena block allocated for a parse. Each later block doubles in size, up to MaxArenaBlockSize.
+	static const size_t MinArenaBlockSize;
+	static const size_t MaxArenaBlockSize;
+
+	// The alignment of each allocation made from an arena block
+	static const size_t ArenaAlignment;
+
 	// Set the json value to a newly created builder object
 	void resetBuilder ();
 
@@ -217,12 +234,61 @@ private:
 	// Return a newly created json_value object containing a copy of the provided source value's data
 	json_value *copyJsonValue (json_value *sourceValue);
 
+	// Return the json pointer for insertion into another value and clear it from this object. If the value is held in an arena, return a separately allocated copy instead.
+	json_value *takeJsonValue ();
+
+	// Allocate memory from the arena referenced by arenaPtr (a Json::ArenaBlock ** value), for use as the json-parser mem_alloc function
+	static void *arenaAlloc (size_t size, int zero, void *arenaPtr);
+
+	// Ignore a request to free memory allocated from an arena, for use as the json-parser mem_free function. Arena memory is released by freeArena.
+	static void arenaFree (void *ptr, void *arenaPtr);
+
+	// Free all blocks in an arena
+	static void freeArena (Json::ArenaBlock *arena);
+
 	// Return a boolean value indicating if a value's content matches that of a value from another object
 	bool deepEqualsValue (json_value *thisValue, json_value *otherValue);
 
+	// Return the value stored under the named key, or NULL if no such key was found. Lookups in larger objects use a key hash index held by the json value, so the key need not be copied into a StdString.
+	json_value *findValue (const char *key, int keyLength) const;
+
+	// Return a boolean value indicating if the provided value is non-NULL and holds the specified type
+	static bool isValueType (json_value *value, json_type type);
+
+	// Return a boolean value indicating if the provided value is non-NULL and holds a number
+	static bool isValueNumber (json_value *value);
+
+	// Return the number held by the provided value, or the provided default if the value is NULL or not a number
+	static int getValueNumber (json_value *value, int defaultValue);
+	static int64_t getValueNumber (json_value *value, int64_t defaultValue);
+	static double getValueNumber (json_value *value, double defaultValue);
+	static float getValueNumber (json_value *value, float defaultValue);
+
+	// Return the boolean held by the provided value, or the provided default if the value is NULL or not a boolean
+	static bool getValueBoolean (json_value *value, bool defaultValue);
+
+	// Return the string held by the provided value, or the provided default if the value is NULL or not a string
+	static StdString getValueString (json_value *value, const StdString &defaultValue);
+	static StdString getValueString (json_value *value, const char *defaultValue);
+
+	// Store the strings held by the provided array value into destList, clearing it first. Returns a boolean value indicating if the value is an array.
+	static bool getValueStringList (json_value *value, StringList *destList);
+
+	// Store the provided object value in destJson. Returns a boolean value indicating if the value is an object.
+	bool getValueObject (json_value *value, Json *destJson);
+
+	// Return the length of the provided array value, or zero if the value is NULL or not an array
+	static int getValueArrayLength (json_value *value);
+
+	// Return the item at the specified index of the provided array value, or NULL if the value is not an array or holds no such item
+	static json_value *getArrayItem (json_value *value, int index);
+
 	json_value *json;
 	bool shouldFreeJson;
 	bool isJsonBuilder;
+
+	// Blocks holding the parsed value referenced by json, most recently allocated first, or NULL if the value was not parsed by this object
+	Json::ArenaBlock *arena;
 };
 
 // Json list class that extends std::list<Json *> and frees all contained Json objects when destroyed
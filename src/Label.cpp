@@ -33,6 +33,7 @@
 #include <string.h>
 #include "SDL2/SDL.h"
 #include "App.h"
+#include "Profiler.h"
 #include "StdString.h"
 #include "Sprite.h"
 #include "Resource.h"
@@ -58,6 +59,7 @@ Label::Label (const StdString &text, UiConfiguration::FontType fontType, const C
 , underlineMargin (0.0f)
 , textMutex (NULL)
 {
+	textColor.setAnimationOwner (this);
 	textColor.assign (color);
 	textMutex = SDL_CreateMutex ();
 	setText (text, fontType);
@@ -184,6 +186,7 @@ void Label::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 		return;
 	}
 
+	App::instance->flushDrawBatch ();
 	x0 = (int) (originX + position.x);
 	y0 = (int) (originY + position.y);
 	x = 0;
@@ -215,6 +218,7 @@ void Label::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 				rect.h = glyph->height;
 				SDL_SetTextureColorMod (glyph->texture, textColor.rByte, textColor.gByte, textColor.bByte);
 				SDL_RenderCopy (App::instance->render, glyph->texture, NULL, &rect);
+				Profiler::instance->addCount (Profiler::RenderCallCounter);
 			}
 
 			x += glyph->advanceWidth;
@@ -248,10 +252,6 @@ void Label::doRefresh () {
 	}
 }
 
-void Label::doUpdate (int msElapsed) {
-	textColor.update (msElapsed);
-}
-
 void Label::setText (const StdString &textContent, UiConfiguration::FontType fontType, bool forceFontReload) {
 	Font *font;
 	Font::Glyph *glyph;
@@ -283,6 +283,7 @@ void Label::setText (const StdString &textContent, UiConfiguration::FontType fon
 	if ((! font) && text.equals (textContent)) {
 		return;
 	}
+	addDrawDamage ();
 
 	SDL_LockMutex (textMutex);
 	text.assign (textContent);
@@ -92,9 +92,6 @@ public:
 	virtual void centerVertical (float topExtent, float bottomExtent);
 
 protected:
-	// Execute operations to update object state as appropriate for an elapsed millisecond time period
-	virtual void doUpdate (int msElapsed);
-
 	// Execute subclass-specific operations to refresh the widget's layout as appropriate for the current set of UiConfiguration values
 	virtual void doRefresh ();
 
@@ -77,10 +77,13 @@ MediaItemUi::MediaItemUi (const StdString &mediaId, const StdString &mediaName)
 , isCreateStreamAvailable (true)
 {
 	streamServerAgentMap.sort (HashMap::sortAscending);
+	RecordStore::instance->pinRecord (mediaId);
 }
 
 MediaItemUi::~MediaItemUi () {
-
+	if (RecordStore::instance) {
+		RecordStore::instance->unpinRecord (mediaId);
+	}
 }
 
 StdString MediaItemUi::getSpritePath () {
@@ -188,7 +191,8 @@ void MediaItemUi::doSyncRecordStore () {
 }
 
 void MediaItemUi::syncMediaItem () {
-	Json *mediaitem, *agentstatus, serverstatus, *params;
+	const RecordStore::MediaItem *mediaitem;
+	Json *record, *agentstatus, serverstatus, *params;
 	MediaThumbnailWindow *thumbnail;
 	IconCardWindow *iconcard;
 	IconLabelWindow *iconlabel;
@@ -198,15 +202,15 @@ void MediaItemUi::syncMediaItem () {
 	float dt;
 	int i;
 
-	mediaitem = RecordStore::instance->findRecord (mediaId, SystemInterface::CommandId_MediaItem);
+	mediaitem = RecordStore::instance->findMediaItem (mediaId);
 	if (! mediaitem) {
 		return;
 	}
-	agentId = SystemInterface::instance->getCommandAgentId (mediaitem);
+	agentId.assign (*(mediaitem->agentId));
 	if (agentId.empty ()) {
 		return;
 	}
-	agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentId);
+	agentstatus = RecordStore::instance->findAgentStatusRecord (agentId);
 	if (! agentstatus) {
 		return;
 	}
@@ -215,13 +219,13 @@ void MediaItemUi::syncMediaItem () {
 		thumbnailPath = serverstatus.getString ("thumbnailPath", "");
 		thumbnailCount = serverstatus.getNumber ("thumbnailCount", (int) 0);
 	}
-	duration = SystemInterface::instance->getCommandNumberParam (mediaitem, "duration", (int64_t) 0);
-	bitrate = SystemInterface::instance->getCommandNumberParam (mediaitem, "bitrate", (int64_t) 0);
-	frameWidth = SystemInterface::instance->getCommandNumberParam (mediaitem, "width", (int) 0);
-	frameHeight = SystemInterface::instance->getCommandNumberParam (mediaitem, "height", (int) 0);
-	frameRate = SystemInterface::instance->getCommandNumberParam (mediaitem, "frameRate", (float) 0.0f);
-	mediaSize = SystemInterface::instance->getCommandNumberParam (mediaitem, "size", (int64_t) 0);
-	isCreateStreamAvailable = SystemInterface::instance->getCommandBooleanParam (mediaitem, "isCreateStreamAvailable", true);
+	duration = (int64_t) mediaitem->duration;
+	bitrate = mediaitem->bitrate;
+	frameWidth = mediaitem->width;
+	frameHeight = mediaitem->height;
+	frameRate = (float) mediaitem->frameRate;
+	mediaSize = mediaitem->size;
+	isCreateStreamAvailable = mediaitem->isCreateStreamAvailable;
 
 	if ((thumbnailCount > 0) && (frameWidth > 0) && (frameHeight > 0) && (! thumbnailPath.empty ())) {
 		dt = (float) duration / (float) thumbnailCount;
@@ -247,7 +251,7 @@ void MediaItemUi::syncMediaItem () {
 		nameWindow.assign (iconcard);
 		iconcard = (IconCardWindow *) nameWindow.widget;
 	}
-	text = SystemInterface::instance->getCommandStringParam (mediaitem, "name", "");
+	text.assign (mediaitem->name);
 	iconcard->setName (UiConfiguration::instance->fonts[UiConfiguration::TitleFont]->truncatedText (text, App::instance->windowWidth * MediaItemUi::TextWidthMultiplier, Font::DotTruncateSuffix), UiConfiguration::TitleFont);
 	iconcard->setSubtitle (AgentControl::instance->getAgentDisplayName (agentId));
 	iconcard->setSubtitleColor (UiConfiguration::instance->lightPrimaryTextColor);
@@ -322,9 +326,10 @@ void MediaItemUi::syncMediaItem () {
 	}
 
 	cardView->removeRowItems (MediaItemUi::TagRow);
+	record = RecordStore::instance->findRecord (mediaId, SystemInterface::CommandId_MediaItem);
 	i = 0;
-	while (true) {
-		text = SystemInterface::instance->getCommandStringArrayItem (mediaitem, "tags", i, StdString (""));
+	while (record) {
+		text = SystemInterface::instance->getCommandStringArrayItem (record, "tags", i, StdString (""));
 		if (text.empty ()) {
 			break;
 		}
@@ -239,6 +239,10 @@ void MediaLibraryWindow::syncRecordStore () {
 	resetNameLabel ();
 }
 
+bool MediaLibraryWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void MediaLibraryWindow::resetNameLabel () {
 	float w;
 
@@ -99,13 +99,16 @@ StdString MediaTimelineWindow::toStringDetail () {
 
 void MediaTimelineWindow::syncRecordStore () {
 	Json *record, *agentstatus, serverstatus;
+	const RecordStore::MediaItem *mediaitem;
+	const RecordStore::StreamItem *streamitem;
 
 	record = RecordStore::instance->findRecord (recordId, SystemInterface::CommandId_MediaItem);
-	if (record) {
+	mediaitem = RecordStore::instance->findMediaItem (recordId);
+	if (record && mediaitem) {
 		recordType = SystemInterface::CommandId_MediaItem;
-		agentId = SystemInterface::instance->getCommandAgentId (record);
-		duration = SystemInterface::instance->getCommandNumberParam (record, "duration", (float) 0.0f);
-		agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentId);
+		agentId.assign (*(mediaitem->agentId));
+		duration = (float) mediaitem->duration;
+		agentstatus = RecordStore::instance->findAgentStatusRecord (agentId);
 		if (agentstatus) {
 			if (SystemInterface::instance->getCommandObjectParam (agentstatus, "mediaServerStatus", &serverstatus)) {
 				thumbnailCount = serverstatus.getNumber ("thumbnailCount", (int) 0);
@@ -113,15 +116,19 @@ void MediaTimelineWindow::syncRecordStore () {
 		}
 	}
 
-	if (! record) {
+	else {
 		record = RecordStore::instance->findRecord (recordId, SystemInterface::CommandId_StreamItem);
-		if (record) {
+		streamitem = RecordStore::instance->findStreamItem (recordId);
+		if (record && streamitem) {
 			recordType = SystemInterface::CommandId_StreamItem;
-			agentId = SystemInterface::instance->getCommandAgentId (record);
-			duration = SystemInterface::instance->getCommandNumberParam (record, "duration", (float) 0.0f);
-			thumbnailCount = SystemInterface::instance->getCommandNumberParam (record, "segmentCount", (int) 0);
+			agentId.assign (*(streamitem->agentId));
+			duration = (float) streamitem->duration;
+			thumbnailCount = streamitem->segmentCount;
 			SystemInterface::instance->getCommandNumberArrayParam (record, "segmentPositions", &segmentPositionList, true);
 		}
+		else {
+			record = NULL;
+		}
 	}
 
 	if (! record) {
@@ -134,6 +141,10 @@ void MediaTimelineWindow::syncRecordStore () {
 	refreshLayout ();
 }
 
+bool MediaTimelineWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return ((changes.recordIds.count (recordId) > 0) || (changes.recordIds.count (agentId) > 0));
+}
+
 void MediaTimelineWindow::populateMarkers () {
 	if ((! markerList.empty ()) || (recordType < 0)) {
 		return;
@@ -66,6 +66,9 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	void syncRecordStore ();
 
+	// Return a boolean value indicating if the widget must execute syncRecordStore to reflect the provided set of record changes
+	bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
 protected:
 	// Return a string that should be included as part of the toString method's output
 	StdString toStringDetail ();
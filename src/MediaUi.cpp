@@ -75,6 +75,8 @@ const char *MediaUi::VideoQualityKey = "Media_VideoQuality";
 const char *MediaUi::ShowMediaWithoutStreamsKey = "Media_ShowWithoutStreams";
 
 const int MediaUi::PageSize = 64;
+const int MediaUi::MaxPageRefetchCount = 3;
+const int64_t MediaUi::PageRefetchRetryPeriod = 10000;
 const float MediaUi::TextTruncateWidthScale = 0.25f;
 const float MediaUi::SearchFieldWidthScale = 0.27f;
 const float MediaUi::BottomPaddingHeightScale = 0.5f;
@@ -164,7 +166,7 @@ bool MediaUi::openWidget (const StdString &targetName) {
 	StdString name;
 
 	name.assign (targetName.lowercased ());
-	media = (MediaWindow *) cardView->findItem (findItem_matchMediaName, (char *) name.c_str ());
+	media = findMediaWindow (name);
 	if (media) {
 		media->eventCallback (media->viewButtonClickCallback);
 		return (true);
@@ -177,12 +179,44 @@ bool MediaUi::openWidget (const StdString &targetName) {
 	return (false);
 }
 
+MediaWindow *MediaUi::findMediaWindow (const StdString &mediaName) {
+	MediaWindow *media;
+	const RecordStore::MediaItem *mediaitem;
+	StringList ids;
+	StringList::iterator i, end;
+	StdString id;
+
+	media = (MediaWindow *) cardView->findItem (findItem_matchMediaName, (char *) mediaName.c_str ());
+	if (media) {
+		return (media);
+	}
+
+	// Cards without a widget are matched through the media item index, visiting only the records shown in the media row
+	cardView->getRowItemIds (MediaUi::MediaRow, &ids);
+	RecordStore::instance->lock ();
+	i = ids.begin ();
+	end = ids.end ();
+	while (i != end) {
+		mediaitem = RecordStore::instance->findMediaItem (*i);
+		if (mediaitem && mediaitem->name.lowercased ().equals (mediaName)) {
+			id.assign (*i);
+			break;
+		}
+		++i;
+	}
+	RecordStore::instance->unlock ();
+	if (id.empty ()) {
+		return (NULL);
+	}
+	return (MediaWindow::castWidget (cardView->realizeItem (id)));
+}
+
 bool MediaUi::selectWidget (const StdString &targetName) {
 	MediaWindow *media;
 	StdString name;
 
 	name.assign (targetName.lowercased ());
-	media = (MediaWindow *) cardView->findItem (findItem_matchMediaName, (char *) name.c_str ());
+	media = findMediaWindow (name);
 	if (media) {
 		media->setSelected (true);
 		return (true);
@@ -195,7 +229,7 @@ bool MediaUi::unselectWidget (const StdString &targetName) {
 	StdString name;
 
 	name.assign (targetName.lowercased ());
-	media = (MediaWindow *) cardView->findItem (findItem_matchMediaName, (char *) name.c_str ());
+	media = findMediaWindow (name);
 	if (media) {
 		media->setSelected (false);
 		return (true);
@@ -269,7 +303,7 @@ void MediaUi::doUnload () {
 	lastSelectedMediaWindow.clear ();
 	selectedPlaylistWindow.clear ();
 	selectedMonitorMap.clear ();
-	selectedMediaMap.clear ();
+	clearSelectedMedia ();
 	expandAgentsToggle.clear ();
 	expandPlaylistsToggle.clear ();
 	configureStreamSizeIcon.clear ();
@@ -280,6 +314,7 @@ void MediaUi::doUnload () {
 
 	SDL_LockMutex (mediaServerMapMutex);
 	mediaServerMap.clear ();
+	mediaPageMap.clear ();
 	SDL_UnlockMutex (mediaServerMapMutex);
 
 	RecordStore::instance->removeRecords (SystemInterface::CommandId_MediaItem);
@@ -588,17 +623,106 @@ bool MediaUi::doProcessKeyEvent (SDL_Keycode keycode, bool isShiftDown, bool isC
 }
 
 void MediaUi::doSyncRecordStore () {
-	IconCardWindow *window;
-	int type;
-
 	mediaServerCount = 0;
 	RecordStore::instance->processAgentRecords ("mediaServerStatus", MediaUi::doSyncRecordStore_processMediaServerAgent, this);
 	RecordStore::instance->processAgentRecords ("monitorServerStatus", MediaUi::doSyncRecordStore_processMonitorAgent, this);
 
+	SDL_LockMutex (findMediaStreamsMapMutex);
+	streamsReceivedIds.clear ();
+	SDL_UnlockMutex (findMediaStreamsMapMutex);
 	mediaItemCount = 0;
 	mediaStreamCount = 0;
 	RecordStore::instance->processCommandRecords (SystemInterface::CommandId_MediaItem, MediaUi::doSyncRecordStore_processMediaItem, this);
 
+	syncEmptyState ();
+	cardView->syncRecordStore ();
+	cardView->refresh ();
+	resetExpandToggles ();
+}
+
+void MediaUi::doSyncRecordStoreChanges (const RecordStore::ChangeSet &changes) {
+	std::vector<RecordStore::Change>::const_iterator i, end;
+	StringList mediaids;
+	StringList::iterator j, jend;
+	std::map<StdString, bool> mediaidmap;
+	const RecordStore::StreamItem *streamitem;
+	Json *record;
+
+	i = changes.changes.cbegin ();
+	end = changes.changes.cend ();
+	while (i != end) {
+		// Cards are removed by the operations that remove their records, so this sync only handles added and updated records. An evicted record keeps its page entry for use in fetching it again, while a removed record no longer has one.
+		if (i->changeType == RecordStore::RecordRemoved) {
+			if (i->commandId == SystemInterface::CommandId_MediaItem) {
+				SDL_LockMutex (mediaServerMapMutex);
+				mediaPageMap.erase (i->recordId);
+				SDL_UnlockMutex (mediaServerMapMutex);
+			}
+		}
+		else if (i->changeType != RecordStore::RecordEvicted) {
+			switch (i->commandId) {
+				case SystemInterface::CommandId_AgentStatus: {
+					record = RecordStore::instance->findRecord (i->recordId, SystemInterface::CommandId_AgentStatus);
+					if (record) {
+						if (SystemInterface::instance->getCommandObjectParam (record, "mediaServerStatus", NULL)) {
+							MediaUi::doSyncRecordStore_processMediaServerAgent (this, record, i->recordId);
+						}
+						if (SystemInterface::instance->getCommandObjectParam (record, "monitorServerStatus", NULL)) {
+							MediaUi::doSyncRecordStore_processMonitorAgent (this, record, i->recordId);
+						}
+					}
+					break;
+				}
+				case SystemInterface::CommandId_MediaItem: {
+					mediaids.push_back (i->recordId);
+					break;
+				}
+				case SystemInterface::CommandId_StreamItem: {
+					// A new stream can change the visibility of its source media item
+					streamitem = RecordStore::instance->findStreamItem (i->recordId);
+					if (streamitem && (! streamitem->sourceId.empty ())) {
+						mediaids.push_back (streamitem->sourceId);
+					}
+					break;
+				}
+			}
+		}
+		++i;
+	}
+
+	SDL_LockMutex (findMediaStreamsMapMutex);
+	mediaids.insertStringList (streamsReceivedIds);
+	streamsReceivedIds.clear ();
+	SDL_UnlockMutex (findMediaStreamsMapMutex);
+
+	j = mediaids.begin ();
+	jend = mediaids.end ();
+	while (j != jend) {
+		if (mediaidmap.count (*j) <= 0) {
+			mediaidmap.insert (std::pair<StdString, bool> (*j, true));
+			record = RecordStore::instance->findRecord (*j, SystemInterface::CommandId_MediaItem);
+			if (record) {
+				MediaUi::doSyncRecordStore_processMediaItem (this, record, *j);
+			}
+		}
+		++j;
+	}
+
+	// Counts gathered by process functions cover only changed records, so take totals from counts maintained by the store's indexes
+	mediaServerCount = RecordStore::instance->countAgentRecords ("mediaServerStatus");
+	mediaItemCount = RecordStore::instance->countCommandRecords (SystemInterface::CommandId_MediaItem);
+	mediaStreamCount = RecordStore::instance->countSourceStreamMediaItems ();
+
+	// Cards added above were placed by sorted insert, leaving the existing layout valid without a full refresh
+	syncEmptyState ();
+	cardView->syncRecordStoreChanges (changes);
+	resetExpandToggles ();
+}
+
+void MediaUi::syncEmptyState () {
+	IconCardWindow *window;
+	int type;
+
 	type = -1;
 	if (cardView->getRowItemCount (MediaUi::MediaRow) <= 0) {
 		if (mediaServerCount <= 0) {
@@ -653,10 +777,6 @@ void MediaUi::doSyncRecordStore () {
 		}
 	}
 	emptyStateType = type;
-
-	cardView->syncRecordStore ();
-	cardView->refresh ();
-	resetExpandToggles ();
 }
 
 void MediaUi::doSyncRecordStore_processMediaServerAgent (void *uiPtr, Json *record, const StdString &recordId) {
@@ -741,19 +861,24 @@ void MediaUi::doSyncRecordStore_processMonitorAgent (void *uiPtr, Json *record,
 
 void MediaUi::doSyncRecordStore_processMediaItem (void *uiPtr, Json *record, const StdString &recordId) {
 	MediaUi *ui;
-	MediaWindow *media;
-	StdString mediaid, agentid;
-	Json *params, *streamrecord;
+	const RecordStore::MediaItem *mediaitem;
+	const RecordStore::StreamItem *streamitem;
+	MediaUi::MediaPage page;
+	StdString agentid, sortkey;
+	Json *params;
 	int findstate;
 	bool show;
 
 	ui = (MediaUi *) uiPtr;
+	mediaitem = RecordStore::instance->findMediaItem (recordId);
+	if (! mediaitem) {
+		return;
+	}
 	++(ui->mediaItemCount);
 
-	agentid = SystemInterface::instance->getCommandAgentId (record);
-	mediaid.assign (recordId);
-	streamrecord = RecordStore::instance->findRecord (MediaWindow::matchStreamSourceId, &mediaid);
-	if (streamrecord) {
+	agentid.assign (*(mediaitem->agentId));
+	streamitem = RecordStore::instance->findSourceStreamItem (recordId);
+	if (streamitem) {
 		++(ui->mediaStreamCount);
 	}
 
@@ -775,7 +900,7 @@ void MediaUi::doSyncRecordStore_processMediaItem (void *uiPtr, Json *record, con
 	else if (findstate == MediaUi::StreamsReceivedState) {
 		if (! ui->cardView->contains (recordId)) {
 			show = true;
-			if ((!(ui->isShowingMediaWithoutStreams)) && (! streamrecord)) {
+			if ((!(ui->isShowingMediaWithoutStreams)) && (! streamitem)) {
 				show = false;
 			}
 			else {
@@ -783,45 +908,151 @@ void MediaUi::doSyncRecordStore_processMediaItem (void *uiPtr, Json *record, con
 				if (ui->mediaServerMap.count (agentid) <= 0) {
 					show = false;
 				}
+				else if (ui->mediaPageMap.count (recordId) <= 0) {
+					// A record restored from a store snapshot has no known result offset, so record its agent to allow the card to be fetched again after eviction
+					page.agentId.assign (agentid);
+					page.resultOffset = -1;
+					ui->mediaPageMap.insert (std::pair<StdString, MediaUi::MediaPage> (recordId, page));
+				}
 				SDL_UnlockMutex (ui->mediaServerMapMutex);
 			}
 
 			if (show) {
-				media = new MediaWindow (record, &(ui->sprites));
-				media->mediaImageClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowImageClicked, ui);
-				media->viewButtonClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowViewButtonClicked, ui);
-				media->browserPlayButtonClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowBrowserPlayButtonClicked, ui);
-				media->selectStateChangeCallback = Widget::EventCallbackContext (MediaUi::mediaWindowSelectStateChanged, ui);
 				if (ui->mediaSortOrder == SystemInterface::Constant_NewestSort) {
-					media->sortKey.sprintf ("%016llx", (long long int) (0x7FFFFFFFFFFFFFFFLL - SystemInterface::instance->getCommandNumberParam (record, "mtime", (int64_t) 0)));
+					sortkey.sprintf ("%016llx", (long long int) (0x7FFFFFFFFFFFFFFFLL - mediaitem->mtime));
 				}
 				else {
-					if (! media->mediaSortKey.empty ()) {
-						media->sortKey.assign (media->mediaSortKey);
-					}
-					else {
-						media->sortKey.assign (media->mediaName);
+					sortkey.assign (mediaitem->sortKey);
+					if (sortkey.empty ()) {
+						sortkey.assign (mediaitem->name);
 					}
 				}
-				if (ui->selectedMediaMap.exists (recordId)) {
-					media->setSelected (true, true);
-				}
-				ui->cardView->addItem (media, recordId, MediaUi::MediaRow);
+				ui->cardView->addVirtualItem (recordId, MediaUi::MediaRow, sortkey, CardView::ItemPanelContext (MediaUi::createMediaWindow, ui, MediaUi::resetMediaWindow));
 			}
 		}
 	}
 }
 
-bool MediaUi::matchMediaItem (void *idPtr, Widget *widget) {
-	StdString *id;
+Panel *MediaUi::createMediaWindow (void *uiPtr, const StdString &mediaId) {
+	MediaUi *ui;
 	MediaWindow *media;
+	const RecordStore::MediaItem *mediaitem;
 
-	media = MediaWindow::castWidget (widget);
+	ui = (MediaUi *) uiPtr;
+	media = NULL;
+	RecordStore::instance->lock ();
+	mediaitem = RecordStore::instance->findMediaItem (mediaId);
+	if (mediaitem) {
+		media = new MediaWindow (mediaitem, &(ui->sprites));
+		media->mediaImageClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowImageClicked, ui);
+		media->viewButtonClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowViewButtonClicked, ui);
+		media->browserPlayButtonClickCallback = Widget::EventCallbackContext (MediaUi::mediaWindowBrowserPlayButtonClicked, ui);
+		media->selectStateChangeCallback = Widget::EventCallbackContext (MediaUi::mediaWindowSelectStateChanged, ui);
+		if (ui->selectedMediaMap.exists (mediaId)) {
+			media->setSelected (true, true);
+		}
+		media->syncRecordStore ();
+	}
+	RecordStore::instance->unlock ();
+
+	// The store may have evicted the record while its card was out of view; the card view retries creation after the next record sync
+	if (! media) {
+		ui->requestMediaPage (mediaId);
+	}
+
+	return (media);
+}
+
+bool MediaUi::resetMediaWindow (void *uiPtr, Panel *itemPanel, const StdString &mediaId) {
+	MediaUi *ui;
+	MediaWindow *media;
+	const RecordStore::MediaItem *mediaitem;
+	bool found;
+
+	ui = (MediaUi *) uiPtr;
+	media = MediaWindow::castWidget (itemPanel);
 	if (! media) {
 		return (false);
 	}
-	id = (StdString *) idPtr;
-	return (id->equals (media->mediaId));
+
+	// Handles that refer to the window's previous media item must not follow it to a different item
+	if (! media->mediaId.equals (mediaId)) {
+		if (ui->targetMediaWindow.equals (media)) {
+			ui->targetMediaWindow.clear ();
+		}
+		if (ui->lastSelectedMediaWindow.equals (media)) {
+			ui->lastSelectedMediaWindow.clear ();
+		}
+	}
+
+	found = false;
+	RecordStore::instance->lock ();
+	mediaitem = RecordStore::instance->findMediaItem (mediaId);
+	if (mediaitem) {
+		found = true;
+		media->resetMediaItem (mediaitem);
+		media->setSelected (ui->selectedMediaMap.exists (mediaId), true);
+		media->syncRecordStore ();
+	}
+	RecordStore::instance->unlock ();
+
+	if (! found) {
+		ui->requestMediaPage (mediaId);
+	}
+	return (found);
+}
+
+bool MediaUi::getSelectedMediaItem (const StdString &mediaId, MediaUi::SelectedMediaItem *destItem) {
+	const RecordStore::MediaItem *mediaitem;
+	const RecordStore::StreamItem *streamitem;
+	Json *agentstatus, serverstatus;
+	StdString agentid, hlspath, htmlpath;
+
+	mediaitem = RecordStore::instance->findMediaItem (mediaId);
+	if (! mediaitem) {
+		return (false);
+	}
+	destItem->mediaId.assign (mediaId);
+	destItem->agentId.assign (*(mediaitem->agentId));
+	destItem->mediaName.assign (mediaitem->name);
+	destItem->mediaWidth = mediaitem->width;
+	destItem->mediaHeight = mediaitem->height;
+	destItem->mediaSize = mediaitem->size;
+	destItem->mediaBitrate = mediaitem->bitrate;
+	destItem->mediaDuration = (float) mediaitem->duration;
+	destItem->isCreateStreamAvailable = mediaitem->isCreateStreamAvailable;
+	destItem->streamId.assign ("");
+	destItem->streamAgentId.assign ("");
+	destItem->hlsStreamPath.assign ("");
+	destItem->streamThumbnailPath.assign ("");
+	destItem->streamSize = 0;
+	destItem->streamSegmentCount = 0;
+
+	// As in MediaWindow::syncRecordStore, a stream is available only if its server reports playback paths
+	streamitem = RecordStore::instance->findSourceStreamItem (mediaId);
+	if (! streamitem) {
+		return (true);
+	}
+	agentid.assign (*(streamitem->agentId));
+	agentstatus = RecordStore::instance->findAgentStatusRecord (agentid);
+	if ((! agentstatus) || Agent::getCommandAgentName (agentstatus).empty ()) {
+		return (true);
+	}
+	if (! SystemInterface::instance->getCommandObjectParam (agentstatus, "streamServerStatus", &serverstatus)) {
+		return (true);
+	}
+	hlspath = serverstatus.getString ("hlsStreamPath", "");
+	htmlpath = serverstatus.getString ("htmlPlayerPath", "");
+	if (streamitem->id.empty () || agentid.empty () || hlspath.empty () || htmlpath.empty ()) {
+		return (true);
+	}
+	destItem->streamId.assign (streamitem->id);
+	destItem->streamAgentId.assign (agentid);
+	destItem->hlsStreamPath.assign (hlspath);
+	destItem->streamThumbnailPath = serverstatus.getString ("thumbnailPath", "");
+	destItem->streamSize = streamitem->size;
+	destItem->streamSegmentCount = streamitem->segmentCount;
+	return (true);
 }
 
 void MediaUi::handleLinkClientConnect (const StdString &agentId) {
@@ -829,6 +1060,9 @@ void MediaUi::handleLinkClientConnect (const StdString &agentId) {
 	bool ismedia, ismonitor;
 	std::map<StdString, MediaUi::MediaServerInfo>::iterator info;
 
+	// Media items from this agent may have been held back while its link client was disconnected
+	resetRecordSync ();
+
 	ismedia = false;
 	ismonitor = false;
 	RecordStore::instance->lock ();
@@ -880,15 +1114,42 @@ void MediaUi::receiveFindMediaItemsResult (void *uiPtr, const StdString &agentId
 void MediaUi::receiveMediaItem (void *uiPtr, const StdString &agentId, Json *command) {
 	MediaUi *ui;
 	std::map<StdString, MediaUi::MediaServerInfo>::iterator info;
+	std::map<StdString, MediaUi::MediaPage>::iterator pos;
+	std::map<int, MediaUi::PageRefetch>::iterator refetch;
+	MediaUi::MediaPage page;
+	StdString mediaid;
 
 	ui = (MediaUi *) uiPtr;
 	RecordStore::instance->addRecord (command);
+	mediaid = SystemInterface::instance->getCommandRecordId (command);
 	SDL_LockMutex (ui->mediaServerMapMutex);
 	info = ui->getMediaServerInfo (agentId);
-	++(info->second.recordCount);
-	if ((info->second.recordCount >= info->second.setSize) || (info->second.recordCount >= info->second.resultOffset)) {
+	pos = ui->mediaPageMap.find (mediaid);
+	if ((pos != ui->mediaPageMap.end ()) && (pos->second.resultOffset >= 0)) {
+		// An item already counted toward its result set, received again after eviction or as an update. A refetched page is satisfied only by the records it was requested for, since result offsets shift as the agent's media set changes.
+		refetch = info->second.refetchPageMap.find (pos->second.resultOffset);
+		if (refetch != info->second.refetchPageMap.end ()) {
+			refetch->second.mediaIds.erase (mediaid);
+			if (refetch->second.mediaIds.empty ()) {
+				info->second.refetchPageMap.erase (refetch);
+			}
+		}
 		App::instance->shouldSyncRecordStore = true;
 	}
+	else {
+		page.agentId.assign (agentId);
+		page.resultOffset = (info->second.recordCount / MediaUi::PageSize) * MediaUi::PageSize;
+		if (pos != ui->mediaPageMap.end ()) {
+			pos->second = page;
+		}
+		else {
+			ui->mediaPageMap.insert (std::pair<StdString, MediaUi::MediaPage> (mediaid, page));
+		}
+		++(info->second.recordCount);
+		if ((info->second.recordCount >= info->second.setSize) || (info->second.recordCount >= info->second.resultOffset)) {
+			App::instance->shouldSyncRecordStore = true;
+		}
+	}
 	SDL_UnlockMutex (ui->mediaServerMapMutex);
 	ui->findMediaComplete = true;
 	++(ui->recordReceiveCount);
@@ -909,6 +1170,7 @@ void MediaUi::receiveFindMediaStreamsResult (void *uiPtr, const StdString &agent
 		SDL_LockMutex (ui->findMediaStreamsMapMutex);
 		if (ui->findMediaStreamsMap.exists (id)) {
 			ui->findMediaStreamsMap.insert (id, MediaUi::StreamsReceivedState);
+			ui->streamsReceivedIds.push_back (id);
 		}
 		SDL_UnlockMutex (ui->findMediaStreamsMapMutex);
 	}
@@ -968,34 +1230,38 @@ void MediaUi::sortButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	ui->showActionPopup (menu, widgetPtr, MediaUi::sortButtonClicked, widgetPtr->getScreenRect (), Ui::RightEdgeAlignment, Ui::TopOfAlignment);
 }
 
-static void showMediaWithoutStreamsActionClicked_appendMediaId (void *stringListPtr, Widget *widgetPtr) {
-	StringList *idlist;
-	MediaWindow *media;
-
-	idlist = (StringList *) stringListPtr;
-	media = MediaWindow::castWidget (widgetPtr);
-	if (media && media->streamId.empty ()) {
-		idlist->push_back (media->mediaId);
-	}
-}
 void MediaUi::showMediaWithoutStreamsActionClicked (void *uiPtr, Widget *widgetPtr) {
 	MediaUi *ui;
-	StringList idlist;
+	StringList idlist, removelist;
 	StringList::iterator i, end;
+	StdString id;
 
 	ui = (MediaUi *) uiPtr;
 	ui->isShowingMediaWithoutStreams = (! ui->isShowingMediaWithoutStreams);
 
 	if (! ui->isShowingMediaWithoutStreams) {
-		ui->cardView->processRowItems (MediaUi::MediaRow, showMediaWithoutStreamsActionClicked_appendMediaId, &idlist);
+		ui->cardView->getRowItemIds (MediaUi::MediaRow, &idlist);
+		RecordStore::instance->lock ();
 		i = idlist.begin ();
 		end = idlist.end ();
+		while (i != end) {
+			id.assign (*i);
+			if (! RecordStore::instance->findSourceStreamItem (id)) {
+				removelist.push_back (id);
+			}
+			++i;
+		}
+		RecordStore::instance->unlock ();
+
+		i = removelist.begin ();
+		end = removelist.end ();
 		while (i != end) {
 			ui->cardView->removeItem (*i, true);
 			++i;
 		}
 		ui->cardView->refresh ();
 	}
+	ui->resetRecordSync ();
 	App::instance->shouldSyncRecordStore = true;
 }
 
@@ -1036,13 +1302,16 @@ void MediaUi::loadSearchResults () {
 		i->second.resultOffset = MediaUi::PageSize;
 		i->second.setSize = 0;
 		i->second.recordCount = 0;
+		i->second.refetchPageMap.clear ();
 		++i;
 	}
+	mediaPageMap.clear ();
 	SDL_UnlockMutex (mediaServerMapMutex);
 
 	SDL_LockMutex (findMediaStreamsMapMutex);
 	findMediaStreamsMap.clear ();
 	SDL_UnlockMutex (findMediaStreamsMapMutex);
+	resetRecordSync ();
 
 	cardView->removeRowItems (MediaUi::MediaRow);
 	cardView->scrollToRow (MediaUi::MediaRow, ((float) App::instance->windowHeight) * MediaUi::BottomPaddingHeightScale);
@@ -1303,11 +1572,11 @@ void MediaUi::mediaWindowSelectStateChanged (void *uiPtr, Widget *widgetPtr) {
 		if (ui->toolbarMode == MediaUi::MonitorMode) {
 			ui->unselectAllMedia ();
 		}
-		ui->selectedMediaMap.insert (media->mediaId, media->mediaName);
+		ui->insertSelectedMedia (media->mediaId, media->mediaName);
 		ui->lastSelectedMediaWindow.assign (media);
 	}
 	else {
-		ui->selectedMediaMap.remove (media->mediaId);
+		ui->removeSelectedMedia (media->mediaId);
 		if (ui->selectedMediaMap.empty ()) {
 			ui->lastSelectedMediaWindow.clear ();
 		}
@@ -1315,7 +1584,7 @@ void MediaUi::mediaWindowSelectStateChanged (void *uiPtr, Widget *widgetPtr) {
 			if (media == ui->lastSelectedMediaWindow.widget) {
 				i = ui->selectedMediaMap.begin ();
 				mediaid = ui->selectedMediaMap.next (&i);
-				ui->lastSelectedMediaWindow.assign (ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid));
+				ui->lastSelectedMediaWindow.assign (ui->cardView->getItem (mediaid));
 			}
 		}
 	}
@@ -1682,14 +1951,19 @@ void MediaUi::playlistAddItemActionClicked (void *uiPtr, Widget *widgetPtr) {
 	MediaUi *ui;
 	MediaWindow *media;
 	StreamPlaylistWindow *playlist;
+	MediaUi::SelectedMediaItem item;
 	StdString streamurl, thumbnailurl;
 	HashMap::Iterator i;
 	StdString mediaid;
-	int count;
+	int count, thumbnailindex;
 	float startpos;
+	bool found;
 
 	ui = (MediaUi *) uiPtr;
 	playlist = (StreamPlaylistWindow *) widgetPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (true).empty ()) {
 		return;
 	}
@@ -1697,21 +1971,31 @@ void MediaUi::playlistAddItemActionClicked (void *uiPtr, Widget *widgetPtr) {
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media && (! media->streamId.empty ())) {
+		RecordStore::instance->lock ();
+		found = ui->getSelectedMediaItem (mediaid, &item);
+		RecordStore::instance->unlock ();
+		if (found && (! item.streamId.empty ())) {
 			++count;
-			streamurl = AgentControl::instance->getAgentSecondaryUrl (media->streamAgentId, media->hlsStreamPath);
-			startpos = (float) media->displayTimestamp;
+			streamurl = AgentControl::instance->getAgentSecondaryUrl (item.streamAgentId, item.hlsStreamPath);
+
+			// A card currently present in the view holds the position and thumbnail the user last browsed to
+			startpos = 0.0f;
+			thumbnailindex = item.streamSegmentCount / 4;
+			media = MediaWindow::castWidget (ui->cardView->getItem (mediaid));
+			if (media) {
+				startpos = (float) media->displayTimestamp;
+				thumbnailindex = media->playThumbnailIndex;
+			}
 			if (startpos < 0.0f) {
 				startpos = 0.0f;
 			}
 			startpos /= 1000.0f;
 
 			thumbnailurl.assign ("");
-			if (! media->streamThumbnailPath.empty ()) {
-				thumbnailurl = AgentControl::instance->getAgentSecondaryUrl (media->streamAgentId, media->streamThumbnailPath);
+			if (! item.streamThumbnailPath.empty ()) {
+				thumbnailurl = AgentControl::instance->getAgentSecondaryUrl (item.streamAgentId, item.streamThumbnailPath);
 			}
-			playlist->addItem (streamurl, media->streamId, media->mediaName, startpos, thumbnailurl, media->playThumbnailIndex);
+			playlist->addItem (streamurl, item.streamId, item.mediaName, startpos, thumbnailurl, thumbnailindex);
 		}
 	}
 
@@ -2245,6 +2529,9 @@ void MediaUi::configureStreamButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	int count, profile;
 
 	ui = (MediaUi *) uiPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (false, true).empty ()) {
 		return;
 	}
@@ -2318,19 +2605,23 @@ void MediaUi::configureStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 	MediaUi *ui;
 	HashMap *prefs;
 	ActionWindow *action;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	HashMap::Iterator i;
 	StdString mediaid, cmdtext;
 	Json *params, *cmd;
 	JsonList commands;
 	StringList agentids;
 	int profile;
+	bool found;
 
 	ui = (MediaUi *) uiPtr;
 	action = (ActionWindow *) widgetPtr;
 	if (! action->isConfirmed) {
 		return;
 	}
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	profile = MediaUtil::getStreamProfile (action->getStringValue (UiText::instance->getText (UiTextString::VideoQuality).capitalized (), ""));
 	prefs = App::instance->lockPrefs ();
 	if (profile != SystemInterface::Constant_DefaultStreamProfile) {
@@ -2344,14 +2635,16 @@ void MediaUi::configureStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media && media->isCreateStreamAvailable) {
+		RecordStore::instance->lock ();
+		found = ui->getSelectedMediaItem (mediaid, &item);
+		RecordStore::instance->unlock ();
+		if (found && item.isCreateStreamAvailable) {
 			params = new Json ();
-			params->set ("mediaId", media->mediaId);
-			params->set ("mediaServerAgentId", media->agentId);
-			params->set ("streamName", media->mediaName);
-			params->set ("mediaWidth", media->mediaWidth);
-			params->set ("mediaHeight", media->mediaHeight);
+			params->set ("mediaId", item.mediaId);
+			params->set ("mediaServerAgentId", item.agentId);
+			params->set ("streamName", item.mediaName);
+			params->set ("mediaWidth", item.mediaWidth);
+			params->set ("mediaHeight", item.mediaHeight);
 			params->set ("profile", profile);
 
 			// TODO: Populate the mediaUrl field (to allow streams to be populated on a stream server other than the source agent)
@@ -2359,10 +2652,10 @@ void MediaUi::configureStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 
 			cmd = App::instance->createCommand (SystemInterface::Command_ConfigureMediaStream, params);
 			if (cmd) {
-				agentids.push_back (media->agentId);
+				agentids.push_back (item.agentId);
 				commands.push_back (cmd);
 				if (cmdtext.empty ()) {
-					cmdtext.assign (media->mediaName);
+					cmdtext.assign (item.mediaName);
 				}
 			}
 		}
@@ -2374,16 +2667,16 @@ void MediaUi::configureStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 }
 
 void MediaUi::configureMediaStreamComplete (Ui *invokeUi, const StdString &agentId, Json *invokeCommand, Json *responseCommand, bool isResponseCommandSuccess) {
+	const RecordStore::StreamItem *streamitem;
 	StdString mediaid, streamid;
-	Json *streamitem;
 
 	if (isResponseCommandSuccess) {
 		mediaid = SystemInterface::instance->getCommandStringParam (invokeCommand, "mediaId", "");
 		if (! mediaid.empty ()) {
 			RecordStore::instance->lock ();
-			streamitem = RecordStore::instance->findRecord (MediaWindow::matchStreamSourceId, &mediaid);
+			streamitem = RecordStore::instance->findSourceStreamItem (mediaid);
 			if (streamitem) {
-				streamid = SystemInterface::instance->getCommandRecordId (streamitem);
+				streamid.assign (streamitem->id);
 				if (! streamid.empty ()) {
 					RecordStore::instance->removeRecord (streamid);
 				}
@@ -2405,6 +2698,9 @@ void MediaUi::cacheStreamButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	int count;
 
 	ui = (MediaUi *) uiPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMonitorMap.empty () || ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (true).empty ()) {
 		return;
 	}
@@ -2443,16 +2739,20 @@ void MediaUi::cacheStreamButtonClicked (void *uiPtr, Widget *widgetPtr) {
 void MediaUi::cacheStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 	MediaUi *ui;
 	ActionWindow *action;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
+	const RecordStore::StreamItem *streamitem;
 	HashMap::Iterator i, j;
 	StdString mediaid, agentid, cmdtext;
-	Json *params, *cmd, *streamitem, *agentstatus, serverstatus;
+	Json *params, *cmd;
 	StringList agentids;
 	JsonList commands;
 	int mediacount;
 
 	ui = (MediaUi *) uiPtr;
 	action = (ActionWindow *) widgetPtr;
+	if (action->isConfirmed && ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if ((! action->isConfirmed) || ui->selectedMonitorMap.empty () || ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (true).empty ()) {
 		return;
 	}
@@ -2460,41 +2760,39 @@ void MediaUi::cacheStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media && (! media->streamId.empty ())) {
-			params = NULL;
-			RecordStore::instance->lock ();
-			streamitem = RecordStore::instance->findRecord (media->streamId, SystemInterface::CommandId_StreamItem);
-			agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &(media->streamAgentId));
-			if (streamitem && agentstatus && SystemInterface::instance->getCommandObjectParam (agentstatus, "streamServerStatus", &serverstatus)) {
+		params = NULL;
+		RecordStore::instance->lock ();
+		if (ui->getSelectedMediaItem (mediaid, &item) && (! item.streamId.empty ())) {
+			streamitem = RecordStore::instance->findStreamItem (item.streamId);
+			if (streamitem) {
 				params = new Json ();
-				params->set ("streamUrl", AgentControl::instance->getAgentSecondaryUrl (media->streamAgentId, media->hlsStreamPath));
-				params->set ("thumbnailUrl", AgentControl::instance->getAgentSecondaryUrl (media->streamAgentId, serverstatus.getString ("thumbnailPath", "")));
-				params->set ("streamId", media->streamId);
-				params->set ("streamName", SystemInterface::instance->getCommandStringParam (streamitem, "name", ""));
-				params->set ("duration", SystemInterface::instance->getCommandNumberParam (streamitem, "duration", (float) 0.0f));
-				params->set ("width", SystemInterface::instance->getCommandNumberParam (streamitem, "width", (int) 0));
-				params->set ("height", SystemInterface::instance->getCommandNumberParam (streamitem, "height", (int) 0));
-				params->set ("bitrate", SystemInterface::instance->getCommandNumberParam (streamitem, "bitrate", (int64_t) 0));
-				params->set ("frameRate", SystemInterface::instance->getCommandNumberParam (streamitem, "frameRate", (float) 0.0f));
+				params->set ("streamUrl", AgentControl::instance->getAgentSecondaryUrl (item.streamAgentId, item.hlsStreamPath));
+				params->set ("thumbnailUrl", AgentControl::instance->getAgentSecondaryUrl (item.streamAgentId, item.streamThumbnailPath));
+				params->set ("streamId", item.streamId);
+				params->set ("streamName", streamitem->name);
+				params->set ("duration", (float) streamitem->duration);
+				params->set ("width", streamitem->width);
+				params->set ("height", streamitem->height);
+				params->set ("bitrate", streamitem->bitrate);
+				params->set ("frameRate", (float) streamitem->frameRate);
 			}
-			RecordStore::instance->unlock ();
+		}
+		RecordStore::instance->unlock ();
 
-			if (params) {
-				cmd = App::instance->createCommand (SystemInterface::Command_CreateCacheStream, params);
-				if (cmd) {
-					++mediacount;
-					if (cmdtext.empty ()) {
-						cmdtext.assign (media->mediaName);
-					}
-					j = ui->selectedMonitorMap.begin ();
-					while (ui->selectedMonitorMap.hasNext (&j)) {
-						agentid = ui->selectedMonitorMap.next (&j);
-						agentids.push_back (agentid);
-						commands.push_back (cmd->copy ());
-					}
-					delete (cmd);
+		if (params) {
+			cmd = App::instance->createCommand (SystemInterface::Command_CreateCacheStream, params);
+			if (cmd) {
+				++mediacount;
+				if (cmdtext.empty ()) {
+					cmdtext.assign (item.mediaName);
+				}
+				j = ui->selectedMonitorMap.begin ();
+				while (ui->selectedMonitorMap.hasNext (&j)) {
+					agentid = ui->selectedMonitorMap.next (&j);
+					agentids.push_back (agentid);
+					commands.push_back (cmd->copy ());
 				}
+				delete (cmd);
 			}
 		}
 	}
@@ -2512,6 +2810,9 @@ void MediaUi::removeStreamButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	int count;
 
 	ui = (MediaUi *) uiPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (true).empty ()) {
 		return;
 	}
@@ -2546,33 +2847,39 @@ void MediaUi::removeStreamButtonClicked (void *uiPtr, Widget *widgetPtr) {
 void MediaUi::removeStreamActionClosed (void *uiPtr, Widget *widgetPtr) {
 	MediaUi *ui;
 	ActionWindow *action;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	HashMap::Iterator i;
 	StdString mediaid, cmdtext;
 	Json *params, *cmd;
 	StringList agentids;
 	StringList::iterator ri, rend;
 	JsonList commands;
+	bool found;
 
 	ui = (MediaUi *) uiPtr;
 	action = (ActionWindow *) widgetPtr;
+	if (action->isConfirmed && ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if ((! action->isConfirmed) || ui->selectedMediaMap.empty () || ui->getSelectedMediaNames (true).empty ()) {
 		return;
 	}
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media && (! media->streamId.empty ())) {
+		RecordStore::instance->lock ();
+		found = ui->getSelectedMediaItem (mediaid, &item);
+		RecordStore::instance->unlock ();
+		if (found && (! item.streamId.empty ())) {
 			params = new Json ();
-			params->set ("id", media->streamId);
+			params->set ("id", item.streamId);
 
 			cmd = App::instance->createCommand (SystemInterface::Command_RemoveStream, params);
 			if (cmd) {
-				agentids.push_back (media->streamAgentId);
+				agentids.push_back (item.streamAgentId);
 				commands.push_back (cmd);
 				if (cmdtext.empty ()) {
-					cmdtext.assign (media->mediaName);
+					cmdtext.assign (item.mediaName);
 				}
 			}
 		}
@@ -2605,6 +2912,9 @@ void MediaUi::addTagButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	int count;
 
 	ui = (MediaUi *) uiPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMediaMap.empty ()) {
 		return;
 	}
@@ -2642,12 +2952,16 @@ void MediaUi::addTagActionClosed (void *uiPtr, Widget *widgetPtr) {
 	JsonList commands;
 	StringList agentids;
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	Json *params, *cmd;
 	StdString mediaid, tag, cmdtext;
+	bool found;
 
 	ui = (MediaUi *) uiPtr;
 	action = (ActionWindow *) widgetPtr;
+	if (action->isConfirmed && ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if ((! action->isConfirmed) || ui->selectedMediaMap.empty ()) {
 		return;
 	}
@@ -2655,17 +2969,19 @@ void MediaUi::addTagActionClosed (void *uiPtr, Widget *widgetPtr) {
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media) {
+		RecordStore::instance->lock ();
+		found = ui->getSelectedMediaItem (mediaid, &item);
+		RecordStore::instance->unlock ();
+		if (found) {
 			params = new Json ();
-			params->set ("mediaId", media->mediaId);
+			params->set ("mediaId", item.mediaId);
 			params->set ("tag", tag);
 			cmd = App::instance->createCommand (SystemInterface::Command_AddMediaTag, params);
 			if (cmd) {
-				agentids.push_back (media->agentId);
+				agentids.push_back (item.agentId);
 				commands.push_back (cmd);
 				if (cmdtext.empty ()) {
-					cmdtext.assign (media->mediaName);
+					cmdtext.assign (item.mediaName);
 				}
 			}
 		}
@@ -2697,6 +3013,9 @@ void MediaUi::removeTagButtonClicked (void *uiPtr, Widget *widgetPtr) {
 	int count;
 
 	ui = (MediaUi *) uiPtr;
+	if (ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if (ui->selectedMediaMap.empty ()) {
 		return;
 	}
@@ -2734,12 +3053,16 @@ void MediaUi::removeTagActionClosed (void *uiPtr, Widget *widgetPtr) {
 	JsonList commands;
 	StringList agentids;
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	Json *params, *cmd;
 	StdString mediaid, tag, cmdtext;
+	bool found;
 
 	ui = (MediaUi *) uiPtr;
 	action = (ActionWindow *) widgetPtr;
+	if (action->isConfirmed && ui->isSelectedMediaPending ()) {
+		return;
+	}
 	if ((! action->isConfirmed) || ui->selectedMediaMap.empty ()) {
 		return;
 	}
@@ -2747,17 +3070,19 @@ void MediaUi::removeTagActionClosed (void *uiPtr, Widget *widgetPtr) {
 	i = ui->selectedMediaMap.begin ();
 	while (ui->selectedMediaMap.hasNext (&i)) {
 		mediaid = ui->selectedMediaMap.next (&i);
-		media = (MediaWindow *) ui->cardView->findItem (MediaUi::matchMediaItem, &mediaid);
-		if (media) {
+		RecordStore::instance->lock ();
+		found = ui->getSelectedMediaItem (mediaid, &item);
+		RecordStore::instance->unlock ();
+		if (found) {
 			params = new Json ();
-			params->set ("mediaId", media->mediaId);
+			params->set ("mediaId", item.mediaId);
 			params->set ("tag", tag);
 			cmd = App::instance->createCommand (SystemInterface::Command_RemoveMediaTag, params);
 			if (cmd) {
-				agentids.push_back (media->agentId);
+				agentids.push_back (item.agentId);
 				commands.push_back (cmd);
 				if (cmdtext.empty ()) {
-					cmdtext.assign (media->mediaName);
+					cmdtext.assign (item.mediaName);
 				}
 			}
 		}
@@ -2838,23 +3163,24 @@ StdString MediaUi::getSelectedMonitorNames () {
 StdString MediaUi::getSelectedMediaNames (bool isStreamRequired, bool isCreateStreamRequired) {
 	StdString text, id;
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	StringList names;
 
+	RecordStore::instance->lock ();
 	i = selectedMediaMap.begin ();
 	while (selectedMediaMap.hasNext (&i)) {
 		id = selectedMediaMap.next (&i);
-		media = MediaWindow::castWidget (cardView->getItem (id));
-		if (media) {
-			if (isStreamRequired && media->streamId.empty ()) {
+		if (getSelectedMediaItem (id, &item)) {
+			if (isStreamRequired && item.streamId.empty ()) {
 				continue;
 			}
-			if (isCreateStreamRequired && (! media->isCreateStreamAvailable)) {
+			if (isCreateStreamRequired && (! item.isCreateStreamAvailable)) {
 				continue;
 			}
-			names.push_back (selectedMediaMap.find (id, ""));
+			names.push_back (item.mediaName);
 		}
 	}
+	RecordStore::instance->unlock ();
 	if (names.empty ()) {
 		return (StdString (""));
 	}
@@ -2867,8 +3193,31 @@ StdString MediaUi::getSelectedMediaNames (bool isStreamRequired, bool isCreateSt
 }
 
 void MediaUi::selectAllMedia () {
-	selectedMediaMap.clear ();
+	StringList ids;
+	StringList::iterator i, end;
+	const RecordStore::MediaItem *mediaitem;
+
+	clearSelectedMedia ();
 	lastSelectedMediaWindow.clear ();
+
+	cardView->getRowItemIds (MediaUi::MediaRow, &ids);
+	RecordStore::instance->lock ();
+	i = ids.begin ();
+	end = ids.end ();
+	while (i != end) {
+		// Evicted items are selected too, with their records pinned so that they remain in the store once their pages are fetched again
+		mediaitem = RecordStore::instance->findMediaItem (*i);
+		if (mediaitem) {
+			insertSelectedMedia (*i, mediaitem->name);
+		}
+		else {
+			insertSelectedMedia (*i, StdString (""));
+			requestMediaPage (*i);
+		}
+		++i;
+	}
+	RecordStore::instance->unlock ();
+
 	cardView->processRowItems (MediaUi::MediaRow, MediaUi::selectMediaWindow, this);
 }
 
@@ -2880,7 +3229,7 @@ void MediaUi::selectMediaWindow (void *uiPtr, Widget *widgetPtr) {
 	media = MediaWindow::castWidget (widgetPtr);
 	if (media) {
 		media->setSelected (true, true);
-		ui->selectedMediaMap.insert (media->mediaId, media->mediaName);
+		ui->insertSelectedMedia (media->mediaId, media->mediaName);
 	}
 }
 
@@ -2895,16 +3244,116 @@ void MediaUi::unselectAllMedia () {
 	kend = keys.end ();
 	while (ki != kend) {
 		id.assign (*ki);
-		media = (MediaWindow *) cardView->findItem (MediaUi::matchMediaItem, &id);
+		media = MediaWindow::castWidget (cardView->getItem (id));
 		if (media) {
 			media->setSelected (false, true);
 		}
 		++ki;
 	}
-	selectedMediaMap.clear ();
+	clearSelectedMedia ();
 	lastSelectedMediaWindow.clear ();
 }
 
+bool MediaUi::isSelectedMediaPending () {
+	HashMap::Iterator i;
+	StringList ids;
+	StringList::iterator j, end;
+	StdString id;
+
+	RecordStore::instance->lock ();
+	i = selectedMediaMap.begin ();
+	while (selectedMediaMap.hasNext (&i)) {
+		id = selectedMediaMap.next (&i);
+		if (! RecordStore::instance->findMediaItem (id)) {
+			ids.push_back (id);
+		}
+	}
+	RecordStore::instance->unlock ();
+	if (ids.empty ()) {
+		return (false);
+	}
+
+	j = ids.begin ();
+	end = ids.end ();
+	while (j != end) {
+		requestMediaPage (*j);
+		++j;
+	}
+	App::instance->uiStack.showSnackbar (UiText::instance->getText (UiTextString::Loading).capitalized ());
+	return (true);
+}
+
+void MediaUi::insertSelectedMedia (const StdString &mediaId, const StdString &mediaName) {
+	if (! selectedMediaMap.exists (mediaId)) {
+		RecordStore::instance->pinRecord (mediaId);
+	}
+	selectedMediaMap.insert (mediaId, mediaName);
+}
+
+void MediaUi::removeSelectedMedia (const StdString &mediaId) {
+	if (selectedMediaMap.exists (mediaId)) {
+		RecordStore::instance->unpinRecord (mediaId);
+		selectedMediaMap.remove (mediaId);
+	}
+}
+
+void MediaUi::clearSelectedMedia () {
+	HashMap::Iterator i;
+
+	i = selectedMediaMap.begin ();
+	while (selectedMediaMap.hasNext (&i)) {
+		RecordStore::instance->unpinRecord (selectedMediaMap.next (&i));
+	}
+	selectedMediaMap.clear ();
+}
+
+void MediaUi::requestMediaPage (const StdString &mediaId) {
+	std::map<StdString, MediaUi::MediaPage>::iterator pos;
+	std::map<StdString, MediaUi::MediaServerInfo>::iterator info;
+	MediaUi::PageRefetch *refetch;
+	StdString agentid;
+	Json *params;
+	int64_t now;
+	int offset;
+
+	offset = -1;
+	now = OsUtil::getTime ();
+	SDL_LockMutex (mediaServerMapMutex);
+	pos = mediaPageMap.find (mediaId);
+	if (pos != mediaPageMap.end ()) {
+		info = mediaServerMap.find (pos->second.agentId);
+		if ((info != mediaServerMap.end ()) && (pos->second.resultOffset < 0)) {
+			// A restored item's page is unknown until the agent's current search delivers it, so advance that search by its next page once the previous one has been received
+			if ((info->second.recordCount >= info->second.resultOffset) && (info->second.recordCount < info->second.setSize)) {
+				agentid.assign (pos->second.agentId);
+				offset = info->second.resultOffset;
+				info->second.resultOffset += MediaUi::PageSize;
+			}
+		}
+		else if (info != mediaServerMap.end ()) {
+			refetch = &(info->second.refetchPageMap[pos->second.resultOffset]);
+			refetch->mediaIds.insert (mediaId);
+			if ((refetch->requestCount <= 0) || ((refetch->requestCount < MediaUi::MaxPageRefetchCount) && (now >= (refetch->lastRequestTime + MediaUi::PageRefetchRetryPeriod)))) {
+				++(refetch->requestCount);
+				refetch->lastRequestTime = now;
+				agentid.assign (pos->second.agentId);
+				offset = pos->second.resultOffset;
+			}
+		}
+	}
+	SDL_UnlockMutex (mediaServerMapMutex);
+	if (offset < 0) {
+		return;
+	}
+
+	params = new Json ();
+	params->set ("searchKey", searchKey);
+	params->set ("resultOffset", offset);
+	params->set ("maxResults", MediaUi::PageSize);
+	params->set ("sortOrder", mediaSortOrder);
+	AgentControl::instance->writeLinkCommand (App::instance->createCommand (SystemInterface::Command_FindMediaItems, params), agentid);
+}
+
 static void resetExpandToggles_countExpandedAgents (void *intPtr, Widget *widgetPtr) {
 	MonitorWindow *monitor;
 	MediaLibraryWindow *medialibrary;
@@ -3007,17 +3456,18 @@ void MediaUi::resetNextRecordSyncTime () {
 
 int64_t MediaUi::getSelectedStreamSize () {
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	int64_t bytes;
 
 	bytes = 0;
+	RecordStore::instance->lock ();
 	i = selectedMediaMap.begin ();
 	while (selectedMediaMap.hasNext (&i)) {
-		media = MediaWindow::castWidget (cardView->getItem (selectedMediaMap.next (&i)));
-		if (media && (! media->streamId.empty ())) {
-			bytes += media->streamSize;
+		if (getSelectedMediaItem (selectedMediaMap.next (&i), &item) && (! item.streamId.empty ())) {
+			bytes += item.streamSize;
 		}
 	}
+	RecordStore::instance->unlock ();
 	return (bytes);
 }
 
@@ -3027,48 +3477,51 @@ int MediaUi::getSelectedMediaCount () {
 
 int MediaUi::getSelectedStreamCount () {
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	int count;
 
 	count = 0;
+	RecordStore::instance->lock ();
 	i = selectedMediaMap.begin ();
 	while (selectedMediaMap.hasNext (&i)) {
-		media = MediaWindow::castWidget (cardView->getItem (selectedMediaMap.next (&i)));
-		if (media && (! media->streamId.empty ())) {
+		if (getSelectedMediaItem (selectedMediaMap.next (&i), &item) && (! item.streamId.empty ())) {
 			++count;
 		}
 	}
+	RecordStore::instance->unlock ();
 	return (count);
 }
 
 int MediaUi::getSelectedCreateStreamCount () {
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	int count;
 
 	count = 0;
+	RecordStore::instance->lock ();
 	i = selectedMediaMap.begin ();
 	while (selectedMediaMap.hasNext (&i)) {
-		media = MediaWindow::castWidget (cardView->getItem (selectedMediaMap.next (&i)));
-		if (media && media->isCreateStreamAvailable) {
+		if (getSelectedMediaItem (selectedMediaMap.next (&i), &item) && item.isCreateStreamAvailable) {
 			++count;
 		}
 	}
+	RecordStore::instance->unlock ();
 	return (count);
 }
 
 int64_t MediaUi::getSelectedCreateStreamSize (int profile) {
 	HashMap::Iterator i;
-	MediaWindow *media;
+	MediaUi::SelectedMediaItem item;
 	int64_t bytes;
 
 	bytes = 0;
+	RecordStore::instance->lock ();
 	i = selectedMediaMap.begin ();
 	while (selectedMediaMap.hasNext (&i)) {
-		media = MediaWindow::castWidget (cardView->getItem (selectedMediaMap.next (&i)));
-		if (media && media->isCreateStreamAvailable) {
-			bytes += MediaUtil::getStreamSize (media->mediaSize, media->mediaBitrate, media->mediaDuration, profile);
+		if (getSelectedMediaItem (selectedMediaMap.next (&i), &item) && item.isCreateStreamAvailable) {
+			bytes += MediaUtil::getStreamSize (item.mediaSize, item.mediaBitrate, item.mediaDuration, profile);
 		}
 	}
+	RecordStore::instance->unlock ();
 	return (bytes);
 }
@@ -33,6 +33,7 @@
 #define MEDIA_UI_H
 
 #include <map>
+#include <set>
 #include "SDL2/SDL.h"
 #include "StdString.h"
 #include "HashMap.h"
@@ -43,6 +44,8 @@
 #include "HelpWindow.h"
 #include "Ui.h"
 
+class MediaWindow;
+
 class MediaUi : public Ui {
 public:
 	// Sprite indexes
@@ -172,9 +175,17 @@ protected:
 	static void doSyncRecordStore_processMonitorAgent (void *uiPtr, Json *record, const StdString &recordId);
 	static void doSyncRecordStore_processMediaItem (void *uiPtr, Json *record, const StdString &recordId);
 
+	// Execute subclass-specific operations to sync state with records listed in a RecordStore change set
+	void doSyncRecordStoreChanges (const RecordStore::ChangeSet &changes);
+
+	// Return a newly created MediaWindow widget for the media item with the specified ID, suitable for use as a virtual card view item, or NULL if the media item record wasn't found
+	static Panel *createMediaWindow (void *uiPtr, const StdString &mediaId);
+
+	// Rebind a detached MediaWindow from the card view's free list to the media item with the specified ID, as appropriate for current selection and record store state, and return a boolean value indicating if the window was rebound
+	static bool resetMediaWindow (void *uiPtr, Panel *itemPanel, const StdString &mediaId);
+
 private:
 	// Callback functions
-	static bool matchMediaItem (void *idPtr, Widget *widget);
 	static void imageSizeButtonClicked (void *uiPtr, Widget *widgetPtr);
 	static void smallImageSizeActionClicked (void *uiPtr, Widget *widgetPtr);
 	static void mediumImageSizeActionClicked (void *uiPtr, Widget *widgetPtr);
@@ -243,16 +254,64 @@ private:
 	static void invokeMonitorCommandComplete (Ui *invokeUi, const StdString &agentId, Json *invokeCommand, Json *responseCommand, bool isResponseCommandSuccess);
 	static void invokeMediaCommandComplete (Ui *invokeUi, const StdString &agentId, Json *invokeCommand, Json *responseCommand, bool isResponseCommandSuccess);
 
+	struct PageRefetch {
+		std::set<StdString> mediaIds; // IDs of evicted records expected from the page
+		int requestCount;
+		int64_t lastRequestTime;
+		PageRefetch ():
+			requestCount (0),
+			lastRequestTime (0) { }
+	};
+
 	struct MediaServerInfo {
 		int resultOffset;
 		int setSize;
 		int recordCount;
+		std::map<int, MediaUi::PageRefetch> refetchPageMap; // Pages requested again after the store evicted their records, keyed by result offset
 		MediaServerInfo ():
 			resultOffset (0),
 			setSize (0),
 			recordCount (0) { }
 	};
 
+	struct MediaPage {
+		StdString agentId;
+		int resultOffset; // A value of -1 indicates a media item restored from a store snapshot and not yet received from its agent's current search
+		MediaPage ():
+			resultOffset (0) { }
+	};
+
+	// Fields of a selected media item and its playback stream, as read from the record store
+	struct SelectedMediaItem {
+		StdString mediaId;
+		StdString agentId;
+		StdString mediaName;
+		int mediaWidth;
+		int mediaHeight;
+		int64_t mediaSize;
+		int64_t mediaBitrate;
+		float mediaDuration;
+		bool isCreateStreamAvailable;
+		StdString streamId;
+		StdString streamAgentId;
+		StdString hlsStreamPath;
+		StdString streamThumbnailPath;
+		int64_t streamSize;
+		int streamSegmentCount;
+		SelectedMediaItem ():
+			mediaWidth (0),
+			mediaHeight (0),
+			mediaSize (0),
+			mediaBitrate (0),
+			mediaDuration (0.0f),
+			isCreateStreamAvailable (false),
+			streamSize (0),
+			streamSegmentCount (0) { }
+	};
+
+	// Fill the provided struct with fields of the specified media item and return a boolean value indicating if the item was found. Stream fields are left empty unless the stream is available for playback. This method must be invoked only while the record store is locked.
+	bool getSelectedMediaItem (const StdString &mediaId, MediaUi::SelectedMediaItem *destItem);
+
 	// Return a mediaServerMap iterator positioned at the specified entry, creating it if it doesn't already exist. This method must be invoked only while holding a lock on mediaServerMapMutex.
 	std::map<StdString, MediaUi::MediaServerInfo>::iterator getMediaServerInfo (const StdString &agentId);
 
@@ -268,12 +327,30 @@ private:
 	// Return a string containing the set of selected media item names, appropriate for use in a command popup, or an empty string if no media items are selected
 	StdString getSelectedMediaNames (bool isStreamRequired = false, bool isCreateStreamRequired = false);
 
+	// Return the MediaWindow item showing the media with the specified lowercase name, creating its widget if needed, or NULL if no such item was found
+	MediaWindow *findMediaWindow (const StdString &mediaName);
+
 	// Set selected state for all media items
 	void selectAllMedia ();
 
 	// Clear selected state from all media items
 	void unselectAllMedia ();
 
+	// Add a media item to selectedMediaMap, pinning its record in the store while it remains selected
+	void insertSelectedMedia (const StdString &mediaId, const StdString &mediaName);
+
+	// Remove a media item from selectedMediaMap and release its record pin
+	void removeSelectedMedia (const StdString &mediaId);
+
+	// Return a boolean value indicating if any selected media item has no record in the store, after requesting the search result pages that deliver such records and showing a snackbar message. Bulk media actions are deferred while this method returns true.
+	bool isSelectedMediaPending ();
+
+	// Remove all media items from selectedMediaMap and release their record pins
+	void clearSelectedMedia ();
+
+	// Request the search result page that originally delivered the specified media item, for use after the store has evicted its record. A page is requested again if the item hasn't arrived after PageRefetchRetryPeriod, up to MaxPageRefetchCount requests. For an item restored from a store snapshot and not yet received, the agent's current search is advanced by its next page instead.
+	void requestMediaPage (const StdString &mediaId);
+
 	// Return a newly created StreamPlaylistWindow widget, suitable for use as a card view item
 	StreamPlaylistWindow *createStreamPlaylistWindow ();
 
@@ -283,6 +360,9 @@ private:
 	// Reset checked states for row expand toggles, as appropriate for item expand state
 	void resetExpandToggles ();
 
+	// Show or remove the empty state card as appropriate for current record counts
+	void syncEmptyState ();
+
 	// Reset state of search status widgets
 	void resetSearchStatus ();
 
@@ -305,6 +385,8 @@ private:
 	int64_t getSelectedCreateStreamSize (int profile);
 
 	static const int PageSize;
+	static const int MaxPageRefetchCount;
+	static const int64_t PageRefetchRetryPeriod; // milliseconds
 	static const float TextTruncateWidthScale;
 	static const float SearchFieldWidthScale;
 	static const float BottomPaddingHeightScale;
@@ -344,10 +426,12 @@ private:
 	int recordReceiveCount;
 	int64_t nextRecordSyncTime;
 	std::map<StdString, MediaUi::MediaServerInfo> mediaServerMap;
+	std::map<StdString, MediaUi::MediaPage> mediaPageMap; // Search result page for each received or restored media item, erased when the item's record is removed from the store and guarded by mediaServerMapMutex
 	SDL_mutex *mediaServerMapMutex;
 	HashMap selectedMonitorMap;
 	HashMap selectedMediaMap;
 	HashMap findMediaStreamsMap;
+	StringList streamsReceivedIds; // Media IDs that have moved to StreamsReceivedState since the last record sync, guarded by findMediaStreamsMapMutex
 	SDL_mutex *findMediaStreamsMapMutex;
 };
 
@@ -54,7 +54,7 @@
 #include "MediaUi.h"
 #include "MediaWindow.h"
 
-MediaWindow::MediaWindow (Json *mediaItem, SpriteGroup *mediaUiSpriteGroup)
+MediaWindow::MediaWindow (const RecordStore::MediaItem *mediaItem, SpriteGroup *mediaUiSpriteGroup)
 : Panel ()
 , thumbnailCount (0)
 , mediaWidth (0)
@@ -83,12 +83,13 @@ MediaWindow::MediaWindow (Json *mediaItem, SpriteGroup *mediaUiSpriteGroup)
 	classId = ClassId::MediaWindow;
 
 	setFillBg (true, UiConfiguration::instance->mediumBackgroundColor);
-	mediaId = SystemInterface::instance->getCommandStringParam (mediaItem, "id", "");
-	mediaName = SystemInterface::instance->getCommandStringParam (mediaItem, "name", "");
-	mediaSortKey = SystemInterface::instance->getCommandStringParam (mediaItem, "sortKey", "");
-	agentId = SystemInterface::instance->getCommandAgentId (mediaItem);
-	mediaWidth = SystemInterface::instance->getCommandNumberParam (mediaItem, "width", (int) 0);
-	mediaHeight = SystemInterface::instance->getCommandNumberParam (mediaItem, "height", (int) 0);
+	mediaId.assign (mediaItem->id);
+	mediaName.assign (mediaItem->name);
+	mediaSortKey.assign (mediaItem->sortKey);
+	agentId.assign (*(mediaItem->agentId));
+	mediaWidth = mediaItem->width;
+	mediaHeight = mediaItem->height;
+	RecordStore::instance->pinRecord (mediaId);
 
 	mediaImage = (ImageWindow *) addWidget (new ImageWindow (new Image (UiConfiguration::instance->coreSprites.getSprite (UiConfiguration::LargeLoadingIconSprite))));
 	mediaImage->loadCallback = Widget::EventCallbackContext (MediaWindow::mediaImageLoaded, this);
@@ -161,7 +162,9 @@ MediaWindow::MediaWindow (Json *mediaItem, SpriteGroup *mediaUiSpriteGroup)
 }
 
 MediaWindow::~MediaWindow () {
-
+	if (RecordStore::instance) {
+		RecordStore::instance->unpinRecord (mediaId);
+	}
 }
 
 StdString MediaWindow::toStringDetail () {
@@ -176,6 +179,48 @@ MediaWindow *MediaWindow::castWidget (Widget *widget) {
 	return (MediaWindow::isWidgetType (widget) ? (MediaWindow *) widget : NULL);
 }
 
+void MediaWindow::resetMediaItem (const RecordStore::MediaItem *mediaItem) {
+	if (mediaId.equals (mediaItem->id)) {
+		return;
+	}
+	RecordStore::instance->unpinRecord (mediaId);
+	mediaId.assign (mediaItem->id);
+	mediaName.assign (mediaItem->name);
+	mediaSortKey.assign (mediaItem->sortKey);
+	agentId.assign (*(mediaItem->agentId));
+	mediaWidth = mediaItem->width;
+	mediaHeight = mediaItem->height;
+	RecordStore::instance->pinRecord (mediaId);
+
+	mediaPath.assign ("");
+	thumbnailPath.assign ("");
+	thumbnailCount = 0;
+	mediaDuration = 0.0f;
+	mediaFrameRate = 0.0f;
+	mediaSize = 0;
+	mediaBitrate = 0;
+	isCreateStreamAvailable = true;
+	streamId.assign ("");
+	streamSize = 0;
+	streamAgentId.assign ("");
+	streamAgentName.assign ("");
+	streamThumbnailPath.assign ("");
+	hlsStreamPath.assign ("");
+	htmlPlayerPath.assign ("");
+	playThumbnailUrl.assign ("");
+	playThumbnailIndex = 0;
+
+	nameLabel->setText (mediaName);
+	detailNameLabel->setText (mediaName);
+	mediaImage->setImageUrl (StdString (""));
+	streamIconImage->isVisible = false;
+	browserPlayButton->isVisible = false;
+	createStreamUnavailableIconImage->isVisible = false;
+	setDisplayTimestamp (-1.0f);
+	shouldRefreshTexture = true;
+	refreshLayout ();
+}
+
 void MediaWindow::setDisplayTimestamp (float timestamp) {
 	if (FLOAT_EQUALS (timestamp, displayTimestamp)) {
 		return;
@@ -225,16 +270,18 @@ void MediaWindow::setThumbnail (const StdString &imageUrl, int thumbnailIndex) {
 }
 
 void MediaWindow::syncRecordStore () {
-	Json *mediaitem, *agentstatus, serverstatus, *streamitem, *params;
+	const RecordStore::MediaItem *mediaitem;
+	const RecordStore::StreamItem *streamitem;
+	Json *agentstatus, serverstatus, *params;
 	StdString agentid, recordid, agentname, hlspath, htmlpath;
 
-	mediaitem = RecordStore::instance->findRecord (mediaId, SystemInterface::CommandId_MediaItem);
+	mediaitem = RecordStore::instance->findMediaItem (mediaId);
 	if (! mediaitem) {
 		return;
 	}
 
-	agentid = SystemInterface::instance->getCommandAgentId (mediaitem);
-	agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentid);
+	agentid.assign (*(mediaitem->agentId));
+	agentstatus = RecordStore::instance->findAgentStatusRecord (agentid);
 	if (! agentstatus) {
 		return;
 	}
@@ -249,12 +296,12 @@ void MediaWindow::syncRecordStore () {
 		return;
 	}
 
-	mediaDuration = SystemInterface::instance->getCommandNumberParam (mediaitem, "duration", (float) 0.0f);
-	mediaFrameRate = SystemInterface::instance->getCommandNumberParam (mediaitem, "frameRate", (float) 0.0f);
-	mediaSize = SystemInterface::instance->getCommandNumberParam (mediaitem, "size", (int64_t) 0);
-	mediaBitrate = SystemInterface::instance->getCommandNumberParam (mediaitem, "bitrate", (int64_t) 0);
+	mediaDuration = (float) mediaitem->duration;
+	mediaFrameRate = (float) mediaitem->frameRate;
+	mediaSize = mediaitem->size;
+	mediaBitrate = mediaitem->bitrate;
 
-	streamitem = RecordStore::instance->findRecord (MediaWindow::matchStreamSourceId, &mediaId);
+	streamitem = RecordStore::instance->findSourceStreamItem (mediaId);
 	if (! streamitem) {
 		streamAgentId.assign ("");
 		streamId.assign ("");
@@ -267,12 +314,12 @@ void MediaWindow::syncRecordStore () {
 		browserPlayButton->isVisible = false;
 	}
 	else {
-		recordid = SystemInterface::instance->getCommandRecordId (streamitem);
+		recordid.assign (streamitem->id);
 		if (! recordid.empty ()) {
-			agentid = SystemInterface::instance->getCommandAgentId (streamitem);
+			agentid.assign (*(streamitem->agentId));
 		}
 		if (! agentid.empty ()) {
-			agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentid);
+			agentstatus = RecordStore::instance->findAgentStatusRecord (agentid);
 			if (agentstatus) {
 				agentname = Agent::getCommandAgentName (agentstatus);
 				if (SystemInterface::instance->getCommandObjectParam (agentstatus, "streamServerStatus", &serverstatus)) {
@@ -293,13 +340,13 @@ void MediaWindow::syncRecordStore () {
 			streamAgentName.assign (agentname);
 			hlsStreamPath.assign (hlspath);
 			htmlPlayerPath.assign (htmlpath);
-			streamSize = SystemInterface::instance->getCommandNumberParam (streamitem, "size", (int64_t) 0);
+			streamSize = streamitem->size;
 			streamIconImage->isVisible = true;
 			browserPlayButton->isVisible = true;
 		}
 	}
 
-	isCreateStreamAvailable = SystemInterface::instance->getCommandBooleanParam (mediaitem, "isCreateStreamAvailable", true);
+	isCreateStreamAvailable = mediaitem->isCreateStreamAvailable;
 	if (isCreateStreamAvailable) {
 		createStreamUnavailableIconImage->isVisible = false;
 	}
@@ -307,9 +354,10 @@ void MediaWindow::syncRecordStore () {
 		createStreamUnavailableIconImage->isVisible = true;
 	}
 
-	if (hasThumbnails () && mediaImage->isImageUrlEmpty ()) {
+	// playThumbnailUrl is empty after resetMediaItem, even if the image window is still finishing a load from the previous item's URL
+	if (hasThumbnails () && (mediaImage->isImageUrlEmpty () || playThumbnailUrl.empty ())) {
 		if (streamitem) {
-			playThumbnailIndex = SystemInterface::instance->getCommandNumberParam (streamitem, "segmentCount", (int) 0) / 4;
+			playThumbnailIndex = streamitem->segmentCount / 4;
 		}
 		params = new Json ();
 		params->set ("id", mediaId);
@@ -322,14 +370,22 @@ void MediaWindow::syncRecordStore () {
 	refreshLayout ();
 }
 
-bool MediaWindow::matchStreamSourceId (void *idStringPtr, Json *record) {
-	StdString *id;
+bool MediaWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	const RecordStore::StreamItem *streamitem;
 
-	if (SystemInterface::instance->getCommandId (record) != SystemInterface::CommandId_StreamItem) {
-		return (false);
+	if ((changes.recordIds.count (mediaId) > 0) || (changes.recordIds.count (agentId) > 0)) {
+		return (true);
+	}
+	if ((! streamId.empty ()) && (changes.recordIds.count (streamId) > 0)) {
+		return (true);
 	}
-	id = (StdString *) idStringPtr;
-	return (id->equals (SystemInterface::instance->getCommandStringParam (record, "sourceId", "")));
+
+	// The stream's server status can change the stream's availability before streamAgentId has been assigned
+	streamitem = RecordStore::instance->findSourceStreamItem (mediaId);
+	if (streamitem && (changes.recordIds.count (*(streamitem->agentId)) > 0)) {
+		return (true);
+	}
+	return (false);
 }
 
 void MediaWindow::refreshLayout () {
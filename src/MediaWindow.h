@@ -34,6 +34,7 @@
 
 #include "StdString.h"
 #include "Json.h"
+#include "RecordStore.h"
 #include "Widget.h"
 #include "SpriteGroup.h"
 #include "Label.h"
@@ -45,7 +46,7 @@
 
 class MediaWindow : public Panel {
 public:
-	MediaWindow (Json *mediaItem, SpriteGroup *mediaUiSprites);
+	MediaWindow (const RecordStore::MediaItem *mediaItem, SpriteGroup *mediaUiSprites);
 	virtual ~MediaWindow ();
 
 	// Read-write data members
@@ -83,6 +84,9 @@ public:
 	// Set the layout type that should be used to arrange the panel's widgets, as specified by a CardView detail constant
 	void setLayout (int layoutType, float maxPanelWidth);
 
+	// Rebind the window to the provided media item, clearing state held for any previous item. This method should be invoked only while the application's RecordStore object is locked, and followed by syncRecordStore.
+	void resetMediaItem (const RecordStore::MediaItem *mediaItem);
+
 	// Set the timestamp that should be shown for the media item, with a negative value specifying that no timestamp should be shown
 	void setDisplayTimestamp (float timestamp);
 
@@ -98,15 +102,15 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	void syncRecordStore ();
 
+	// Return a boolean value indicating if the widget must execute syncRecordStore to reflect the provided set of record changes
+	bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
 	// Return a boolean value indicating if the provided Widget is a member of this class
 	static bool isWidgetType (Widget *widget);
 
 	// Return a typecasted pointer to the provided widget, or NULL if the widget does not appear to be of the correct type
 	static MediaWindow *castWidget (Widget *widget);
 
-	// Match a StreamItem record by sourceId using the provided StdString pointer
-	static bool matchStreamSourceId (void *idStringPtr, Json *record);
-
 protected:
 	// Return a string that should be included as part of the toString method's output
 	StdString toStringDetail ();
@@ -289,14 +289,16 @@ void MonitorCacheUi::doSyncRecordStore () {
 void MonitorCacheUi::doSyncRecordStore_processStreamItem (void *uiPtr, Json *record, const StdString &recordId) {
 	MonitorCacheUi *ui;
 	StreamWindow *stream;
+	const RecordStore::StreamItem *streamitem;
 
 	ui = (MonitorCacheUi *) uiPtr;
-	if (! ui->agentId.equals (SystemInterface::instance->getCommandAgentId (record))) {
+	streamitem = RecordStore::instance->findStreamItem (recordId);
+	if ((! streamitem) || (! ui->agentId.equals (*(streamitem->agentId)))) {
 		return;
 	}
 	++(ui->streamCount);
 	if (! ui->cardView->contains (recordId)) {
-		stream = new StreamWindow (record);
+		stream = new StreamWindow (streamitem);
 		stream->streamImageClickCallback = Widget::EventCallbackContext (MonitorCacheUi::streamWindowImageClicked, ui);
 		stream->viewButtonClickCallback = Widget::EventCallbackContext (MonitorCacheUi::streamWindowViewButtonClicked, ui);
 		stream->removeButtonClickCallback = Widget::EventCallbackContext (MonitorCacheUi::streamWindowRemoveButtonClicked, ui);
@@ -273,6 +273,10 @@ void MonitorWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool MonitorWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void MonitorWindow::resetNameLabel () {
 	float w;
 
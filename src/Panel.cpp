@@ -31,10 +31,14 @@
 #include <stdlib.h>
 #include <math.h>
 #include <list>
+#include <vector>
+#include <algorithm>
 #include "SDL2/SDL.h"
 #include "StdString.h"
 #include "StringList.h"
 #include "App.h"
+#include "Profiler.h"
+#include "AnimationTimeline.h"
 #include "UiConfiguration.h"
 #include "Resource.h"
 #include "Input.h"
@@ -44,6 +48,11 @@
 #include "Panel.h"
 
 const int Panel::LongPressDuration = 1000;
+const int Panel::SpatialIndexMinWidgetCount = 16;
+const int Panel::SpatialIndexMaxGridSize = 32;
+const int Panel::TextureCacheMinDrawCost = 200;
+const int Panel::TextureCacheMinStablePeriod = 1000;
+const float Panel::TextureCacheMaxWindowArea = 0.5f;
 
 Panel::Panel ()
 : Widget ()
@@ -53,6 +62,7 @@ Panel::Panel ()
 , shouldRefreshTexture (false)
 , layoutSpacing (-1.0f)
 , isTextureRenderEnabled (false)
+, isTextureCached (false)
 , maxWidgetX (0.0f)
 , maxWidgetY (0.0f)
 , maxWidgetZLevel (0)
@@ -82,6 +92,11 @@ Panel::Panel ()
 , drawTextureWidth (0)
 , drawTextureHeight (0)
 , isResettingDrawTexture (false)
+, drawTextureGeneration (-1)
+, lastDrawGeneration (0)
+, lastInputEventCount (0)
+, stableDrawPeriod (0)
+, drawCost (0)
 , isMouseInputStarted (false)
 , lastMouseLeftUpCount (0)
 , lastMouseLeftDownCount (0)
@@ -115,15 +130,41 @@ Panel::Panel ()
 , cornerSize (0)
 , widgetListMutex (NULL)
 , widgetAddListMutex (NULL)
+, drawListMutex (NULL)
+, spatialIndexX (0.0f)
+, spatialIndexY (0.0f)
+, spatialIndexCellWidth (1.0f)
+, spatialIndexCellHeight (1.0f)
+, spatialIndexColumnCount (0)
+, spatialIndexRowCount (0)
+, isSpatialIndexValid (false)
+, lastMouseTarget (NULL)
 {
 	widgetListMutex = SDL_CreateMutex ();
 	widgetAddListMutex = SDL_CreateMutex ();
+	drawListMutex = SDL_CreateMutex ();
+	bgColor.setAnimationOwner (this);
+	borderColor.setAnimationOwner (this);
+	dropShadowColor.setAnimationOwner (this);
 	animationScale.assign (1.0f, 1.0f);
 }
 
 Panel::~Panel () {
+	std::vector<Widget *>::iterator i, end;
+
+	if (AnimationTimeline::instance) {
+		AnimationTimeline::instance->removeTween (this);
+	}
 	clear ();
 
+	i = drawList.begin ();
+	end = drawList.end ();
+	while (i != end) {
+		(*i)->release ();
+		++i;
+	}
+	drawList.clear ();
+
 	if (! drawTexturePath.empty ()) {
 		Resource::instance->unloadTexture (drawTexturePath);
 		drawTexturePath.assign ("");
@@ -138,6 +179,10 @@ Panel::~Panel () {
 		SDL_DestroyMutex (widgetAddListMutex);
 		widgetAddListMutex = NULL;
 	}
+	if (drawListMutex) {
+		SDL_DestroyMutex (drawListMutex);
+		drawListMutex = NULL;
+	}
 }
 
 void Panel::setTextureRender (bool enable) {
@@ -156,7 +201,7 @@ void Panel::resetDrawTexture (void *panelPtr) {
 	SDL_Texture *texture;
 
 	panel = (Panel *) panelPtr;
-	if (! panel->isTextureRenderEnabled) {
+	if ((! panel->isTextureRenderEnabled) && (! panel->isTextureCached)) {
 		if (! panel->drawTexturePath.empty ()) {
 			Resource::instance->unloadTexture (panel->drawTexturePath);
 			panel->drawTexturePath.assign ("");
@@ -188,13 +233,24 @@ void Panel::resetDrawTexture (void *panelPtr) {
 	if (! texture) {
 		panel->drawTexturePath.assign ("");
 		panel->isTextureRenderEnabled = false;
+		panel->isTextureCached = false;
 	}
 	else {
 		panel->drawTexture = texture;
+		panel->drawTextureGeneration = panel->getDrawGeneration ();
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+		// Content alpha-blended onto the cleared texture holds color values already multiplied by alpha, which a premultiplied blend mode composites without applying alpha a second time
+		SDL_SetTextureBlendMode (texture, SDL_ComposeCustomBlendMode (SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD));
+#endif
+		App::instance->setRenderTarget (texture);
+		SDL_SetRenderDrawColor (App::instance->render, 0, 0, 0, 0);
+		SDL_RenderClear (App::instance->render);
+		App::instance->setRenderTarget (NULL);
 		panel->draw (texture, -(panel->position.x), -(panel->position.y));
 	}
 	panel->shouldRefreshTexture = false;
 	panel->isResettingDrawTexture = false;
+	panel->addDrawDamage ();
 	panel->release ();
 }
 
@@ -205,6 +261,7 @@ void Panel::animateScale (float startScale, float targetScale, int duration) {
 	isAnimating = true;
 	setTextureRender (true);
 	animationScale.translateX (startScale, targetScale, duration);
+	AnimationTimeline::instance->addTween (this, Panel::stepAnimation);
 }
 
 void Panel::animateNewCard () {
@@ -216,6 +273,25 @@ void Panel::animateNewCard () {
 	animationScale.assignX (0.8f);
 	animationScale.plotX (0.4f, 80);
 	animationScale.plotX (-0.2f, 80);
+	AnimationTimeline::instance->addTween (this, Panel::stepAnimation);
+}
+
+bool Panel::stepAnimation (void *panelPtr, int msElapsed) {
+	Panel *panel;
+
+	panel = (Panel *) panelPtr;
+	if (! panel->isAnimating) {
+		return (false);
+	}
+	panel->animationScale.update (msElapsed);
+	if (! panel->animationScale.isTranslating) {
+		panel->isAnimating = false;
+		if (FLOAT_EQUALS (panel->animationScale.x, 1.0f)) {
+			panel->setTextureRender (false);
+		}
+		return (false);
+	}
+	return (true);
 }
 
 void Panel::clear () {
@@ -228,6 +304,7 @@ void Panel::clear () {
 	while (i != end) {
 		widget = *i;
 		widget->isDestroyed = true;
+		widget->parentWidget = NULL;
 		widget->release ();
 		++i;
 	}
@@ -240,10 +317,13 @@ void Panel::clear () {
 	while (i != end) {
 		widget = *i;
 		widget->isDestroyed = true;
+		widget->parentWidget = NULL;
 		widget->release ();
 		++i;
 	}
 	widgetList.clear ();
+	isSpatialIndexValid = false;
+	lastMouseTarget = NULL;
 	SDL_UnlockMutex (widgetListMutex);
 
 	resetSize ();
@@ -258,6 +338,7 @@ Widget *Panel::addWidget (Widget *widget, float positionX, float positionY, int
 	}
 	widget->position.assign (positionX, positionY);
 	widget->zLevel = zLevel;
+	widget->parentWidget = this;
 	widget->retain ();
 	SDL_LockMutex (widgetAddListMutex);
 	widgetAddList.push_back (widget);
@@ -278,6 +359,7 @@ void Panel::removeWidget (Widget *targetWidget) {
 		widget = *i;
 		if (widget == targetWidget) {
 			widgetAddList.erase (i);
+			widget->parentWidget = NULL;
 			widget->release ();
 			break;
 		}
@@ -292,6 +374,11 @@ void Panel::removeWidget (Widget *targetWidget) {
 		widget = *i;
 		if (widget == targetWidget) {
 			widgetList.erase (i);
+			widget->parentWidget = NULL;
+			if (widget == lastMouseTarget) {
+				lastMouseTarget = NULL;
+			}
+			isSpatialIndexValid = false;
 			widget->release ();
 			break;
 		}
@@ -301,32 +388,10 @@ void Panel::removeWidget (Widget *targetWidget) {
 }
 
 Widget *Panel::findWidget (float screenPositionX, float screenPositionY, bool requireMouseHoverEnabled) {
-	std::list<Widget *>::reverse_iterator i, end;
-	Widget *widget, *item, *nextitem;
-	float x, y, w, h;
+	Widget *item, *nextitem;
 
-	item = NULL;
 	SDL_LockMutex (widgetListMutex);
-	i = widgetList.rbegin ();
-	end = widgetList.rend ();
-	while (i != end) {
-		widget = *i;
-		++i;
-		if (widget->isDestroyed || (! widget->isVisible) || (! widget->hasScreenPosition)) {
-			continue;
-		}
-		w = widget->width;
-		h = widget->height;
-		if ((w <= 0.0f) || (h <= 0.0f)) {
-			continue;
-		}
-		x = widget->screenX;
-		y = widget->screenY;
-		if ((screenPositionX >= x) && (screenPositionX <= (x + w)) && (screenPositionY >= y) && (screenPositionY <= (y + h))) {
-			item = widget;
-			break;
-		}
-	}
+	item = findChildWidget (screenPositionX, screenPositionY, false);
 	SDL_UnlockMutex (widgetListMutex);
 
 	if (item) {
@@ -342,6 +407,230 @@ Widget *Panel::findWidget (float screenPositionX, float screenPositionY, bool re
 	return (item);
 }
 
+Widget *Panel::findChildWidget (float screenPositionX, float screenPositionY, bool isMouseInputTarget) {
+	std::list<Widget *>::reverse_iterator i, end;
+	std::vector<int> *cell;
+	std::vector<int>::reverse_iterator j, jend;
+	Widget *widget;
+
+	if (! isSpatialIndexValid) {
+		resetSpatialIndex ();
+	}
+	if (spatialIndexItems.empty ()) {
+		i = widgetList.rbegin ();
+		end = widgetList.rend ();
+		while (i != end) {
+			widget = *i;
+			++i;
+			if (isChildWidgetHit (widget, screenPositionX, screenPositionY, isMouseInputTarget)) {
+				return (widget);
+			}
+		}
+		return (NULL);
+	}
+
+	cell = findSpatialIndexCell (screenPositionX, screenPositionY);
+	if (! cell) {
+		return (NULL);
+	}
+	j = cell->rbegin ();
+	jend = cell->rend ();
+	while (j != jend) {
+		widget = spatialIndexItems[*j].widget;
+		++j;
+		if (isChildWidgetHit (widget, screenPositionX, screenPositionY, isMouseInputTarget)) {
+			return (widget);
+		}
+	}
+	return (NULL);
+}
+
+std::vector<int> *Panel::findSpatialIndexCell (float screenPositionX, float screenPositionY) {
+	float x, y;
+	int col, row;
+
+	if (spatialIndexCells.empty ()) {
+		return (NULL);
+	}
+	x = screenPositionX - (screenX - viewOriginX) - spatialIndexX;
+	y = screenPositionY - (screenY - viewOriginY) - spatialIndexY;
+	if ((x < 0.0f) || (y < 0.0f)) {
+		return (NULL);
+	}
+	col = (int) (x / spatialIndexCellWidth);
+	row = (int) (y / spatialIndexCellHeight);
+	if ((col >= spatialIndexColumnCount) || (row >= spatialIndexRowCount)) {
+		return (NULL);
+	}
+	return (&(spatialIndexCells[(row * spatialIndexColumnCount) + col]));
+}
+
+bool Panel::isChildWidgetHit (Widget *widget, float screenPositionX, float screenPositionY, bool isMouseInputTarget) {
+	float x, y, w, h;
+
+	if (widget->isDestroyed || (! widget->isVisible) || (! widget->hasScreenPosition)) {
+		return (false);
+	}
+	if (isMouseInputTarget && widget->isInputSuspended) {
+		return (false);
+	}
+	w = widget->width;
+	h = widget->height;
+	if ((w <= 0.0f) || (h <= 0.0f)) {
+		return (false);
+	}
+	x = widget->screenX;
+	y = widget->screenY;
+	if (isMouseInputTarget) {
+		return ((screenPositionX >= (int) x) && (screenPositionX <= (int) (x + w)) && (screenPositionY >= (int) y) && (screenPositionY <= (int) (y + h)));
+	}
+	return ((screenPositionX >= x) && (screenPositionX <= (x + w)) && (screenPositionY >= y) && (screenPositionY <= (y + h)));
+}
+
+void Panel::resetSpatialIndex () {
+	std::list<Widget *>::iterator i, end;
+	Panel::SpatialIndexItem item;
+	Widget *widget;
+	float x1, y1, x2, y2;
+	int index, count, col, row, col1, col2, row1, row2;
+
+	spatialIndexItems.clear ();
+	spatialIndexCells.clear ();
+	spatialIndexColumnCount = 0;
+	spatialIndexRowCount = 0;
+	isSpatialIndexValid = true;
+	count = (int) widgetList.size ();
+	if (count < Panel::SpatialIndexMinWidgetCount) {
+		return;
+	}
+
+	x1 = 0.0f;
+	y1 = 0.0f;
+	x2 = 0.0f;
+	y2 = 0.0f;
+	spatialIndexItems.reserve (count);
+	i = widgetList.begin ();
+	end = widgetList.end ();
+	while (i != end) {
+		widget = *i;
+		++i;
+
+		// Item bounds are expanded by one pixel on each side to cover rounding of screen positions in isChildWidgetHit
+		item.widget = widget;
+		item.x = widget->position.x - 1.0f;
+		item.y = widget->position.y - 1.0f;
+		item.w = widget->width + 2.0f;
+		item.h = widget->height + 2.0f;
+		if (spatialIndexItems.empty ()) {
+			x1 = item.x;
+			y1 = item.y;
+			x2 = item.x + item.w;
+			y2 = item.y + item.h;
+		}
+		else {
+			if (item.x < x1) {
+				x1 = item.x;
+			}
+			if (item.y < y1) {
+				y1 = item.y;
+			}
+			if ((item.x + item.w) > x2) {
+				x2 = item.x + item.w;
+			}
+			if ((item.y + item.h) > y2) {
+				y2 = item.y + item.h;
+			}
+		}
+		spatialIndexItems.push_back (item);
+	}
+
+	spatialIndexColumnCount = (int) ceilf (sqrtf ((float) count));
+	if (spatialIndexColumnCount > Panel::SpatialIndexMaxGridSize) {
+		spatialIndexColumnCount = Panel::SpatialIndexMaxGridSize;
+	}
+	spatialIndexRowCount = spatialIndexColumnCount;
+	spatialIndexX = x1;
+	spatialIndexY = y1;
+	spatialIndexCellWidth = (x2 - x1) / (float) spatialIndexColumnCount;
+	if (spatialIndexCellWidth < 1.0f) {
+		spatialIndexCellWidth = 1.0f;
+	}
+	spatialIndexCellHeight = (y2 - y1) / (float) spatialIndexRowCount;
+	if (spatialIndexCellHeight < 1.0f) {
+		spatialIndexCellHeight = 1.0f;
+	}
+	spatialIndexCells.resize (spatialIndexColumnCount * spatialIndexRowCount);
+
+	for (index = 0; index < count; ++index) {
+		getSpatialIndexCellRange (spatialIndexItems[index], &col1, &col2, &row1, &row2);
+		for (row = row1; row <= row2; ++row) {
+			for (col = col1; col <= col2; ++col) {
+				spatialIndexCells[(row * spatialIndexColumnCount) + col].push_back (index);
+			}
+		}
+	}
+}
+
+void Panel::getSpatialIndexCellRange (const Panel::SpatialIndexItem &item, int *columnStart, int *columnEnd, int *rowStart, int *rowEnd) {
+	*columnStart = (int) ((item.x - spatialIndexX) / spatialIndexCellWidth);
+	*columnEnd = (int) ((item.x + item.w - spatialIndexX) / spatialIndexCellWidth);
+	*rowStart = (int) ((item.y - spatialIndexY) / spatialIndexCellHeight);
+	*rowEnd = (int) ((item.y + item.h - spatialIndexY) / spatialIndexCellHeight);
+	if (*columnEnd >= spatialIndexColumnCount) {
+		*columnEnd = spatialIndexColumnCount - 1;
+	}
+	if (*rowEnd >= spatialIndexRowCount) {
+		*rowEnd = spatialIndexRowCount - 1;
+	}
+}
+
+void Panel::updateSpatialIndexItem (int itemIndex) {
+	Panel::SpatialIndexItem *item;
+	std::vector<int> *cell;
+	std::vector<int>::iterator pos;
+	Widget *widget;
+	float x, y, w, h;
+	int col, row, col1, col2, row1, row2;
+
+	item = &(spatialIndexItems[itemIndex]);
+	widget = item->widget;
+	x = widget->position.x - 1.0f;
+	y = widget->position.y - 1.0f;
+	w = widget->width + 2.0f;
+	h = widget->height + 2.0f;
+	if (FLOAT_EQUALS (x, item->x) && FLOAT_EQUALS (y, item->y) && FLOAT_EQUALS (w, item->w) && FLOAT_EQUALS (h, item->h)) {
+		return;
+	}
+	if ((x < spatialIndexX) || (y < spatialIndexY) || ((x + w) > (spatialIndexX + (spatialIndexCellWidth * (float) spatialIndexColumnCount))) || ((y + h) > (spatialIndexY + (spatialIndexCellHeight * (float) spatialIndexRowCount)))) {
+		isSpatialIndexValid = false;
+		return;
+	}
+
+	getSpatialIndexCellRange (*item, &col1, &col2, &row1, &row2);
+	for (row = row1; row <= row2; ++row) {
+		for (col = col1; col <= col2; ++col) {
+			cell = &(spatialIndexCells[(row * spatialIndexColumnCount) + col]);
+			pos = std::lower_bound (cell->begin (), cell->end (), itemIndex);
+			if ((pos != cell->end ()) && (*pos == itemIndex)) {
+				cell->erase (pos);
+			}
+		}
+	}
+
+	item->x = x;
+	item->y = y;
+	item->w = w;
+	item->h = h;
+	getSpatialIndexCellRange (*item, &col1, &col2, &row1, &row2);
+	for (row = row1; row <= row2; ++row) {
+		for (col = col1; col <= col2; ++col) {
+			cell = &(spatialIndexCells[(row * spatialIndexColumnCount) + col]);
+			pos = std::lower_bound (cell->begin (), cell->end (), itemIndex);
+			cell->insert (pos, itemIndex);
+		}
+	}
+}
+
 Widget *Panel::findWidget (const StdString &widgetName) {
 	std::list<Widget *>::iterator i, end;
 	Widget *widget, *item;
@@ -418,25 +707,23 @@ void Panel::doUpdate (int msElapsed) {
 	Widget *widget;
 	Panel *panel;
 	ProgressBar *bar;
-	bool found;
-
-	bgColor.update (msElapsed);
-	borderColor.update (msElapsed);
-	if (isAnimating) {
-		animationScale.update (msElapsed);
-		if (! animationScale.isTranslating) {
-			isAnimating = false;
-			if (FLOAT_EQUALS (animationScale.x, 1.0f)) {
-				setTextureRender (false);
-			}
-		}
-	}
+	Widget::Rectangle drawrect;
+	float originx, originy, x, y;
+	int itemindex;
+	bool found, iscomplete, usetexture;
 
 	SDL_LockMutex (widgetAddListMutex);
 	addlist.swap (widgetAddList);
 	SDL_UnlockMutex (widgetAddListMutex);
 
+	if (! addlist.empty ()) {
+		addDrawDamage ();
+	}
+
 	SDL_LockMutex (widgetListMutex);
+	if (! addlist.empty ()) {
+		isSpatialIndexValid = false;
+	}
 	widgetList.splice (widgetList.end (), addlist);
 	addlist.clear ();
 	while (true) {
@@ -448,7 +735,13 @@ void Panel::doUpdate (int msElapsed) {
 			if (widget->isDestroyed) {
 				found = true;
 				widgetList.erase (i);
+				widget->parentWidget = NULL;
+				if (widget == lastMouseTarget) {
+					lastMouseTarget = NULL;
+				}
+				isSpatialIndexValid = false;
 				widget->release ();
+				addDrawDamage ();
 				break;
 			}
 			++i;
@@ -471,17 +764,61 @@ void Panel::doUpdate (int msElapsed) {
 		}
 	}
 
+	originx = screenX - viewOriginX;
+	originy = screenY - viewOriginY;
+	iscomplete = true;
+	itemindex = 0;
 	i = widgetList.begin ();
 	end = widgetList.end ();
 	while (i != end) {
 		widget = *i;
-		widget->update (msElapsed, screenX - viewOriginX, screenY - viewOriginY);
+		// Children of a hidden panel aren't drawn, and are marked offscreen so that their animations don't generate draw damage
+		if (isOffscreen || (! isVisible)) {
+			widget->isOffscreen = true;
+		}
+		else if (! widget->hasScreenPosition) {
+			widget->isOffscreen = false;
+		}
+		else {
+			drawrect = widget->getDrawRect ();
+			x = originx + widget->position.x;
+			y = originy + widget->position.y;
+			widget->isOffscreen = ((x + drawrect.w) < screenX) || (x > (screenX + width)) || ((y + drawrect.h) < screenY) || (y > (screenY + height));
+		}
+		widget->update (msElapsed, originx, originy);
+		if (widget->isVisible && ((! widget->isTextureTargetDrawEnabled) || (! widget->isTextureTargetDrawComplete))) {
+			iscomplete = false;
+		}
+		if ((! widget->isDestroyed) && widget->isVisible) {
+			nextDrawList.push_back (widget);
+		}
+
+		// Move the index cells of widgets whose bounds changed, or invalidate the index if widgetList no longer matches its item order
+		if (isSpatialIndexValid && (! spatialIndexItems.empty ())) {
+			if ((itemindex >= (int) spatialIndexItems.size ()) || (spatialIndexItems[itemindex].widget != widget)) {
+				isSpatialIndexValid = false;
+			}
+			else {
+				updateSpatialIndexItem (itemindex);
+			}
+		}
+		++itemindex;
 		++i;
 	}
+	if (isSpatialIndexValid && (itemindex != (int) spatialIndexItems.size ())) {
+		if ((! spatialIndexItems.empty ()) || (itemindex >= Panel::SpatialIndexMinWidgetCount)) {
+			isSpatialIndexValid = false;
+		}
+	}
 	SDL_UnlockMutex (widgetListMutex);
+	publishDrawList ();
+
+	isTextureTargetDrawComplete = iscomplete;
+	updateTextureCache (msElapsed);
 
 	if (! isResettingDrawTexture) {
-		if ((isTextureRenderEnabled && (! drawTexture)) || ((! isTextureRenderEnabled) && drawTexture) || shouldRefreshTexture) {
+		usetexture = isTextureRenderEnabled || isTextureCached;
+		if ((usetexture && (! drawTexture)) || ((! usetexture) && drawTexture) || shouldRefreshTexture || (isTextureCached && drawTexture && (drawTextureGeneration != getDrawGeneration ()))) {
 			isResettingDrawTexture = true;
 			shouldRefreshTexture = false;
 			retain ();
@@ -490,6 +827,79 @@ void Panel::doUpdate (int msElapsed) {
 	}
 }
 
+void Panel::publishDrawList () {
+	std::vector<Widget *>::iterator i, end;
+
+	// drawList is modified only by this method, so the update thread can compare against it without holding drawListMutex
+	if (nextDrawList == drawList) {
+		nextDrawList.clear ();
+		return;
+	}
+
+	i = nextDrawList.begin ();
+	end = nextDrawList.end ();
+	while (i != end) {
+		(*i)->retain ();
+		++i;
+	}
+	SDL_LockMutex (drawListMutex);
+	drawList.swap (nextDrawList);
+	SDL_UnlockMutex (drawListMutex);
+
+	i = nextDrawList.begin ();
+	end = nextDrawList.end ();
+	while (i != end) {
+		(*i)->release ();
+		++i;
+	}
+	nextDrawList.clear ();
+}
+
+void Panel::updateTextureCache (int msElapsed) {
+	Input *input;
+	float x1, y1, x2, y2;
+	int period, generation;
+	bool changed, cacheable;
+
+	// Input events can change hover and focus state without reporting draw damage, so any input while the mouse is over the panel counts as a content change
+	input = Input::instance;
+	if (input->eventCount != lastInputEventCount) {
+		lastInputEventCount = input->eventCount;
+		if (hasScreenPosition) {
+			x1 = screenX;
+			y1 = screenY;
+			x2 = screenX + width;
+			y2 = screenY + height;
+			if ((((float) input->mouseX >= x1) && ((float) input->mouseX <= x2) && ((float) input->mouseY >= y1) && ((float) input->mouseY <= y2)) || (((float) input->lastMouseX >= x1) && ((float) input->lastMouseX <= x2) && ((float) input->lastMouseY >= y1) && ((float) input->lastMouseY <= y2))) {
+				advanceDrawGeneration ();
+			}
+		}
+	}
+
+	changed = false;
+	period = stableDrawPeriod;
+	generation = getDrawGeneration ();
+	if (generation != lastDrawGeneration) {
+		lastDrawGeneration = generation;
+		stableDrawPeriod = 0;
+		changed = true;
+	}
+	else if (stableDrawPeriod < Panel::TextureCacheMinStablePeriod) {
+		stableDrawPeriod += msElapsed;
+	}
+
+	cacheable = App::instance->isTextureCacheEnabled && isVisible && (! isOffscreen) && hasScreenPosition && isTextureTargetDrawEnabled && isTextureTargetDrawComplete && (! isTextureRenderEnabled) && (! isAnimating) && (! isWaiting) && (! isDropShadowed) && (width >= 1.0f) && (height >= 1.0f) && ((width * height) <= ((float) (App::instance->windowWidth * App::instance->windowHeight) * Panel::TextureCacheMaxWindowArea));
+	if (isTextureCached) {
+		// A change arriving soon after the previous one indicates content that updates too frequently to benefit from caching
+		if ((! cacheable) || (changed && (period < Panel::TextureCacheMinStablePeriod))) {
+			isTextureCached = false;
+		}
+	}
+	else if (cacheable && (stableDrawPeriod >= Panel::TextureCacheMinStablePeriod) && (drawCost >= Panel::TextureCacheMinDrawCost)) {
+		isTextureCached = true;
+	}
+}
+
 void Panel::processInput () {
 	std::list<Widget *>::reverse_iterator i, iend;
 	std::vector<SDL_Keycode> keyevents;
@@ -664,9 +1074,10 @@ bool Panel::doProcessKeyEvent (SDL_Keycode keycode, bool isShiftDown, bool isCon
 
 bool Panel::doProcessMouseState (const Widget::MouseState &mouseState) {
 	std::list<Widget *>::reverse_iterator i, end;
-	Widget *widget;
-	bool found, consumed;
-	Widget::MouseState m;
+	std::vector<int> *cell;
+	std::vector<int>::reverse_iterator j, jend;
+	Widget *widget, *target;
+	bool consumed;
 	float x, y;
 
 	if (isTextureRenderEnabled) {
@@ -675,45 +1086,77 @@ bool Panel::doProcessMouseState (const Widget::MouseState &mouseState) {
 	x = Input::instance->mouseX;
 	y = Input::instance->mouseY;
 	consumed = false;
-	found = false;
+	target = NULL;
 	SDL_LockMutex (widgetListMutex);
-	i = widgetList.rbegin ();
-	end = widgetList.rend ();
-	while (i != end) {
-		widget = *i;
-		++i;
-		if (widget->isDestroyed || widget->isInputSuspended || (! widget->isVisible) || (! widget->hasScreenPosition)) {
-			continue;
-		}
+	if (! isSpatialIndexValid) {
+		resetSpatialIndex ();
+	}
+	if (mouseState.isEntered) {
+		target = findChildWidget (x, y, true);
+	}
 
-		m = mouseState;
-		m.isEntered = false;
-		m.enterDeltaX = 0.0f;
-		m.enterDeltaY = 0.0f;
-		if ((! found) && mouseState.isEntered) {
-			if ((widget->width > 0.0f) && (widget->height > 0.0f)) {
-				if ((x >= (int) widget->screenX) && (x <= (int) (widget->screenX + widget->width)) && (y >= (int) widget->screenY) && (y <= (int) (widget->screenY + widget->height))) {
-					m.isEntered = true;
-					m.enterDeltaX = x - widget->screenX;
-					m.enterDeltaY = y - widget->screenY;
-					found = true;
-				}
+	// Button and wheel events can change the state of children that don't contain the mouse position, such as dragging sliders or expanded combo boxes, and are delivered to every child. A plain pointer move can only change the state of the previous and current targets, so panels with a spatial index deliver it to those children and the candidates found in the grid cell under the mouse.
+	if (spatialIndexItems.empty () || (mouseState.wheelUp > 0) || (mouseState.wheelDown > 0) || mouseState.isLeftClicked || mouseState.isLeftClickReleased || mouseState.isLongPressed || Input::instance->isMouseLeftButtonDown) {
+		i = widgetList.rbegin ();
+		end = widgetList.rend ();
+		while (i != end) {
+			widget = *i;
+			++i;
+			if (processChildMouseState (widget, target, mouseState, consumed)) {
+				consumed = true;
 			}
 		}
-
-		if (consumed) {
-			m.wheelUp = 0;
-			m.wheelDown = 0;
+	}
+	else {
+		if (lastMouseTarget && (lastMouseTarget != target)) {
+			processChildMouseState (lastMouseTarget, target, mouseState, false);
+		}
+		if (mouseState.isEntered) {
+			cell = findSpatialIndexCell (x, y);
+			if (cell) {
+				j = cell->rbegin ();
+				jend = cell->rend ();
+				while (j != jend) {
+					widget = spatialIndexItems[*j].widget;
+					++j;
+					if (widget != lastMouseTarget) {
+						processChildMouseState (widget, target, mouseState, false);
+					}
+				}
+			}
 		}
-		if (widget->processMouseState (m)) {
-			consumed = true;
+		if (lastMouseTarget && (lastMouseTarget == target)) {
+			processChildMouseState (lastMouseTarget, target, mouseState, false);
 		}
 	}
+	lastMouseTarget = target;
 	SDL_UnlockMutex (widgetListMutex);
 
 	return (consumed);
 }
 
+bool Panel::processChildMouseState (Widget *widget, Widget *targetWidget, const Widget::MouseState &mouseState, bool isWheelConsumed) {
+	Widget::MouseState m;
+
+	if (widget->isDestroyed || widget->isInputSuspended || (! widget->isVisible) || (! widget->hasScreenPosition)) {
+		return (false);
+	}
+	m = mouseState;
+	m.isEntered = false;
+	m.enterDeltaX = 0.0f;
+	m.enterDeltaY = 0.0f;
+	if (widget == targetWidget) {
+		m.isEntered = true;
+		m.enterDeltaX = ((float) Input::instance->mouseX) - widget->screenX;
+		m.enterDeltaY = ((float) Input::instance->mouseY) - widget->screenY;
+	}
+	if (isWheelConsumed) {
+		m.wheelUp = 0;
+		m.wheelDown = 0;
+	}
+	return (widget->processMouseState (m));
+}
+
 void Panel::doResetInputState () {
 	std::list<Widget *>::iterator i, end;
 	Widget *widget;
@@ -740,9 +1183,11 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 	SDL_Renderer *render;
 	SDL_Texture *cornertexture;
 	SDL_Rect rect;
-	std::list<Widget *>::iterator i, end;
+	std::vector<Widget *>::iterator i, end;
 	Widget *widget;
-	int x0, y0, texturew, textureh;
+	Widget::Rectangle drawrect;
+	Uint64 starttime;
+	int x0, y0, texturew, textureh, cost;
 	float w, h;
 
 	render = App::instance->render;
@@ -764,12 +1209,25 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 
 			rect.w = (int) w;
 			rect.h = (int) h;
+			App::instance->flushDrawBatch ();
 			SDL_RenderCopy (render, drawTexture, NULL, &rect);
+			Profiler::instance->addCount (Profiler::RenderCallCounter);
 		}
 		return;
 	}
+	if ((! targetTexture) && isTextureCached && drawTexture && (drawTextureGeneration == getDrawGeneration ())) {
+		rect.x = x0;
+		rect.y = y0;
+		rect.w = drawTextureWidth;
+		rect.h = drawTextureHeight;
+		App::instance->flushDrawBatch ();
+		SDL_RenderCopy (render, drawTexture, NULL, &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
+		return;
+	}
 
-	SDL_SetRenderTarget (render, targetTexture);
+	starttime = SDL_GetPerformanceCounter ();
+	App::instance->setRenderTarget (targetTexture);
 	rect.x = x0;
 	rect.y = y0;
 	rect.w = (int) width;
@@ -777,12 +1235,7 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 	App::instance->pushClipRect (&rect);
 
 	if (isFilledBg && (bgColor.aByte > 0)) {
-		SDL_SetRenderTarget (render, targetTexture);
-		if (bgColor.aByte < 255) {
-			SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_BLEND);
-		}
-		SDL_SetRenderDrawColor (render, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
-
+		App::instance->setRenderTarget (targetTexture);
 		if ((cornerSize > 0) && ((int) width >= cornerSize) && ((int) height >= cornerSize)) {
 			if (topLeftCornerRadius > 0) {
 				cornertexture = App::instance->getRoundedCornerTexture (topLeftCornerRadius, &texturew, &textureh);
@@ -791,9 +1244,7 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 					rect.y = y0;
 					rect.w = texturew;
 					rect.h = textureh;
-					SDL_SetTextureColorMod (cornertexture, bgColor.rByte, bgColor.gByte, bgColor.bByte);
-					SDL_SetTextureBlendMode (cornertexture, SDL_BLENDMODE_BLEND);
-					SDL_RenderCopy (render, cornertexture, NULL, &rect);
+					App::instance->addDrawBatchTexture (cornertexture, rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, 255);
 				}
 			}
 			if (topRightCornerRadius > 0) {
@@ -803,9 +1254,7 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 					rect.y = y0;
 					rect.w = texturew;
 					rect.h = textureh;
-					SDL_SetTextureColorMod (cornertexture, bgColor.rByte, bgColor.gByte, bgColor.bByte);
-					SDL_SetTextureBlendMode (cornertexture, SDL_BLENDMODE_BLEND);
-					SDL_RenderCopy (render, cornertexture, NULL, &rect);
+					App::instance->addDrawBatchTexture (cornertexture, rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, 255);
 				}
 			}
 			if (bottomLeftCornerRadius > 0) {
@@ -815,9 +1264,7 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 					rect.y = y0 + (int) height - textureh;
 					rect.w = texturew;
 					rect.h = textureh;
-					SDL_SetTextureColorMod (cornertexture, bgColor.rByte, bgColor.gByte, bgColor.bByte);
-					SDL_SetTextureBlendMode (cornertexture, SDL_BLENDMODE_BLEND);
-					SDL_RenderCopy (render, cornertexture, NULL, &rect);
+					App::instance->addDrawBatchTexture (cornertexture, rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, 255);
 				}
 			}
 			if (bottomRightCornerRadius > 0) {
@@ -827,9 +1274,7 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 					rect.y = y0 + (int) height - textureh;
 					rect.w = texturew;
 					rect.h = textureh;
-					SDL_SetTextureColorMod (cornertexture, bgColor.rByte, bgColor.gByte, bgColor.bByte);
-					SDL_SetTextureBlendMode (cornertexture, SDL_BLENDMODE_BLEND);
-					SDL_RenderCopy (render, cornertexture, NULL, &rect);
+					App::instance->addDrawBatchTexture (cornertexture, rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, 255);
 				}
 			}
 
@@ -841,35 +1286,35 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 			rect.y += cornerCenterDy;
 			rect.w += cornerCenterDw;
 			rect.h += cornerCenterDh;
-			SDL_RenderFillRect (render, &rect);
+			App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 
 			if (cornerTopDh > 0) {
 				rect.x = x0 + cornerTopDx;
 				rect.y = y0 + cornerTopDy;
 				rect.w = ((int) width) + cornerTopDw;
 				rect.h = cornerTopDh;
-				SDL_RenderFillRect (render, &rect);
+				App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 			}
 			if (cornerLeftDw > 0) {
 				rect.x = x0 + cornerLeftDx;
 				rect.y = y0 + cornerLeftDy;
 				rect.w = cornerLeftDw;
 				rect.h = ((int) height) + cornerLeftDh;
-				SDL_RenderFillRect (render, &rect);
+				App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 			}
 			if (cornerRightDw > 0) {
 				rect.x = x0 + width + cornerRightDx;
 				rect.y = y0 + cornerRightDy;
 				rect.w = cornerRightDw;
 				rect.h = ((int) height) + cornerRightDh;
-				SDL_RenderFillRect (render, &rect);
+				App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 			}
 			if (cornerBottomDh > 0) {
 				rect.x = x0 + cornerBottomDx;
 				rect.y = y0 + height + cornerBottomDy;
 				rect.w = ((int) width) + cornerBottomDw;
 				rect.h = cornerBottomDh;
-				SDL_RenderFillRect (render, &rect);
+				App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 			}
 		}
 		else {
@@ -877,19 +1322,15 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 			rect.y = y0;
 			rect.w = (int) width;
 			rect.h = (int) height;
-			SDL_RenderFillRect (render, &rect);
-		}
-
-		if (bgColor.aByte < 255) {
-			SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_NONE);
+			App::instance->addDrawBatchRect (rect, bgColor.rByte, bgColor.gByte, bgColor.bByte, bgColor.aByte);
 		}
-		SDL_SetRenderDrawColor (render, 0, 0, 0, 0);
-		SDL_SetRenderTarget (render, NULL);
+		App::instance->setRenderTarget (NULL);
 	}
 
-	SDL_LockMutex (widgetListMutex);
-	i = widgetList.begin ();
-	end = widgetList.end ();
+	// Draw from the most recently published draw list, which is held only briefly by the update thread while swapping in a new list
+	SDL_LockMutex (drawListMutex);
+	i = drawList.begin ();
+	end = drawList.end ();
 	while (i != end) {
 		widget = *i;
 		++i;
@@ -897,47 +1338,46 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 			continue;
 		}
 
+		// Skip drawing of child widgets that fall entirely outside the active clip area. Texture target draws are excluded, since their coordinates are not relative to the window clip rectangle.
+		if ((! targetTexture) && widget->hasScreenPosition) {
+			drawrect = widget->getDrawRect ();
+			rect.x = x0 - (int) viewOriginX + (int) widget->position.x;
+			rect.y = y0 - (int) viewOriginY + (int) widget->position.y;
+			rect.w = (int) drawrect.w + 1;
+			rect.h = (int) drawrect.h + 1;
+			if (! SDL_HasIntersection (&rect, &(App::instance->clipRect))) {
+				continue;
+			}
+		}
+
 		widget->draw (targetTexture, x0 - (int) viewOriginX, y0 - (int) viewOriginY);
 	}
-	SDL_UnlockMutex (widgetListMutex);
+	SDL_UnlockMutex (drawListMutex);
 
 	if (isBordered && (borderColor.aByte > 0) && (borderWidth >= 1.0f)) {
-		SDL_SetRenderTarget (render, targetTexture);
-		if (borderColor.aByte < 255) {
-			SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_BLEND);
-		}
-		SDL_SetRenderDrawColor (render, borderColor.rByte, borderColor.gByte, borderColor.bByte, borderColor.aByte);
-
+		App::instance->setRenderTarget (targetTexture);
 		rect.x = x0;
 		rect.y = y0;
 		rect.w = (int) width;
 		rect.h = (int) borderWidth;
-		SDL_RenderFillRect (render, &rect);
+		App::instance->addDrawBatchRect (rect, borderColor.rByte, borderColor.gByte, borderColor.bByte, borderColor.aByte);
 
 		rect.y = y0 + (int) (height - borderWidth);
-		SDL_RenderFillRect (render, &rect);
+		App::instance->addDrawBatchRect (rect, borderColor.rByte, borderColor.gByte, borderColor.bByte, borderColor.aByte);
 
 		rect.y = y0 + (int) borderWidth;
 		rect.w = (int) borderWidth;
 		rect.h = ((int) height) - (int) (borderWidth * 2.0f);
-		SDL_RenderFillRect (render, &rect);
+		App::instance->addDrawBatchRect (rect, borderColor.rByte, borderColor.gByte, borderColor.bByte, borderColor.aByte);
 
 		rect.x = x0 + (int) (width - borderWidth);
-		SDL_RenderFillRect (render, &rect);
-
-		if (borderColor.aByte < 255) {
-			SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_NONE);
-		}
-		SDL_SetRenderDrawColor (render, 0, 0, 0, 0);
-		SDL_SetRenderTarget (render, NULL);
+		App::instance->addDrawBatchRect (rect, borderColor.rByte, borderColor.gByte, borderColor.bByte, borderColor.aByte);
+		App::instance->setRenderTarget (NULL);
 	}
 	App::instance->popClipRect ();
 
 	if (isDropShadowed && (dropShadowColor.aByte > 0) && (dropShadowWidth >= 1.0f)) {
-		SDL_SetRenderTarget (render, targetTexture);
-		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_BLEND);
-		SDL_SetRenderDrawColor (render, dropShadowColor.rByte, dropShadowColor.gByte, dropShadowColor.bByte, dropShadowColor.aByte);
-
+		App::instance->setRenderTarget (targetTexture);
 		rect.x = App::instance->clipRect.x;
 		rect.y = App::instance->clipRect.y;
 		rect.w = App::instance->clipRect.w + dropShadowWidth;
@@ -948,19 +1388,21 @@ void Panel::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 		rect.y = y0 + (int) dropShadowWidth;
 		rect.w = (int) dropShadowWidth;
 		rect.h = (int) height;
-		SDL_RenderFillRect (render, &rect);
+		App::instance->addDrawBatchRect (rect, dropShadowColor.rByte, dropShadowColor.gByte, dropShadowColor.bByte, dropShadowColor.aByte);
 
 		rect.x = x0 + (int) dropShadowWidth;
 		rect.y = y0 + (int) height;
 		rect.w = (int) (width - dropShadowWidth);
 		rect.h = (int) dropShadowWidth;
-		SDL_RenderFillRect (render, &rect);
+		App::instance->addDrawBatchRect (rect, dropShadowColor.rByte, dropShadowColor.gByte, dropShadowColor.bByte, dropShadowColor.aByte);
 
 		App::instance->popClipRect ();
+		App::instance->setRenderTarget (NULL);
+	}
 
-		SDL_SetRenderDrawBlendMode (render, SDL_BLENDMODE_NONE);
-		SDL_SetRenderDrawColor (render, 0, 0, 0, 0);
-		SDL_SetRenderTarget (render, NULL);
+	if (! targetTexture) {
+		cost = (int) ((SDL_GetPerformanceCounter () - starttime) * 1000000 / SDL_GetPerformanceFrequency ());
+		drawCost = ((drawCost * 3) + cost) / 4;
 	}
 }
 
@@ -1259,6 +1701,10 @@ void Panel::refreshLayout () {
 			break;
 		}
 	}
+
+	SDL_LockMutex (widgetListMutex);
+	isSpatialIndexValid = false;
+	SDL_UnlockMutex (widgetListMutex);
 	resetSize ();
 }
 
@@ -1320,6 +1766,7 @@ void Panel::setFillBg (bool enable, const Color &color) {
 	else {
 		isFilledBg = false;
 	}
+	addDrawDamage ();
 }
 
 void Panel::setCornerRadius (int radius) {
@@ -1506,6 +1953,7 @@ void Panel::setCornerRadius (int topLeftRadius, int topRightRadius, int bottomLe
 		amt = bottomRightRadius;
 	}
 	cornerSize = amt * 2;
+	addDrawDamage ();
 }
 
 void Panel::setBorder (bool enable, const Color &color, float borderWidthValue) {
@@ -1520,6 +1968,7 @@ void Panel::setBorder (bool enable, const Color &color, float borderWidthValue)
 	else {
 		isBordered = false;
 	}
+	addDrawDamage ();
 }
 
 void Panel::setDropShadow (bool enable, const Color &color, float dropShadowWidthValue) {
@@ -1534,6 +1983,18 @@ void Panel::setDropShadow (bool enable, const Color &color, float dropShadowWidt
 	else {
 		isDropShadowed = false;
 	}
+	addDrawDamage ();
+}
+
+Widget::Rectangle Panel::getDrawRect () {
+	Widget::Rectangle rect;
+
+	rect = getScreenRect ();
+	if (isDropShadowed && (dropShadowWidth >= 1.0f)) {
+		rect.w += dropShadowWidth;
+		rect.h += dropShadowWidth;
+	}
+	return (rect);
 }
 
 void Panel::setViewOrigin (float originX, float originY) {
@@ -1557,6 +2018,9 @@ void Panel::setViewOrigin (float originX, float originY) {
 		}
 	}
 
+	if ((! FLOAT_EQUALS (x, viewOriginX)) || (! FLOAT_EQUALS (y, viewOriginY))) {
+		addDrawDamage ();
+	}
 	viewOriginX = x;
 	viewOriginY = y;
 }
@@ -1648,3 +2112,45 @@ void Panel::syncRecordStore () {
 	}
 	SDL_UnlockMutex (widgetAddListMutex);
 }
+
+void Panel::syncRecordStoreChanges (const RecordStore::ChangeSet &changes) {
+	std::list<Widget *>::iterator i, end;
+	Widget *widget;
+
+	if (isRecordSyncRequired (changes)) {
+		syncRecordStore ();
+		return;
+	}
+
+	SDL_LockMutex (widgetListMutex);
+	i = widgetList.begin ();
+	end = widgetList.end ();
+	while (i != end) {
+		widget = *i;
+		++i;
+		if (widget->isDestroyed) {
+			continue;
+		}
+
+		widget->syncRecordStoreChanges (changes);
+	}
+	SDL_UnlockMutex (widgetListMutex);
+
+	SDL_LockMutex (widgetAddListMutex);
+	i = widgetAddList.begin ();
+	end = widgetAddList.end ();
+	while (i != end) {
+		widget = *i;
+		++i;
+		if (widget->isDestroyed) {
+			continue;
+		}
+
+		widget->syncRecordStoreChanges (changes);
+	}
+	SDL_UnlockMutex (widgetAddListMutex);
+}
+
+bool Panel::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (false);
+}
@@ -34,6 +34,7 @@
 
 #include <stdint.h>
 #include <list>
+#include <vector>
 #include "SDL2/SDL.h"
 #include "StdString.h"
 #include "StringList.h"
@@ -48,6 +49,11 @@ public:
 	virtual ~Panel ();
 
 	static const int LongPressDuration; // ms
+	static const int SpatialIndexMinWidgetCount;
+	static const int SpatialIndexMaxGridSize;
+	static const int TextureCacheMinDrawCost; // microseconds
+	static const int TextureCacheMinStablePeriod; // milliseconds
+	static const float TextureCacheMaxWindowArea; // fraction of the window area
 
 	// Layout types
 	enum {
@@ -67,6 +73,7 @@ public:
 
 	// Read-only data members
 	bool isTextureRenderEnabled;
+	bool isTextureCached;
 	float maxWidgetX, maxWidgetY;
 	int maxWidgetZLevel;
 	float viewOriginX, viewOriginY;
@@ -157,9 +164,21 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	virtual void syncRecordStore ();
 
+	// Update widget state as appropriate for the provided set of changes to the application's RecordStore object, which has been locked prior to invocation. If isRecordSyncRequired returns true, the panel executes syncRecordStore; otherwise, it passes the change set to its child widgets.
+	virtual void syncRecordStoreChanges (const RecordStore::ChangeSet &changes);
+
+	// Return a boolean value indicating if the panel must execute syncRecordStore to reflect the provided set of record changes. Panel's own syncRecordStore only visits child widgets, so the default implementation returns false; subclasses that override syncRecordStore must also override this method.
+	virtual bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
+	// Return a Rectangle struct containing the screen extent values covered by the panel's draw operations
+	virtual Widget::Rectangle getDrawRect ();
+
 	// Reset the panel's draw texture as appropriate for a new enable state
 	static void resetDrawTexture (void *panelPtr);
 
+	// Advance the scale animation of the panel provided in panelPtr, as an AnimationTimeline::StepFunction
+	static bool stepAnimation (void *panelPtr, int msElapsed);
+
 protected:
 	// Execute operations to update object state as appropriate for an elapsed millisecond time period
 	virtual void doUpdate (int msElapsed);
@@ -188,10 +207,48 @@ protected:
 	// Check if the widget list is correctly sorted for drawing by z-level, and sort the list if not. This method must only be invoked while holding a lock on widgetListMutex.
 	void sortWidgetList ();
 
+	// Return the topmost child widget containing the specified screen position, or NULL if no such widget was found. If isMouseInputTarget is true, skip widgets with suspended input and match positions against whole pixel bounds as appropriate for mouse input. This method must only be invoked while holding a lock on widgetListMutex.
+	Widget *findChildWidget (float screenPositionX, float screenPositionY, bool isMouseInputTarget);
+
+	// Return a boolean value indicating if the provided child widget contains the specified screen position, as appropriate for findChildWidget
+	bool isChildWidgetHit (Widget *widget, float screenPositionX, float screenPositionY, bool isMouseInputTarget);
+
+	// Replace drawList with the contents of nextDrawList if the two differ, then clear nextDrawList. This method must only be invoked from the update thread.
+	void publishDrawList ();
+
+	// Enable or disable the panel's texture cache as appropriate for its measured draw cost and the time elapsed since its content last changed
+	void updateTextureCache (int msElapsed);
+
+	// A child widget's bounds in the panel's content coordinates, as stored in the spatial index
+	struct SpatialIndexItem {
+		Widget *widget;
+		float x, y, w, h;
+	};
+
+	// Rebuild the spatial index of child widget bounds. This method must only be invoked while holding a lock on widgetListMutex.
+	void resetSpatialIndex ();
+
+	// Move the spatial index item at the specified position to the cells matching its widget's current bounds, or invalidate the index if the widget has moved outside the grid. This method must only be invoked while holding a lock on widgetListMutex.
+	void updateSpatialIndexItem (int itemIndex);
+
+	// Store the range of spatial index cells covered by the provided item in the provided pointers
+	void getSpatialIndexCellRange (const Panel::SpatialIndexItem &item, int *columnStart, int *columnEnd, int *rowStart, int *rowEnd);
+
+	// Return the spatial index cell containing the specified screen position, or NULL if the position lies outside the grid. This method must only be invoked while holding a lock on widgetListMutex.
+	std::vector<int> *findSpatialIndexCell (float screenPositionX, float screenPositionY);
+
+	// Update the provided child widget with the specified mouse state, setting its entered state if it matches the provided target widget. Returns a boolean value indicating if mouse wheel events were consumed.
+	bool processChildMouseState (Widget *widget, Widget *targetWidget, const Widget::MouseState &mouseState, bool isWheelConsumed);
+
 	SDL_Texture *drawTexture;
 	int drawTextureWidth, drawTextureHeight;
 	StdString drawTexturePath;
 	bool isResettingDrawTexture;
+	int drawTextureGeneration;
+	int lastDrawGeneration;
+	int64_t lastInputEventCount;
+	int stableDrawPeriod;
+	int drawCost;
 	bool isMouseInputStarted;
 	int lastMouseLeftUpCount, lastMouseLeftDownCount;
 	int lastMouseRightUpCount, lastMouseRightDownCount;
@@ -208,8 +265,24 @@ protected:
 	std::list<Widget *> widgetList;
 	SDL_mutex *widgetAddListMutex;
 	std::list<Widget *> widgetAddList;
+
+	// The set of child widgets to draw, in draw order. The update thread publishes a new list after each update pass, allowing draw operations to proceed without a lock on widgetListMutex. Each widget in drawList is retained by the panel.
+	SDL_mutex *drawListMutex;
+	std::vector<Widget *> drawList;
+	std::vector<Widget *> nextDrawList;
 	WidgetHandle waitPanel;
 	WidgetHandle waitProgressBar;
+
+	// A uniform grid of child widget bounds in the panel's content coordinates, used to find hit test candidates for panels holding many widgets. Each cell lists indexes into spatialIndexItems in widgetList order.
+	std::vector<Panel::SpatialIndexItem> spatialIndexItems;
+	std::vector<std::vector<int> > spatialIndexCells;
+	float spatialIndexX, spatialIndexY;
+	float spatialIndexCellWidth, spatialIndexCellHeight;
+	int spatialIndexColumnCount, spatialIndexRowCount;
+	bool isSpatialIndexValid;
+
+	// The child widget that received an entered mouse state in the last mouse state pass, or NULL if no such widget exists
+	Widget *lastMouseTarget;
 };
 
 #endif
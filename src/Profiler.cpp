@@ -0,0 +1,265 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Config.h"
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+#include "SDL2/SDL.h"
+#include "StdString.h"
+#include "Profiler.h"
+
+Profiler *Profiler::instance = NULL;
+
+const int Profiler::SampleCount = 240;
+const int Profiler::HistogramBucketCount = 8;
+
+Profiler::Profiler ()
+: isEnabled (false)
+, sampleMutex (NULL)
+, performanceFrequency (1)
+{
+	int i;
+
+	sampleMutex = SDL_CreateMutex ();
+	for (i = 0; i < Profiler::CounterCount; ++i) {
+		SDL_AtomicSet (&(counterValues[i]), 0);
+	}
+	performanceFrequency = SDL_GetPerformanceFrequency ();
+	if (performanceFrequency <= 0) {
+		performanceFrequency = 1;
+	}
+}
+
+Profiler::~Profiler () {
+	if (sampleMutex) {
+		SDL_DestroyMutex (sampleMutex);
+		sampleMutex = NULL;
+	}
+}
+
+void Profiler::setEnabled (bool enable) {
+	int i;
+
+	if (enable == isEnabled) {
+		return;
+	}
+	SDL_LockMutex (sampleMutex);
+	for (i = 0; i < Profiler::SectionCount; ++i) {
+		sectionSamples[i].samples.clear ();
+		sectionSamples[i].nextIndex = 0;
+	}
+	for (i = 0; i < Profiler::CounterCount; ++i) {
+		counterSamples[i].samples.clear ();
+		counterSamples[i].nextIndex = 0;
+		SDL_AtomicSet (&(counterValues[i]), 0);
+	}
+	isEnabled = enable;
+	SDL_UnlockMutex (sampleMutex);
+}
+
+Uint64 Profiler::beginSection () {
+	if (! isEnabled) {
+		return (0);
+	}
+	return (SDL_GetPerformanceCounter ());
+}
+
+void Profiler::endSection (int section, Uint64 startTime) {
+	Uint64 now;
+
+	if ((! isEnabled) || (startTime <= 0) || (section < 0) || (section >= Profiler::SectionCount)) {
+		return;
+	}
+	now = SDL_GetPerformanceCounter ();
+	if (now < startTime) {
+		return;
+	}
+	SDL_LockMutex (sampleMutex);
+	addSample (&(sectionSamples[section]), (int64_t) ((now - startTime) * 1000000 / performanceFrequency));
+	SDL_UnlockMutex (sampleMutex);
+}
+
+void Profiler::addCount (int counter, int amount) {
+	if ((! isEnabled) || (counter < 0) || (counter >= Profiler::CounterCount)) {
+		return;
+	}
+	SDL_AtomicAdd (&(counterValues[counter]), amount);
+}
+
+void Profiler::endCounterFrame (int counter) {
+	int value;
+
+	if ((! isEnabled) || (counter < 0) || (counter >= Profiler::CounterCount)) {
+		return;
+	}
+	value = SDL_AtomicSet (&(counterValues[counter]), 0);
+	SDL_LockMutex (sampleMutex);
+	addSample (&(counterSamples[counter]), (int64_t) value);
+	SDL_UnlockMutex (sampleMutex);
+}
+
+void Profiler::addSample (Profiler::SampleRing *ring, int64_t value) {
+	if ((int) ring->samples.size () < Profiler::SampleCount) {
+		ring->samples.push_back (value);
+		return;
+	}
+	ring->samples[ring->nextIndex] = value;
+	ring->nextIndex = (ring->nextIndex + 1) % Profiler::SampleCount;
+}
+
+void Profiler::getSectionStats (int section, Profiler::Stats *destStats) {
+	if ((section < 0) || (section >= Profiler::SectionCount)) {
+		*destStats = Profiler::Stats ();
+		return;
+	}
+	getStats (&(sectionSamples[section]), destStats);
+}
+
+void Profiler::getCounterStats (int counter, Profiler::Stats *destStats) {
+	if ((counter < 0) || (counter >= Profiler::CounterCount)) {
+		*destStats = Profiler::Stats ();
+		return;
+	}
+	getStats (&(counterSamples[counter]), destStats);
+}
+
+void Profiler::getStats (Profiler::SampleRing *ring, Profiler::Stats *destStats) {
+	std::vector<int64_t> samples;
+	int count;
+
+	SDL_LockMutex (sampleMutex);
+	samples = ring->samples;
+	SDL_UnlockMutex (sampleMutex);
+
+	*destStats = Profiler::Stats ();
+	count = (int) samples.size ();
+	if (count <= 0) {
+		return;
+	}
+	std::sort (samples.begin (), samples.end ());
+	destStats->sampleCount = count;
+	destStats->p50 = samples[((count - 1) * 50) / 100];
+	destStats->p90 = samples[((count - 1) * 90) / 100];
+	destStats->p99 = samples[((count - 1) * 99) / 100];
+	destStats->max = samples[count - 1];
+}
+
+StdString Profiler::getSectionHistogram (int section) {
+	static const char BucketChars[] = " .:-=+*#";
+	std::vector<int64_t> samples;
+	std::vector<int64_t>::iterator i, end;
+	int buckets[Profiler::HistogramBucketCount];
+	StdString s;
+	int64_t limit;
+	int bucket, maxcount, level;
+
+	if ((section < 0) || (section >= Profiler::SectionCount)) {
+		return (StdString (""));
+	}
+	SDL_LockMutex (sampleMutex);
+	samples = sectionSamples[section].samples;
+	SDL_UnlockMutex (sampleMutex);
+
+	for (bucket = 0; bucket < Profiler::HistogramBucketCount; ++bucket) {
+		buckets[bucket] = 0;
+	}
+	i = samples.begin ();
+	end = samples.end ();
+	while (i != end) {
+		bucket = 0;
+		limit = 250;
+		while ((bucket < (Profiler::HistogramBucketCount - 1)) && (*i >= limit)) {
+			++bucket;
+			limit *= 2;
+		}
+		++(buckets[bucket]);
+		++i;
+	}
+
+	maxcount = 0;
+	for (bucket = 0; bucket < Profiler::HistogramBucketCount; ++bucket) {
+		if (buckets[bucket] > maxcount) {
+			maxcount = buckets[bucket];
+		}
+	}
+	for (bucket = 0; bucket < Profiler::HistogramBucketCount; ++bucket) {
+		level = 0;
+		if ((maxcount > 0) && (buckets[bucket] > 0)) {
+			level = 1 + ((buckets[bucket] * 6) / maxcount);
+		}
+		s.append (1, BucketChars[level]);
+	}
+	return (s);
+}
+
+const char *Profiler::getSectionName (int section) {
+	switch (section) {
+		case Profiler::PollEventsSection: {
+			return ("pollEvents");
+		}
+		case Profiler::RenderTasksSection: {
+			return ("renderTasks");
+		}
+		case Profiler::DrawSection: {
+			return ("draw");
+		}
+		case Profiler::UpdateSection: {
+			return ("update");
+		}
+		case Profiler::UiStackUpdateSection: {
+			return ("uiStackUpdate");
+		}
+		case Profiler::SyncRecordStoreSection: {
+			return ("syncRecordStore");
+		}
+		case Profiler::ResourceCompactSection: {
+			return ("resourceCompact");
+		}
+	}
+	return ("");
+}
+
+const char *Profiler::getCounterName (int counter) {
+	switch (counter) {
+		case Profiler::RenderCallCounter: {
+			return ("renderCalls");
+		}
+		case Profiler::TextureUploadCounter: {
+			return ("textureUploads");
+		}
+		case Profiler::WidgetDrawCounter: {
+			return ("widgetDraws");
+		}
+		case Profiler::WidgetUpdateCounter: {
+			return ("widgetUpdates");
+		}
+	}
+	return ("");
+}
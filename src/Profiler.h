@@ -0,0 +1,136 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+// Object that collects per-frame timing samples and event counts for application profiling
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <vector>
+#include "SDL2/SDL.h"
+#include "StdString.h"
+
+class Profiler {
+public:
+	Profiler ();
+	~Profiler ();
+
+	static Profiler *instance;
+
+	static const int SampleCount;
+	static const int HistogramBucketCount;
+
+	// Timed section types
+	enum {
+		PollEventsSection = 0,
+		RenderTasksSection = 1,
+		DrawSection = 2,
+		UpdateSection = 3,
+		UiStackUpdateSection = 4,
+		SyncRecordStoreSection = 5,
+		ResourceCompactSection = 6,
+		SectionCount = 7
+	};
+
+	// Counter types
+	enum {
+		RenderCallCounter = 0,
+		TextureUploadCounter = 1,
+		WidgetDrawCounter = 2,
+		WidgetUpdateCounter = 3,
+		CounterCount = 4
+	};
+
+	struct Stats {
+		int sampleCount;
+		int64_t p50;
+		int64_t p90;
+		int64_t p99;
+		int64_t max;
+		Stats ():
+			sampleCount (0),
+			p50 (0),
+			p90 (0),
+			p99 (0),
+			max (0) { }
+	};
+
+	// Read-only data members
+	bool isEnabled;
+
+	// Set the profiler's enable state. If disabled, the profiler discards all samples and ignores section and counter events.
+	void setEnabled (bool enable);
+
+	// Return a performance counter value marking the start of a timed section, or zero if the profiler is disabled
+	Uint64 beginSection ();
+
+	// Record the time elapsed since startTime, as returned by a previous call to beginSection, as a sample for the specified section
+	void endSection (int section, Uint64 startTime);
+
+	// Add the specified amount to a counter's value for the current frame
+	void addCount (int counter, int amount = 1);
+
+	// Record a counter's accumulated value as a frame sample and reset the value to zero
+	void endCounterFrame (int counter);
+
+	// Fill in destStats with percentile values computed from samples for the specified section, in microseconds
+	void getSectionStats (int section, Profiler::Stats *destStats);
+
+	// Fill in destStats with percentile values computed from frame samples for the specified counter
+	void getCounterStats (int counter, Profiler::Stats *destStats);
+
+	// Return a string containing one character for each histogram bucket of the specified section's samples, with buckets covering doubling time spans from 250 microseconds
+	StdString getSectionHistogram (int section);
+
+	// Return the display name of the specified section or counter
+	static const char *getSectionName (int section);
+	static const char *getCounterName (int counter);
+
+private:
+	struct SampleRing {
+		std::vector<int64_t> samples;
+		int nextIndex;
+		SampleRing ():
+			nextIndex (0) { }
+	};
+
+	// Add a sample to the provided ring, replacing its oldest sample if the ring is full. This method must only be invoked while holding a lock on sampleMutex.
+	void addSample (Profiler::SampleRing *ring, int64_t value);
+
+	// Fill in destStats with percentile values from the provided ring
+	void getStats (Profiler::SampleRing *ring, Profiler::Stats *destStats);
+
+	SDL_mutex *sampleMutex;
+	Profiler::SampleRing sectionSamples[Profiler::SectionCount];
+	Profiler::SampleRing counterSamples[Profiler::CounterCount];
+	SDL_atomic_t counterValues[Profiler::CounterCount];
+	Uint64 performanceFrequency;
+};
+
+#endif
@@ -55,6 +55,8 @@ ProgressBar::ProgressBar (float barWidth, float barHeight)
 {
 	width = barWidth;
 	height = barHeight;
+	bgColor.setAnimationOwner (this);
+	fillColor.setAnimationOwner (this);
 	bgColor.assign (UiConfiguration::instance->lightPrimaryColor);
 	fillColor.animate (UiConfiguration::instance->darkPrimaryColor, UiConfiguration::instance->mediumSecondaryColor, UiConfiguration::instance->longColorAnimateDuration, UiConfiguration::instance->longColorAnimateDuration * 2);
 }
@@ -111,6 +113,7 @@ void ProgressBar::setIndeterminate (bool indeterminate) {
 
 void ProgressBar::doUpdate (int msElapsed) {
 	if (isIndeterminate) {
+		addDrawDamage ();
 		switch (fillStage) {
 			case 0: {
 				fillStart = 0.0f;
@@ -172,8 +175,6 @@ void ProgressBar::doUpdate (int msElapsed) {
 			}
 		}
 	}
-
-	fillColor.update (msElapsed);
 }
 
 void ProgressBar::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
@@ -181,6 +182,7 @@ void ProgressBar::doDraw (SDL_Texture *targetTexture, float originX, float origi
 	SDL_Rect rect;
 	float x1, x2, w;
 
+	App::instance->flushDrawBatch ();
 	render = App::instance->render;
 	rect.x = (int) (originX + position.x);
 	rect.y = (int) (originY + position.y);
@@ -29,11 +29,19 @@
 */
 #include "Config.h"
 #include <stdlib.h>
+#include <stdio.h>
 #include <map>
+#include <vector>
+#include <deque>
+#include <algorithm>
 #include "SDL2/SDL.h"
+#include "zlib.h"
 #include "App.h"
 #include "Log.h"
+#include "OsUtil.h"
 #include "StdString.h"
+#include "Buffer.h"
+#include "TaskGroup.h"
 #include "StringList.h"
 #include "Json.h"
 #include "SystemInterface.h"
@@ -42,143 +50,1194 @@
 
 RecordStore *RecordStore::instance = NULL;
 
+const int RecordStore::MaxChangeLogSize = 8192;
+const int RecordStore::MaxPendingWrites = 256;
+const int RecordStore::DefaultRecordBudget = 16384;
+const int RecordStore::DefaultSnapshotWritePeriod = 60000;
+const uint32_t RecordStore::SnapshotFileMagic = 0x4D525301;
+const uint32_t RecordStore::MaxSnapshotPayloadLength = 256 * 1024 * 1024;
+const uint32_t RecordStore::MaxSnapshotCompressionRatio = 1032;
+
 RecordStore::RecordStore ()
-: mutex (NULL)
+: currentSnapshot (NULL)
+, snapshotMutex (NULL)
+, pendingMutex (NULL)
+, readContextId (0)
+, recordBudget (RecordStore::DefaultRecordBudget)
+, snapshotWritePeriod (0)
+, lastSnapshotWriteTime (0)
+, lastSnapshotWriteVersion (-1)
+, isSnapshotWriteActive (false)
+, snapshotFileMutex (NULL)
+, snapshotFileWriteMutex (NULL)
+, version (0)
+, changeLogBaseVersion (0)
 {
-	mutex = SDL_CreateMutex ();
+	snapshotMutex = SDL_CreateMutex ();
+	pendingMutex = SDL_CreateMutex ();
+	snapshotFileMutex = SDL_CreateMutex ();
+	snapshotFileWriteMutex = SDL_CreateMutex ();
+	readContextId = SDL_TLSCreate ();
+	currentSnapshot = new RecordStore::Snapshot ();
+	currentSnapshot->refcount = 1;
+
+	mediaItemParamNames.push_back (StdString ("id"));
+	mediaItemParamNames.push_back (StdString ("name"));
+	mediaItemParamNames.push_back (StdString ("sortKey"));
+	mediaItemParamNames.push_back (StdString ("mtime"));
+	mediaItemParamNames.push_back (StdString ("size"));
+	mediaItemParamNames.push_back (StdString ("bitrate"));
+	mediaItemParamNames.push_back (StdString ("duration"));
+	mediaItemParamNames.push_back (StdString ("frameRate"));
+	mediaItemParamNames.push_back (StdString ("width"));
+	mediaItemParamNames.push_back (StdString ("height"));
+	mediaItemParamNames.push_back (StdString ("isCreateStreamAvailable"));
+
+	streamItemParamNames.push_back (StdString ("id"));
+	streamItemParamNames.push_back (StdString ("sourceId"));
+	streamItemParamNames.push_back (StdString ("name"));
+	streamItemParamNames.push_back (StdString ("size"));
+	streamItemParamNames.push_back (StdString ("bitrate"));
+	streamItemParamNames.push_back (StdString ("duration"));
+	streamItemParamNames.push_back (StdString ("frameRate"));
+	streamItemParamNames.push_back (StdString ("width"));
+	streamItemParamNames.push_back (StdString ("height"));
+	streamItemParamNames.push_back (StdString ("profile"));
+	streamItemParamNames.push_back (StdString ("segmentCount"));
 }
 
 RecordStore::~RecordStore () {
-	clear ();
-	if (mutex) {
-		SDL_DestroyMutex (mutex);
-		mutex = NULL;
+	std::list<RecordStore::PendingWrite>::iterator i, end;
+
+	i = pendingWrites.begin ();
+	end = pendingWrites.end ();
+	while (i != end) {
+		if (i->record) {
+			delete (i->record);
+			i->record = NULL;
+		}
+		++i;
+	}
+	pendingWrites.clear ();
+	if (currentSnapshot) {
+		releaseSnapshot (currentSnapshot);
+		currentSnapshot = NULL;
+	}
+	if (pendingMutex) {
+		SDL_DestroyMutex (pendingMutex);
+		pendingMutex = NULL;
+	}
+	if (snapshotMutex) {
+		SDL_DestroyMutex (snapshotMutex);
+		snapshotMutex = NULL;
+	}
+	if (snapshotFileMutex) {
+		SDL_DestroyMutex (snapshotFileMutex);
+		snapshotFileMutex = NULL;
+	}
+	if (snapshotFileWriteMutex) {
+		SDL_DestroyMutex (snapshotFileWriteMutex);
+		snapshotFileWriteMutex = NULL;
 	}
 }
 
-void RecordStore::clear () {
-	std::map<StdString, Json *>::iterator i, end;
+void RecordStore::freeReadContext (void *contextPtr) {
+	delete ((RecordStore::ReadContext *) contextPtr);
+}
 
-	lock ();
-	i = recordMap.begin ();
-	end = recordMap.end ();
-	while (i != end) {
-		if (i->second) {
-			delete (i->second);
+RecordStore::ReadContext *RecordStore::getReadContext () {
+	RecordStore::ReadContext *ctx;
+
+	ctx = (RecordStore::ReadContext *) SDL_TLSGet (readContextId);
+	if (! ctx) {
+		ctx = new RecordStore::ReadContext ();
+		SDL_TLSSet (readContextId, ctx, RecordStore::freeReadContext);
+	}
+	return (ctx);
+}
+
+RecordStore::Snapshot *RecordStore::getReadSnapshot () {
+	RecordStore::ReadContext *ctx;
+
+	ctx = (RecordStore::ReadContext *) SDL_TLSGet (readContextId);
+	if (ctx && ctx->snapshot) {
+		return (ctx->snapshot);
+	}
+	return (currentSnapshot);
+}
+
+void RecordStore::lock (bool shouldPublishAll) {
+	RecordStore::ReadContext *ctx;
+
+	ctx = getReadContext ();
+	if (ctx->lockDepth <= 0) {
+		SDL_LockMutex (snapshotMutex);
+		// Copying a snapshot held by other readers is needed only to show the caller its own writes; writes from other threads are left to batch
+		publish (shouldPublishAll || ctx->hasQueuedWrites);
+		ctx->hasQueuedWrites = false;
+		ctx->snapshot = currentSnapshot;
+		++(ctx->snapshot->refcount);
+		SDL_UnlockMutex (snapshotMutex);
+		ctx->lockDepth = 0;
+	}
+	++(ctx->lockDepth);
+}
+
+void RecordStore::unlock () {
+	RecordStore::ReadContext *ctx;
+
+	ctx = (RecordStore::ReadContext *) SDL_TLSGet (readContextId);
+	if ((! ctx) || (ctx->lockDepth <= 0)) {
+		return;
+	}
+	--(ctx->lockDepth);
+	if (ctx->lockDepth > 0) {
+		return;
+	}
+	SDL_LockMutex (snapshotMutex);
+	releaseSnapshot (ctx->snapshot);
+	ctx->snapshot = NULL;
+
+	// Writes queued while this reader held the snapshot can now be applied in place if no other readers remain
+	publish (false);
+	SDL_UnlockMutex (snapshotMutex);
+}
+
+void RecordStore::queueWrite (const RecordStore::PendingWrite &write) {
+	getReadContext ()->hasQueuedWrites = true;
+	SDL_LockMutex (pendingMutex);
+	pendingWrites.push_back (write);
+	SDL_UnlockMutex (pendingMutex);
+
+	// If another thread holds snapshotMutex, it publishes or leaves the write for the next lock or unlock
+	if (SDL_TryLockMutex (snapshotMutex) == 0) {
+		publish (false);
+		SDL_UnlockMutex (snapshotMutex);
+	}
+}
+
+void RecordStore::publish (bool shouldForce) {
+	std::list<RecordStore::PendingWrite> writes;
+	std::list<RecordStore::PendingWrite>::iterator i, end;
+	std::map<StdString, RecordStore::Record *>::iterator j, jend;
+	RecordStore::Snapshot *snapshot;
+
+	SDL_LockMutex (pendingMutex);
+	if (pendingWrites.empty ()) {
+		SDL_UnlockMutex (pendingMutex);
+		return;
+	}
+	if ((! shouldForce) && (currentSnapshot->refcount > 1) && ((int) pendingWrites.size () < RecordStore::MaxPendingWrites)) {
+		SDL_UnlockMutex (pendingMutex);
+		return;
+	}
+	writes.swap (pendingWrites);
+	SDL_UnlockMutex (pendingMutex);
+
+	// Readers holding the current snapshot keep it unchanged, so apply writes to a copy that shares its Record objects
+	if (currentSnapshot->refcount > 1) {
+		snapshot = new RecordStore::Snapshot ();
+		snapshot->recordMap = currentSnapshot->recordMap;
+		snapshot->commandIdIndex = currentSnapshot->commandIdIndex;
+		snapshot->agentStatusSourceIndex = currentSnapshot->agentStatusSourceIndex;
+		snapshot->agentStatusFieldIndex = currentSnapshot->agentStatusFieldIndex;
+		snapshot->streamSourceIndex = currentSnapshot->streamSourceIndex;
+		snapshot->sourceStreamMediaCount = currentSnapshot->sourceStreamMediaCount;
+		snapshot->version = currentSnapshot->version;
+		snapshot->refcount = 1;
+		j = snapshot->recordMap.begin ();
+		jend = snapshot->recordMap.end ();
+		while (j != jend) {
+			++(j->second->refcount);
+			++j;
 		}
+		releaseSnapshot (currentSnapshot);
+		currentSnapshot = snapshot;
+	}
+
+	i = writes.begin ();
+	end = writes.end ();
+	while (i != end) {
+		applyWrite (currentSnapshot, &(*i));
 		++i;
 	}
-	recordMap.clear ();
-	unlock ();
+	if ((recordBudget > 0) && ((int) evictionPositions.size () > recordBudget)) {
+		evictRecords ();
+	}
+	currentSnapshot->version = version;
 }
 
-void RecordStore::addRecord (Json *record, const StdString &recordId) {
-	std::map<StdString, Json *>::iterator pos;
+void RecordStore::setRecordBudget (int maxRecordCount) {
+	SDL_LockMutex (snapshotMutex);
+	recordBudget = maxRecordCount;
+	SDL_UnlockMutex (snapshotMutex);
+}
+
+void RecordStore::pinRecord (const StdString &recordId) {
+	SDL_LockMutex (snapshotMutex);
+	++(pinMap[recordId]);
+	SDL_UnlockMutex (snapshotMutex);
+}
+
+void RecordStore::unpinRecord (const StdString &recordId) {
+	std::map<StdString, int>::iterator pos;
+
+	SDL_LockMutex (snapshotMutex);
+	pos = pinMap.find (recordId);
+	if (pos != pinMap.end ()) {
+		--(pos->second);
+		if (pos->second <= 0) {
+			pinMap.erase (pos);
+			if (evictionPositions.count (recordId) > 0) {
+				touchEvictionEntry (recordId);
+			}
+		}
+	}
+	SDL_UnlockMutex (snapshotMutex);
+}
+
+void RecordStore::touchEvictionEntry (const StdString &recordId) {
+	std::map<StdString, std::list<StdString>::iterator>::iterator pos;
+
+	pos = evictionPositions.find (recordId);
+	if (pos != evictionPositions.end ()) {
+		evictionList.splice (evictionList.end (), evictionList, pos->second);
+		return;
+	}
+	evictionList.push_back (recordId);
+	evictionPositions.insert (std::pair<StdString, std::list<StdString>::iterator> (recordId, --(evictionList.end ())));
+}
+
+void RecordStore::removeEvictionEntry (const StdString &recordId) {
+	std::map<StdString, std::list<StdString>::iterator>::iterator pos;
+
+	pos = evictionPositions.find (recordId);
+	if (pos == evictionPositions.end ()) {
+		return;
+	}
+	evictionList.erase (pos->second);
+	evictionPositions.erase (pos);
+}
+
+void RecordStore::evictRecords () {
+	std::list<StdString>::iterator i, end;
 	StdString id;
-	Json *item;
+	int count;
 
-	if (! record) {
+	count = 0;
+	i = evictionList.begin ();
+	end = evictionList.end ();
+	while ((i != end) && ((int) evictionPositions.size () > recordBudget)) {
+		id.assign (*i);
+		++i;
+		if (pinMap.count (id) > 0) {
+			continue;
+		}
+		// eraseRecord also removes the record's eviction entry, which i no longer references
+		if (eraseRecord (currentSnapshot, id, RecordStore::RecordEvicted)) {
+			++count;
+		}
+		else {
+			removeEvictionEntry (id);
+		}
+	}
+	if (count > 0) {
+		Log::debug ("Evicted records from store; count=%i recordBudget=%i", count, recordBudget);
+	}
+}
+
+void RecordStore::applyWrite (RecordStore::Snapshot *snapshot, RecordStore::PendingWrite *write) {
+	std::map<StdString, RecordStore::Record *>::iterator pos, end;
+	std::map<int, RecordStore::RecordMap>::iterator ci;
+	RecordStore::RecordMap::iterator i, iend;
+	std::vector<StdString> ids;
+	std::vector<StdString>::iterator j, jend;
+	RecordStore::Record *record;
+
+	switch (write->writeType) {
+		case RecordStore::AddWrite:
+		case RecordStore::AddIfAbsentWrite: {
+			if (! write->record) {
+				break;
+			}
+			if ((write->writeType == RecordStore::AddIfAbsentWrite) && (snapshot->recordMap.count (write->recordId) > 0)) {
+				// A record already received from an agent is newer than one restored from the snapshot file
+				delete (write->record);
+				write->record = NULL;
+				break;
+			}
+			record = createRecord (write->record);
+			record->refcount = 1;
+			write->record = NULL;
+
+			pos = snapshot->recordMap.find (write->recordId);
+			if (pos != snapshot->recordMap.end ()) {
+				RecordStore::removeIndexEntries (snapshot, write->recordId, pos->second);
+				releaseRecord (pos->second);
+				pos->second = record;
+				logChange (write->recordId, SystemInterface::instance->getCommandId (record->json), RecordStore::RecordUpdated);
+			}
+			else {
+				snapshot->recordMap.insert (std::pair<StdString, RecordStore::Record *> (write->recordId, record));
+				logChange (write->recordId, SystemInterface::instance->getCommandId (record->json), RecordStore::RecordAdded);
+			}
+			RecordStore::addIndexEntries (snapshot, write->recordId, record);
+			if (record->mediaItem) {
+				touchEvictionEntry (write->recordId);
+			}
+			else {
+				removeEvictionEntry (write->recordId);
+			}
+			break;
+		}
+		case RecordStore::RemoveWrite: {
+			eraseRecord (snapshot, write->recordId);
+			break;
+		}
+		case RecordStore::RemoveCommandWrite: {
+			ci = snapshot->commandIdIndex.find (write->commandId);
+			if (ci == snapshot->commandIdIndex.end ()) {
+				break;
+			}
+			ids.reserve (ci->second.size ());
+			i = ci->second.begin ();
+			iend = ci->second.end ();
+			while (i != iend) {
+				ids.push_back (i->first);
+				++i;
+			}
+			j = ids.begin ();
+			jend = ids.end ();
+			while (j != jend) {
+				eraseRecord (snapshot, *j);
+				++j;
+			}
+			break;
+		}
+		case RecordStore::ClearWrite: {
+			pos = snapshot->recordMap.begin ();
+			end = snapshot->recordMap.end ();
+			while (pos != end) {
+				releaseRecord (pos->second);
+				++pos;
+			}
+			snapshot->recordMap.clear ();
+			snapshot->commandIdIndex.clear ();
+			snapshot->agentStatusSourceIndex.clear ();
+			snapshot->agentStatusFieldIndex.clear ();
+			snapshot->streamSourceIndex.clear ();
+			snapshot->sourceStreamMediaCount = 0;
+
+			evictionList.clear ();
+			evictionPositions.clear ();
+
+			// Discard the change log, causing every later getChanges call to receive a full sync
+			changeLog.clear ();
+			++version;
+			changeLogBaseVersion = version;
+			break;
+		}
+	}
+}
+
+bool RecordStore::eraseRecord (RecordStore::Snapshot *snapshot, const StdString &recordId, int changeType) {
+	std::map<StdString, RecordStore::Record *>::iterator pos;
+
+	pos = snapshot->recordMap.find (recordId);
+	if (pos == snapshot->recordMap.end ()) {
+		return (false);
+	}
+	RecordStore::removeIndexEntries (snapshot, recordId, pos->second);
+	if (pos->second->mediaItem) {
+		removeEvictionEntry (recordId);
+	}
+	logChange (recordId, SystemInterface::instance->getCommandId (pos->second->json), changeType);
+	releaseRecord (pos->second);
+	snapshot->recordMap.erase (pos);
+	return (true);
+}
+
+RecordStore::Record *RecordStore::createRecord (Json *record) {
+	RecordStore::Record *item;
+	RecordStore::MediaItem *mediaitem;
+	RecordStore::StreamItem *streamitem;
+	Json params;
+
+	item = new RecordStore::Record ();
+	item->json = record;
+	switch (SystemInterface::instance->getCommandId (record)) {
+		case SystemInterface::CommandId_MediaItem: {
+			record->getObject ("params", &params);
+			mediaitem = new RecordStore::MediaItem ();
+			mediaitem->id = params.getString ("id", "");
+			mediaitem->agentId = stringPool.intern (SystemInterface::instance->getCommandAgentId (record));
+			mediaitem->name = params.getString ("name", "");
+			mediaitem->sortKey = params.getString ("sortKey", "");
+			mediaitem->mtime = params.getNumber ("mtime", (int64_t) 0);
+			mediaitem->size = params.getNumber ("size", (int64_t) 0);
+			mediaitem->bitrate = params.getNumber ("bitrate", (int64_t) 0);
+			mediaitem->duration = params.getNumber ("duration", (double) 0.0f);
+			mediaitem->frameRate = params.getNumber ("frameRate", (double) 0.0f);
+			mediaitem->width = params.getNumber ("width", (int) 0);
+			mediaitem->height = params.getNumber ("height", (int) 0);
+			mediaitem->isCreateStreamAvailable = params.getBoolean ("isCreateStreamAvailable", true);
+			item->mediaItem = mediaitem;
+			item->json = RecordStore::copyRecordParams (record, mediaItemParamNames);
+			delete (record);
+			break;
+		}
+		case SystemInterface::CommandId_StreamItem: {
+			record->getObject ("params", &params);
+			streamitem = new RecordStore::StreamItem ();
+			streamitem->id = params.getString ("id", "");
+			streamitem->agentId = stringPool.intern (SystemInterface::instance->getCommandAgentId (record));
+			streamitem->sourceId = params.getString ("sourceId", "");
+			streamitem->name = params.getString ("name", "");
+			streamitem->size = params.getNumber ("size", (int64_t) 0);
+			streamitem->bitrate = params.getNumber ("bitrate", (int64_t) 0);
+			streamitem->duration = params.getNumber ("duration", (double) 0.0f);
+			streamitem->frameRate = params.getNumber ("frameRate", (double) 0.0f);
+			streamitem->width = params.getNumber ("width", (int) 0);
+			streamitem->height = params.getNumber ("height", (int) 0);
+			streamitem->profile = params.getNumber ("profile", (int) -1);
+			streamitem->segmentCount = params.getNumber ("segmentCount", (int) 0);
+			item->streamItem = streamitem;
+			item->json = RecordStore::copyRecordParams (record, streamItemParamNames);
+			delete (record);
+			break;
+		}
+	}
+	return (item);
+}
+
+Json *RecordStore::copyRecordParams (Json *record, const StringList &omitParamNames) {
+	Json *result, params;
+	StringList omitkeys;
+
+	omitkeys.push_back (StdString ("params"));
+	result = record->copy (omitkeys);
+	if (record->getObject ("params", &params)) {
+		result->set ("params", params.copy (omitParamNames));
+	}
+	return (result);
+}
+
+void RecordStore::getRecordJson (RecordStore::Record *record, Json *destJson) {
+	Json *params, storedparams;
+	StringList omitkeys;
+
+	if ((! record->mediaItem) && (! record->streamItem)) {
+		destJson->copyValue (record->json);
 		return;
 	}
-	if (! recordId.empty ()) {
-		id.assign (recordId);
+
+	omitkeys.push_back (StdString ("params"));
+	destJson->assign (record->json->copy (omitkeys));
+	record->json->getObject ("params", &storedparams);
+	params = new Json ();
+	params->copyValue (&storedparams);
+	if (record->mediaItem) {
+		params->set ("id", record->mediaItem->id);
+		params->set ("name", record->mediaItem->name);
+		params->set ("sortKey", record->mediaItem->sortKey);
+		params->set ("mtime", record->mediaItem->mtime);
+		params->set ("size", record->mediaItem->size);
+		params->set ("bitrate", record->mediaItem->bitrate);
+		params->set ("duration", record->mediaItem->duration);
+		params->set ("frameRate", record->mediaItem->frameRate);
+		params->set ("width", record->mediaItem->width);
+		params->set ("height", record->mediaItem->height);
+		params->set ("isCreateStreamAvailable", record->mediaItem->isCreateStreamAvailable);
+	}
+	if (record->streamItem) {
+		params->set ("id", record->streamItem->id);
+		params->set ("sourceId", record->streamItem->sourceId);
+		params->set ("name", record->streamItem->name);
+		params->set ("size", record->streamItem->size);
+		params->set ("bitrate", record->streamItem->bitrate);
+		params->set ("duration", record->streamItem->duration);
+		params->set ("frameRate", record->streamItem->frameRate);
+		params->set ("width", record->streamItem->width);
+		params->set ("height", record->streamItem->height);
+		params->set ("profile", record->streamItem->profile);
+		params->set ("segmentCount", record->streamItem->segmentCount);
+	}
+	destJson->set ("params", params);
+}
+
+void RecordStore::releaseRecord (RecordStore::Record *record) {
+	--(record->refcount);
+	if (record->refcount > 0) {
+		return;
+	}
+	if (record->mediaItem) {
+		stringPool.release (record->mediaItem->agentId);
+		delete (record->mediaItem);
+		record->mediaItem = NULL;
+	}
+	if (record->streamItem) {
+		stringPool.release (record->streamItem->agentId);
+		delete (record->streamItem);
+		record->streamItem = NULL;
+	}
+	if (record->json) {
+		delete (record->json);
+		record->json = NULL;
+	}
+	delete (record);
+}
+
+void RecordStore::releaseSnapshot (RecordStore::Snapshot *snapshot) {
+	std::map<StdString, RecordStore::Record *>::iterator i, end;
+
+	--(snapshot->refcount);
+	if (snapshot->refcount > 0) {
+		return;
+	}
+	i = snapshot->recordMap.begin ();
+	end = snapshot->recordMap.end ();
+	while (i != end) {
+		releaseRecord (i->second);
+		++i;
+	}
+	delete (snapshot);
+}
+
+void RecordStore::clear () {
+	RecordStore::PendingWrite write;
+
+	write.writeType = RecordStore::ClearWrite;
+	queueWrite (write);
+}
+
+void RecordStore::setSnapshotFile (const StdString &path, int writePeriod) {
+	SDL_LockMutex (snapshotFileMutex);
+	snapshotFilePath.assign (path);
+	snapshotWritePeriod = writePeriod;
+	lastSnapshotWriteTime = OsUtil::getTime ();
+	SDL_UnlockMutex (snapshotFileMutex);
+}
+
+void RecordStore::appendUint32 (Buffer *buffer, uint32_t value) {
+	uint8_t data[4];
+
+	data[0] = (uint8_t) ((value >> 24) & 0xFF);
+	data[1] = (uint8_t) ((value >> 16) & 0xFF);
+	data[2] = (uint8_t) ((value >> 8) & 0xFF);
+	data[3] = (uint8_t) (value & 0xFF);
+	buffer->add (data, 4);
+}
+
+uint32_t RecordStore::readUint32 (const uint8_t *data) {
+	uint32_t value;
+
+	value = data[0];
+	value <<= 8;
+	value |= data[1];
+	value <<= 8;
+	value |= data[2];
+	value <<= 8;
+	value |= data[3];
+	return (value);
+}
+
+OsUtil::Result RecordStore::readSnapshotFile () {
+	std::list<RecordStore::PendingWrite> writes;
+	std::list<RecordStore::PendingWrite>::iterator i, end;
+	RecordStore::PendingWrite write;
+	StdString path;
+	Buffer *buffer;
+	Json parsejson, *record;
+	uint8_t *data;
+	uLongf datalength;
+	uint32_t count, payloadlength, storedlength, idlength, textlength, pos, n;
+	OsUtil::Result result;
+
+	SDL_LockMutex (snapshotFileMutex);
+	path.assign (snapshotFilePath);
+	SDL_UnlockMutex (snapshotFileMutex);
+	if (path.empty ()) {
+		return (OsUtil::Success);
+	}
+
+	buffer = OsUtil::readFile (path);
+	if (! buffer) {
+		return (OsUtil::FileOpenFailedError);
+	}
+
+	// A snapshot file holds a 16-byte header (magic, record count, payload length, compressed payload length) followed by the zlib-compressed payload
+	result = OsUtil::Success;
+	data = NULL;
+	count = 0;
+	payloadlength = 0;
+	storedlength = 0;
+	if ((buffer->length < 16) || (RecordStore::readUint32 (buffer->data) != RecordStore::SnapshotFileMagic)) {
+		result = OsUtil::MalformedDataError;
 	}
 	else {
-		id = SystemInterface::instance->getCommandRecordId (record);
-		if (id.empty ()) {
-			return;
+		count = RecordStore::readUint32 (buffer->data + 4);
+		payloadlength = RecordStore::readUint32 (buffer->data + 8);
+		storedlength = RecordStore::readUint32 (buffer->data + 12);
+		if (storedlength != (uint32_t) (buffer->length - 16)) {
+			result = OsUtil::MalformedDataError;
+		}
+		else if ((payloadlength > RecordStore::MaxSnapshotPayloadLength) || (((uint64_t) payloadlength) > (((uint64_t) storedlength) * RecordStore::MaxSnapshotCompressionRatio))) {
+			result = OsUtil::MalformedDataError;
+		}
+	}
+	if (result == OsUtil::Success) {
+		data = (uint8_t *) malloc (payloadlength + 1);
+		if (! data) {
+			result = OsUtil::OutOfMemoryError;
 		}
 	}
+	if (result == OsUtil::Success) {
+		datalength = (uLongf) payloadlength;
+		if ((uncompress ((Bytef *) data, &datalength, (const Bytef *) (buffer->data + 16), (uLong) storedlength) != Z_OK) || (datalength != (uLongf) payloadlength)) {
+			result = OsUtil::MalformedDataError;
+		}
+	}
+	delete (buffer);
 
-	item = new Json ();
-	item->copyValue (record);
-	lock ();
-	pos = recordMap.find (id);
-	if (pos != recordMap.end ()) {
-		if (pos->second) {
-			delete (pos->second);
+	// The payload holds a length-prefixed record ID and length-prefixed record JSON text for each record
+	pos = 0;
+	for (n = 0; (result == OsUtil::Success) && (n < count); ++n) {
+		if ((payloadlength - pos) < 4) {
+			result = OsUtil::MalformedDataError;
+			break;
+		}
+		idlength = RecordStore::readUint32 (data + pos);
+		pos += 4;
+		if ((payloadlength - pos) < idlength) {
+			result = OsUtil::MalformedDataError;
+			break;
+		}
+		write.recordId.assign ((char *) (data + pos), idlength);
+		pos += idlength;
+		if ((payloadlength - pos) < 4) {
+			result = OsUtil::MalformedDataError;
+			break;
+		}
+		textlength = RecordStore::readUint32 (data + pos);
+		pos += 4;
+		if ((payloadlength - pos) < textlength) {
+			result = OsUtil::MalformedDataError;
+			break;
+		}
+		if (! parsejson.parse ((char *) (data + pos), (int) textlength)) {
+			result = OsUtil::JsonParseFailedError;
+			break;
+		}
+		pos += textlength;
+
+		// Parsed values are held in the parser's arena, so store a builder copy as addRecord does. The copy is sized to the record and can carry a key index.
+		record = new Json ();
+		record->copyValue (&parsejson);
+
+		write.writeType = RecordStore::AddIfAbsentWrite;
+		write.record = record;
+		writes.push_back (write);
+	}
+	if (data) {
+		free (data);
+	}
+
+	if (result != OsUtil::Success) {
+		i = writes.begin ();
+		end = writes.end ();
+		while (i != end) {
+			delete (i->record);
+			++i;
 		}
-		pos->second = item;
+		return (result);
+	}
+	if (writes.empty ()) {
+		return (OsUtil::Success);
+	}
+
+	// Queue all restored records at once so that they are applied by a single publish
+	SDL_LockMutex (pendingMutex);
+	pendingWrites.splice (pendingWrites.end (), writes);
+	SDL_UnlockMutex (pendingMutex);
+	if (SDL_TryLockMutex (snapshotMutex) == 0) {
+		publish (false);
+		SDL_UnlockMutex (snapshotMutex);
+	}
+	Log::debug ("Read record snapshot file; path=\"%s\" count=%i", path.c_str (), (int) count);
+	return (OsUtil::Success);
+}
+
+void RecordStore::updateSnapshotFile () {
+	int64_t now, storeversion;
+	bool shouldwrite;
+
+	now = OsUtil::getTime ();
+	SDL_LockMutex (snapshotFileMutex);
+	shouldwrite = (! snapshotFilePath.empty ()) && (snapshotWritePeriod > 0) && (! isSnapshotWriteActive) && ((now - lastSnapshotWriteTime) >= snapshotWritePeriod);
+	SDL_UnlockMutex (snapshotFileMutex);
+	if (! shouldwrite) {
+		return;
+	}
+
+	SDL_LockMutex (snapshotMutex);
+	storeversion = version;
+	SDL_UnlockMutex (snapshotMutex);
+
+	SDL_LockMutex (snapshotFileMutex);
+	lastSnapshotWriteTime = now;
+	if (isSnapshotWriteActive || (storeversion == lastSnapshotWriteVersion)) {
+		shouldwrite = false;
 	}
 	else {
-		recordMap.insert (std::pair<StdString, Json *> (id, item));
+		isSnapshotWriteActive = true;
+	}
+	SDL_UnlockMutex (snapshotFileMutex);
+	if (! shouldwrite) {
+		return;
+	}
+
+	if (! TaskGroup::instance->run (TaskGroup::RunContext (RecordStore::writeSnapshotFileTask, this))) {
+		SDL_LockMutex (snapshotFileMutex);
+		isSnapshotWriteActive = false;
+		SDL_UnlockMutex (snapshotFileMutex);
 	}
-	unlock ();
 }
 
-void RecordStore::removeRecord (const StdString &recordId) {
-	std::map<StdString, Json *>::iterator pos;
+void RecordStore::writeSnapshotFileTask (void *storePtr) {
+	RecordStore *store;
+	int result;
+
+	store = (RecordStore *) storePtr;
+	result = store->writeSnapshotFile ();
+	if (result != OsUtil::Success) {
+		Log::debug ("Failed to write record snapshot file; err=%i", result);
+	}
+	SDL_LockMutex (store->snapshotFileMutex);
+	store->isSnapshotWriteActive = false;
+	SDL_UnlockMutex (store->snapshotFileMutex);
+}
+
+OsUtil::Result RecordStore::writeSnapshotFile () {
+	std::map<StdString, RecordStore::Record *>::iterator i, end;
+	RecordStore::Snapshot *snapshot;
+	Buffer payload, header;
+	StdString path, temppath, text;
+	Json item;
+	uint8_t *data;
+	uLongf datalength;
+	uint32_t count;
+	int64_t snapshotversion;
+	OsUtil::Result result;
+	int commandid;
+	FILE *fp;
+
+	SDL_LockMutex (snapshotFileMutex);
+	path.assign (snapshotFilePath);
+	SDL_UnlockMutex (snapshotFileMutex);
+	if (path.empty ()) {
+		return (OsUtil::Success);
+	}
 
+	SDL_LockMutex (snapshotFileWriteMutex);
+	count = 0;
 	lock ();
-	pos = recordMap.find (recordId);
-	if (pos != recordMap.end ()) {
-		if (pos->second) {
-			delete (pos->second);
+	snapshot = getReadSnapshot ();
+	snapshotversion = snapshot->version;
+	i = snapshot->recordMap.begin ();
+	end = snapshot->recordMap.end ();
+	while (i != end) {
+		commandid = SystemInterface::instance->getCommandId (i->second->json);
+		if ((commandid == SystemInterface::CommandId_AgentStatus) || (commandid == SystemInterface::CommandId_MediaItem) || (commandid == SystemInterface::CommandId_StreamItem)) {
+			// Typed fields are held apart from the shared record's Json object, which Json::toString would also modify while measuring it, so serialize a reconstructed private copy
+			RecordStore::getRecordJson (i->second, &item);
+			text = item.toString ();
+			RecordStore::appendUint32 (&payload, (uint32_t) i->first.length ());
+			payload.add ((uint8_t *) i->first.c_str (), (int) i->first.length ());
+			RecordStore::appendUint32 (&payload, (uint32_t) text.length ());
+			payload.add ((uint8_t *) text.c_str (), (int) text.length ());
+			++count;
 		}
-		recordMap.erase (pos);
+		++i;
 	}
 	unlock ();
+
+	datalength = compressBound ((uLong) payload.length);
+	data = (uint8_t *) malloc (datalength);
+	if (! data) {
+		SDL_UnlockMutex (snapshotFileWriteMutex);
+		return (OsUtil::OutOfMemoryError);
+	}
+	if (compress2 ((Bytef *) data, &datalength, (const Bytef *) payload.data, (uLong) payload.length, Z_DEFAULT_COMPRESSION) != Z_OK) {
+		free (data);
+		SDL_UnlockMutex (snapshotFileWriteMutex);
+		return (OsUtil::InternalApplicationFailureError);
+	}
+	RecordStore::appendUint32 (&header, RecordStore::SnapshotFileMagic);
+	RecordStore::appendUint32 (&header, count);
+	RecordStore::appendUint32 (&header, (uint32_t) payload.length);
+	RecordStore::appendUint32 (&header, (uint32_t) datalength);
+
+	// Write to a temporary file and rename it into place, so that an interrupted write can't leave a truncated snapshot file at path
+	result = OsUtil::Success;
+	temppath.sprintf ("%s.tmp", path.c_str ());
+	fp = fopen (temppath.c_str (), "wb");
+	if (! fp) {
+		result = OsUtil::FileOpenFailedError;
+	}
+	else {
+		if ((fwrite (header.data, (size_t) header.length, 1, fp) < 1) || (fwrite (data, (size_t) datalength, 1, fp) < 1)) {
+			result = OsUtil::FileOperationFailedError;
+		}
+		if (fclose (fp) != 0) {
+			result = OsUtil::FileOperationFailedError;
+		}
+	}
+	free (data);
+	if (result == OsUtil::Success) {
+#if PLATFORM_WINDOWS
+		// rename fails on Windows if the target file exists
+		remove (path.c_str ());
+#endif
+		if (rename (temppath.c_str (), path.c_str ()) != 0) {
+			result = OsUtil::FileOperationFailedError;
+		}
+	}
+	if (result != OsUtil::Success) {
+		remove (temppath.c_str ());
+	}
+
+	if (result == OsUtil::Success) {
+		SDL_LockMutex (snapshotFileMutex);
+		lastSnapshotWriteVersion = snapshotversion;
+		SDL_UnlockMutex (snapshotFileMutex);
+	}
+	SDL_UnlockMutex (snapshotFileWriteMutex);
+	return (result);
 }
 
-void RecordStore::removeRecords (int commandId) {
-	StringList idlist;
-	std::map<StdString, Json *>::iterator i, iend, pos;
-	StringList::iterator j, jend;
+int64_t RecordStore::getVersion () {
+	return (getReadSnapshot ()->version);
+}
 
-	lock ();
-	i = recordMap.begin ();
-	iend = recordMap.end ();
-	while (i != iend) {
-		if (SystemInterface::instance->getCommandId (i->second) == commandId) {
-			idlist.push_back (i->first);
+void RecordStore::logChange (const StdString &recordId, int commandId, int changeType) {
+	RecordStore::Change change;
+
+	++version;
+	change.recordId.assign (recordId);
+	change.commandId = commandId;
+	change.changeType = changeType;
+	change.version = version;
+	changeLog.push_back (change);
+	while ((int) changeLog.size () > RecordStore::MaxChangeLogSize) {
+		changeLogBaseVersion = changeLog.front ().version;
+		changeLog.pop_front ();
+	}
+}
+
+bool RecordStore::compareChangeVersions (const RecordStore::Change &a, const RecordStore::Change &b) {
+	return (a.version < b.version);
+}
+
+void RecordStore::getChanges (int64_t sinceVersion, RecordStore::ChangeSet *destChangeSet) {
+	std::deque<RecordStore::Change>::iterator i, end;
+	std::map<StdString, int> indexmap;
+	std::map<StdString, int>::iterator pos;
+	RecordStore::Snapshot *snapshot;
+	RecordStore::Change key;
+	RecordStore::Change *item;
+	std::vector<RecordStore::Change>::iterator j, jend;
+	const RecordStore::StreamItem *streamitem;
+
+	snapshot = getReadSnapshot ();
+	destChangeSet->changes.clear ();
+	destChangeSet->recordIds.clear ();
+	destChangeSet->version = snapshot->version;
+
+	// The change log may hold changes published after the caller's snapshot, which are left for a later sync
+	SDL_LockMutex (snapshotMutex);
+	if (sinceVersion < changeLogBaseVersion) {
+		destChangeSet->isFullSync = true;
+		SDL_UnlockMutex (snapshotMutex);
+		return;
+	}
+	destChangeSet->isFullSync = false;
+
+	key.version = sinceVersion;
+	i = std::upper_bound (changeLog.begin (), changeLog.end (), key, RecordStore::compareChangeVersions);
+	end = changeLog.end ();
+	while ((i != end) && (i->version <= snapshot->version)) {
+		pos = indexmap.find (i->recordId);
+		if (pos == indexmap.end ()) {
+			indexmap.insert (std::pair<StdString, int> (i->recordId, (int) destChangeSet->changes.size ()));
+			destChangeSet->changes.push_back (*i);
+		}
+		else {
+			item = &(destChangeSet->changes.at (pos->second));
+			// A record added and then updated within the change set remains an addition to the receiver
+			if ((item->changeType == RecordStore::RecordAdded) && (i->changeType == RecordStore::RecordUpdated)) {
+				item->version = i->version;
+			}
+			else {
+				item->changeType = i->changeType;
+				item->commandId = i->commandId;
+				item->version = i->version;
+			}
 		}
 		++i;
 	}
+	SDL_UnlockMutex (snapshotMutex);
 
-	j = idlist.begin ();
-	jend = idlist.end ();
+	j = destChangeSet->changes.begin ();
+	jend = destChangeSet->changes.end ();
 	while (j != jend) {
-		pos = recordMap.find (*j);
-		if (pos != recordMap.end ()) {
-			if (pos->second) {
-				delete (pos->second);
+		destChangeSet->recordIds.insert (j->recordId);
+		if (j->commandId == SystemInterface::CommandId_StreamItem) {
+			streamitem = findStreamItem (j->recordId);
+			if (streamitem && (! streamitem->sourceId.empty ())) {
+				destChangeSet->recordIds.insert (streamitem->sourceId);
 			}
-			recordMap.erase (pos);
 		}
 		++j;
 	}
-	unlock ();
 }
 
-void RecordStore::lock () {
-	SDL_LockMutex (mutex);
+void RecordStore::getAgentStatusFieldNames (Json *record, std::vector<StdString> *destList) {
+	std::vector<StdString> keys;
+	std::vector<StdString>::iterator i, end;
+	Json params;
+
+	destList->clear ();
+	if (! record->getObject ("params", &params)) {
+		return;
+	}
+	params.getKeys (&keys);
+	i = keys.begin ();
+	end = keys.end ();
+	while (i != end) {
+		if (params.getObject (*i, NULL)) {
+			destList->push_back (*i);
+		}
+		++i;
+	}
 }
 
-void RecordStore::unlock () {
-	SDL_UnlockMutex (mutex);
+void RecordStore::addIndexEntries (RecordStore::Snapshot *snapshot, const StdString &recordId, RecordStore::Record *record) {
+	std::vector<StdString> fields;
+	std::vector<StdString>::iterator i, end;
+	RecordStore::RecordMap *sources;
+	int commandid;
+
+	commandid = SystemInterface::instance->getCommandId (record->json);
+	snapshot->commandIdIndex[commandid][recordId] = record->json;
+	if (commandid == SystemInterface::CommandId_StreamItem) {
+		sources = &(snapshot->streamSourceIndex[record->streamItem->sourceId]);
+		if (sources->empty () && RecordStore::isMediaItemIndexed (snapshot, record->streamItem->sourceId)) {
+			++(snapshot->sourceStreamMediaCount);
+		}
+		(*sources)[recordId] = record->json;
+		return;
+	}
+	if (commandid == SystemInterface::CommandId_MediaItem) {
+		if (snapshot->streamSourceIndex.count (recordId) > 0) {
+			++(snapshot->sourceStreamMediaCount);
+		}
+		return;
+	}
+	if (commandid != SystemInterface::CommandId_AgentStatus) {
+		return;
+	}
+
+	snapshot->agentStatusSourceIndex[SystemInterface::instance->getCommandAgentId (record->json)][recordId] = record->json;
+	RecordStore::getAgentStatusFieldNames (record->json, &fields);
+	i = fields.begin ();
+	end = fields.end ();
+	while (i != end) {
+		snapshot->agentStatusFieldIndex[*i][recordId] = record->json;
+		++i;
+	}
+}
+
+void RecordStore::removeIndexEntries (RecordStore::Snapshot *snapshot, const StdString &recordId, RecordStore::Record *record) {
+	std::map<int, RecordStore::RecordMap>::iterator ci;
+	std::map<StdString, RecordStore::RecordMap>::iterator si;
+	std::vector<StdString> fields;
+	std::vector<StdString>::iterator i, end;
+	int commandid;
+
+	commandid = SystemInterface::instance->getCommandId (record->json);
+	ci = snapshot->commandIdIndex.find (commandid);
+	if (ci != snapshot->commandIdIndex.end ()) {
+		ci->second.erase (recordId);
+		if (ci->second.empty ()) {
+			snapshot->commandIdIndex.erase (ci);
+		}
+	}
+	if (commandid == SystemInterface::CommandId_StreamItem) {
+		si = snapshot->streamSourceIndex.find (record->streamItem->sourceId);
+		if (si != snapshot->streamSourceIndex.end ()) {
+			si->second.erase (recordId);
+			if (si->second.empty ()) {
+				snapshot->streamSourceIndex.erase (si);
+				if (RecordStore::isMediaItemIndexed (snapshot, record->streamItem->sourceId)) {
+					--(snapshot->sourceStreamMediaCount);
+				}
+			}
+		}
+		return;
+	}
+	if (commandid == SystemInterface::CommandId_MediaItem) {
+		if (snapshot->streamSourceIndex.count (recordId) > 0) {
+			--(snapshot->sourceStreamMediaCount);
+		}
+		return;
+	}
+	if (commandid != SystemInterface::CommandId_AgentStatus) {
+		return;
+	}
+
+	si = snapshot->agentStatusSourceIndex.find (SystemInterface::instance->getCommandAgentId (record->json));
+	if (si != snapshot->agentStatusSourceIndex.end ()) {
+		si->second.erase (recordId);
+		if (si->second.empty ()) {
+			snapshot->agentStatusSourceIndex.erase (si);
+		}
+	}
+	RecordStore::getAgentStatusFieldNames (record->json, &fields);
+	i = fields.begin ();
+	end = fields.end ();
+	while (i != end) {
+		si = snapshot->agentStatusFieldIndex.find (*i);
+		if (si != snapshot->agentStatusFieldIndex.end ()) {
+			si->second.erase (recordId);
+			if (si->second.empty ()) {
+				snapshot->agentStatusFieldIndex.erase (si);
+			}
+		}
+		++i;
+	}
+}
+
+bool RecordStore::isMediaItemIndexed (RecordStore::Snapshot *snapshot, const StdString &mediaId) {
+	std::map<int, RecordStore::RecordMap>::iterator pos;
+
+	pos = snapshot->commandIdIndex.find (SystemInterface::CommandId_MediaItem);
+	if (pos == snapshot->commandIdIndex.end ()) {
+		return (false);
+	}
+	return (pos->second.count (mediaId) > 0);
+}
+
+void RecordStore::addRecord (Json *record, const StdString &recordId) {
+	RecordStore::PendingWrite write;
+
+	if (! record) {
+		return;
+	}
+	if (! recordId.empty ()) {
+		write.recordId.assign (recordId);
+	}
+	else {
+		write.recordId = SystemInterface::instance->getCommandRecordId (record);
+		if (write.recordId.empty ()) {
+			return;
+		}
+	}
+
+	write.writeType = RecordStore::AddWrite;
+	write.record = new Json ();
+	write.record->copyValue (record);
+	queueWrite (write);
+}
+
+void RecordStore::removeRecord (const StdString &recordId) {
+	RecordStore::PendingWrite write;
+
+	write.writeType = RecordStore::RemoveWrite;
+	write.recordId.assign (recordId);
+	queueWrite (write);
+}
+
+void RecordStore::removeRecords (int commandId) {
+	RecordStore::PendingWrite write;
+
+	write.writeType = RecordStore::RemoveCommandWrite;
+	write.commandId = commandId;
+	queueWrite (write);
 }
 
 Json *RecordStore::findRecord (const StdString &recordId, int recordType) {
-	std::map<StdString, Json *>::iterator pos;
-	
-	pos = recordMap.find (recordId);
-	if (pos == recordMap.end ()) {
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->recordMap.find (recordId);
+	if (pos == snapshot->recordMap.end ()) {
+		return (NULL);
+	}
+	if (SystemInterface::instance->getCommandId (pos->second->json) != recordType) {
+		return (NULL);
+	}
+	return (pos->second->json);
+}
+
+Json *RecordStore::findAgentStatusRecord (const StdString &agentId) {
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::RecordMap>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->agentStatusSourceIndex.find (agentId);
+	if ((pos == snapshot->agentStatusSourceIndex.end ()) || pos->second.empty ()) {
+		return (NULL);
+	}
+	return (pos->second.begin ()->second);
+}
+
+const RecordStore::MediaItem *RecordStore::findMediaItem (const StdString &mediaId) {
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->recordMap.find (mediaId);
+	if (pos == snapshot->recordMap.end ()) {
 		return (NULL);
 	}
-	if (SystemInterface::instance->getCommandId (pos->second) != recordType) {
+	return (pos->second->mediaItem);
+}
+
+const RecordStore::StreamItem *RecordStore::findStreamItem (const StdString &streamId) {
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->recordMap.find (streamId);
+	if (pos == snapshot->recordMap.end ()) {
 		return (NULL);
 	}
-	return (pos->second);
+	return (pos->second->streamItem);
+}
+
+const RecordStore::StreamItem *RecordStore::findSourceStreamItem (const StdString &mediaId) {
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::RecordMap>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->streamSourceIndex.find (mediaId);
+	if ((pos == snapshot->streamSourceIndex.end ()) || pos->second.empty ()) {
+		return (NULL);
+	}
+	return (findStreamItem (pos->second.begin ()->first));
 }
 
 Json *RecordStore::findRecord (RecordStore::FindMatchFunction matchFn, void *matchData) {
-	std::map<StdString, Json *>::iterator i, end;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator i, end;
 
-	i = recordMap.begin ();
-	end = recordMap.end ();
+	snapshot = getReadSnapshot ();
+	i = snapshot->recordMap.begin ();
+	end = snapshot->recordMap.end ();
 	while (i != end) {
-		if (matchFn (matchData, i->second)) {
-			return (i->second);
+		if (matchFn (matchData, i->second->json)) {
+			return (i->second->json);
 		}
 		++i;
 	}
@@ -186,54 +1245,63 @@ Json *RecordStore::findRecord (RecordStore::FindMatchFunction matchFn, void *mat
 }
 
 void RecordStore::findRecords (RecordStore::FindMatchFunction matchFn, void *matchData, std::list<Json *> *destList, bool shouldClear) {
-	std::map<StdString, Json *>::iterator i, end;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator i, end;
 
 	if (shouldClear) {
 		destList->clear ();
 	}
-	i = recordMap.begin ();
-	end = recordMap.end ();
+	snapshot = getReadSnapshot ();
+	i = snapshot->recordMap.begin ();
+	end = snapshot->recordMap.end ();
 	while (i != end) {
-		if (matchFn (matchData, i->second)) {
-			destList->push_back (i->second);
+		if (matchFn (matchData, i->second->json)) {
+			destList->push_back (i->second->json);
 		}
 		++i;
 	}
 }
 
 void RecordStore::processRecords (RecordStore::FindMatchFunction matchFn, void *matchData, RecordStore::ProcessAgentRecordFunction processFn, void *processFnData) {
-	std::map<StdString, Json *>::iterator i, end;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::Record *>::iterator i, end;
 
-	i = recordMap.begin ();
-	end = recordMap.end ();
+	// Process functions may modify the store, so hold a snapshot that their writes leave unchanged
+	lock ();
+	snapshot = getReadSnapshot ();
+	i = snapshot->recordMap.begin ();
+	end = snapshot->recordMap.end ();
 	while (i != end) {
-		if (matchFn (matchData, i->second)) {
-			processFn (processFnData, i->second, i->first);
+		if (matchFn (matchData, i->second->json)) {
+			processFn (processFnData, i->second->json, i->first);
 		}
 		++i;
 	}
+	unlock ();
 }
 
 void RecordStore::processAgentRecords (const char *agentStatusFieldName, RecordStore::ProcessAgentRecordFunction processFn, void *processFnData) {
-	std::list<Json *> records;
-	std::list<Json *>::iterator i, end;
-	StdString fieldname, agentid;
-	Json *record;
-
-	fieldname.assign (agentStatusFieldName);
-	findRecords (RecordStore::matchAgentStatusObjectExists, &fieldname, &records, true);
-	i = records.begin ();
-	end = records.end ();
-	while (i != end) {
-		record = *i;
-		++i;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::RecordMap>::iterator pos;
+	RecordStore::RecordMap::iterator i, end;
+	StdString agentid;
 
-		agentid = SystemInterface::instance->getCommandStringParam (record, "id", "");
-		if (agentid.empty ()) {
-			continue;
+	// Process functions may modify the store, so hold a snapshot that their writes leave unchanged
+	lock ();
+	snapshot = getReadSnapshot ();
+	pos = snapshot->agentStatusFieldIndex.find (StdString (agentStatusFieldName));
+	if (pos != snapshot->agentStatusFieldIndex.end ()) {
+		i = pos->second.begin ();
+		end = pos->second.end ();
+		while (i != end) {
+			agentid = SystemInterface::instance->getCommandStringParam (i->second, "id", "");
+			if (! agentid.empty ()) {
+				processFn (processFnData, i->second, agentid);
+			}
+			++i;
 		}
-		processFn (processFnData, record, agentid);
 	}
+	unlock ();
 }
 
 void RecordStore::processAgentRecords (const StdString &agentStatusFieldName, RecordStore::ProcessAgentRecordFunction processFn, void *processFnData) {
@@ -241,27 +1309,26 @@ void RecordStore::processAgentRecords (const StdString &agentStatusFieldName, Re
 }
 
 void RecordStore::processCommandRecords (int commandId, RecordStore::ProcessRecordFunction processFn, void *processFnData) {
-	std::list<Json *> records;
-	std::list<Json *>::iterator i, end;
-	StdString fieldname, recordid;
-	Json *record;
-
-	findRecords (RecordStore::matchCommandId, &commandId, &records, true);
-	i = records.begin ();
-	end = records.end ();
-	while (i != end) {
-		record = *i;
-		++i;
+	RecordStore::Snapshot *snapshot;
+	std::map<int, RecordStore::RecordMap>::iterator pos;
+	RecordStore::RecordMap::iterator i, end;
 
-		recordid = SystemInterface::instance->getCommandRecordId (record);
-		if (recordid.empty ()) {
-			recordid = SystemInterface::instance->getCommandStringParam (record, "id", "");
-		}
-		if (recordid.empty ()) {
-			continue;
+	// Process functions may modify the store, so hold a snapshot that their writes leave unchanged
+	lock ();
+	snapshot = getReadSnapshot ();
+	pos = snapshot->commandIdIndex.find (commandId);
+	if (pos != snapshot->commandIdIndex.end ()) {
+		i = pos->second.begin ();
+		end = pos->second.end ();
+		while (i != end) {
+			// Index keys are record IDs, which typed records no longer hold in their stored Json objects
+			if (! i->first.empty ()) {
+				processFn (processFnData, i->second, i->first);
+			}
+			++i;
 		}
-		processFn (processFnData, record, recordid);
 	}
+	unlock ();
 }
 
 void RecordStore::populateAgentMap (HashMap *destMap, const StdString &statusFieldName) {
@@ -269,18 +1336,22 @@ void RecordStore::populateAgentMap (HashMap *destMap, const StdString &statusFie
 }
 
 void RecordStore::populateAgentMap (HashMap *destMap, const char *statusFieldName) {
-	std::list<Json *> records;
-	std::list<Json *>::iterator i, end;
-	StdString fieldname, agentid, agentname;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::RecordMap>::iterator pos;
+	RecordStore::RecordMap::iterator i, end;
+	StdString agentid, agentname;
 
-	fieldname.assign (statusFieldName);
-	findRecords (RecordStore::matchAgentStatusObjectExists, &fieldname, &records, true);
 	destMap->clear ();
-	i = records.begin ();
-	end = records.end ();
+	snapshot = getReadSnapshot ();
+	pos = snapshot->agentStatusFieldIndex.find (StdString (statusFieldName));
+	if (pos == snapshot->agentStatusFieldIndex.end ()) {
+		return;
+	}
+	i = pos->second.begin ();
+	end = pos->second.end ();
 	while (i != end) {
-		agentid = SystemInterface::instance->getCommandAgentId (*i);
-		agentname = Agent::getCommandAgentName (*i);
+		agentid = SystemInterface::instance->getCommandAgentId (i->second);
+		agentname = Agent::getCommandAgentName (i->second);
 		if ((! agentid.empty () && (! agentname.empty ()))) {
 			destMap->insert (agentname, agentid);
 		}
@@ -289,12 +1360,15 @@ void RecordStore::populateAgentMap (HashMap *destMap, const char *statusFieldNam
 }
 
 int RecordStore::countAgentRecords (const char *agentStatusFieldName) {
-	StdString fieldname;
-	std::list<Json *> records;
+	RecordStore::Snapshot *snapshot;
+	std::map<StdString, RecordStore::RecordMap>::iterator pos;
 
-	fieldname.assign (agentStatusFieldName);
-	findRecords (RecordStore::matchAgentStatusObjectExists, &fieldname, &records);
-	return ((int) records.size ());
+	snapshot = getReadSnapshot ();
+	pos = snapshot->agentStatusFieldIndex.find (StdString (agentStatusFieldName));
+	if (pos == snapshot->agentStatusFieldIndex.end ()) {
+		return (0);
+	}
+	return ((int) pos->second.size ());
 }
 
 int RecordStore::countAgentRecords (const StdString &agentStatusFieldName) {
@@ -302,12 +1376,22 @@ int RecordStore::countAgentRecords (const StdString &agentStatusFieldName) {
 }
 
 int RecordStore::countCommandRecords (int commandId) {
-	std::list<Json *> records;
-	int id;
+	RecordStore::Snapshot *snapshot;
+	std::map<int, RecordStore::RecordMap>::iterator pos;
+
+	snapshot = getReadSnapshot ();
+	pos = snapshot->commandIdIndex.find (commandId);
+	if (pos == snapshot->commandIdIndex.end ()) {
+		return (0);
+	}
+	return ((int) pos->second.size ());
+}
+
+int RecordStore::countSourceStreamMediaItems () {
+	RecordStore::Snapshot *snapshot;
 
-	id = commandId;
-	findRecords (RecordStore::matchCommandId, &id, &records);
-	return ((int) records.size ());
+	snapshot = getReadSnapshot ();
+	return (snapshot->sourceStreamMediaCount);
 }
 
 bool RecordStore::matchCommandId (void *intPtr, Json *record) {
@@ -33,10 +33,17 @@
 #define RECORD_STORE_H
 
 #include <map>
+#include <set>
 #include <list>
+#include <vector>
+#include <deque>
 #include "SDL2/SDL.h"
+#include "OsUtil.h"
 #include "StdString.h"
+#include "StringList.h"
+#include "Buffer.h"
 #include "HashMap.h"
+#include "StringPool.h"
 #include "Json.h"
 
 class RecordStore {
@@ -48,21 +55,152 @@ public:
 	~RecordStore ();
 	static RecordStore *instance;
 
+	// The maximum number of entries held in the change log. A sync that falls further behind than this receives a full sync change set.
+	static const int MaxChangeLogSize;
+
+	// The number of queued writes that causes a writer to publish a new snapshot even if readers hold the current one
+	static const int MaxPendingWrites;
+
+	// The default maximum number of MediaItem records held by the store before eviction begins
+	static const int DefaultRecordBudget;
+
+	static const int DefaultSnapshotWritePeriod; // milliseconds
+
+	// Change types for use in Change structs
+	enum {
+		RecordAdded = 0,
+		RecordUpdated = 1,
+		RecordRemoved = 2,
+		RecordEvicted = 3 // The record was removed to hold the store within its record budget, and remains available from its source
+	};
+
+	struct Change {
+		StdString recordId;
+		int commandId;
+		int changeType;
+		int64_t version;
+		Change ():
+			commandId (-1),
+			changeType (RecordStore::RecordAdded),
+			version (0) { }
+	};
+
+	struct ChangeSet {
+		int64_t version; // The store version at the time the change set was created, for use as the sinceVersion value in a later call to getChanges
+		bool isFullSync; // If true, changes is empty and the receiver must examine all records in the store
+		std::vector<RecordStore::Change> changes; // Changes in order of occurrence, holding one item for each changed record ID
+		std::set<StdString> recordIds; // IDs of changed records, along with the source media IDs of changed StreamItem records that remain in the store
+		ChangeSet ():
+			version (0),
+			isFullSync (true) { }
+	};
+
+	// Typed fields of a MediaItem record, mirroring the hot fields of SystemInterface::getParams_MediaItem. The agentId pointer refers to a value held in the store's string pool and is never NULL.
+	struct MediaItem {
+		StdString id;
+		const StdString *agentId;
+		StdString name;
+		StdString sortKey;
+		int64_t mtime;
+		int64_t size;
+		int64_t bitrate;
+		double duration;
+		double frameRate;
+		int width;
+		int height;
+		bool isCreateStreamAvailable;
+		MediaItem ():
+			agentId (NULL),
+			mtime (0),
+			size (0),
+			bitrate (0),
+			duration (0.0f),
+			frameRate (0.0f),
+			width (0),
+			height (0),
+			isCreateStreamAvailable (true) { }
+	};
+
+	// Typed fields of a StreamItem record, mirroring the hot fields of SystemInterface::getParams_StreamItem. The agentId pointer refers to a value held in the store's string pool and is never NULL.
+	struct StreamItem {
+		StdString id;
+		const StdString *agentId;
+		StdString sourceId;
+		StdString name;
+		int64_t size;
+		int64_t bitrate;
+		double duration;
+		double frameRate;
+		int width;
+		int height;
+		int profile;
+		int segmentCount;
+		StreamItem ():
+			agentId (NULL),
+			size (0),
+			bitrate (0),
+			duration (0.0f),
+			frameRate (0.0f),
+			width (0),
+			height (0),
+			profile (-1),
+			segmentCount (0) { }
+	};
+
 	// Copy the provided Json object and add the copy to the record store. If recordId is not provided, the command must include a params.id field for use as a record ID.
 	void addRecord (Json *record, const StdString &recordId = StdString (""));
 
 	// Remove all records from the store
 	void clear ();
 
-	// Lock the record store. This lock should be obtained before executing certain other methods, as specified in their descriptions.
-	void lock ();
+	// Set the maximum number of MediaItem records to hold. When the store holds more than this number, it evicts the least recently used records that are not pinned, and the owning Ui is expected to fetch them again if they are needed. A budget of zero or less disables eviction.
+	void setRecordBudget (int maxRecordCount);
+
+	// Mark the record with the specified ID as referenced by a live widget, preventing its eviction. Each pinRecord call must be balanced by a later unpinRecord call. A record may be pinned before it is present in the store.
+	void pinRecord (const StdString &recordId);
+
+	// Release a pin previously placed by pinRecord, marking the record as most recently used
+	void unpinRecord (const StdString &recordId);
+
+	// Set the path of the file used to persist AgentStatus, MediaItem, and StreamItem records across application runs, and the minimum interval in milliseconds between periodic writes of that file. An empty path disables snapshot file operations.
+	void setSnapshotFile (const StdString &path, int writePeriod);
+
+	// Read records from the snapshot file and add each one to the store unless a record with the same ID is already present, and return a Result value. Records received later from agents replace restored records with the same ID.
+	OsUtil::Result readSnapshotFile ();
+
+	// Start a background write of the snapshot file if records have changed since the last write and the write period has elapsed
+	void updateSnapshotFile ();
+
+	// Write the snapshot file on the calling thread, waiting for any background write to complete first, and return a Result value
+	OsUtil::Result writeSnapshotFile ();
+
+	// Return the store's current version number, which increases with each record change. This method should be invoked only while the store is locked.
+	int64_t getVersion ();
+
+	// Clear the provided ChangeSet and fill it with changes that occurred after sinceVersion, collapsing multiple changes to a record into a single item with the record's latest change type. If the change log no longer holds all changes after sinceVersion, the change set is marked as a full sync. This method should be invoked only while the store is locked.
+	void getChanges (int64_t sinceVersion, RecordStore::ChangeSet *destChangeSet);
+
+	// Lock the record store, acquiring a snapshot of its records for use by the calling thread. This lock should be obtained before executing certain other methods, as specified in their descriptions. Writes made by other threads while the lock is held do not change the snapshot. The snapshot acquired by an outermost lock includes all writes previously made by the calling thread, while writes from other threads may remain queued until no reader holds the current snapshot or MaxPendingWrites is reached. If shouldPublishAll is true, all queued writes are published before the snapshot is acquired. Calls to lock may be nested within a single thread.
+	void lock (bool shouldPublishAll = false);
 
 	// Release a previously acquired lock
 	void unlock ();
 
-	// Find a record matching the specified ID and type and return the associated Json object, or NULL if no such record was found. This method should be invoked only while the store is locked; if a Json object is returned by this method, it remains valid only as long as the store lock is held.
+	// Find a record matching the specified ID and type and return the associated Json object, or NULL if no such record was found. For MediaItem and StreamItem records, the returned object omits params fields held by the typed structs returned from findMediaItem and findStreamItem. This method should be invoked only while the store is locked; if a Json object is returned by this method, it remains valid only as long as the store lock is held.
 	Json *findRecord (const StdString &recordId, int recordType);
 
+	// Find the AgentStatus record whose command prefix holds the specified agent ID and return the associated Json object, or NULL if no such record was found. This method should be invoked only while the store is locked; if a Json object is returned by this method, it remains valid only as long as the store lock is held.
+	Json *findAgentStatusRecord (const StdString &agentId);
+
+	// Find the MediaItem record with the specified ID and return its typed fields, or NULL if no such record was found. This method should be invoked only while the store is locked; if an object is returned by this method, it remains valid only as long as the store lock is held.
+	const RecordStore::MediaItem *findMediaItem (const StdString &mediaId);
+
+	// Find the StreamItem record with the specified ID and return its typed fields, or NULL if no such record was found. This method should be invoked only while the store is locked; if an object is returned by this method, it remains valid only as long as the store lock is held.
+	const RecordStore::StreamItem *findStreamItem (const StdString &streamId);
+
+	// Find the first StreamItem record whose sourceId field holds the specified media ID and return its typed fields, or NULL if no such record was found. This method should be invoked only while the store is locked; if an object is returned by this method, it remains valid only as long as the store lock is held.
+	const RecordStore::StreamItem *findSourceStreamItem (const StdString &mediaId);
+
 	// Find the first available record that passes a match predicate function and return the resulting Json object, or NULL if no such record was found. This method should be invoked only while the store is locked; if Json objects are returned by this method, they remain valid only as long as the store lock is held.
 	Json *findRecord (RecordStore::FindMatchFunction matchFn, void *matchData);
 
@@ -96,14 +234,200 @@ public:
 	// Return the number of records matching the specified command ID. This method should be invoked only while the store is locked.
 	int countCommandRecords (int commandId);
 
+	// Return the number of MediaItem records that are the source of at least one StreamItem record. This method should be invoked only while the store is locked.
+	int countSourceStreamMediaItems ();
+
 	// Match functions for use with find methods
 	static bool matchCommandId (void *intPtr, Json *record);
 	static bool matchAgentStatusSource (void *agentIdStringPtr, Json *record);
 	static bool matchAgentStatusObjectExists (void *objectFieldNameStringPtr, Json *record);
 
 private:
-	std::map<StdString, Json *> recordMap;
-	SDL_mutex *mutex;
+	typedef std::map<StdString, Json *> RecordMap;
+
+	// The value stored in the first four bytes of a snapshot file
+	static const uint32_t SnapshotFileMagic;
+
+	// The largest uncompressed payload length accepted from a snapshot file
+	static const uint32_t MaxSnapshotPayloadLength;
+
+	// The largest ratio of uncompressed to compressed length that zlib can produce, used to reject snapshot headers with an inconsistent payload length
+	static const uint32_t MaxSnapshotCompressionRatio;
+
+	// Write types for use in PendingWrite structs
+	enum {
+		AddWrite = 0,
+		RemoveWrite = 1,
+		RemoveCommandWrite = 2,
+		ClearWrite = 3,
+		AddIfAbsentWrite = 4
+	};
+
+	// A record Json object and its typed fields, shared by all snapshots that contain it. mediaItem and streamItem are set only for records of the matching command type.
+	struct Record {
+		Json *json;
+		RecordStore::MediaItem *mediaItem;
+		RecordStore::StreamItem *streamItem;
+		int refcount;
+		Record ():
+			json (NULL),
+			mediaItem (NULL),
+			streamItem (NULL),
+			refcount (0) { }
+	};
+
+	// An immutable view of the store, valid while its refcount is held
+	struct Snapshot {
+		std::map<StdString, RecordStore::Record *> recordMap;
+
+		// Secondary indexes over recordMap, each holding record ID / Json pairs so that matching records are visited in the same order as in recordMap
+		std::map<int, RecordStore::RecordMap> commandIdIndex;
+		std::map<StdString, RecordStore::RecordMap> agentStatusSourceIndex;
+		std::map<StdString, RecordStore::RecordMap> agentStatusFieldIndex;
+		std::map<StdString, RecordStore::RecordMap> streamSourceIndex;
+
+		// The number of MediaItem records with at least one entry in streamSourceIndex, maintained by addIndexEntries and removeIndexEntries
+		int sourceStreamMediaCount;
+
+		int64_t version;
+		int refcount;
+		Snapshot ():
+			sourceStreamMediaCount (0),
+			version (0),
+			refcount (0) { }
+	};
+
+	// A write operation waiting to be applied to the current snapshot
+	struct PendingWrite {
+		int writeType;
+		StdString recordId;
+		Json *record; // Owned by the PendingWrite until applied
+		int commandId;
+		PendingWrite ():
+			writeType (RecordStore::AddWrite),
+			record (NULL),
+			commandId (-1) { }
+	};
+
+	// Per-thread lock state, stored in thread-local storage
+	struct ReadContext {
+		RecordStore::Snapshot *snapshot;
+		int lockDepth;
+		bool hasQueuedWrites; // True if the thread has queued writes since its last outermost lock
+		ReadContext ():
+			snapshot (NULL),
+			lockDepth (0),
+			hasQueuedWrites (false) { }
+	};
+
+	// Add a write to the pending queue and publish it if the snapshot mutex is immediately available
+	void queueWrite (const RecordStore::PendingWrite &write);
+
+	// Apply all pending writes to the current snapshot, copying the snapshot first if readers hold it. If shouldForce is false and readers hold the current snapshot, leave the writes queued unless their number has reached MaxPendingWrites. This method must be invoked only while snapshotMutex is held.
+	void publish (bool shouldForce);
+
+	// Apply a write to the provided snapshot, which must not be held by any reader. This method must be invoked only while snapshotMutex is held.
+	void applyWrite (RecordStore::Snapshot *snapshot, RecordStore::PendingWrite *write);
+
+	// Remove a record from the provided snapshot and log the change with the specified type, returning true if the record was found. This method must be invoked only while snapshotMutex is held.
+	bool eraseRecord (RecordStore::Snapshot *snapshot, const StdString &recordId, int changeType = RecordStore::RecordRemoved);
+
+	// Return a newly created Record holding the provided Json object and typed fields parsed from it, interning agent IDs in stringPool. For MediaItem and StreamItem records, the Record holds a copy of the Json object without its typed params fields, and the provided object is deleted. This method must be invoked only while snapshotMutex is held.
+	RecordStore::Record *createRecord (Json *record);
+
+	// Return a newly created copy of the provided record, omitting any params fields whose names appear in omitParamNames
+	static Json *copyRecordParams (Json *record, const StringList &omitParamNames);
+
+	// Replace the content of destJson with the complete Json object for the provided record, restoring params fields held in its typed fields
+	static void getRecordJson (RecordStore::Record *record, Json *destJson);
+
+	// Release a Record reference, deleting the record if no references remain. This method must be invoked only while snapshotMutex is held.
+	void releaseRecord (RecordStore::Record *record);
+
+	// Move the specified MediaItem record to the most recently used end of the eviction list, adding it if needed. This method must be invoked only while snapshotMutex is held.
+	void touchEvictionEntry (const StdString &recordId);
+
+	// Remove the specified record from the eviction list, if present. This method must be invoked only while snapshotMutex is held.
+	void removeEvictionEntry (const StdString &recordId);
+
+	// Remove least recently used, unpinned MediaItem records from the current snapshot until the store is within its record budget. This method must be invoked only while snapshotMutex is held and no reader holds the current snapshot.
+	void evictRecords ();
+
+	// Release a Snapshot reference, deleting the snapshot if no references remain. This method must be invoked only while snapshotMutex is held.
+	void releaseSnapshot (RecordStore::Snapshot *snapshot);
+
+	// Return the snapshot held by the calling thread, or the current snapshot if the thread holds no lock
+	RecordStore::Snapshot *getReadSnapshot ();
+
+	// Return the calling thread's ReadContext, creating it if needed
+	RecordStore::ReadContext *getReadContext ();
+
+	// Free a ReadContext object on thread exit
+	static void freeReadContext (void *contextPtr);
+
+	// Add entries for the provided record to the secondary indexes of a snapshot
+	static void addIndexEntries (RecordStore::Snapshot *snapshot, const StdString &recordId, RecordStore::Record *record);
+
+	// Remove entries for the provided record from the secondary indexes of a snapshot
+	static void removeIndexEntries (RecordStore::Snapshot *snapshot, const StdString &recordId, RecordStore::Record *record);
+
+	// Return true if the commandIdIndex of a snapshot holds a MediaItem record with the specified ID
+	static bool isMediaItemIndexed (RecordStore::Snapshot *snapshot, const StdString &mediaId);
+
+	// Append an item to the change log and advance the store version. This method must be invoked only while snapshotMutex is held.
+	void logChange (const StdString &recordId, int commandId, int changeType);
+
+	// Execute a background snapshot file write
+	static void writeSnapshotFileTask (void *storePtr);
+
+	// Append a uint32 value to a buffer in big-endian byte order
+	static void appendUint32 (Buffer *buffer, uint32_t value);
+
+	// Return a uint32 value read in big-endian byte order from the provided data, which must hold at least four bytes
+	static uint32_t readUint32 (const uint8_t *data);
+
+	// Return true if change a has a lower version than change b
+	static bool compareChangeVersions (const RecordStore::Change &a, const RecordStore::Change &b);
+
+	// Return the names of object fields present in the params of an AgentStatus record
+	static void getAgentStatusFieldNames (Json *record, std::vector<StdString> *destList);
+
+	// The most recently published snapshot, holding one reference owned by the store. snapshotMutex guards this pointer, all Snapshot and Record refcounts, and the change log, and is held only briefly by both readers and writers.
+	RecordStore::Snapshot *currentSnapshot;
+	SDL_mutex *snapshotMutex;
+
+	// Writes not yet applied to a snapshot, guarded by pendingMutex
+	std::list<RecordStore::PendingWrite> pendingWrites;
+	SDL_mutex *pendingMutex;
+
+	SDL_TLSID readContextId;
+
+	// Agent IDs referenced by typed record fields, guarded by snapshotMutex
+	StringPool stringPool;
+
+	// Names of params fields held in MediaItem and StreamItem typed fields rather than in stored record Json objects
+	StringList mediaItemParamNames;
+	StringList streamItemParamNames;
+
+	// Eviction state, guarded by snapshotMutex. evictionList holds MediaItem record IDs with the least recently used first, and pinMap holds pin counts for records referenced by live widgets.
+	int recordBudget;
+	std::list<StdString> evictionList;
+	std::map<StdString, std::list<StdString>::iterator> evictionPositions;
+	std::map<StdString, int> pinMap;
+
+	// Snapshot file state, guarded by snapshotFileMutex. snapshotFileWriteMutex is held for the duration of each file write.
+	StdString snapshotFilePath;
+	int snapshotWritePeriod;
+	int64_t lastSnapshotWriteTime;
+	int64_t lastSnapshotWriteVersion;
+	bool isSnapshotWriteActive;
+	SDL_mutex *snapshotFileMutex;
+	SDL_mutex *snapshotFileWriteMutex;
+
+	// Recent record changes in version order, and the newest version not covered by the log
+	std::deque<RecordStore::Change> changeLog;
+	int64_t version;
+	int64_t changeLogBaseVersion;
 };
 
 #endif
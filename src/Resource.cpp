@@ -34,33 +34,59 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <limits.h>
+#if PLATFORM_LINUX || PLATFORM_MACOS
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 #include <map>
 #include <vector>
+#include <algorithm>
 #include "SDL2/SDL.h"
 #include "SDL2/SDL_image.h"
+#include "zlib.h"
 #include "ft2build.h"
 #include FT_FREETYPE_H
 #include "App.h"
+#include "Profiler.h"
 #include "Font.h"
 #include "OsUtil.h"
 #include "Log.h"
 #include "StdString.h"
+#include "StringList.h"
+#include "HashMap.h"
 #include "Resource.h"
 
 Resource *Resource::instance = NULL;
 
+const uint64_t Resource::BundleFormatMagic = 0x4D42554E444C4532ULL; // "MBUNDLE2"
+const uint64_t Resource::ArchiveEntryCompressedFlag = 0x1;
+const uint64_t Resource::ArchiveEntryPreloadFlag = 0x2;
+const int Resource::DefaultWarmupRecordPeriod = 10000;
+const char *Resource::WarmupImagePathsKey = "a";
+const char *Resource::WarmupFilePathsKey = "b";
+
 Resource::Resource ()
 : dataPath ("")
 , freetype (NULL)
 , isBundleFile (false)
 , isOpen (false)
+, bundleData (NULL)
+, bundleDataSize (0)
 , fileMapMutex (NULL)
 , textureMapMutex (NULL)
 , fontMapMutex (NULL)
+, preloadDataMapMutex (NULL)
+, warmupRecordPeriod (0)
+, warmupRecordStartTime (0)
+, isWarmupRecording (false)
+, warmupMutex (NULL)
 {
 	fileMapMutex = SDL_CreateMutex ();
 	textureMapMutex = SDL_CreateMutex ();
 	fontMapMutex = SDL_CreateMutex ();
+	preloadDataMapMutex = SDL_CreateMutex ();
+	warmupMutex = SDL_CreateMutex ();
 }
 
 Resource::~Resource () {
@@ -81,6 +107,14 @@ Resource::~Resource () {
 		SDL_DestroyMutex (textureMapMutex);
 		textureMapMutex = NULL;
 	}
+	if (preloadDataMapMutex) {
+		SDL_DestroyMutex (preloadDataMapMutex);
+		preloadDataMapMutex = NULL;
+	}
+	if (warmupMutex) {
+		SDL_DestroyMutex (warmupMutex);
+		warmupMutex = NULL;
+	}
 }
 
 void Resource::clearFileMap () {
@@ -139,11 +173,14 @@ void Resource::setSource (const StdString &path) {
 	isBundleFile = (dataPath.find (".dat") == (dataPath.length () - 4));
 }
 
+void Resource::setWarmupManifest (const StdString &path, int recordPeriod) {
+	warmupManifestPath.assign (path);
+	warmupRecordPeriod = recordPeriod;
+}
+
 OsUtil::Result Resource::open () {
 	struct stat st;
 	SDL_RWops *rw;
-	Resource::ArchiveEntry ae;
-	uint64_t id;
 	OsUtil::Result result;
 
 	if (FT_Init_FreeType (&(freetype))) {
@@ -158,6 +195,13 @@ OsUtil::Result Resource::open () {
 		return (OsUtil::FileOperationFailedError);
 	}
 
+	SDL_LockMutex (warmupMutex);
+	warmupImagePaths.clear ();
+	warmupFilePaths.clear ();
+	warmupRecordStartTime = OsUtil::getTime ();
+	isWarmupRecording = (! warmupManifestPath.empty ()) && (warmupRecordPeriod > 0);
+	SDL_UnlockMutex (warmupMutex);
+
 	if (! isBundleFile) {
 		if (! S_ISDIR (st.st_mode)) {
 			Log::err ("Failed to open resources; path=\"%s\" err=\"Invalid resource path\"", dataPath.c_str ());
@@ -167,38 +211,511 @@ OsUtil::Result Resource::open () {
 		return (OsUtil::Success);
 	}
 
-	rw = SDL_RWFromFile (dataPath.c_str (), "r");
+	// Read entries through the bundle mapping if one could be created, and fall back to file reads otherwise
+	if (mapBundleFile () == OsUtil::Success) {
+		rw = SDL_RWFromConstMem (bundleData, (int) bundleDataSize);
+	}
+	else {
+		rw = SDL_RWFromFile (dataPath.c_str (), "r");
+	}
 	if (! rw) {
 		Log::err ("Failed to open resource bundle file; path=\"%s\" error=\"%s\"", dataPath.c_str (), SDL_GetError ());
+		unmapBundleFile ();
 		return (OsUtil::FileOperationFailedError);
 	}
 
-	result = OsUtil::Success;
-	archiveEntryMap.clear ();
-	while (true) {
-		result = Resource::readUint64 (rw, &id);
+	result = readArchiveIndex (rw);
+	SDL_RWclose (rw);
+	if (result == OsUtil::Success) {
+		isOpen = true;
+		decompressPreloadEntries ();
+	}
+	else {
+		unmapBundleFile ();
+	}
+	return (result);
+}
+
+OsUtil::Result Resource::readArchiveIndex (SDL_RWops *rw) {
+	Resource::ArchiveEntry ae;
+	OsUtil::Result result;
+	uint64_t id, count, i;
+	Sint64 size;
+	bool sorted;
+
+	archiveEntryList.clear ();
+	result = Resource::readUint64 (rw, &id);
+	if (result != OsUtil::Success) {
+		return (result);
+	}
+
+	if (id == Resource::BundleFormatMagic) {
+		result = Resource::readUint64 (rw, &count);
 		if (result != OsUtil::Success) {
-			break;
+			return (result);
+		}
+		// Each index record holds five uint64 values, so a count larger than the source can hold is malformed and must not size the reservation
+		size = SDL_RWsize (rw);
+		if ((size < 0) && (bundleDataSize > 0)) {
+			size = (Sint64) bundleDataSize;
+		}
+		if ((size >= 0) && (count > (((uint64_t) size) / 40))) {
+			return (OsUtil::MalformedDataError);
+		}
+		if (size >= 0) {
+			archiveEntryList.reserve ((size_t) count);
+		}
+		for (i = 0; i < count; ++i) {
+			result = Resource::readUint64 (rw, &(ae.id));
+			if (result == OsUtil::Success) {
+				result = Resource::readUint64 (rw, &(ae.position));
+			}
+			if (result == OsUtil::Success) {
+				result = Resource::readUint64 (rw, &(ae.length));
+			}
+			if (result == OsUtil::Success) {
+				result = Resource::readUint64 (rw, &(ae.storedLength));
+			}
+			if (result == OsUtil::Success) {
+				result = Resource::readUint64 (rw, &(ae.flags));
+			}
+			if (result != OsUtil::Success) {
+				break;
+			}
+			archiveEntryList.push_back (ae);
+		}
+	}
+	else {
+		// Version 1 bundles list entries in arbitrary order and store all data uncompressed
+		while (id != 0) {
+			ae.id = id;
+			ae.flags = 0;
+			result = Resource::readUint64 (rw, &(ae.position));
+			if (result == OsUtil::Success) {
+				result = Resource::readUint64 (rw, &(ae.length));
+			}
+			if (result != OsUtil::Success) {
+				break;
+			}
+			ae.storedLength = ae.length;
+			archiveEntryList.push_back (ae);
+			result = Resource::readUint64 (rw, &id);
+			if (result != OsUtil::Success) {
+				break;
+			}
 		}
-		if (id == 0) {
+	}
+	if (result != OsUtil::Success) {
+		archiveEntryList.clear ();
+		return (result);
+	}
+
+	sorted = true;
+	for (i = 1; i < (uint64_t) archiveEntryList.size (); ++i) {
+		if (archiveEntryList[i].id < archiveEntryList[i - 1].id) {
+			sorted = false;
 			break;
 		}
-		result = Resource::readUint64 (rw, &(ae.position));
-		if (result != OsUtil::Success) {
+	}
+	if (! sorted) {
+		std::sort (archiveEntryList.begin (), archiveEntryList.end (), Resource::compareArchiveEntries);
+	}
+	return (OsUtil::Success);
+}
+
+bool Resource::compareArchiveEntries (const Resource::ArchiveEntry &a, const Resource::ArchiveEntry &b) {
+	return (a.id < b.id);
+}
+
+const Resource::ArchiveEntry *Resource::findArchiveEntry (uint64_t id) {
+	std::vector<Resource::ArchiveEntry>::iterator i;
+	Resource::ArchiveEntry key;
+
+	key.id = id;
+	i = std::lower_bound (archiveEntryList.begin (), archiveEntryList.end (), key, Resource::compareArchiveEntries);
+	if ((i == archiveEntryList.end ()) || (i->id != id)) {
+		return (NULL);
+	}
+	return (&(*i));
+}
+
+uint8_t *Resource::readEntryData (const Resource::ArchiveEntry *entry) {
+	const uint8_t *src;
+	uint8_t *srcbuffer, *data;
+	SDL_RWops *rw;
+	uLongf datalength;
+	int result;
+
+	if ((entry->length > INT_MAX) || (entry->storedLength > INT_MAX)) {
+		return (NULL);
+	}
+	srcbuffer = NULL;
+	if (bundleData) {
+		if ((entry->position > bundleDataSize) || (entry->storedLength > (bundleDataSize - entry->position))) {
+			Log::err ("Failed to read resource entry; id=0x%llx err=\"Entry exceeds bundle length\"", (long long int) entry->id);
+			return (NULL);
+		}
+		src = bundleData + entry->position;
+	}
+	else {
+		rw = SDL_RWFromFile (dataPath.c_str (), "r");
+		if (! rw) {
+			Log::err ("Failed to read resource entry; id=0x%llx err=\"bundle: %s\"", (long long int) entry->id, SDL_GetError ());
+			return (NULL);
+		}
+		srcbuffer = (uint8_t *) malloc ((size_t) entry->storedLength + 1);
+		if (! srcbuffer) {
+			SDL_RWclose (rw);
+			return (NULL);
+		}
+		if ((SDL_RWseek (rw, (Sint64) entry->position, RW_SEEK_SET) < 0) || (SDL_RWread (rw, srcbuffer, 1, (size_t) entry->storedLength) != (size_t) entry->storedLength)) {
+			Log::err ("Failed to read resource entry; id=0x%llx err=\"bundle read: %s\"", (long long int) entry->id, SDL_GetError ());
+			SDL_RWclose (rw);
+			free (srcbuffer);
+			return (NULL);
+		}
+		SDL_RWclose (rw);
+		src = srcbuffer;
+	}
+
+	data = (uint8_t *) malloc ((size_t) entry->length + 1);
+	if (! data) {
+		if (srcbuffer) {
+			free (srcbuffer);
+		}
+		return (NULL);
+	}
+	datalength = (uLongf) entry->length;
+	result = uncompress ((Bytef *) data, &datalength, (const Bytef *) src, (uLong) entry->storedLength);
+	if (srcbuffer) {
+		free (srcbuffer);
+	}
+	if ((result != Z_OK) || (datalength != (uLongf) entry->length)) {
+		Log::err ("Failed to decompress resource entry; id=0x%llx err=%i", (long long int) entry->id, result);
+		free (data);
+		return (NULL);
+	}
+	return (data);
+}
+
+void Resource::decompressPreloadEntries () {
+	Resource::PreloadContext ctx;
+	std::vector<Resource::ArchiveEntry>::iterator i, end;
+	int threadcount;
+	int64_t t;
+
+	ctx.resource = this;
+	i = archiveEntryList.begin ();
+	end = archiveEntryList.end ();
+	while (i != end) {
+		if ((i->flags & Resource::ArchiveEntryCompressedFlag) && (i->flags & Resource::ArchiveEntryPreloadFlag)) {
+			ctx.entries.push_back (&(*i));
+		}
+		++i;
+	}
+	if (ctx.entries.empty ()) {
+		return;
+	}
+	t = OsUtil::getTime ();
+	threadcount = executePreload (&ctx);
+	Log::debug ("Decompress resource preload entries; count=%i threads=%i duration=%lldms", (int) ctx.entries.size (), threadcount, (long long int) (OsUtil::getTime () - t));
+}
+
+int Resource::executePreload (Resource::PreloadContext *ctx) {
+	std::vector<SDL_Thread *> threads;
+	std::vector<SDL_Thread *>::iterator ti, tend;
+	SDL_Thread *thread;
+	int threadcount, itemcount, result, k;
+
+	itemcount = (int) (ctx->entries.size () + ctx->surfacePaths.size ());
+	if (itemcount <= 0) {
+		return (0);
+	}
+	ctx->entryData.assign (ctx->entries.size (), NULL);
+	ctx->surfaces.assign (ctx->surfacePaths.size (), NULL);
+	SDL_AtomicSet (&(ctx->nextIndex), 0);
+
+	threadcount = SDL_GetCPUCount ();
+	if (threadcount > itemcount) {
+		threadcount = itemcount;
+	}
+	// This thread also runs the preload loop, so start one fewer thread than the target count
+	for (k = 1; k < threadcount; ++k) {
+		thread = SDL_CreateThread (Resource::runPreloadThread, "executePreload", ctx);
+		if (! thread) {
+			Log::warning ("Failed to create resource preload thread; err=\"%s\"", SDL_GetError ());
 			break;
 		}
-		result = Resource::readUint64 (rw, &(ae.length));
-		if (result != OsUtil::Success) {
+		threads.push_back (thread);
+	}
+	Resource::runPreloadThread (ctx);
+	ti = threads.begin ();
+	tend = threads.end ();
+	while (ti != tend) {
+		SDL_WaitThread (*ti, &result);
+		++ti;
+	}
+
+	SDL_LockMutex (preloadDataMapMutex);
+	for (k = 0; k < (int) ctx->entries.size (); ++k) {
+		if (ctx->entryData[k]) {
+			if (! preloadDataMap.insert (std::pair<uint64_t, uint8_t *> (ctx->entries[k]->id, ctx->entryData[k])).second) {
+				free (ctx->entryData[k]);
+			}
+		}
+	}
+	for (k = 0; k < (int) ctx->surfacePaths.size (); ++k) {
+		if (ctx->surfaces[k]) {
+			if (! prefetchSurfaceMap.insert (std::pair<StdString, SDL_Surface *> (ctx->surfacePaths[k], ctx->surfaces[k])).second) {
+				SDL_FreeSurface (ctx->surfaces[k]);
+			}
+		}
+	}
+	SDL_UnlockMutex (preloadDataMapMutex);
+	return ((int) threads.size () + 1);
+}
+
+int Resource::runPreloadThread (void *contextPtr) {
+	Resource::PreloadContext *ctx;
+	int index, entrycount;
+
+	ctx = (Resource::PreloadContext *) contextPtr;
+	entrycount = (int) ctx->entries.size ();
+	while (true) {
+		index = SDL_AtomicAdd (&(ctx->nextIndex), 1);
+		if (index < entrycount) {
+			ctx->entryData[index] = ctx->resource->readEntryData (ctx->entries[index]);
+			continue;
+		}
+		index -= entrycount;
+		if (index >= (int) ctx->surfacePaths.size ()) {
 			break;
 		}
-		archiveEntryMap.insert (std::pair<uint64_t, Resource::ArchiveEntry> (id, ae));
+		ctx->surfaces[index] = ctx->resource->decodeSurface (ctx->surfacePaths[index]);
 	}
+	return (0);
+}
 
-	SDL_RWclose (rw);
-	if (result == OsUtil::Success) {
-		isOpen = true;
+uint8_t *Resource::takePreloadData (uint64_t id) {
+	std::map<uint64_t, uint8_t *>::iterator i;
+	uint8_t *data;
+
+	data = NULL;
+	SDL_LockMutex (preloadDataMapMutex);
+	i = preloadDataMap.find (id);
+	if (i != preloadDataMap.end ()) {
+		data = i->second;
+		preloadDataMap.erase (i);
 	}
-	return (result);
+	SDL_UnlockMutex (preloadDataMapMutex);
+	return (data);
+}
+
+void Resource::clearPreloadDataMap () {
+	std::map<uint64_t, uint8_t *>::iterator i, end;
+
+	SDL_LockMutex (preloadDataMapMutex);
+	i = preloadDataMap.begin ();
+	end = preloadDataMap.end ();
+	while (i != end) {
+		free (i->second);
+		++i;
+	}
+	preloadDataMap.clear ();
+	SDL_UnlockMutex (preloadDataMapMutex);
+}
+
+void Resource::clearPrefetchEntryData () {
+	std::map<uint64_t, uint8_t *>::iterator i;
+	const Resource::ArchiveEntry *entry;
+
+	SDL_LockMutex (preloadDataMapMutex);
+	i = preloadDataMap.begin ();
+	while (i != preloadDataMap.end ()) {
+		entry = findArchiveEntry (i->first);
+		if ((! entry) || (! (entry->flags & Resource::ArchiveEntryPreloadFlag))) {
+			free (i->second);
+			preloadDataMap.erase (i++);
+		}
+		else {
+			++i;
+		}
+	}
+	SDL_UnlockMutex (preloadDataMapMutex);
+}
+
+SDL_Surface *Resource::takePrefetchSurface (const StdString &path) {
+	std::map<StdString, SDL_Surface *>::iterator i;
+	SDL_Surface *surface;
+
+	surface = NULL;
+	SDL_LockMutex (preloadDataMapMutex);
+	i = prefetchSurfaceMap.find (path);
+	if (i != prefetchSurfaceMap.end ()) {
+		surface = i->second;
+		prefetchSurfaceMap.erase (i);
+	}
+	SDL_UnlockMutex (preloadDataMapMutex);
+	return (surface);
+}
+
+void Resource::clearPrefetchSurfaceMap () {
+	std::map<StdString, SDL_Surface *>::iterator i, end;
+
+	SDL_LockMutex (preloadDataMapMutex);
+	i = prefetchSurfaceMap.begin ();
+	end = prefetchSurfaceMap.end ();
+	while (i != end) {
+		SDL_FreeSurface (i->second);
+		++i;
+	}
+	prefetchSurfaceMap.clear ();
+	SDL_UnlockMutex (preloadDataMapMutex);
+}
+
+void Resource::prefetchWarmupManifest () {
+	Resource::PreloadContext ctx;
+	HashMap manifest;
+	StringList paths;
+	StringList::iterator i, end;
+	const Resource::ArchiveEntry *entry;
+	int threadcount;
+	int64_t t;
+	bool isrecording;
+#if PLATFORM_LINUX || PLATFORM_MACOS
+	uint64_t pagesize, pos;
+#endif
+
+	// Prefetched data is released when the warm-up record period ends, so a prefetch without that period would be held indefinitely
+	SDL_LockMutex (warmupMutex);
+	isrecording = isWarmupRecording;
+	SDL_UnlockMutex (warmupMutex);
+	if ((! isOpen) || warmupManifestPath.empty () || (! isrecording)) {
+		return;
+	}
+	if (manifest.read (warmupManifestPath) != OsUtil::Success) {
+		return;
+	}
+	t = OsUtil::getTime ();
+	ctx.resource = this;
+
+	manifest.find (Resource::WarmupFilePathsKey, &paths);
+	i = paths.begin ();
+	end = paths.end ();
+	while (i != end) {
+		entry = isBundleFile ? findArchiveEntry (Resource::getPathId (*i)) : NULL;
+		if (entry) {
+			if (entry->flags & Resource::ArchiveEntryCompressedFlag) {
+				if (! (entry->flags & Resource::ArchiveEntryPreloadFlag)) {
+					ctx.entries.push_back (entry);
+				}
+			}
+#if PLATFORM_LINUX || PLATFORM_MACOS
+			else if (bundleData && (entry->position < bundleDataSize) && (entry->length <= (bundleDataSize - entry->position))) {
+				// Ask the kernel to read mapped pages ahead, so that the first access doesn't stall on page faults
+				pagesize = (uint64_t) sysconf (_SC_PAGESIZE);
+				pos = entry->position - (entry->position % pagesize);
+				posix_madvise (bundleData + pos, (size_t) (entry->position + entry->length - pos), POSIX_MADV_WILLNEED);
+			}
+#endif
+		}
+		++i;
+	}
+
+	// Paths from a manifest written by an earlier build may no longer exist
+	manifest.find (Resource::WarmupImagePathsKey, &paths);
+	i = paths.begin ();
+	end = paths.end ();
+	while (i != end) {
+		if (fileExists (*i)) {
+			ctx.surfacePaths.push_back (*i);
+		}
+		++i;
+	}
+
+	threadcount = executePreload (&ctx);
+	Log::debug ("Prefetch resource warm-up manifest; fileCount=%i imageCount=%i threads=%i duration=%lldms", (int) ctx.entries.size (), (int) ctx.surfacePaths.size (), threadcount, (long long int) (OsUtil::getTime () - t));
+}
+
+void Resource::recordWarmupPath (StringList *pathList, const StdString &path) {
+	SDL_LockMutex (warmupMutex);
+	if (isWarmupRecording && (! pathList->contains (path))) {
+		pathList->push_back (path);
+	}
+	SDL_UnlockMutex (warmupMutex);
+}
+
+void Resource::endWarmupRecord () {
+	HashMap manifest;
+	OsUtil::Result result;
+
+	SDL_LockMutex (warmupMutex);
+	if (! isWarmupRecording) {
+		SDL_UnlockMutex (warmupMutex);
+		return;
+	}
+	isWarmupRecording = false;
+	manifest.insert (Resource::WarmupImagePathsKey, warmupImagePaths);
+	manifest.insert (Resource::WarmupFilePathsKey, warmupFilePaths);
+	warmupImagePaths.clear ();
+	warmupFilePaths.clear ();
+	SDL_UnlockMutex (warmupMutex);
+
+	result = manifest.write (warmupManifestPath);
+	if (result != OsUtil::Success) {
+		Log::debug ("Failed to write resource warm-up manifest; path=\"%s\" err=%i", warmupManifestPath.c_str (), result);
+	}
+
+	// Prefetched images and entry data that haven't been claimed by now aren't needed at startup
+	clearPrefetchSurfaceMap ();
+	clearPrefetchEntryData ();
+}
+
+OsUtil::Result Resource::mapBundleFile () {
+#if PLATFORM_LINUX || PLATFORM_MACOS
+	struct stat st;
+	void *data;
+	int fd;
+
+	unmapBundleFile ();
+	fd = ::open (dataPath.c_str (), O_RDONLY);
+	if (fd < 0) {
+		Log::debug ("Failed to map resource bundle file; path=\"%s\" err=\"open: %s\"", dataPath.c_str (), strerror (errno));
+		return (OsUtil::FileOpenFailedError);
+	}
+	if (fstat (fd, &st) != 0) {
+		Log::debug ("Failed to map resource bundle file; path=\"%s\" err=\"fstat: %s\"", dataPath.c_str (), strerror (errno));
+		::close (fd);
+		return (OsUtil::FileOperationFailedError);
+	}
+	// SDL_RWFromConstMem takes an int size, which limits the mapped bundle length
+	if ((st.st_size <= 0) || (st.st_size > INT_MAX)) {
+		::close (fd);
+		return (OsUtil::InvalidParamError);
+	}
+	data = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close (fd);
+	if (data == MAP_FAILED) {
+		Log::debug ("Failed to map resource bundle file; path=\"%s\" err=\"mmap: %s\"", dataPath.c_str (), strerror (errno));
+		return (OsUtil::SystemOperationFailedError);
+	}
+	bundleData = (uint8_t *) data;
+	bundleDataSize = (uint64_t) st.st_size;
+	return (OsUtil::Success);
+#else
+	return (OsUtil::NotImplementedError);
+#endif
+}
+
+void Resource::unmapBundleFile () {
+	if (! bundleData) {
+		return;
+	}
+#if PLATFORM_LINUX || PLATFORM_MACOS
+	munmap (bundleData, (size_t) bundleDataSize);
+#endif
+	bundleData = NULL;
+	bundleDataSize = 0;
 }
 
 void Resource::close () {
@@ -212,10 +729,22 @@ void Resource::close () {
 		FT_Done_FreeType (freetype);
 		freetype = NULL;
 	}
+	endWarmupRecord ();
+	clearPrefetchSurfaceMap ();
+	clearPreloadDataMap ();
+	unmapBundleFile ();
 	isOpen = false;
 }
 
 void Resource::compact () {
+	bool shouldend;
+
+	SDL_LockMutex (warmupMutex);
+	shouldend = isWarmupRecording && ((OsUtil::getTime () - warmupRecordStartTime) >= warmupRecordPeriod);
+	SDL_UnlockMutex (warmupMutex);
+	if (shouldend) {
+		endWarmupRecord ();
+	}
 	compactFontMap ();
 	compactFileMap ();
 	compactTextureMap ();
@@ -297,17 +826,13 @@ void Resource::compactFontMap () {
 }
 
 bool Resource::fileExists (const StdString &path) {
-	uint64_t id;
-	std::map<uint64_t, Resource::ArchiveEntry>::iterator i;
 	SDL_RWops *rw;
 	StdString loadpath;
 	bool exists;
 
 	exists = false;
 	if (isBundleFile) {
-		id = Resource::getPathId (path);
-		i = archiveEntryMap.find (id);
-		if (i != archiveEntryMap.end ()) {
+		if (findArchiveEntry (Resource::getPathId (path))) {
 			exists = true;
 		}
 	}
@@ -323,26 +848,77 @@ bool Resource::fileExists (const StdString &path) {
 }
 
 SDL_RWops *Resource::openFile (const StdString &path, uint64_t *fileSize) {
-	uint64_t id;
-	std::map<uint64_t, Resource::ArchiveEntry>::iterator i;
-	SDL_RWops *rw, *rwbundle;
+	const Resource::ArchiveEntry *entry;
+	SDL_RWops *rw, *rwbundle, *rwdata;
 	StdString loadpath;
+	uint8_t *data;
 	Sint64 pos;
 
 	rw = NULL;
 	if (isBundleFile) {
-		id = Resource::getPathId (path);
-		i = archiveEntryMap.find (id);
-		if (i == archiveEntryMap.end ()) {
+		entry = findArchiveEntry (Resource::getPathId (path));
+		if (! entry) {
 			Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"Unknown path\"", path.c_str ());
 			return (NULL);
 		}
+		if (entry->flags & Resource::ArchiveEntryCompressedFlag) {
+			data = takePreloadData (entry->id);
+			if (! data) {
+				data = readEntryData (entry);
+			}
+			if (! data) {
+				Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"Failed to decompress entry\"", path.c_str ());
+				return (NULL);
+			}
+			rwdata = SDL_RWFromConstMem (data, (int) entry->length);
+			if (! rwdata) {
+				free (data);
+				Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"bundle: %s\"", path.c_str (), SDL_GetError ());
+				return (NULL);
+			}
+			rw = SDL_AllocRW ();
+			if (! rw) {
+				SDL_RWclose (rwdata);
+				free (data);
+				Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"bundle: %s\"", path.c_str (), SDL_GetError ());
+				return (NULL);
+			}
+
+			// The returned SDL_RWops object owns the decompressed data and frees it on close
+			rw->type = SDL_RWOPS_UNKNOWN;
+			rw->hidden.unknown.data1 = data;
+			rw->hidden.unknown.data2 = rwdata;
+			rw->size = Resource::dataRwopsSize;
+			rw->seek = Resource::dataRwopsSeek;
+			rw->read = Resource::dataRwopsRead;
+			rw->write = Resource::rwopsWrite;
+			rw->close = Resource::dataRwopsClose;
+			if (fileSize) {
+				*fileSize = entry->length;
+			}
+			return (rw);
+		}
+		if (bundleData) {
+			if ((entry->position > bundleDataSize) || (entry->length > (bundleDataSize - entry->position))) {
+				Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"Entry exceeds bundle length\"", path.c_str ());
+				return (NULL);
+			}
+			rw = SDL_RWFromConstMem (bundleData + entry->position, (int) entry->length);
+			if (! rw) {
+				Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"bundle: %s\"", path.c_str (), SDL_GetError ());
+				return (NULL);
+			}
+			if (fileSize) {
+				*fileSize = entry->length;
+			}
+			return (rw);
+		}
 		rwbundle = SDL_RWFromFile (dataPath.c_str (), "r");
 		if (! rwbundle) {
 			Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"bundle: %s\"", dataPath.c_str (), SDL_GetError ());
 			return (NULL);
 		}
-		pos = SDL_RWseek (rwbundle, (Sint64) i->second.position, RW_SEEK_SET);
+		pos = SDL_RWseek (rwbundle, (Sint64) entry->position, RW_SEEK_SET);
 		if (pos < 0) {
 			SDL_RWclose (rwbundle);
 			Log::debug3 ("Failed to open file resource; path=\"%s\" error=\"seek: %s\"", dataPath.c_str (), SDL_GetError ());
@@ -356,7 +932,7 @@ SDL_RWops *Resource::openFile (const StdString &path, uint64_t *fileSize) {
 		}
 
 		rw->type = SDL_RWOPS_UNKNOWN;
-		rw->hidden.unknown.data1 = &(i->second);
+		rw->hidden.unknown.data1 = (void *) entry;
 		rw->hidden.unknown.data2 = rwbundle;
 		rw->size = Resource::rwopsSize;
 		rw->seek = Resource::rwopsSeek;
@@ -365,7 +941,7 @@ SDL_RWops *Resource::openFile (const StdString &path, uint64_t *fileSize) {
 		rw->close = Resource::rwopsClose;
 
 		if (fileSize) {
-			*fileSize = i->second.length;
+			*fileSize = entry->length;
 		}
 	}
 	else {
@@ -386,6 +962,25 @@ SDL_RWops *Resource::openFile (const StdString &path, uint64_t *fileSize) {
 	return (rw);
 }
 
+const uint8_t *Resource::getMappedFile (const StdString &path, uint64_t *fileSize) {
+	const Resource::ArchiveEntry *entry;
+
+	if (! bundleData) {
+		return (NULL);
+	}
+	entry = findArchiveEntry (Resource::getPathId (path));
+	if ((! entry) || (entry->flags & Resource::ArchiveEntryCompressedFlag)) {
+		return (NULL);
+	}
+	if ((entry->position > bundleDataSize) || (entry->length > (bundleDataSize - entry->position))) {
+		return (NULL);
+	}
+	if (fileSize) {
+		*fileSize = entry->length;
+	}
+	return (bundleData + entry->position);
+}
+
 Sint64 Resource::rwopsSize (SDL_RWops *rw) {
 	Resource::ArchiveEntry *ae;
 
@@ -485,11 +1080,31 @@ int Resource::rwopsClose (SDL_RWops *rw) {
 	return (0);
 }
 
+Sint64 Resource::dataRwopsSize (SDL_RWops *rw) {
+	return (SDL_RWsize ((SDL_RWops *) rw->hidden.unknown.data2));
+}
+
+Sint64 Resource::dataRwopsSeek (SDL_RWops *rw, Sint64 offset, int whence) {
+	return (SDL_RWseek ((SDL_RWops *) rw->hidden.unknown.data2, offset, whence));
+}
+
+size_t Resource::dataRwopsRead (SDL_RWops *rw, void *ptr, size_t size, size_t maxnum) {
+	return (SDL_RWread ((SDL_RWops *) rw->hidden.unknown.data2, ptr, size, maxnum));
+}
+
+int Resource::dataRwopsClose (SDL_RWops *rw) {
+	SDL_RWclose ((SDL_RWops *) rw->hidden.unknown.data2);
+	free (rw->hidden.unknown.data1);
+	SDL_FreeRW (rw);
+	return (0);
+}
+
 Buffer *Resource::loadFile (const StdString &path) {
 	std::map<StdString, Resource::FileData>::iterator i;
 	Resource::FileData data;
 	Buffer *buffer;
 	SDL_RWops *rw;
+	const uint8_t *mapdata;
 	uint64_t sz;
 	uint8_t buf[8192];
 	size_t len, rlen;
@@ -505,6 +1120,24 @@ Buffer *Resource::loadFile (const StdString &path) {
 	if (buffer) {
 		return (buffer);
 	}
+
+	mapdata = getMappedFile (path, &sz);
+	if (mapdata) {
+		buffer = new Buffer ();
+		if (buffer->add ((uint8_t *) mapdata, (int) sz) != OsUtil::Success) {
+			Log::err ("Failed to load file resource; path=\"%s\" error=\"Out of memory\"", path.c_str ());
+			delete (buffer);
+			return (NULL);
+		}
+		data.data = buffer;
+		data.refcount = 1;
+		SDL_LockMutex (fileMapMutex);
+		fileMap.insert (std::pair<StdString, Resource::FileData> (path, data));
+		SDL_UnlockMutex (fileMapMutex);
+		recordWarmupPath (&warmupFilePaths, path);
+		return (buffer);
+	}
+
 	rw = openFile (path, &sz);
 	if (! rw) {
 		return (NULL);
@@ -537,6 +1170,7 @@ Buffer *Resource::loadFile (const StdString &path) {
 	SDL_LockMutex (fileMapMutex);
 	fileMap.insert (std::pair<StdString, Resource::FileData> (path, data));
 	SDL_UnlockMutex (fileMapMutex);
+	recordWarmupPath (&warmupFilePaths, path);
 
 	return (buffer);
 }
@@ -558,6 +1192,19 @@ void Resource::unloadFile (const StdString &path) {
 }
 
 SDL_Surface *Resource::loadSurface (const StdString &path) {
+	SDL_Surface *surface;
+
+	surface = takePrefetchSurface (path);
+	if (! surface) {
+		surface = decodeSurface (path);
+	}
+	if (surface) {
+		recordWarmupPath (&warmupImagePaths, path);
+	}
+	return (surface);
+}
+
+SDL_Surface *Resource::decodeSurface (const StdString &path) {
 	StdString loadpath;
 	SDL_RWops *rw;
 	SDL_Surface *surface;
@@ -588,8 +1235,6 @@ SDL_Surface *Resource::loadSurface (const StdString &path) {
 SDL_Texture *Resource::loadTexture (const StdString &path) {
 	std::map<StdString, Resource::TextureData>::iterator i;
 	Resource::TextureData data;
-	StdString loadpath;
-	SDL_RWops *rw;
 	SDL_Surface *surface;
 	SDL_Texture *texture;
 
@@ -605,26 +1250,7 @@ SDL_Texture *Resource::loadTexture (const StdString &path) {
 		return (texture);
 	}
 
-	surface = NULL;
-	if (isBundleFile) {
-		rw = openFile (path);
-		if (! rw) {
-			return (NULL);
-		}
-		surface = IMG_Load_RW (rw, 1);
-		if (! surface) {
-			Log::info ("bundle IMG_Load_RW failed; path=\"%s\" err=\"%s\"", path.c_str (), SDL_GetError ());
-			return (NULL);
-		}
-	}
-	else {
-		loadpath.sprintf ("%s/%s", dataPath.c_str (), path.c_str ());
-		surface = IMG_Load (loadpath.c_str ());
-		if (! surface) {
-			Log::info ("IMG_Load failed; path=\"%s\" err=\"%s\"", path.c_str (), SDL_GetError ());
-			return (NULL);
-		}
-	}
+	surface = loadSurface (path);
 	if (! surface) {
 		return (NULL);
 	}
@@ -635,6 +1261,7 @@ SDL_Texture *Resource::loadTexture (const StdString &path) {
 		Log::err ("SDL_CreateTextureFromSurface failed; path=\"%s\" err=\"%s\"", path.c_str (), SDL_GetError ());
 		return (NULL);
 	}
+	Profiler::instance->addCount (Profiler::TextureUploadCounter);
 
 	data.texture = texture;
 	data.refcount = 1;
@@ -666,6 +1293,7 @@ SDL_Texture *Resource::createTexture (const StdString &path, SDL_Surface *surfac
 		Log::err ("SDL_CreateTextureFromSurface failed; path=\"%s\" err=\"%s\"", path.c_str (), SDL_GetError ());
 		return (NULL);
 	}
+	Profiler::instance->addCount (Profiler::TextureUploadCounter);
 
 	data.texture = texture;
 	data.refcount = 1;
@@ -734,6 +1362,8 @@ Font *Resource::loadFont (const StdString &path, int pointSize) {
 	StdString key;
 	Buffer *buffer;
 	Font *font;
+	const uint8_t *mapdata;
+	uint64_t sz;
 	int result;
 
 	font = NULL;
@@ -748,16 +1378,26 @@ Font *Resource::loadFont (const StdString &path, int pointSize) {
 	if (font) {
 		return (font);
 	}
-	buffer = loadFile (path);
-	if (! buffer) {
-		return (NULL);
-	}
 
-	font = new Font (freetype, key);
-	result = font->load (buffer, pointSize);
+	// Font faces open directly from the bundle mapping where possible, rather than holding a copy of the font file in fileMap
+	mapdata = getMappedFile (path, &sz);
+	if (mapdata) {
+		font = new Font (freetype, key);
+		result = font->load (mapdata, (int) sz, pointSize);
+	}
+	else {
+		buffer = loadFile (path);
+		if (! buffer) {
+			return (NULL);
+		}
+		font = new Font (freetype, key);
+		result = font->load (buffer, pointSize);
+	}
 	if (result != OsUtil::Success) {
 		delete (font);
-		unloadFile (path);
+		if (! mapdata) {
+			unloadFile (path);
+		}
 		Log::err ("Failed to load font resource; key=\"%s\" err=%i", key.c_str (), result);
 		return (NULL);
 	}
@@ -767,6 +1407,7 @@ Font *Resource::loadFont (const StdString &path, int pointSize) {
 	SDL_LockMutex (fontMapMutex);
 	fontMap.insert (std::pair<StdString, Resource::FontData> (key, data));
 	SDL_UnlockMutex (fontMapMutex);
+	recordWarmupPath (&warmupFilePaths, path);
 
 	return (font);
 }
@@ -790,7 +1431,7 @@ void Resource::unloadFont (const StdString &path, int pointSize) {
 		}
 	}
 	SDL_UnlockMutex (fontMapMutex);
-	if (unloaded) {
+	if (unloaded && (! getMappedFile (path, NULL))) {
 		unloadFile (path);
 	}
 }
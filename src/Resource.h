@@ -38,6 +38,7 @@
 #include "ft2build.h"
 #include FT_FREETYPE_H
 #include "StdString.h"
+#include "StringList.h"
 #include "OsUtil.h"
 #include "Buffer.h"
 #include "Font.h"
@@ -48,24 +49,43 @@ public:
 	~Resource ();
 	static Resource *instance;
 
+	// Bundle file format values. A version 2 bundle begins with BundleFormatMagic and an entry count, followed by that number of index records sorted by ID, each holding five big-endian uint64 values: ID, data position, data length, stored length, and flags. A version 1 bundle holds index records of ID, position, and length, terminated by a zero ID.
+	static const uint64_t BundleFormatMagic;
+	static const uint64_t ArchiveEntryCompressedFlag; // Entry data is stored in zlib format and must be inflated to its data length
+	static const uint64_t ArchiveEntryPreloadFlag; // Entry data should be decompressed while the bundle is opened
+
+	// Warm-up manifest values
+	static const int DefaultWarmupRecordPeriod; // milliseconds
+	static const char *WarmupImagePathsKey;
+	static const char *WarmupFilePathsKey;
+
 	// Set the source path that should be used for loading file assets. If the path ends in ".dat", it is opened as a bundle file; otherwise, the path is treated as a directory prefix for direct file access.
 	void setSource (const StdString &path);
 
+	// Set the path of the warm-up manifest file, which records the assets loaded during the first recordPeriod milliseconds after the Resource object opens. An empty path disables warm-up recording and prefetch.
+	void setWarmupManifest (const StdString &path, int recordPeriod);
+
 	// Prepare the Resource object to execute file operations. Returns a Result value.
 	OsUtil::Result open ();
 
 	// Close the resource object and free all assets
 	void close ();
 
+	// Read the warm-up manifest and load the assets it lists, decoding images and decompressing files in parallel threads, and block until the operation completes. Images prefetched by this method are held until claimed by loadSurface or loadTexture, or until the warm-up record period ends.
+	void prefetchWarmupManifest ();
+
 	// Free objects associated with resources that are no longer referenced
 	void compact ();
 
 	// Return a boolean value indicating whether a resource file exists at the specified path
 	bool fileExists (const StdString &path);
 
-	// Open resource data at the specified path and return the resulting SDL_RWops object, or NULL if the file could not be opened. The caller is responsible for closing the SDL_RWops object when it's no longer needed. If fileSize is non-NULL, its value is set to the size of the opened file.
+	// Open resource data at the specified path and return the resulting SDL_RWops object, or NULL if the file could not be opened. The caller is responsible for closing the SDL_RWops object when it's no longer needed. If fileSize is non-NULL, its value is set to the size of the opened file. If the resource bundle is memory-mapped, the SDL_RWops object reads uncompressed entries directly from the mapping.
 	SDL_RWops *openFile (const StdString &path, uint64_t *fileSize = NULL);
 
+	// Return a pointer to the mapped bundle data for the file at the specified resource path and store its length in fileSize, or return NULL if the resource bundle isn't memory-mapped, no such file was found, or the file is stored compressed. The returned data remains valid until the Resource object is closed.
+	const uint8_t *getMappedFile (const StdString &path, uint64_t *fileSize);
+
 	// Load file data from the specified resource path. Returns a pointer to the resulting Buffer object, or NULL if the file load failed. If a pointer is returned by this method, the referenced path must be unloaded with the unloadFile method when the Buffer is no longer needed.
 	Buffer *loadFile (const StdString &path);
 
@@ -103,10 +123,34 @@ public:
 	static size_t rwopsWrite (SDL_RWops *rw, const void *ptr, size_t size, size_t num);
 	static int rwopsClose (SDL_RWops *rw);
 
+	// Interface functions for use in an SDL_RWops struct that reads decompressed entry data
+	static Sint64 dataRwopsSize (SDL_RWops *rw);
+	static Sint64 dataRwopsSeek (SDL_RWops *rw, Sint64 offset, int whence);
+	static size_t dataRwopsRead (SDL_RWops *rw, void *ptr, size_t size, size_t maxnum);
+	static int dataRwopsClose (SDL_RWops *rw);
+
 private:
 	struct ArchiveEntry {
+		uint64_t id;
 		uint64_t position;
 		uint64_t length;
+		uint64_t storedLength;
+		uint64_t flags;
+		ArchiveEntry ():
+			id (0),
+			position (0),
+			length (0),
+			storedLength (0),
+			flags (0) { }
+	};
+
+	struct PreloadContext {
+		Resource *resource;
+		std::vector<const Resource::ArchiveEntry *> entries;
+		std::vector<uint8_t *> entryData;
+		std::vector<StdString> surfacePaths;
+		std::vector<SDL_Surface *> surfaces;
+		SDL_atomic_t nextIndex;
 	};
 
 	struct FileData {
@@ -124,10 +168,63 @@ private:
 		int refcount;
 	};
 
+	// Map the bundle file at dataPath into memory and return a Result value
+	OsUtil::Result mapBundleFile ();
+
+	// Release any memory mapping created by mapBundleFile
+	void unmapBundleFile ();
+
+	// Read the bundle index from the provided SDL_RWops object and store the resulting entries in archiveEntryList, sorted by ID. Returns a Result value.
+	OsUtil::Result readArchiveIndex (SDL_RWops *rw);
+
+	// Return the archive entry with the specified ID, or NULL if no such entry was found
+	const Resource::ArchiveEntry *findArchiveEntry (uint64_t id);
+
+	// Return true if archive entry a sorts before archive entry b
+	static bool compareArchiveEntries (const Resource::ArchiveEntry &a, const Resource::ArchiveEntry &b);
+
+	// Return a newly allocated block holding the decompressed data for a compressed archive entry, or NULL if the data could not be read. The caller is responsible for freeing the returned block with free. This method doesn't modify Resource state and can be invoked from any thread.
+	uint8_t *readEntryData (const Resource::ArchiveEntry *entry);
+
+	// Decompress all entries marked with ArchiveEntryPreloadFlag in parallel and store the results in preloadDataMap
+	void decompressPreloadEntries ();
+
+	// Execute all items from a PreloadContext in parallel threads, and store the resulting entry data in preloadDataMap and the resulting surfaces in prefetchSurfaceMap. Returns the number of threads used.
+	int executePreload (Resource::PreloadContext *ctx);
+
+	// Decompress entries and decode surfaces from a PreloadContext until none remain, as the function for a preload thread
+	static int runPreloadThread (void *contextPtr);
+
+	// Load an SDL_Surface from the image file at the specified resource path, without consulting prefetchSurfaceMap. This method can be invoked from any thread.
+	SDL_Surface *decodeSurface (const StdString &path);
+
+	// Remove and return the prefetched surface for the specified path, or NULL if no such surface was found. The caller takes ownership of the returned surface.
+	SDL_Surface *takePrefetchSurface (const StdString &path);
+
+	// Free all items in prefetchSurfaceMap
+	void clearPrefetchSurfaceMap ();
+
+	// Add path to the provided warm-up list if the warm-up record period is active
+	void recordWarmupPath (StringList *pathList, const StdString &path);
+
+	// Write recorded warm-up paths to the manifest file and end the warm-up record period
+	void endWarmupRecord ();
+
+	// Remove and return the preloaded data block for the specified entry ID, or NULL if no such data was found. The caller takes ownership of the returned block.
+	uint8_t *takePreloadData (uint64_t id);
+
+	// Free all items in preloadDataMap
+	void clearPreloadDataMap ();
+
+	// Free all items in preloadDataMap that were added by prefetchWarmupManifest rather than for entries marked with ArchiveEntryPreloadFlag
+	void clearPrefetchEntryData ();
+
 	StdString dataPath;
 	FT_Library freetype;
 	bool isBundleFile;
 	bool isOpen;
+	uint8_t *bundleData;
+	uint64_t bundleDataSize;
 
 	// A map of resource paths to FileData objects
 	std::map<StdString, Resource::FileData> fileMap;
@@ -144,8 +241,24 @@ private:
 	std::vector<StdString> fontCompactList;
 	SDL_mutex *fontMapMutex;
 
-	// A map of entry ID values to ArchiveEntry structs
-	std::map<uint64_t, Resource::ArchiveEntry> archiveEntryMap;
+	// A list of ArchiveEntry structs sorted by ID, for binary search by findArchiveEntry
+	std::vector<Resource::ArchiveEntry> archiveEntryList;
+
+	// A map of entry ID values to decompressed data blocks produced by decompressPreloadEntries
+	std::map<uint64_t, uint8_t *> preloadDataMap;
+	SDL_mutex *preloadDataMapMutex;
+
+	// A map of resource paths to surfaces decoded by prefetchWarmupManifest, guarded by preloadDataMapMutex
+	std::map<StdString, SDL_Surface *> prefetchSurfaceMap;
+
+	// Paths loaded during the warm-up record period
+	StdString warmupManifestPath;
+	int warmupRecordPeriod;
+	int64_t warmupRecordStartTime;
+	bool isWarmupRecording;
+	StringList warmupImagePaths;
+	StringList warmupFilePaths;
+	SDL_mutex *warmupMutex;
 
 	// Clear the file map
 	void clearFileMap ();
@@ -307,6 +307,10 @@ void ServerWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool ServerWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (agentId) > 0);
+}
+
 void ServerWindow::setExpanded (bool expanded, bool shouldSkipStateChangeCallback) {
 	if (expanded == isExpanded) {
 		return;
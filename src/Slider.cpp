@@ -35,6 +35,7 @@
 #include "Log.h"
 #include "StdString.h"
 #include "App.h"
+#include "Profiler.h"
 #include "Resource.h"
 #include "MathUtil.h"
 #include "Widget.h"
@@ -69,6 +70,9 @@ Slider::Slider (float minValue, float maxValue)
 	if (maxValue < minValue) {
 		maxValue = minValue;
 	}
+	thumbColor.setAnimationOwner (this);
+	trackColor.setAnimationOwner (this);
+	hoverColor.setAnimationOwner (this);
 	thumbSize = UiConfiguration::instance->sliderThumbSize;
 	thumbColor.assign (UiConfiguration::instance->lightPrimaryColor);
 	trackWidth = UiConfiguration::instance->sliderTrackWidth;
@@ -205,9 +209,6 @@ void Slider::addSnapValue (float snapValue) {
 }
 
 void Slider::doUpdate (int msElapsed) {
-	thumbColor.update (msElapsed);
-	trackColor.update (msElapsed);
-	hoverColor.update (msElapsed);
 	if (!(isThumbSpriteLoaded || isThumbSpriteLoading)) {
 		loadThumbSprite ();
 	}
@@ -223,6 +224,7 @@ void Slider::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 	if (! isThumbSpriteLoaded) {
 		return;
 	}
+	App::instance->flushDrawBatch ();
 	render = App::instance->render;
 	x0 = (int) (originX + position.x);
 	y0 = (int) (originY + position.y);
@@ -259,7 +261,8 @@ void Slider::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 		texture = thumbSprite->getTexture (0);
 		SDL_SetTextureColorMod (texture, thumbColor.rByte, thumbColor.gByte, thumbColor.bByte);
 		SDL_SetTextureBlendMode (texture, SDL_BLENDMODE_BLEND);
-		SDL_RenderCopy (render, texture, NULL, &rect);
+		SDL_RenderCopy (render, texture, thumbSprite->getSourceRect (0), &rect);
+		Profiler::instance->addCount (Profiler::RenderCallCounter);
 	}
 	else {
 		SDL_SetRenderDrawColor (render, thumbColor.rByte, thumbColor.gByte, thumbColor.bByte, 255);
@@ -448,6 +451,7 @@ void Slider::createThumbTexture (void *sliderPtr) {
 		delete (slider->thumbSprite);
 	}
 	slider->thumbSprite = sprite;
+	slider->addDrawDamage ();
 	slider->endLoadThumbSprite ();
 }
 
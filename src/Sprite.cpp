@@ -66,7 +66,12 @@ Sprite *Sprite::copy () {
 			sprite = NULL;
 			break;
 		}
-		result = sprite->addTexture (texture, i->loadPath);
+		if (i->hasSourceRect) {
+			result = sprite->addAtlasFrame (texture, i->loadPath, i->sourceRect);
+		}
+		else {
+			result = sprite->addTexture (texture, i->loadPath);
+		}
 		if (result != OsUtil::Success) {
 			Resource::instance->unloadTexture (i->loadPath);
 			delete (sprite);
@@ -83,28 +88,14 @@ OsUtil::Result Sprite::load (const StdString &path, int imageScale) {
 	SDL_Texture *texture;
 	OsUtil::Result result;
 	int i;
-	bool found;
 
 	result = OsUtil::Success;
 	i = 0;
 	maxWidth = 0;
 	maxHeight = 0;
 	while (true) {
-		found = false;
-
-		if (imageScale >= 0) {
-			loadpath.sprintf ("%s/%03i_%i.png", path.c_str (), i, imageScale);
-			if (Resource::instance->fileExists (loadpath)) {
-				found = true;
-			}
-		}
-		if (! found) {
-			loadpath.sprintf ("%s/%03i.png", path.c_str (), i);
-			if (Resource::instance->fileExists (loadpath)) {
-				found = true;
-			}
-		}
-		if (! found) {
+		loadpath = Sprite::getFramePath (path, i, imageScale);
+		if (loadpath.empty ()) {
 			break;
 		}
 		texture = Resource::instance->loadTexture (loadpath);
@@ -123,6 +114,22 @@ OsUtil::Result Sprite::load (const StdString &path, int imageScale) {
 	return (result);
 }
 
+StdString Sprite::getFramePath (const StdString &path, int index, int imageScale) {
+	StdString loadpath;
+
+	if (imageScale >= 0) {
+		loadpath.sprintf ("%s/%03i_%i.png", path.c_str (), index, imageScale);
+		if (Resource::instance->fileExists (loadpath)) {
+			return (loadpath);
+		}
+	}
+	loadpath.sprintf ("%s/%03i.png", path.c_str (), index);
+	if (Resource::instance->fileExists (loadpath)) {
+		return (loadpath);
+	}
+	return (StdString (""));
+}
+
 OsUtil::Result Sprite::addTexture (SDL_Texture *texture, const StdString &loadPath) {
 	Sprite::TextureData item;
 
@@ -143,6 +150,29 @@ OsUtil::Result Sprite::addTexture (SDL_Texture *texture, const StdString &loadPa
 	return (OsUtil::Success);
 }
 
+OsUtil::Result Sprite::addAtlasFrame (SDL_Texture *atlasTexture, const StdString &atlasPath, const SDL_Rect &sourceRect) {
+	Sprite::TextureData item;
+
+	if ((! atlasTexture) || (sourceRect.w <= 0) || (sourceRect.h <= 0)) {
+		return (OsUtil::InvalidParamError);
+	}
+	item.texture = atlasTexture;
+	item.loadPath.assign (atlasPath);
+	item.width = sourceRect.w;
+	item.height = sourceRect.h;
+	item.hasSourceRect = true;
+	item.sourceRect = sourceRect;
+	textureList.push_back (item);
+	frameCount = (int) textureList.size ();
+	if (item.width > maxWidth) {
+		maxWidth = item.width;
+	}
+	if (item.height > maxHeight) {
+		maxHeight = item.height;
+	}
+	return (OsUtil::Success);
+}
+
 void Sprite::unload () {
 	std::vector<Sprite::TextureData>::iterator i, end;
 
@@ -176,6 +206,16 @@ SDL_Texture *Sprite::getTexture (int index, int *width, int *height) {
 	return (item.texture);
 }
 
+const SDL_Rect *Sprite::getSourceRect (int index) const {
+	if ((index < 0) || (index >= (int) textureList.size ())) {
+		return (NULL);
+	}
+	if (! textureList[index].hasSourceRect) {
+		return (NULL);
+	}
+	return (&(textureList[index].sourceRect));
+}
+
 StdString Sprite::getLoadPath (int index) const {
 	Sprite::TextureData item;
 
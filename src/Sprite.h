@@ -52,15 +52,24 @@ public:
 	// Load sprite data from png files at the specified path, which is expected to contain numbered png files named 000.png, 001.png, etc. If an image scale value is provided, the operation checks for files named with that suffix (i.e. 000_0.png, 001_0.png) and loads those if they exist. Returns a Result value.
 	OsUtil::Result load (const StdString &path, int imageScale = -1);
 
+	// Return the resource path of the png file holding the specified frame index in the sprite directory at path, as found by the load method, or an empty string if no such file exists
+	static StdString getFramePath (const StdString &path, int index, int imageScale = -1);
+
 	// Add the provided texture to the sprite's frame set. When the sprite is unloaded, release it from resources using the specified loadPath. Returns a Result value.
 	OsUtil::Result addTexture (SDL_Texture *texture, const StdString &loadPath);
 
+	// Add a frame to the sprite's frame set, drawn from the specified area of an atlas texture. When the sprite is unloaded, release atlasTexture from resources using atlasPath. Returns a Result value.
+	OsUtil::Result addAtlasFrame (SDL_Texture *atlasTexture, const StdString &atlasPath, const SDL_Rect &sourceRect);
+
 	// Unload previously loaded sprite data
 	void unload ();
 
 	// Return the SDL_Texture object at the specified index, or NULL if no such texture was found. If a texture is found and width and height pointers are provided, those values are filled in with texture attributes.
 	SDL_Texture *getTexture (int index, int *width = NULL, int *height = NULL);
 
+	// Return the area of the frame's texture holding the frame at the specified index, or NULL if the frame covers its entire texture or no such frame was found. Draw operations should pass this value as the source rect of any copy from a sprite texture.
+	const SDL_Rect *getSourceRect (int index) const;
+
 	// Return the load path for the texture at the specified index, or an empty string if no such texture was found
 	StdString getLoadPath (int index) const;
 
@@ -69,11 +78,19 @@ private:
 		SDL_Texture *texture;
 		StdString loadPath;
 		int width, height;
+		bool hasSourceRect;
+		SDL_Rect sourceRect;
 		TextureData ():
 			texture (NULL),
 			loadPath (""),
 			width (0),
-			height (0) { }
+			height (0),
+			hasSourceRect (false) {
+			sourceRect.x = 0;
+			sourceRect.y = 0;
+			sourceRect.w = 0;
+			sourceRect.h = 0;
+		}
 	};
 	std::vector<Sprite::TextureData> textureList;
 };
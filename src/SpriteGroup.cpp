@@ -30,6 +30,8 @@
 #include "Config.h"
 #include <stdlib.h>
 #include <vector>
+#include <algorithm>
+#include "SDL2/SDL.h"
 #include "OsUtil.h"
 #include "Log.h"
 #include "App.h"
@@ -38,8 +40,13 @@
 #include "Sprite.h"
 #include "SpriteGroup.h"
 
+const int SpriteGroup::AtlasPageSize = 2048;
+const int SpriteGroup::AtlasPadding = 1;
+
 SpriteGroup::SpriteGroup ()
-: isLoaded (false)
+: isAtlasEnabled (false)
+, isLoaded (false)
+, atlasPageCount (0)
 {
 
 }
@@ -61,6 +68,7 @@ void SpriteGroup::clearSpriteList () {
 		++i;
 	}
 	spriteList.clear ();
+	atlasPageCount = 0;
 }
 
 OsUtil::Result SpriteGroup::load (const StdString &path, int imageScale) {
@@ -78,6 +86,17 @@ OsUtil::Result SpriteGroup::load (const StdString &path, int imageScale) {
 	if (imageScale < 0) {
 		imageScale = App::instance->imageScale;
 	}
+	if (isAtlasEnabled) {
+		result = loadAtlas (path, imageScale);
+		if (result == OsUtil::Success) {
+			loadPath.assign (path);
+			isLoaded = true;
+			return (OsUtil::Success);
+		}
+		Log::warning ("Failed to load sprite atlas, loading individual sprite textures instead; path=\"%s\" err=%i", path.c_str (), result);
+		clearSpriteList ();
+	}
+
 	result = OsUtil::Success;
 	i = 0;
 	while (true) {
@@ -122,6 +141,13 @@ void SpriteGroup::resize (int imageScale) {
 	if (imageScale < 0) {
 		imageScale = App::instance->imageScale;
 	}
+	if (isAtlasEnabled && (atlasPageCount > 0)) {
+		result = loadAtlas (loadPath, imageScale);
+		if (result != OsUtil::Success) {
+			Log::err ("Failed to reload sprite atlas; path=\"%s\" err=%i", loadPath.c_str (), result);
+		}
+		return;
+	}
 	index = 0;
 	i = spriteList.begin ();
 	end = spriteList.end ();
@@ -139,6 +165,239 @@ void SpriteGroup::resize (int imageScale) {
 	}
 }
 
+bool SpriteGroup::compareAtlasFrameHeights (const SpriteGroup::AtlasFrame *a, const SpriteGroup::AtlasFrame *b) {
+	if (a->rect.h != b->rect.h) {
+		return (a->rect.h > b->rect.h);
+	}
+	return (a->rect.w > b->rect.w);
+}
+
+OsUtil::Result SpriteGroup::loadAtlas (const StdString &path, int imageScale) {
+	std::vector<SpriteGroup::AtlasFrame> frames;
+	std::vector<SpriteGroup::AtlasFrame>::iterator i, end;
+	std::vector<SpriteGroup::AtlasFrame *> packlist;
+	std::vector<SpriteGroup::AtlasFrame *>::iterator j, jend;
+	std::vector<SDL_Rect> pagerects;
+	std::vector<SDL_Texture *> pagetextures;
+	std::vector<StdString> pagepaths;
+	SpriteGroup::AtlasFrame frame, *item;
+	SDL_RendererInfo renderinfo;
+	SDL_Surface *surface;
+	SDL_Texture *texture;
+	SDL_Rect rect;
+	Sprite *sprite;
+	StdString spritepath, framepath, atlaspath;
+	OsUtil::Result result;
+	int spritecount, framecount, pagesize, page, x, y, w, h, shelfheight, k, standalonecount;
+
+	result = OsUtil::Success;
+	spritecount = 0;
+	standalonecount = 0;
+	while (true) {
+		spritepath.sprintf ("%s/%03i", path.c_str (), spritecount);
+		framepath = Sprite::getFramePath (spritepath, 0, imageScale);
+		if (framepath.empty ()) {
+			break;
+		}
+		framecount = 0;
+		while (! framepath.empty ()) {
+			surface = Resource::instance->loadSurface (framepath);
+			if (! surface) {
+				result = OsUtil::SdlOperationFailedError;
+				break;
+			}
+			frame.spriteIndex = spritecount;
+			frame.loadPath.assign (framepath);
+			frame.surface = surface;
+			frame.rect.x = 0;
+			frame.rect.y = 0;
+			frame.rect.w = surface->w;
+			frame.rect.h = surface->h;
+			frame.page = -1;
+			frames.push_back (frame);
+			++framecount;
+			framepath = Sprite::getFramePath (spritepath, framecount, imageScale);
+		}
+		if (result != OsUtil::Success) {
+			break;
+		}
+		++spritecount;
+	}
+
+	pagesize = SpriteGroup::AtlasPageSize;
+	if (SDL_GetRendererInfo (App::instance->render, &renderinfo) == 0) {
+		if ((renderinfo.max_texture_width > 0) && (renderinfo.max_texture_width < pagesize)) {
+			pagesize = renderinfo.max_texture_width;
+		}
+		if ((renderinfo.max_texture_height > 0) && (renderinfo.max_texture_height < pagesize)) {
+			pagesize = renderinfo.max_texture_height;
+		}
+	}
+
+	// Shelf pack frames in order of decreasing height, leaving transparent padding around each frame so that scaled draws don't sample neighboring frames
+	if (result == OsUtil::Success) {
+		i = frames.begin ();
+		end = frames.end ();
+		while (i != end) {
+			packlist.push_back (&(*i));
+			++i;
+		}
+		std::sort (packlist.begin (), packlist.end (), SpriteGroup::compareAtlasFrameHeights);
+
+		page = -1;
+		x = 0;
+		y = 0;
+		shelfheight = 0;
+		j = packlist.begin ();
+		jend = packlist.end ();
+		while (j != jend) {
+			item = *j;
+			w = item->rect.w + (SpriteGroup::AtlasPadding * 2);
+			h = item->rect.h + (SpriteGroup::AtlasPadding * 2);
+			if ((w > pagesize) || (h > pagesize)) {
+				// The frame doesn't fit in an atlas page and gets its own texture
+				++j;
+				continue;
+			}
+			if ((x + w) > pagesize) {
+				x = 0;
+				y += shelfheight;
+				shelfheight = 0;
+			}
+			if ((page < 0) || ((y + h) > pagesize)) {
+				++page;
+				x = 0;
+				y = 0;
+				shelfheight = 0;
+				rect.x = 0;
+				rect.y = 0;
+				rect.w = 0;
+				rect.h = 0;
+				pagerects.push_back (rect);
+			}
+			item->page = page;
+			item->rect.x = x + SpriteGroup::AtlasPadding;
+			item->rect.y = y + SpriteGroup::AtlasPadding;
+			x += w;
+			if (h > shelfheight) {
+				shelfheight = h;
+			}
+			if (x > pagerects[page].w) {
+				pagerects[page].w = x;
+			}
+			if ((y + h) > pagerects[page].h) {
+				pagerects[page].h = y + h;
+			}
+			++j;
+		}
+	}
+
+	if (result == OsUtil::Success) {
+		for (k = 0; k < (int) pagerects.size (); ++k) {
+			surface = SDL_CreateRGBSurfaceWithFormat (0, pagerects[k].w, pagerects[k].h, 32, SDL_PIXELFORMAT_RGBA32);
+			if (! surface) {
+				Log::err ("Failed to create sprite atlas surface; path=\"%s\" err=\"%s\"", path.c_str (), SDL_GetError ());
+				result = OsUtil::SdlOperationFailedError;
+				break;
+			}
+			i = frames.begin ();
+			end = frames.end ();
+			while (i != end) {
+				if (i->page == k) {
+					// Copy frame pixels as-is, including their alpha values, rather than blending them onto the transparent page
+					SDL_SetSurfaceBlendMode (i->surface, SDL_BLENDMODE_NONE);
+					rect = i->rect;
+					if (SDL_BlitSurface (i->surface, NULL, surface, &rect) != 0) {
+						Log::err ("Failed to copy sprite atlas frame; path=\"%s\" err=\"%s\"", i->loadPath.c_str (), SDL_GetError ());
+						result = OsUtil::SdlOperationFailedError;
+						break;
+					}
+				}
+				++i;
+			}
+			if (result != OsUtil::Success) {
+				SDL_FreeSurface (surface);
+				break;
+			}
+
+			atlaspath.sprintf ("*_SpriteAtlas_%i_%i_%llx", imageScale, k, (long long int) App::instance->getUniqueId ());
+			texture = Resource::instance->createTexture (atlaspath, surface);
+			SDL_FreeSurface (surface);
+			if (! texture) {
+				result = OsUtil::SdlOperationFailedError;
+				break;
+			}
+			pagetextures.push_back (texture);
+			pagepaths.push_back (atlaspath);
+		}
+	}
+
+	if (result == OsUtil::Success) {
+		while ((int) spriteList.size () < spritecount) {
+			spriteList.push_back (new Sprite ());
+		}
+		for (k = 0; k < (int) spriteList.size (); ++k) {
+			spriteList[k]->unload ();
+		}
+
+		standalonecount = 0;
+		i = frames.begin ();
+		end = frames.end ();
+		while (i != end) {
+			sprite = spriteList[i->spriteIndex];
+			if (i->page >= 0) {
+				// Each frame holds its own reference to the atlas texture, released when its sprite unloads
+				texture = Resource::instance->loadTexture (pagepaths[i->page]);
+				if (texture) {
+					result = sprite->addAtlasFrame (texture, pagepaths[i->page], i->rect);
+					if (result != OsUtil::Success) {
+						Resource::instance->unloadTexture (pagepaths[i->page]);
+					}
+				}
+				else {
+					result = OsUtil::SdlOperationFailedError;
+				}
+			}
+			else {
+				texture = Resource::instance->createTexture (i->loadPath, i->surface);
+				if (texture) {
+					result = sprite->addTexture (texture, i->loadPath);
+					if (result != OsUtil::Success) {
+						Resource::instance->unloadTexture (i->loadPath);
+					}
+				}
+				else {
+					result = OsUtil::SdlOperationFailedError;
+				}
+				++standalonecount;
+			}
+			if (result != OsUtil::Success) {
+				break;
+			}
+			++i;
+		}
+	}
+
+	for (k = 0; k < (int) pagepaths.size (); ++k) {
+		Resource::instance->unloadTexture (pagepaths[k]);
+	}
+	i = frames.begin ();
+	end = frames.end ();
+	while (i != end) {
+		if (i->surface) {
+			SDL_FreeSurface (i->surface);
+			i->surface = NULL;
+		}
+		++i;
+	}
+
+	if (result == OsUtil::Success) {
+		atlasPageCount = (int) pagepaths.size ();
+		Log::debug ("Load sprite atlas; path=\"%s\" imageScale=%i spriteCount=%i frameCount=%i pageCount=%i standaloneFrameCount=%i", path.c_str (), imageScale, spritecount, (int) frames.size (), atlasPageCount, standalonecount);
+	}
+	return (result);
+}
+
 Sprite *SpriteGroup::getSprite (int index) {
 	if ((! isLoaded) || (index < 0) || (index >= (int) spriteList.size ())) {
 		return (NULL);
@@ -33,6 +33,7 @@
 #define SPRITE_GROUP_H
 
 #include <vector>
+#include "SDL2/SDL.h"
 #include "StdString.h"
 #include "OsUtil.h"
 #include "Sprite.h"
@@ -42,9 +43,16 @@ public:
 	SpriteGroup ();
 	~SpriteGroup ();
 
+	static const int AtlasPageSize;
+	static const int AtlasPadding;
+
+	// Read-write data members
+	bool isAtlasEnabled; // If enabled, load operations pack all sprite frames into a small set of shared atlas textures
+
 	// Read-only data members
 	bool isLoaded;
 	StdString loadPath;
+	int atlasPageCount;
 
 	// Load sprite data from the specified path, which is expected to contain numbered directories named 000, 001, etc. Returns a Result value. If no image scale value is provided, the application image scale is used.
 	OsUtil::Result load (const StdString &path, int imageScale = -1);
@@ -59,9 +67,33 @@ public:
 	Sprite *getSprite (int index);
 
 private:
+	struct AtlasFrame {
+		int spriteIndex;
+		StdString loadPath;
+		SDL_Surface *surface;
+		SDL_Rect rect;
+		int page;
+		AtlasFrame ():
+			spriteIndex (0),
+			loadPath (""),
+			surface (NULL),
+			page (-1) {
+			rect.x = 0;
+			rect.y = 0;
+			rect.w = 0;
+			rect.h = 0;
+		}
+	};
+
 	// Remove all items from the sprite list
 	void clearSpriteList ();
 
+	// Load frame images from the sprite directories at path, pack them into atlas textures, and assign the resulting frames to items in the sprite list, replacing any frames those items already hold. Returns a Result value.
+	OsUtil::Result loadAtlas (const StdString &path, int imageScale);
+
+	// Return true if frame a should be placed ahead of frame b while packing atlas pages
+	static bool compareAtlasFrameHeights (const SpriteGroup::AtlasFrame *a, const SpriteGroup::AtlasFrame *b);
+
 	std::vector<Sprite *> spriteList;
 };
 
@@ -51,3 +51,7 @@ SDL_Texture *SpriteHandle::getTexture (int index, int *width, int *height) {
 SDL_Texture *SpriteHandle::getTexture (int *width, int *height) {
 	return (sprite->getTexture (frame, width, height));
 }
+
+const SDL_Rect *SpriteHandle::getSourceRect () {
+	return (sprite->getSourceRect (frame));
+}
@@ -44,6 +44,9 @@ public:
 	SDL_Texture *getTexture (int index, int *width = NULL, int *height = NULL);
 	SDL_Texture *getTexture (int *width = NULL, int *height = NULL);
 
+	// Return the source rect to use when drawing the handle's current frame, or NULL if the frame covers its entire texture
+	const SDL_Rect *getSourceRect ();
+
 	// Read-write data members
 	int frame;
 
@@ -241,7 +241,8 @@ void StreamItemUi::doSyncRecordStore () {
 }
 
 void StreamItemUi::syncStreamItem () {
-	Json *streamitem, *mediaitem, *agentstatus, serverstatus, *params;
+	const RecordStore::StreamItem *streamitem;
+	Json *record, *mediaitem, *agentstatus, serverstatus, *params;
 	MediaThumbnailWindow *thumbnail;
 	IconCardWindow *iconcard;
 	IconLabelWindow *iconlabel;
@@ -251,16 +252,16 @@ void StreamItemUi::syncStreamItem () {
 	float t;
 	int i;
 
-	streamitem = RecordStore::instance->findRecord (streamId, SystemInterface::CommandId_StreamItem);
+	streamitem = RecordStore::instance->findStreamItem (streamId);
 	if (! streamitem) {
 		return;
 	}
-	agentId = SystemInterface::instance->getCommandAgentId (streamitem);
+	agentId.assign (*(streamitem->agentId));
 	if (agentId.empty ()) {
 		return;
 	}
 
-	agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentId);
+	agentstatus = RecordStore::instance->findAgentStatusRecord (agentId);
 	if (! agentstatus) {
 		return;
 	}
@@ -271,16 +272,19 @@ void StreamItemUi::syncStreamItem () {
 		thumbnailPath = serverstatus.getString ("thumbnailPath", "");
 	}
 
-	mediaId = SystemInterface::instance->getCommandStringParam (streamitem, "sourceId", StdString (""));
-	segmentCount = SystemInterface::instance->getCommandNumberParam (streamitem, "segmentCount", (int) 0);
-	SystemInterface::instance->getCommandNumberArrayParam (streamitem, "segmentPositions", &segmentPositions, true);
-	duration = SystemInterface::instance->getCommandNumberParam (streamitem, "duration", (int64_t) 0);
-	frameWidth = SystemInterface::instance->getCommandNumberParam (streamitem, "width", (int) 0);
-	frameHeight = SystemInterface::instance->getCommandNumberParam (streamitem, "height", (int) 0);
-	frameRate = SystemInterface::instance->getCommandNumberParam (streamitem, "frameRate", (float) 0.0f);
-	bitrate = SystemInterface::instance->getCommandNumberParam (streamitem, "bitrate", (int64_t) 0);
-	profile = SystemInterface::instance->getCommandNumberParam (streamitem, "profile", (int) -1);
-	streamSize = SystemInterface::instance->getCommandNumberParam (streamitem, "size", (int64_t) 0);
+	mediaId.assign (streamitem->sourceId);
+	segmentCount = streamitem->segmentCount;
+	duration = (int64_t) streamitem->duration;
+	frameWidth = streamitem->width;
+	frameHeight = streamitem->height;
+	frameRate = (float) streamitem->frameRate;
+	bitrate = streamitem->bitrate;
+	profile = streamitem->profile;
+	streamSize = streamitem->size;
+	record = RecordStore::instance->findRecord (streamId, SystemInterface::CommandId_StreamItem);
+	if (record) {
+		SystemInterface::instance->getCommandNumberArrayParam (record, "segmentPositions", &segmentPositions, true);
+	}
 
 	if ((cardView->getRowItemCount (StreamItemUi::ImageRow) <= 0) && (segmentCount > 0) && (frameWidth > 0) && (frameHeight > 0) && (! thumbnailPath.empty ())) {
 		for (i = 0; i < segmentCount; ++i) {
@@ -312,7 +316,7 @@ void StreamItemUi::syncStreamItem () {
 		nameWindow.assign (iconcard);
 		iconcard = (IconCardWindow *) nameWindow.widget;
 	}
-	text = SystemInterface::instance->getCommandStringParam (streamitem, "name", "");
+	text.assign (streamitem->name);
 	iconcard->setName (UiConfiguration::instance->fonts[UiConfiguration::TitleFont]->truncatedText (text, App::instance->windowWidth * StreamItemUi::TextWidthMultiplier, Font::DotTruncateSuffix), UiConfiguration::TitleFont);
 	iconcard->setSubtitle (AgentControl::instance->getAgentDisplayName (agentId));
 	iconcard->setSubtitleColor (UiConfiguration::instance->lightPrimaryTextColor);
@@ -52,7 +52,7 @@
 #include "CardView.h"
 #include "StreamWindow.h"
 
-StreamWindow::StreamWindow (Json *streamItem)
+StreamWindow::StreamWindow (const RecordStore::StreamItem *streamItem)
 : Panel ()
 , isSelected (false)
 , displayTimestamp (-1.0f)
@@ -77,14 +77,14 @@ StreamWindow::StreamWindow (Json *streamItem)
 
 	setFillBg (true, UiConfiguration::instance->mediumBackgroundColor);
 
-	streamId = SystemInterface::instance->getCommandStringParam (streamItem, "id", "");
-	agentId = SystemInterface::instance->getCommandAgentId (streamItem);
-	streamName = SystemInterface::instance->getCommandStringParam (streamItem, "name", "");
-	frameWidth = SystemInterface::instance->getCommandNumberParam (streamItem, "width", (int) 0);
-	frameHeight = SystemInterface::instance->getCommandNumberParam (streamItem, "height", (int) 0);
-	frameRate = SystemInterface::instance->getCommandNumberParam (streamItem, "frameRate", (float) 0.0f);
-	bitrate = SystemInterface::instance->getCommandNumberParam (streamItem, "bitrate", (int64_t) 0);
-	streamSize = SystemInterface::instance->getCommandNumberParam (streamItem, "size", (int64_t) 0);
+	streamId.assign (streamItem->id);
+	agentId.assign (*(streamItem->agentId));
+	streamName.assign (streamItem->name);
+	frameWidth = streamItem->width;
+	frameHeight = streamItem->height;
+	frameRate = (float) streamItem->frameRate;
+	bitrate = streamItem->bitrate;
+	streamSize = streamItem->size;
 
 	streamImage = (ImageWindow *) addWidget (new ImageWindow (new Image (UiConfiguration::instance->coreSprites.getSprite (UiConfiguration::LargeLoadingIconSprite))));
 	streamImage->loadCallback = Widget::EventCallbackContext (StreamWindow::streamImageLoaded, this);
@@ -264,14 +264,15 @@ bool StreamWindow::doProcessMouseState (const Widget::MouseState &mouseState) {
 }
 
 void StreamWindow::syncRecordStore () {
+	const RecordStore::StreamItem *streamitem;
 	Json *record, *agentstatus, serverstatus;
 
-	record = RecordStore::instance->findRecord (streamId, SystemInterface::CommandId_StreamItem);
-	if (! record) {
+	streamitem = RecordStore::instance->findStreamItem (streamId);
+	if (! streamitem) {
 		return;
 	}
 
-	agentstatus = RecordStore::instance->findRecord (RecordStore::matchAgentStatusSource, &agentId);
+	agentstatus = RecordStore::instance->findAgentStatusRecord (agentId);
 	if (! agentstatus) {
 		return;
 	}
@@ -284,9 +285,12 @@ void StreamWindow::syncRecordStore () {
 		hlsStreamPath.assign ("");
 	}
 
-	segmentCount = SystemInterface::instance->getCommandNumberParam (record, "segmentCount", (int) 0);
-	SystemInterface::instance->getCommandNumberArrayParam (record, "segmentPositions", &segmentPositions, true);
-	duration = SystemInterface::instance->getCommandNumberParam (record, "duration", (int64_t) 0);
+	segmentCount = streamitem->segmentCount;
+	duration = (int64_t) streamitem->duration;
+	record = RecordStore::instance->findRecord (streamId, SystemInterface::CommandId_StreamItem);
+	if (record) {
+		SystemInterface::instance->getCommandNumberArrayParam (record, "segmentPositions", &segmentPositions, true);
+	}
 
 	detailText->setText (StdString::createSprintf ("%ix%i  %s  %s", frameWidth, frameHeight, MediaUtil::getBitrateDisplayString (bitrate).c_str (), OsUtil::getDurationDisplayString (duration).c_str ()));
 
@@ -297,6 +301,10 @@ void StreamWindow::syncRecordStore () {
 	refreshLayout ();
 }
 
+bool StreamWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return ((changes.recordIds.count (streamId) > 0) || (changes.recordIds.count (agentId) > 0));
+}
+
 void StreamWindow::refreshLayout () {
 	float x, y;
 
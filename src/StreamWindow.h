@@ -41,11 +41,12 @@
 #include "Button.h"
 #include "TextFlow.h"
 #include "Json.h"
+#include "RecordStore.h"
 #include "Panel.h"
 
 class StreamWindow : public Panel {
 public:
-	StreamWindow (Json *streamItem);
+	StreamWindow (const RecordStore::StreamItem *streamItem);
 	virtual ~StreamWindow ();
 
 	// Read-write data members
@@ -86,6 +87,9 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	void syncRecordStore ();
 
+	// Return a boolean value indicating if the widget must execute syncRecordStore to reflect the provided set of record changes
+	bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
 	// Return a boolean value indicating if the provided Widget is a member of this class
 	static bool isWidgetType (Widget *widget);
 
@@ -0,0 +1,76 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Config.h"
+#include <map>
+#include "StdString.h"
+#include "StringPool.h"
+
+StringPool::StringPool () {
+
+}
+
+StringPool::~StringPool () {
+	clear ();
+}
+
+const StdString *StringPool::intern (const StdString &value) {
+	std::map<StdString, int>::iterator pos;
+
+	pos = valueMap.find (value);
+	if (pos == valueMap.end ()) {
+		pos = valueMap.insert (std::pair<StdString, int> (value, 0)).first;
+	}
+	++(pos->second);
+	return (&(pos->first));
+}
+
+void StringPool::release (const StdString *value) {
+	std::map<StdString, int>::iterator pos;
+
+	if (! value) {
+		return;
+	}
+	pos = valueMap.find (*value);
+	if (pos == valueMap.end ()) {
+		return;
+	}
+	--(pos->second);
+	if (pos->second <= 0) {
+		valueMap.erase (pos);
+	}
+}
+
+int StringPool::size () const {
+	return ((int) valueMap.size ());
+}
+
+void StringPool::clear () {
+	valueMap.clear ();
+}
@@ -0,0 +1,60 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+// Object that holds a single shared copy of each distinct string value, referenced by pointer
+
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <map>
+#include "StdString.h"
+
+class StringPool {
+public:
+	StringPool ();
+	~StringPool ();
+
+	// Return a pointer to the pool's copy of the provided value, adding it to the pool if needed. The returned pointer remains valid until a matching number of release calls removes the value.
+	const StdString *intern (const StdString &value);
+
+	// Release a reference previously returned by intern, removing the value from the pool if no references remain
+	void release (const StdString *value);
+
+	// Return the number of distinct values in the pool
+	int size () const;
+
+	// Remove all values from the pool, invalidating all references
+	void clear ();
+
+private:
+	// A map of pool values to reference counts. std::map keys do not move as the map changes, so pointers to them serve as stable references.
+	std::map<StdString, int> valueMap;
+};
+
+#endif
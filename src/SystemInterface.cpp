@@ -3844,7 +3844,12 @@ StdString SystemInterface::getCommandStringParam (Json *command, const StdString
 }
 
 StdString SystemInterface::getCommandStringParam (Json *command, const char *paramName, const char *defaultValue) {
-	return (getCommandStringParam (command, StdString (paramName), StdString (defaultValue)));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (StdString (defaultValue));
+	}
+	return (params.getString (paramName, defaultValue));
 }
 
 bool SystemInterface::getCommandBooleanParam (Json *command, const StdString &paramName, bool defaultValue) {
@@ -3857,7 +3862,12 @@ bool SystemInterface::getCommandBooleanParam (Json *command, const StdString &pa
 }
 
 bool SystemInterface::getCommandBooleanParam (Json *command, const char *paramName, bool defaultValue) {
-	return (getCommandBooleanParam (command, StdString (paramName), defaultValue));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (defaultValue);
+	}
+	return (params.getBoolean (paramName, defaultValue));
 }
 
 int SystemInterface::getCommandNumberParam (Json *command, const StdString &paramName, const int defaultValue) {
@@ -3870,7 +3880,12 @@ int SystemInterface::getCommandNumberParam (Json *command, const StdString &para
 }
 
 int SystemInterface::getCommandNumberParam (Json *command, const char *paramName, const int defaultValue) {
-	return (getCommandNumberParam (command, StdString (paramName), defaultValue));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (defaultValue);
+	}
+	return (params.getNumber (paramName, defaultValue));
 }
 
 int64_t SystemInterface::getCommandNumberParam (Json *command, const StdString &paramName, const int64_t defaultValue) {
@@ -3883,7 +3898,12 @@ int64_t SystemInterface::getCommandNumberParam (Json *command, const StdString &
 }
 
 int64_t SystemInterface::getCommandNumberParam (Json *command, const char *paramName, const int64_t defaultValue) {
-	return (getCommandNumberParam (command, StdString (paramName), defaultValue));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (defaultValue);
+	}
+	return (params.getNumber (paramName, defaultValue));
 }
 
 double SystemInterface::getCommandNumberParam (Json *command, const StdString &paramName, const double defaultValue) {
@@ -3896,7 +3916,12 @@ double SystemInterface::getCommandNumberParam (Json *command, const StdString &p
 }
 
 double SystemInterface::getCommandNumberParam (Json *command, const char *paramName, const double defaultValue) {
-	return (getCommandNumberParam (command, StdString (paramName), defaultValue));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (defaultValue);
+	}
+	return (params.getNumber (paramName, defaultValue));
 }
 
 float SystemInterface::getCommandNumberParam (Json *command, const StdString &paramName, const float defaultValue) {
@@ -3909,7 +3934,12 @@ float SystemInterface::getCommandNumberParam (Json *command, const StdString &pa
 }
 
 float SystemInterface::getCommandNumberParam (Json *command, const char *paramName, const float defaultValue) {
-	return (getCommandNumberParam (command, StdString (paramName), defaultValue));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (defaultValue);
+	}
+	return (params.getNumber (paramName, defaultValue));
 }
 
 bool SystemInterface::getCommandObjectParam (Json *command, const StdString &paramName, Json *destJson) {
@@ -3922,7 +3952,12 @@ bool SystemInterface::getCommandObjectParam (Json *command, const StdString &par
 }
 
 bool SystemInterface::getCommandObjectParam (Json *command, const char *paramName, Json *destJson) {
-	return (getCommandObjectParam (command, StdString (paramName), destJson));
+	Json params;
+
+	if (! command->getObject ("params", &params)) {
+		return (false);
+	}
+	return (params.getObject (paramName, destJson));
 }
 
 bool SystemInterface::getCommandNumberArrayParam (Json *command, const StdString &paramName, std::vector<int> *destList, bool shouldClear) {
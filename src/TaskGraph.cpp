@@ -0,0 +1,300 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+#include "Config.h"
+#include <stdlib.h>
+#include <vector>
+#include "SDL2/SDL.h"
+#include "OsUtil.h"
+#include "Log.h"
+#include "StdString.h"
+#include "StringList.h"
+#include "Json.h"
+#include "TaskGraph.h"
+
+TaskGraph::TaskGraph ()
+: startTime (0)
+, endTime (0)
+, taskListMutex (NULL)
+, taskListCond (NULL)
+{
+	taskListMutex = SDL_CreateMutex ();
+	taskListCond = SDL_CreateCond ();
+}
+
+TaskGraph::~TaskGraph () {
+	if (taskListCond) {
+		SDL_DestroyCond (taskListCond);
+		taskListCond = NULL;
+	}
+	if (taskListMutex) {
+		SDL_DestroyMutex (taskListMutex);
+		taskListMutex = NULL;
+	}
+}
+
+void TaskGraph::addTask (const StdString &name, TaskGraph::TaskFunction fn, void *fnData, const StringList &dependencyNames, bool isMainThread) {
+	TaskGraph::Task task;
+
+	task.name.assign (name);
+	task.fn = fn;
+	task.fnData = fnData;
+	task.dependencyNames.insertStringList (dependencyNames);
+	task.isMainThread = isMainThread;
+	taskList.push_back (task);
+}
+
+void TaskGraph::clear () {
+	taskList.clear ();
+	startTime = 0;
+	endTime = 0;
+}
+
+int TaskGraph::resolveDependencies () {
+	std::vector<TaskGraph::Task>::iterator i, end;
+	StringList::const_iterator j, jend;
+	int index, count;
+
+	count = (int) taskList.size ();
+	i = taskList.begin ();
+	end = taskList.end ();
+	while (i != end) {
+		i->dependencyIndexes.clear ();
+		j = i->dependencyNames.cbegin ();
+		jend = i->dependencyNames.cend ();
+		while (j != jend) {
+			for (index = 0; index < count; ++index) {
+				if (taskList.at (index).name.equals (*j)) {
+					break;
+				}
+			}
+			if (index >= count) {
+				Log::err ("Task graph dependency not found; task=\"%s\" dependency=\"%s\"", i->name.c_str (), j->c_str ());
+				return (OsUtil::InvalidParamError);
+			}
+			i->dependencyIndexes.push_back (index);
+			++j;
+		}
+		i->state = TaskGraph::Waiting;
+		i->result = OsUtil::Success;
+		i->startTime = 0;
+		i->endTime = 0;
+		i->thread = NULL;
+		i->graph = this;
+		++i;
+	}
+	return (OsUtil::Success);
+}
+
+bool TaskGraph::isTaskReady (const TaskGraph::Task &task) const {
+	std::vector<int>::const_iterator i, end;
+
+	if (task.state != TaskGraph::Waiting) {
+		return (false);
+	}
+	i = task.dependencyIndexes.cbegin ();
+	end = task.dependencyIndexes.cend ();
+	while (i != end) {
+		if (taskList.at (*i).state != TaskGraph::Complete) {
+			return (false);
+		}
+		++i;
+	}
+	return (true);
+}
+
+void TaskGraph::executeTask (TaskGraph::Task *task) {
+	int result;
+
+	task->startTime = OsUtil::getTime ();
+	result = task->fn (task->fnData);
+
+	SDL_LockMutex (taskListMutex);
+	task->endTime = OsUtil::getTime ();
+	task->result = result;
+	task->state = TaskGraph::Complete;
+	SDL_CondBroadcast (taskListCond);
+	SDL_UnlockMutex (taskListMutex);
+}
+
+int TaskGraph::runTaskThread (void *taskPtr) {
+	TaskGraph::Task *task;
+
+	task = (TaskGraph::Task *) taskPtr;
+	task->graph->executeTask (task);
+	return (0);
+}
+
+int TaskGraph::run () {
+	std::vector<TaskGraph::Task>::iterator i, end;
+	TaskGraph::Task *maintask;
+	int result, runcount, completecount, count;
+
+	startTime = OsUtil::getTime ();
+	endTime = startTime;
+	result = resolveDependencies ();
+	if (result != OsUtil::Success) {
+		return (result);
+	}
+
+	count = (int) taskList.size ();
+	SDL_LockMutex (taskListMutex);
+	while (true) {
+		maintask = NULL;
+		runcount = 0;
+		completecount = 0;
+		i = taskList.begin ();
+		end = taskList.end ();
+		while (i != end) {
+			if ((i->state == TaskGraph::Complete) && (i->result != OsUtil::Success) && (result == OsUtil::Success)) {
+				result = i->result;
+			}
+			++i;
+		}
+
+		i = taskList.begin ();
+		end = taskList.end ();
+		while (i != end) {
+			if ((result == OsUtil::Success) && isTaskReady (*i)) {
+				if (i->isMainThread) {
+					if (! maintask) {
+						maintask = &(*i);
+						maintask->state = TaskGraph::Running;
+					}
+				}
+				else {
+					i->state = TaskGraph::Running;
+					i->thread = SDL_CreateThread (TaskGraph::runTaskThread, "runTaskThread", (void *) &(*i));
+					if (! i->thread) {
+						// Fall back to executing the task from the calling thread
+						Log::warning ("Failed to create task thread, executing task in sequence; task=\"%s\" err=\"%s\"", i->name.c_str (), SDL_GetError ());
+						SDL_UnlockMutex (taskListMutex);
+						executeTask (&(*i));
+						SDL_LockMutex (taskListMutex);
+					}
+				}
+			}
+			if (i->state == TaskGraph::Running) {
+				++runcount;
+			}
+			else if (i->state == TaskGraph::Complete) {
+				++completecount;
+			}
+			++i;
+		}
+
+		if (maintask) {
+			SDL_UnlockMutex (taskListMutex);
+			executeTask (maintask);
+			SDL_LockMutex (taskListMutex);
+			continue;
+		}
+		if ((completecount >= count) || (runcount <= 0)) {
+			break;
+		}
+		SDL_CondWait (taskListCond, taskListMutex);
+	}
+
+	i = taskList.begin ();
+	end = taskList.end ();
+	while (i != end) {
+		if (i->state == TaskGraph::Waiting) {
+			i->state = TaskGraph::Skipped;
+			if (result == OsUtil::Success) {
+				// No task is running and this task can never become ready, meaning its dependencies form a cycle
+				Log::err ("Task graph dependency cycle detected; task=\"%s\"", i->name.c_str ());
+				result = OsUtil::InvalidParamError;
+			}
+		}
+		++i;
+	}
+	SDL_UnlockMutex (taskListMutex);
+
+	i = taskList.begin ();
+	end = taskList.end ();
+	while (i != end) {
+		if (i->thread) {
+			SDL_WaitThread (i->thread, NULL);
+			i->thread = NULL;
+		}
+		++i;
+	}
+	endTime = OsUtil::getTime ();
+
+	return (result);
+}
+
+int64_t TaskGraph::getDuration () const {
+	return (endTime - startTime);
+}
+
+void TaskGraph::logTimings (const char *graphName) const {
+	std::vector<TaskGraph::Task>::const_iterator i, end;
+
+	i = taskList.cbegin ();
+	end = taskList.cend ();
+	while (i != end) {
+		if (i->state == TaskGraph::Complete) {
+			Log::debug ("* %s task; name=%s start=%llims duration=%llims thread=%s result=%i", graphName, i->name.c_str (), (long long) (i->startTime - startTime), (long long) (i->endTime - i->startTime), i->isMainThread ? "main" : "worker", i->result);
+		}
+		else {
+			Log::debug ("* %s task; name=%s skipped", graphName, i->name.c_str ());
+		}
+		++i;
+	}
+}
+
+Json *TaskGraph::createTimingJson () const {
+	std::vector<TaskGraph::Task>::const_iterator i, end;
+	JsonList items;
+	Json *json, *item;
+
+	i = taskList.cbegin ();
+	end = taskList.cend ();
+	while (i != end) {
+		item = new Json ();
+		item->set ("name", i->name);
+		item->set ("isMainThread", i->isMainThread);
+		if (i->state == TaskGraph::Complete) {
+			item->set ("start", (int64_t) (i->startTime - startTime));
+			item->set ("duration", (int64_t) (i->endTime - i->startTime));
+			item->set ("result", i->result);
+		}
+		else {
+			item->set ("isSkipped", true);
+		}
+		items.push_back (item);
+		++i;
+	}
+
+	json = new Json ();
+	json->set ("duration", (int64_t) getDuration ());
+	json->set ("tasks", &items);
+	return (json);
+}
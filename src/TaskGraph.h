@@ -0,0 +1,120 @@
+/*
+* Copyright 2018-2022 Membrane Software <author@membranesoftware.com> https://membranesoftware.com
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* 1. Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* 2. Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* 3. Neither the name of the copyright holder nor the names of its contributors
+* may be used to endorse or promote products derived from this software without
+* specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+* AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+* ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+* LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+* INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+* CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+* ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+* POSSIBILITY OF SUCH DAMAGE.
+*/
+// Class that runs a set of dependent tasks, executing independent tasks in parallel threads and recording the time taken by each
+
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <vector>
+#include "SDL2/SDL.h"
+#include "StdString.h"
+#include "StringList.h"
+
+class Json;
+
+class TaskGraph {
+public:
+	TaskGraph ();
+	~TaskGraph ();
+
+	// Read-only data members
+	int64_t startTime;
+	int64_t endTime;
+
+	typedef int (*TaskFunction) (void *fnData);
+
+	// Add a task to the graph. fn must return an OsUtil::Result value, and is invoked only after all tasks named in dependencyNames have completed successfully. If isMainThread is true, fn executes from the thread that calls run; otherwise, fn executes in a worker thread.
+	void addTask (const StdString &name, TaskGraph::TaskFunction fn, void *fnData, const StringList &dependencyNames = StringList (), bool isMainThread = false);
+
+	// Remove all tasks from the graph
+	void clear ();
+
+	// Execute all tasks in the graph, blocking until the operation completes. Once a task fails, no further tasks are started. Returns a Result value, equal to the result of the first failed task if any task failed.
+	int run ();
+
+	// Return the number of milliseconds elapsed during the last run operation
+	int64_t getDuration () const;
+
+	// Write a log message at debug level for each task executed by the last run operation
+	void logTimings (const char *graphName) const;
+
+	// Return a newly created Json object containing timing data for each task executed by the last run operation
+	Json *createTimingJson () const;
+
+private:
+	struct Task {
+		StdString name;
+		TaskGraph::TaskFunction fn;
+		void *fnData;
+		StringList dependencyNames;
+		std::vector<int> dependencyIndexes;
+		bool isMainThread;
+		int state;
+		int result;
+		int64_t startTime;
+		int64_t endTime;
+		SDL_Thread *thread;
+		TaskGraph *graph;
+		Task ():
+			fn (NULL),
+			fnData (NULL),
+			isMainThread (false),
+			state (0),
+			result (0),
+			startTime (0),
+			endTime (0),
+			thread (NULL),
+			graph (NULL) { }
+	};
+	enum {
+		Waiting = 0,
+		Running = 1,
+		Complete = 2,
+		Skipped = 3
+	};
+
+	// Resolve task dependency names to task indexes. Returns a Result value.
+	int resolveDependencies ();
+
+	// Return a boolean value indicating if all dependencies of the specified task have completed. This method must be invoked only while holding taskListMutex.
+	bool isTaskReady (const TaskGraph::Task &task) const;
+
+	// Execute a task and record its result, invoking fn from the calling thread
+	void executeTask (TaskGraph::Task *task);
+
+	// Run a thread that executes a task
+	static int runTaskThread (void *taskPtr);
+
+	std::vector<TaskGraph::Task> taskList;
+	SDL_mutex *taskListMutex;
+	SDL_cond *taskListCond;
+};
+
+#endif
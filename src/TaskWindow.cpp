@@ -103,6 +103,10 @@ void TaskWindow::syncRecordStore () {
 	refreshLayout ();
 }
 
+bool TaskWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (changes.recordIds.count (taskId) > 0);
+}
+
 void TaskWindow::refreshLayout () {
 	float x, y, x0, y0, x2, y2;
 
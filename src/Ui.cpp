@@ -50,6 +50,7 @@
 #include "HelpWindow.h"
 #include "IconLabelWindow.h"
 #include "CommandListener.h"
+#include "RecordStore.h"
 #include "Ui.h"
 
 Ui::Ui ()
@@ -64,6 +65,7 @@ Ui::Ui ()
 , refcount (0)
 , refcountMutex (NULL)
 , lastWindowCloseCount (0)
+, recordStoreVersion (-1)
 {
 	invokeMapMutex = SDL_CreateMutex ();
 	refcountMutex = SDL_CreateMutex ();
@@ -155,6 +157,7 @@ void Ui::unload () {
 
 	rootPanel->clear ();
 	doUnload ();
+	resetRecordSync ();
 
 	sprites.unload ();
 	isLoaded = false;
@@ -407,14 +410,31 @@ bool Ui::unselectWidget (const StdString &targetName) {
 }
 
 void Ui::syncRecordStore () {
-	// Superclass method takes no action
-	doSyncRecordStore ();
+	RecordStore::ChangeSet changes;
+
+	RecordStore::instance->getChanges (recordStoreVersion, &changes);
+	recordStoreVersion = changes.version;
+	if (changes.isFullSync) {
+		doSyncRecordStore ();
+	}
+	else {
+		doSyncRecordStoreChanges (changes);
+	}
 }
 
 void Ui::doSyncRecordStore () {
 	// Default implementation does nothing
 }
 
+void Ui::doSyncRecordStoreChanges (const RecordStore::ChangeSet &changes) {
+	// Default implementation examines all records
+	doSyncRecordStore ();
+}
+
+void Ui::resetRecordSync () {
+	recordStoreVersion = -1;
+}
+
 void Ui::setLinkConnected (bool connected) {
 	StringList::iterator i, end;
 
@@ -46,6 +46,7 @@
 #include "SpriteGroup.h"
 #include "CardView.h"
 #include "HelpWindow.h"
+#include "RecordStore.h"
 
 class Ui {
 public:
@@ -121,7 +122,7 @@ public:
 	// Execute an interface action to unselect the named widget and return a boolean value indicating if the widget was found
 	virtual bool unselectWidget (const StdString &targetName);
 
-	// Execute actions to sync state with records present in the application's RecordStore object, which has been locked prior to invocation
+	// Execute actions to sync state with records present in the application's RecordStore object, which has been locked prior to invocation. If the store's change log covers all changes since the last sync, the sync is executed by doSyncRecordStoreChanges; otherwise, it's executed by doSyncRecordStore.
 	void syncRecordStore ();
 
 	typedef void (*InvokeCallback) (Ui *invokeUi, const StdString &agentId, Json *invokeCommand, Json *responseCommand, bool isResponseCommandSuccess);
@@ -183,6 +184,12 @@ protected:
 	// Execute subclass-specific actions to sync state with records present in the application's RecordStore object, which has been locked prior to invocation
 	virtual void doSyncRecordStore ();
 
+	// Execute subclass-specific actions to sync state with the records changed since the last sync, as listed in the provided change set. The application's RecordStore object has been locked prior to invocation. The default implementation invokes doSyncRecordStore.
+	virtual void doSyncRecordStoreChanges (const RecordStore::ChangeSet &changes);
+
+	// Cause the next record store sync to execute doSyncRecordStore, as appropriate when interface state has changed in a way that affects records not listed in the change log
+	void resetRecordSync ();
+
 	// Set the link client connection state that should be maintained for agents with ID values appearing in linkAgentIds
 	void setLinkConnected (bool connected);
 
@@ -245,6 +252,7 @@ private:
 	int refcount;
 	SDL_mutex *refcountMutex;
 	int lastWindowCloseCount;
+	int64_t recordStoreVersion;
 };
 
 #endif
@@ -175,6 +175,7 @@ OsUtil::Result UiConfiguration::load (float fontScale) {
 	}
 
 	if (! coreSpritesPath.empty ()) {
+		coreSprites.isAtlasEnabled = App::instance->isSpriteAtlasEnabled;
 		result = coreSprites.load (coreSpritesPath);
 		if (result != OsUtil::Success) {
 			return (result);
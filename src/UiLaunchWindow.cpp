@@ -293,6 +293,11 @@ void UiLaunchWindow::syncRecordStore () {
 	Panel::syncRecordStore ();
 }
 
+bool UiLaunchWindow::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	// Agent counts shown by the window can change with any record
+	return (true);
+}
+
 int UiLaunchWindow::countMediaItems () {
 	int sum;
 
@@ -48,8 +48,12 @@
 #include "ImageWindow.h"
 #include "ConsoleWindow.h"
 #include "TextFieldWindow.h"
+#include "StatsWindow.h"
+#include "Profiler.h"
 #include "UiStack.h"
 
+const int UiStack::ProfilerWindowUpdatePeriod = 500;
+
 UiStack::UiStack ()
 : mainToolbar (NULL)
 , secondaryToolbar (NULL)
@@ -62,6 +66,7 @@ UiStack::UiStack ()
 , nextCommandType (-1)
 , nextCommandUi (NULL)
 , nextCommandMutex (NULL)
+, profilerWindowClock (0)
 , isUiInputSuspended (false)
 , mouseHoverClock (0)
 , isMouseHoverActive (false)
@@ -154,6 +159,7 @@ void UiStack::setUi (Ui *ui) {
 	nextCommandUi = ui;
 	nextCommandUi->retain ();
 	SDL_UnlockMutex (nextCommandMutex);
+	App::instance->setDrawDirty ();
 }
 
 void UiStack::pushUi (Ui *ui) {
@@ -169,6 +175,7 @@ void UiStack::pushUi (Ui *ui) {
 	nextCommandUi = ui;
 	nextCommandUi->retain ();
 	SDL_UnlockMutex (nextCommandMutex);
+	App::instance->setDrawDirty ();
 }
 
 void UiStack::popUi () {
@@ -179,6 +186,7 @@ void UiStack::popUi () {
 	}
 	nextCommandUi = NULL;
 	SDL_UnlockMutex (nextCommandMutex);
+	App::instance->setDrawDirty ();
 }
 
 void UiStack::update (int msElapsed) {
@@ -222,6 +230,7 @@ void UiStack::update (int msElapsed) {
 	helpWindow.compact ();
 	dialogWindow.compact ();
 	consoleWindow.compact ();
+	profilerWindow.compact ();
 
 	keywidget = keyFocusTarget.widget;
 	if (keywidget && (! keywidget->isKeyFocused)) {
@@ -230,12 +239,20 @@ void UiStack::update (int msElapsed) {
 
 	mousewidget = App::instance->rootPanel->findWidget ((float) Input::instance->mouseX, (float) Input::instance->mouseY, true);
 	if (! mousewidget) {
+		if (mouseHoverTarget.widget) {
+			mouseHoverTarget.widget->addDrawDamage ();
+		}
 		mouseHoverTarget.clear ();
 		deactivateMouseHover ();
 	}
 	else {
 		if (! mouseHoverTarget.equals (mousewidget)) {
+			// Widgets may change appearance as the mouse enters or leaves them
+			if (mouseHoverTarget.widget) {
+				mouseHoverTarget.widget->addDrawDamage ();
+			}
 			mouseHoverTarget.assign (mousewidget);
+			mousewidget->addDrawDamage ();
 			deactivateMouseHover ();
 		}
 		else {
@@ -1034,6 +1051,54 @@ void UiStack::toggleConsoleWindow () {
 	consolewindow->assignKeyFocus ();
 }
 
+void UiStack::toggleProfilerWindow () {
+	StatsWindow *window;
+
+	if (profilerWindow.widget) {
+		profilerWindow.destroyAndClear ();
+		Profiler::instance->setEnabled (false);
+		return;
+	}
+
+	Profiler::instance->setEnabled (true);
+	window = new StatsWindow ();
+	window->setFillBg (true, Color (0.0f, 0.0f, 0.0f, UiConfiguration::instance->overlayWindowAlpha));
+	window->isInputSuspended = true;
+	window->updateCallback = Widget::UpdateCallbackContext (UiStack::profilerWindowUpdated, this);
+	App::instance->rootPanel->addWidget (window, 0.0f, topBarHeight);
+	window->zLevel = App::instance->rootPanel->maxWidgetZLevel + 1;
+	profilerWindow.assign (window);
+	profilerWindowClock = 0;
+}
+
+void UiStack::profilerWindowUpdated (void *uiStackPtr, int msElapsed, Widget *widgetPtr) {
+	UiStack *uistack;
+	StatsWindow *window;
+	Profiler *profiler;
+	Profiler::Stats stats;
+	int i;
+
+	uistack = (UiStack *) uiStackPtr;
+	window = (StatsWindow *) widgetPtr;
+	uistack->profilerWindowClock -= msElapsed;
+	if (uistack->profilerWindowClock > 0) {
+		return;
+	}
+	uistack->profilerWindowClock = UiStack::ProfilerWindowUpdatePeriod;
+
+	profiler = Profiler::instance;
+	window->setItem (StdString ("section"), StdString ("p50 / p90 / p99 / max ms [histogram]"));
+	for (i = 0; i < Profiler::SectionCount; ++i) {
+		profiler->getSectionStats (i, &stats);
+		window->setItem (StdString (Profiler::getSectionName (i)), StdString::createSprintf ("%.2f / %.2f / %.2f / %.2f [%s]", ((double) stats.p50) / 1000.0f, ((double) stats.p90) / 1000.0f, ((double) stats.p99) / 1000.0f, ((double) stats.max) / 1000.0f, profiler->getSectionHistogram (i).c_str ()));
+	}
+	window->setItem (StdString ("counter"), StdString ("p50 / p90 / p99 / max per frame"));
+	for (i = 0; i < Profiler::CounterCount; ++i) {
+		profiler->getCounterStats (i, &stats);
+		window->setItem (StdString (Profiler::getCounterName (i)), StdString::createSprintf ("%lli / %lli / %lli / %lli", (long long) stats.p50, (long long) stats.p90, (long long) stats.p99, (long long) stats.max));
+	}
+}
+
 void UiStack::showDialog (Panel *dialog) {
 	Panel *panel;
 
@@ -48,6 +48,8 @@ public:
 	UiStack ();
 	~UiStack ();
 
+	static const int ProfilerWindowUpdatePeriod; // milliseconds
+
 	// Read-only data members
 	Toolbar *mainToolbar;
 	Toolbar *secondaryToolbar;
@@ -104,6 +106,9 @@ public:
 	// Toggle the visible state of the console window
 	void toggleConsoleWindow ();
 
+	// Toggle the visible state of the profiler window, enabling frame profiling while the window is shown
+	void toggleProfilerWindow ();
+
 	// Show the provided panel as a dialog
 	void showDialog (Panel *dialog);
 
@@ -154,6 +159,7 @@ public:
 	static void helpActionClicked (void *uiStackPtr, Widget *widgetPtr);
 	static void exitActionClicked (void *uiStackPtr, Widget *widgetPtr);
 	static void imageDialogClicked (void *uiStackPtr, Widget *widgetPtr);
+	static void profilerWindowUpdated (void *uiStackPtr, int msElapsed, Widget *widgetPtr);
 	static void imageDialogLoaded (void *uiStackPtr, Widget *widgetPtr);
 	static void historyExecuteClicked (void *uiStackPtr, Widget *widgetPtr);
 
@@ -196,6 +202,8 @@ private:
 	WidgetHandle helpWindow;
 	WidgetHandle dialogWindow;
 	WidgetHandle consoleWindow;
+	WidgetHandle profilerWindow;
+	int profilerWindowClock;
 	bool isUiInputSuspended;
 	int mouseHoverClock;
 	bool isMouseHoverActive;
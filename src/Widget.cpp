@@ -32,6 +32,7 @@
 #include <math.h>
 #include "SDL2/SDL.h"
 #include "App.h"
+#include "Profiler.h"
 #include "StdString.h"
 #include "StringList.h"
 #include "Input.h"
@@ -53,6 +54,9 @@ Widget::Widget ()
 , hasScreenPosition (false)
 , screenX (0.0f)
 , screenY (0.0f)
+, isOffscreen (false)
+, parentWidget (NULL)
+, isTextureTargetDrawComplete (true)
 , isKeyFocused (false)
 , tooltipAlignment (Widget::BottomAlignment)
 , width (0.0f)
@@ -63,8 +67,15 @@ Widget::Widget ()
 , isMousePressed (false)
 , refcount (0)
 , refcountMutex (NULL)
+, lastIsDrawn (false)
+, lastPositionX (0.0f)
+, lastPositionY (0.0f)
+, lastWidth (0.0f)
+, lastHeight (0.0f)
+, lastIsVisible (true)
 {
 	refcountMutex = SDL_CreateMutex ();
+	SDL_AtomicSet (&drawGeneration, 0);
 }
 
 Widget::~Widget () {
@@ -118,8 +129,10 @@ void Widget::setMouseHoverTooltip (const StdString &text, Widget::Alignment alig
 }
 
 void Widget::update (int msElapsed, float originX, float originY) {
+	Widget *lastupdatewidget;
+	Widget::Rectangle rect;
 	float x, y;
-
+	bool isdrawn;
 
 	if (destroyClock > 0) {
 		destroyClock -= msElapsed;
@@ -136,6 +149,9 @@ void Widget::update (int msElapsed, float originX, float originY) {
 	screenY = position.y + originY;
 	hasScreenPosition = true;
 
+	Profiler::instance->addCount (Profiler::WidgetUpdateCounter);
+	lastupdatewidget = App::instance->updateWidget;
+	App::instance->updateWidget = this;
 	doUpdate (msElapsed);
 
 	if (isFixedCenter) {
@@ -154,6 +170,30 @@ void Widget::update (int msElapsed, float originX, float originY) {
 	if (updateCallback.callback) {
 		updateCallback.callback (updateCallback.callbackData, msElapsed, this);
 	}
+	App::instance->updateWidget = lastupdatewidget;
+
+	rect = getDrawRect ();
+	isdrawn = isVisible && (! isOffscreen);
+	if ((isdrawn != lastIsDrawn) || (isdrawn && ((! FLOAT_EQUALS (rect.x, lastDrawRect.x)) || (! FLOAT_EQUALS (rect.y, lastDrawRect.y)) || (! FLOAT_EQUALS (rect.w, lastDrawRect.w)) || (! FLOAT_EQUALS (rect.h, lastDrawRect.h))))) {
+		if (lastIsDrawn) {
+			App::instance->addDrawDamage (lastDrawRect);
+		}
+		if (isdrawn) {
+			App::instance->addDrawDamage (rect);
+		}
+		lastIsDrawn = isdrawn;
+		lastDrawRect = rect;
+	}
+
+	// Screen position changes caused by a parent's movement don't alter the widget's appearance within that parent, and don't advance the draw generation
+	if ((isVisible != lastIsVisible) || (! FLOAT_EQUALS (position.x, lastPositionX)) || (! FLOAT_EQUALS (position.y, lastPositionY)) || (! FLOAT_EQUALS (width, lastWidth)) || (! FLOAT_EQUALS (height, lastHeight))) {
+		advanceDrawGeneration ();
+		lastIsVisible = isVisible;
+		lastPositionX = position.x;
+		lastPositionY = position.y;
+		lastWidth = width;
+		lastHeight = height;
+	}
 }
 
 void Widget::doUpdate (int msElapsed) {
@@ -168,11 +208,12 @@ void Widget::draw (SDL_Texture *targetTexture, float originX, float originY) {
 		if (! isTextureTargetDrawEnabled) {
 			return;
 		}
-		SDL_SetRenderTarget (App::instance->render, targetTexture);
+		App::instance->setRenderTarget (targetTexture);
 	}
+	Profiler::instance->addCount (Profiler::WidgetDrawCounter);
 	doDraw (targetTexture, originX, originY);
 	if (targetTexture) {
-		SDL_SetRenderTarget (App::instance->render, NULL);
+		App::instance->setRenderTarget (NULL);
 	}
 }
 
@@ -181,8 +222,8 @@ void Widget::doDraw (SDL_Texture *targetTexture, float originX, float originY) {
 }
 
 void Widget::refresh () {
-	// Superclass method takes no action
 	doRefresh ();
+	addDrawDamage ();
 }
 
 void Widget::doRefresh () {
@@ -216,6 +257,16 @@ void Widget::syncRecordStore () {
 	// Default implementation does nothing
 }
 
+void Widget::syncRecordStoreChanges (const RecordStore::ChangeSet &changes) {
+	if (isRecordSyncRequired (changes)) {
+		syncRecordStore ();
+	}
+}
+
+bool Widget::isRecordSyncRequired (const RecordStore::ChangeSet &changes) {
+	return (true);
+}
+
 void Widget::setKeyFocus (bool enable) {
 	// Default implementation does nothing
 }
@@ -411,3 +462,31 @@ Widget::Rectangle Widget::getScreenRect () {
 	}
 	return (rect);
 }
+
+Widget::Rectangle Widget::getDrawRect () {
+	return (getScreenRect ());
+}
+
+int Widget::getDrawGeneration () {
+	return (SDL_AtomicGet (&drawGeneration));
+}
+
+void Widget::advanceDrawGeneration () {
+	Widget *widget;
+
+	// Panels compare their draw generation against that of a cached texture, so a change anywhere in the subtree must reach each ancestor
+	widget = this;
+	while (widget) {
+		SDL_AtomicAdd (&(widget->drawGeneration), 1);
+		widget = widget->parentWidget;
+	}
+}
+
+void Widget::addDrawDamage () {
+	advanceDrawGeneration ();
+	// A widget without a screen position hasn't been drawn yet, and its first update adds damage for the area it's drawn in
+	if (isOffscreen || (! hasScreenPosition)) {
+		return;
+	}
+	App::instance->addDrawDamage (getDrawRect ());
+}
@@ -37,6 +37,7 @@
 #include "StdString.h"
 #include "StringList.h"
 #include "Position.h"
+#include "RecordStore.h"
 
 class Widget {
 public:
@@ -127,6 +128,9 @@ public:
 	int classId;
 	bool hasScreenPosition;
 	float screenX, screenY;
+	bool isOffscreen; // Set by the parent panel if the widget's draw area lies outside the parent's visible area
+	Widget *parentWidget; // Set by the parent panel while the widget is held in its widget list
+	bool isTextureTargetDrawComplete; // Cleared by a panel if any of its visible descendants can't be drawn to a target texture
 	bool isKeyFocused;
 	StdString tooltipText;
 	Widget::Alignment tooltipAlignment;
@@ -158,6 +162,12 @@ public:
 	// Update widget state as appropriate for records present in the application's RecordStore object, which has been locked prior to invocation
 	virtual void syncRecordStore ();
 
+	// Update widget state as appropriate for the provided set of changes to the application's RecordStore object, which has been locked prior to invocation. The widget's syncRecordStore method is invoked only if isRecordSyncRequired returns true.
+	virtual void syncRecordStoreChanges (const RecordStore::ChangeSet &changes);
+
+	// Return a boolean value indicating if the widget must execute syncRecordStore to reflect the provided set of record changes. The default implementation returns true; subclasses that read only records with known IDs override this method to skip unrelated changes.
+	virtual bool isRecordSyncRequired (const RecordStore::ChangeSet &changes);
+
 	// Return the topmost child widget at the specified screen position, or NULL if no such widget was found. If requireMouseHoverEnabled is true, return a widget only if it has enabled the isMouseHoverEnabled option.
 	virtual Widget *findWidget (float screenPositionX, float screenPositionY, bool requireMouseHoverEnabled = false);
 
@@ -238,6 +248,18 @@ public:
 	// Return a Rectangle struct containing the widget's screen extent values
 	Widget::Rectangle getScreenRect ();
 
+	// Return a Rectangle struct containing the screen extent values covered by the widget's draw operations
+	virtual Widget::Rectangle getDrawRect ();
+
+	// Add the widget's screen area to the set of window areas that must be redrawn
+	void addDrawDamage ();
+
+	// Return the widget's draw generation, which changes each time the widget's drawn content, size, or position within its parent changes, or the draw generation of a descendant widget changes. This method can be invoked from any thread.
+	int getDrawGeneration ();
+
+	// Advance the draw generation of the widget and each of its ancestor widgets
+	void advanceDrawGeneration ();
+
 	// Callback functions
 	static bool compareZLevel (Widget *first, Widget *second);
 
@@ -272,6 +294,12 @@ protected:
 private:
 	int refcount;
 	SDL_mutex *refcountMutex;
+	SDL_atomic_t drawGeneration;
+	Widget::Rectangle lastDrawRect;
+	bool lastIsDrawn;
+	float lastPositionX, lastPositionY;
+	float lastWidth, lastHeight;
+	bool lastIsVisible;
 };
 
 #endif
@@ -46,6 +46,23 @@ const static json_serialize_opts default_opts =
    3  /* indent_size */
 };
 
+/* Objects with at least this many entries are searched by json_object_find
+ * using a key hash index instead of a linear scan.
+ */
+#define json_object_index_min_length 8
+
+typedef struct json_object_index
+{
+   unsigned int length;  /* Object length at the time the index was built */
+   unsigned int mask;
+
+   /* Open addressed slots holding an entry position plus one, or zero for an
+    * empty slot.  Sized to at least twice the object length.
+    */
+   unsigned int slots [1];
+
+} json_object_index;
+
 typedef struct json_builder_value
 {
    json_value value;
@@ -55,6 +72,8 @@ typedef struct json_builder_value
    size_t additional_length_allocated;
    size_t length_iterated;
 
+   json_object_index * key_index;
+
 } json_builder_value;
 
 static int builderize (json_value * value)
@@ -402,6 +421,131 @@ void json_object_sort (json_value * object, json_value * proto)
          ++ out_index;
       }
    }
+
+   free (((json_builder_value *) object)->key_index);
+   ((json_builder_value *) object)->key_index = 0;
+}
+
+static unsigned int hash_name (const json_char * name, unsigned int name_length)
+{
+   unsigned int hash = 2166136261u, i;
+
+   for (i = 0; i < name_length; ++ i)
+   {
+      hash ^= (unsigned char) name [i];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+static json_object_index * build_index (json_value * object)
+{
+   unsigned int capacity = 16, i, slot;
+   json_object_index * index;
+
+   while (capacity < object->u.object.length * 2)
+      capacity <<= 1;
+
+   if (! (index = (json_object_index *) calloc
+         (1, sizeof (json_object_index) + (capacity - 1) * sizeof (unsigned int))))
+   {
+      return NULL;
+   }
+
+   index->length = object->u.object.length;
+   index->mask = capacity - 1;
+
+   /* Entries with duplicate names land later in the probe sequence, so
+    * lookups find the first one as a linear scan would.
+    */
+   for (i = 0; i < object->u.object.length; ++ i)
+   {
+      slot = hash_name (object->u.object.values [i].name,
+                        object->u.object.values [i].name_length) & index->mask;
+
+      while (index->slots [slot])
+         slot = (slot + 1) & index->mask;
+
+      index->slots [slot] = i + 1;
+   }
+
+   return index;
+}
+
+json_object_entry * json_object_find (json_value * object,
+                                      const json_char * name, unsigned int name_length)
+{
+   json_builder_value * builder_value = (json_builder_value *) object;
+   json_object_index * index, * new_index;
+   json_object_entry * entry;
+   unsigned int i, slot;
+
+   if (!object || object->type != json_object)
+      return NULL;
+
+   index = 0;
+
+   if (object->u.object.length >= json_object_index_min_length
+         && builder_value->is_builder_value)
+   {
+      /* Objects may be shared by several reading threads, so an index built
+       * here is published with a compare-and-swap and the losing copy freed.
+       * An index left stale by a later push is replaced; objects are never
+       * modified while other threads read them.
+       */
+      index = __atomic_load_n (&builder_value->key_index, __ATOMIC_ACQUIRE);
+
+      if (!index || index->length != object->u.object.length)
+      {
+         if ((new_index = build_index (object)))
+         {
+            if (__atomic_compare_exchange_n (&builder_value->key_index, &index, new_index,
+                                             0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+               free (index);
+               index = new_index;
+            }
+            else
+               free (new_index);
+         }
+         else
+            index = 0;
+      }
+   }
+
+   if (!index)
+   {
+      for (i = 0; i < object->u.object.length; ++ i)
+      {
+         entry = &object->u.object.values [i];
+
+         if (entry->name_length == name_length
+               && memcmp (entry->name, name, name_length) == 0)
+         {
+            return entry;
+         }
+      }
+
+      return NULL;
+   }
+
+   slot = hash_name (name, name_length) & index->mask;
+
+   while (index->slots [slot])
+   {
+      entry = &object->u.object.values [index->slots [slot] - 1];
+
+      if (entry->name_length == name_length
+            && memcmp (entry->name, name, name_length) == 0)
+      {
+         return entry;
+      }
+
+      slot = (slot + 1) & index->mask;
+   }
+
+   return NULL;
 }
 
 json_value * json_object_merge (json_value * objectA, json_value * objectB)
@@ -450,6 +594,7 @@ json_value * json_object_merge (json_value * objectA, json_value * objectB)
    objectA->u.object.length += objectB->u.object.length;
 
    free (objectB->u.object.values);
+   free (((json_builder_value *) objectB)->key_index);
    free (objectB);
 
    return objectA;
@@ -944,6 +1089,7 @@ void json_builder_free (json_value * value)
             if (!value->u.object.length)
             {
                free (value->u.object.values);
+               free (((json_builder_value *) value)->key_index);
                break;
             }
 
@@ -93,6 +93,15 @@ json_value * json_object_merge (json_value * objectA, json_value * objectB);
  */
 void json_object_sort (json_value * object, json_value * proto);
 
+/* Returns the first entry of an object with the given name, or NULL if no
+ * such entry exists.  Larger builder objects are searched using a key hash
+ * index that is built on first use and freed along with the object.  Objects
+ * allocated by json-parser are always scanned, since their memory may be
+ * owned by a custom allocator.
+ */
+json_object_entry * json_object_find (json_value * object,
+                                      const json_char * name, unsigned int name_length);
+
 
 
 /*** Strings